@@ -0,0 +1,6 @@
+#version 440 core
+
+// depth-only pre-pass: color writes are masked, only depth is written
+void main()
+{
+}
@@ -0,0 +1,16 @@
+#version 440 core
+
+// depth-only pre-pass: the position must be computed exactly like the
+// scene vertex shader so the lit pass can test with GL_EQUAL
+layout (location = 0) in vec3 inVertexPosition;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+invariant gl_Position;
+
+void main()
+{
+    gl_Position = projection * view * model * vec4(inVertexPosition, 1.0f);
+}
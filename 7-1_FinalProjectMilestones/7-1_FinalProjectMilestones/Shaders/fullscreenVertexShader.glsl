@@ -0,0 +1,11 @@
+#version 440 core
+
+// fullscreen triangle generated from the vertex index, no attributes needed
+out vec2 fragmentTextureCoordinate;
+
+void main()
+{
+    vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    fragmentTextureCoordinate = position;
+    gl_Position = vec4(position * 2.0f - 1.0f, 0.0f, 1.0f);
+}
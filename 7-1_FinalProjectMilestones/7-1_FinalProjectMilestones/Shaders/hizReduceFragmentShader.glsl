@@ -0,0 +1,31 @@
+#version 440 core
+
+// reduce the scene depth to a smaller level, keeping the farthest depth
+// of every source pixel that the output texel covers
+uniform sampler2D depthTexture;
+uniform vec2 sourceSize;    // drawn region of the depth texture
+uniform vec2 targetSize;    // size of the reduced level
+
+out float outDepth;
+
+void main()
+{
+    ivec2 source = ivec2(sourceSize);
+    ivec2 target = ivec2(targetSize);
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+
+    // footprint rounded outward so neighbouring texels overlap rather than gap
+    ivec2 first = (texel * source) / target;
+    ivec2 last = min(((texel + 1) * source + target - 1) / target, source);
+
+    float farthest = 0.0f;
+    for (int y = first.y; y < last.y; y++)
+    {
+        for (int x = first.x; x < last.x; x++)
+        {
+            farthest = max(farthest, texelFetch(depthTexture, ivec2(x, y), 0).r);
+        }
+    }
+
+    outDepth = farthest;
+}
@@ -0,0 +1,19 @@
+#version 440 core
+
+// impostor quads show the captured view and drop the empty texels around it
+in vec2 fragmentAtlasCoordinate;
+
+uniform sampler2D atlasTexture;
+
+out vec4 outFragmentColor;
+
+void main()
+{
+    vec4 color = texture(atlasTexture, fragmentAtlasCoordinate);
+    if (color.a < 0.5f)
+    {
+        discard;
+    }
+
+    outFragmentColor = vec4(color.rgb, 1.0f);
+}
@@ -0,0 +1,60 @@
+#version 440 core
+
+// camera-facing impostor quads, one instance per ship; each quad picks the
+// atlas view captured nearest to the direction the ship is seen from
+layout (location = 0) in vec4 inPositionScale;   // ship position and scale
+layout (location = 1) in vec2 inYawGroup;        // heading in radians and group
+
+out vec2 fragmentAtlasCoordinate;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 cameraPosition;
+
+const int MAX_GROUPS = 8;
+uniform float groupRadius[MAX_GROUPS];
+uniform int yawViews;
+uniform int pitchViews;
+uniform float pitchStep;    // radians between the captured elevations
+uniform int atlasColumns;
+uniform vec2 tileSize;      // size of one view in atlas coordinates
+
+const float PI = 3.14159265f;
+
+void main()
+{
+    // triangle strip corners generated from the vertex index
+    vec2 corner = vec2((gl_VertexID & 1) != 0 ? 1.0f : -1.0f, (gl_VertexID & 2) != 0 ? 1.0f : -1.0f);
+
+    int group = int(inYawGroup.y);
+    float radius = groupRadius[group] * inPositionScale.w;
+    vec3 center = vec3(model * vec4(inPositionScale.xyz, 1.0f));
+    vec3 toCamera = normalize(cameraPosition - center);
+
+    // turn the direction into the ship's own frame, which the views were captured in
+    float yaw = inYawGroup.x;
+    vec3 local = vec3(cos(yaw) * toCamera.x - sin(yaw) * toCamera.z, toCamera.y,
+        sin(yaw) * toCamera.x + cos(yaw) * toCamera.z);
+    int yawIndex = int(round(atan(local.z, local.x) / (2.0f * PI) * float(yawViews)));
+    yawIndex = (yawIndex + yawViews) % yawViews;
+    int pitchIndex = int(round(asin(clamp(local.y, -1.0f, 1.0f)) / pitchStep)) + pitchViews / 2;
+    pitchIndex = clamp(pitchIndex, 0, pitchViews - 1);
+
+    // the quad is oriented like the capture camera, which kept world up
+    vec3 forward = -toCamera;
+    vec3 right = cross(forward, vec3(0.0f, 1.0f, 0.0f));
+    if (dot(right, right) < 1.0e-6f)
+    {
+        right = vec3(view[0][0], view[1][0], view[2][0]);
+    }
+    right = normalize(right);
+    vec3 up = cross(right, forward);
+
+    vec3 position = center + (right * corner.x + up * corner.y) * radius;
+    gl_Position = projection * view * vec4(position, 1.0f);
+
+    int tile = (group * pitchViews + pitchIndex) * yawViews + yawIndex;
+    vec2 tileCorner = vec2(float(tile % atlasColumns), float(tile / atlasColumns));
+    fragmentAtlasCoordinate = (tileCorner + corner * 0.5f + 0.5f) * tileSize;
+}
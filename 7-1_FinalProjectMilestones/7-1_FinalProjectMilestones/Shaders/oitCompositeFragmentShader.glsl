@@ -0,0 +1,30 @@
+#version 440 core
+
+// resolve the weighted blended transparency targets over the opaque scene;
+// the color is the weighted average of the translucent surfaces and the
+// coverage is what the product of their transmittance leaves uncovered
+uniform sampler2D accumulationTexture;
+uniform sampler2D revealageTexture;
+
+out vec4 outFragmentColor;
+
+void main()
+{
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    float revealage = texelFetch(revealageTexture, texel, 0).r;
+    if (revealage >= 1.0f)
+    {
+        // no translucent surface covers this pixel
+        discard;
+    }
+
+    vec4 accumulation = texelFetch(accumulationTexture, texel, 0);
+    // keep the average finite if the half float sum overflowed
+    if (isinf(max(max(abs(accumulation.r), abs(accumulation.g)), abs(accumulation.b))))
+    {
+        accumulation.rgb = vec3(accumulation.a);
+    }
+
+    vec3 averageColor = accumulation.rgb / max(accumulation.a, 1e-5f);
+    outFragmentColor = vec4(averageColor, 1.0f - revealage);
+}
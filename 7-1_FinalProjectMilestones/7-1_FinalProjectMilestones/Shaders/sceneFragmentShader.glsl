@@ -0,0 +1,215 @@
+#version 440 core
+
+struct Material {
+    vec3 ambientColor;
+    float ambientStrength;
+    vec3 diffuseColor;
+    vec3 specularColor;
+    float shininess;
+};
+
+struct Light {
+    vec3 position;
+    vec3 color;
+    float intensity;
+};
+
+in vec3 fragmentPosition;
+in vec3 fragmentVertexNormal;
+in vec2 fragmentTextureCoordinate;
+
+// translucent objects drawn into the weighted blended transparency targets
+// write a weighted premultiplied color and their coverage instead
+layout (location = 0) out vec4 outFragmentColor;
+layout (location = 1) out float outRevealage;
+
+// shader variants define VARIANT and every feature as true or false, so
+// the unused paths are compiled out; otherwise uniforms pick them per draw
+#ifdef VARIANT
+const bool bUseTexture = TEXTURED;
+const bool bUseLighting = LIT;
+const bool bUseShadows = SHADOWS;
+const bool bUseClusteredLights = POINT_LIGHTS;
+const bool bWeightedOIT = WEIGHTED_OIT;
+#else
+uniform bool bUseTexture = false;
+uniform bool bUseLighting = true;
+uniform bool bUseShadows = false;
+uniform bool bUseClusteredLights = false;
+uniform bool bWeightedOIT = false;
+#endif
+
+uniform vec4 objectColor = vec4(1.0f);
+uniform sampler2D objectTexture;
+uniform vec2 UVscale = vec2(1.0f, 1.0f);
+uniform vec3 viewPosition;
+uniform Material material;
+uniform float specularIntensity = 0.5f;
+uniform Light primaryLight;
+uniform Light ambientLight;
+
+// omnidirectional shadow map of the primary light, storing the distance
+// to the nearest caster divided by shadowFarPlane
+uniform samplerCube shadowMap;
+uniform float shadowFarPlane = 25.0f;
+
+// point lights binned into view space clusters; each cluster record holds
+// the offset and count of its lights in the light index list
+struct PointLight {
+    vec4 positionRadius;
+    vec4 colorIntensity;
+};
+
+layout (std430, binding = 0) readonly buffer PointLightBuffer {
+    PointLight pointLights[];
+};
+layout (std430, binding = 1) readonly buffer ClusterBuffer {
+    uvec2 clusterRecords[];
+};
+layout (std430, binding = 2) readonly buffer LightIndexBuffer {
+    uint lightIndices[];
+};
+
+uniform mat4 view;
+uniform vec3 clusterGrid;
+uniform vec2 clusterTileSize;
+uniform vec2 clusterViewportOrigin = vec2(0.0f);
+uniform float clusterNearPlane;
+uniform float clusterFarPlane;
+
+// offsets for percentage closer filtering around the lookup direction
+const vec3 g_ShadowOffsets[8] = vec3[](
+    vec3( 1,  1,  1), vec3( 1, -1,  1), vec3(-1, -1,  1), vec3(-1,  1,  1),
+    vec3( 1,  1, -1), vec3( 1, -1, -1), vec3(-1, -1, -1), vec3(-1,  1, -1));
+
+float ShadowFactor(vec3 normal, vec3 lightDirection)
+{
+    vec3 lightToFragment = fragmentPosition - primaryLight.position;
+    float currentDepth = length(lightToFragment) / shadowFarPlane;
+    if (currentDepth >= 1.0f)
+    {
+        return 1.0f;
+    }
+
+    // slope scaled bias keeps lit surfaces from shadowing themselves
+    float bias = max(0.004f * (1.0f - dot(normal, lightDirection)), 0.001f);
+    float filterRadius = 0.02f * currentDepth;
+
+    float lit = 0.0f;
+    for (int i = 0; i < 8; i++)
+    {
+        float closestDepth = texture(shadowMap, lightToFragment + g_ShadowOffsets[i] * filterRadius * shadowFarPlane).r;
+        lit += (currentDepth - bias > closestDepth) ? 0.0f : 1.0f;
+    }
+
+    return lit / 8.0f;
+}
+
+vec3 ClusteredLights(vec3 normal, vec3 viewDirection, float shininess)
+{
+    // find the cluster from the pixel position and the view depth
+    float viewDepth = -(view * vec4(fragmentPosition, 1.0f)).z;
+    if ((viewDepth < clusterNearPlane) || (viewDepth > clusterFarPlane))
+    {
+        return vec3(0.0f);
+    }
+
+    ivec3 grid = ivec3(clusterGrid);
+    // tiles count from the corner of the viewport, not of the target
+    ivec2 tile = clamp(ivec2((gl_FragCoord.xy - clusterViewportOrigin) / clusterTileSize), ivec2(0), grid.xy - 1);
+    int slice = int(log(viewDepth / clusterNearPlane) / log(clusterFarPlane / clusterNearPlane) * clusterGrid.z);
+    slice = clamp(slice, 0, grid.z - 1);
+    uvec2 record = clusterRecords[(slice * grid.y + tile.y) * grid.x + tile.x];
+
+    vec3 result = vec3(0.0f);
+    for (uint i = 0u; i < record.y; i++)
+    {
+        PointLight light = pointLights[lightIndices[record.x + i]];
+        vec3 toLight = light.positionRadius.xyz - fragmentPosition;
+        float distance = length(toLight);
+        float radius = light.positionRadius.w;
+        if (distance >= radius)
+        {
+            continue;
+        }
+
+        // smooth window so the light reaches exactly zero at its radius
+        float falloff = clamp(1.0f - pow(distance / radius, 4.0f), 0.0f, 1.0f);
+        float attenuation = (falloff * falloff) / (distance * distance + 1.0f);
+
+        vec3 lightDirection = toLight / distance;
+        float diffuseImpact = max(dot(normal, lightDirection), 0.0f);
+        vec3 reflectDirection = reflect(-lightDirection, normal);
+        float specularComponent = pow(max(dot(viewDirection, reflectDirection), 0.0f), shininess);
+
+        vec3 radiance = light.colorIntensity.rgb * light.colorIntensity.a * attenuation;
+        result += (diffuseImpact * material.diffuseColor +
+            specularIntensity * specularComponent * material.specularColor) * radiance;
+    }
+
+    return result;
+}
+
+void WriteColor(vec4 color)
+{
+    if (!bWeightedOIT)
+    {
+        outFragmentColor = color;
+        return;
+    }
+
+    // nearer and more opaque surfaces get more weight, so the average the
+    // composite divides out leans toward them without sorting
+    float depthWeight = pow(1.0f - gl_FragCoord.z * 0.9f, 3.0f);
+    float weight = clamp(pow(min(1.0f, color.a * 10.0f) + 0.01f, 3.0f) * 1e8f * depthWeight, 1e-2f, 3e3f);
+    outFragmentColor = vec4(color.rgb * color.a, color.a) * weight;
+    outRevealage = color.a;
+}
+
+void main()
+{
+    vec4 baseColor = objectColor;
+    if (bUseTexture)
+    {
+        baseColor = texture(objectTexture, fragmentTextureCoordinate * UVscale);
+    }
+
+    // unlit objects show their base color as is
+    if (!bUseLighting)
+    {
+        WriteColor(baseColor);
+        return;
+    }
+
+    vec3 normal = normalize(fragmentVertexNormal);
+    vec3 lightDirection = normalize(primaryLight.position - fragmentPosition);
+    vec3 viewDirection = normalize(viewPosition - fragmentPosition);
+
+    // ambient
+    vec3 ambient = material.ambientStrength * material.ambientColor * ambientLight.color * ambientLight.intensity;
+
+    // diffuse
+    float diffuseImpact = max(dot(normal, lightDirection), 0.0f);
+    vec3 diffuse = diffuseImpact * material.diffuseColor * primaryLight.color * primaryLight.intensity;
+
+    // specular
+    float shininess = (material.shininess > 0.0f) ? material.shininess : 32.0f;
+    vec3 reflectDirection = reflect(-lightDirection, normal);
+    float specularComponent = pow(max(dot(viewDirection, reflectDirection), 0.0f), shininess);
+    vec3 specular = specularIntensity * specularComponent * material.specularColor * primaryLight.color * primaryLight.intensity;
+
+    float shadow = 1.0f;
+    if (bUseShadows)
+    {
+        shadow = ShadowFactor(normal, lightDirection);
+    }
+
+    vec3 pointLighting = vec3(0.0f);
+    if (bUseClusteredLights)
+    {
+        pointLighting = ClusteredLights(normal, viewDirection, shininess);
+    }
+
+    vec3 phong = (ambient + shadow * (diffuse + specular) + pointLighting) * baseColor.rgb;
+    WriteColor(vec4(phong, baseColor.a));
+}
@@ -0,0 +1,50 @@
+#version 440 core
+
+layout (location = 0) in vec3 inVertexPosition;
+layout (location = 1) in vec3 inVertexNormal;
+layout (location = 2) in vec2 inTextureCoordinate;
+
+out vec3 fragmentPosition;
+out vec3 fragmentVertexNormal;
+out vec2 fragmentTextureCoordinate;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+// compact meshes store octahedral normals and fold the position decode
+// scale into the model matrix, which the normal transform must undo; shader
+// variants fix the layout with a define instead of the uniform
+#ifdef VARIANT
+const bool bCompactVertex = COMPACT_VERTEX;
+#else
+uniform bool bCompactVertex = false;
+#endif
+uniform vec3 compactPositionScale = vec3(1.0f);
+
+// must match the depth pre-pass exactly for the GL_EQUAL depth test
+invariant gl_Position;
+
+vec3 DecodeOctahedral(vec2 encoded)
+{
+    vec3 normal = vec3(encoded, 1.0f - abs(encoded.x) - abs(encoded.y));
+    if (normal.z < 0.0f)
+    {
+        normal.xy = (1.0f - abs(normal.yx)) * vec2(normal.x >= 0.0f ? 1.0f : -1.0f, normal.y >= 0.0f ? 1.0f : -1.0f);
+    }
+    return normalize(normal);
+}
+
+void main()
+{
+    gl_Position = projection * view * model * vec4(inVertexPosition, 1.0f);
+
+    fragmentPosition = vec3(model * vec4(inVertexPosition, 1.0f));
+    vec3 normal = inVertexNormal;
+    if (bCompactVertex)
+    {
+        normal = compactPositionScale * DecodeOctahedral(inVertexNormal.xy);
+    }
+    fragmentVertexNormal = mat3(transpose(inverse(model))) * normal;
+    fragmentTextureCoordinate = inTextureCoordinate;
+}
@@ -0,0 +1,12 @@
+#version 440 core
+
+in vec3 fragmentPosition;
+
+uniform vec3 lightPosition;
+uniform float farPlane;
+
+// store the linear distance from the light so every cube face compares alike
+void main()
+{
+    gl_FragDepth = length(fragmentPosition - lightPosition) / farPlane;
+}
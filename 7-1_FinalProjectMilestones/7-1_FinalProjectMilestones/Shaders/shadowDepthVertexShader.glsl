@@ -0,0 +1,15 @@
+#version 440 core
+
+layout (location = 0) in vec3 inVertexPosition;
+
+out vec3 fragmentPosition;
+
+uniform mat4 model;
+uniform mat4 lightViewProjection;
+
+void main()
+{
+    vec4 worldPosition = model * vec4(inVertexPosition, 1.0f);
+    fragmentPosition = worldPosition.xyz;
+    gl_Position = lightViewProjection * worldPosition;
+}
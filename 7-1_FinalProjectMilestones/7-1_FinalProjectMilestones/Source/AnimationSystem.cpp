@@ -0,0 +1,326 @@
+///////////////////////////////////////////////////////////////////////////////
+// animationsystem.cpp
+// ============
+// evaluate keyframed transform and color tracks at a fixed simulation rate
+// and interpolate between the last two steps for rendering
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "AnimationSystem.h"
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <cmath>
+
+// declaration of the global variables and defines
+namespace {
+    // the longest frame the simulation tries to catch up with
+    const double MAX_FRAME_SECONDS = 0.25;
+
+    /***********************************************************
+     *  FindSegment()
+     *
+     *  Finds the pair of keys around the passed in time in one
+     *  track, along with the blend between them and the number
+     *  of completed loops.  The search starts at the key used
+     *  last, since the time only moves forward between loops.
+     ***********************************************************/
+    void FindSegment(const float* times, int count, float duration, int& cursor,
+        double time, float& blend, double& loops) {
+        blend = 0.0f;
+        loops = 0.0;
+        if ((count < 2) || (duration <= 0.0f)) {
+            cursor = 0;
+            return;
+        }
+
+        loops = std::floor(time / duration);
+        float local = (float)(time - loops * duration);
+
+        if (local < times[cursor]) {
+            cursor = 0;
+        }
+        while ((cursor + 2 < count) && (times[cursor + 1] <= local)) {
+            cursor++;
+        }
+
+        float span = times[cursor + 1] - times[cursor];
+        if (span > 0.0f) {
+            blend = glm::clamp((local - times[cursor]) / span, 0.0f, 1.0f);
+        }
+    }
+
+    /***********************************************************
+     *  WrapDegrees()
+     *
+     *  Returns the passed in angle difference in -180 to 180.
+     ***********************************************************/
+    float WrapDegrees(float degrees) {
+        return degrees - 360.0f * std::floor((degrees + 180.0f) / 360.0f);
+    }
+
+    /***********************************************************
+     *  PositiveDegrees()
+     *
+     *  Returns the passed in angle in 0 to 360.
+     ***********************************************************/
+    double PositiveDegrees(double degrees) {
+        return degrees - 360.0 * std::floor(degrees / 360.0);
+    }
+
+    /***********************************************************
+     *  ComposeTransform()
+     *
+     *  Returns translation * rotationX * rotationY * rotationZ *
+     *  scale, the same order the scene objects are placed with,
+     *  multiplied out so each track needs six trig calls.
+     ***********************************************************/
+    glm::mat4 ComposeTransform(const glm::vec3& scaleXYZ, const glm::vec3& rotationDegrees, const glm::vec3& positionXYZ) {
+        float cx = std::cos(glm::radians(rotationDegrees.x));
+        float sx = std::sin(glm::radians(rotationDegrees.x));
+        float cy = std::cos(glm::radians(rotationDegrees.y));
+        float sy = std::sin(glm::radians(rotationDegrees.y));
+        float cz = std::cos(glm::radians(rotationDegrees.z));
+        float sz = std::sin(glm::radians(rotationDegrees.z));
+
+        return glm::mat4(
+            glm::vec4(cy * cz, cx * sz + sx * sy * cz, sx * sz - cx * sy * cz, 0.0f) * scaleXYZ.x,
+            glm::vec4(-cy * sz, cx * cz - sx * sy * sz, sx * cz + cx * sy * sz, 0.0f) * scaleXYZ.y,
+            glm::vec4(sy, -sx * cy, cx * cy, 0.0f) * scaleXYZ.z,
+            glm::vec4(positionXYZ, 1.0f));
+    }
+}
+
+/***********************************************************
+ *  AnimationSystem()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+AnimationSystem::AnimationSystem(double stepSeconds)
+    : m_stepSeconds(stepSeconds), m_accumulator(0.0), m_simulationTime(0.0), m_updateTime(0.0) {
+}
+
+/***********************************************************
+ *  AddTransformTrack()
+ *
+ *  This method is used to add a transform track and returns
+ *  its index.  The state starts at the current time, so a
+ *  track added later does not jump.
+ ***********************************************************/
+int AnimationSystem::AddTransformTrack(const std::vector<TRANSFORM_KEY>& keys) {
+    if (keys.empty()) {
+        return -1;
+    }
+
+    m_trackFirstKey.push_back((int)m_keyTimes.size());
+    m_trackKeyCount.push_back((int)keys.size());
+    m_trackCursor.push_back(0);
+    m_trackDuration.push_back(keys.back().time);
+    glm::vec3 loopTurn = keys.back().rotationDegrees - keys[0].rotationDegrees;
+    m_trackLoopTurn.push_back(glm::vec3((float)PositiveDegrees(loopTurn.x),
+        (float)PositiveDegrees(loopTurn.y), (float)PositiveDegrees(loopTurn.z)));
+    for (size_t i = 0; i < keys.size(); i++) {
+        m_keyTimes.push_back(keys[i].time);
+        m_keyScales.push_back(keys[i].scaleXYZ);
+        m_keyRotations.push_back(keys[i].rotationDegrees);
+        m_keyPositions.push_back(keys[i].positionXYZ);
+    }
+
+    m_currentScales.push_back(keys[0].scaleXYZ);
+    m_currentRotations.push_back(keys[0].rotationDegrees);
+    m_currentPositions.push_back(keys[0].positionXYZ);
+
+    // sample the new track at the current time, with no motion to blend yet
+    int track = TransformTrackCount() - 1;
+    EvaluateTransforms(m_simulationTime, track, track + 1);
+    m_previousScales.push_back(m_currentScales[track]);
+    m_previousRotations.push_back(m_currentRotations[track]);
+    m_previousPositions.push_back(m_currentPositions[track]);
+    m_trackMatrices.push_back(ComposeTransform(m_currentScales[track], m_currentRotations[track], m_currentPositions[track]));
+
+    return track;
+}
+
+/***********************************************************
+ *  AddColorTrack()
+ *
+ *  This method is used to add a color track and returns its
+ *  index.
+ ***********************************************************/
+int AnimationSystem::AddColorTrack(const std::vector<COLOR_KEY>& keys) {
+    if (keys.empty()) {
+        return -1;
+    }
+
+    m_colorFirstKey.push_back((int)m_colorKeyTimes.size());
+    m_colorKeyCount.push_back((int)keys.size());
+    m_colorCursor.push_back(0);
+    m_colorDuration.push_back(keys.back().time);
+    for (size_t i = 0; i < keys.size(); i++) {
+        m_colorKeyTimes.push_back(keys[i].time);
+        m_colorKeyValues.push_back(keys[i].color);
+    }
+
+    m_currentColors.push_back(keys[0].color);
+
+    int track = ColorTrackCount() - 1;
+    EvaluateColors(m_simulationTime, track, track + 1);
+    m_previousColors.push_back(m_currentColors[track]);
+    m_trackColors.push_back(m_currentColors[track]);
+
+    return track;
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used to remove every track and key.
+ ***********************************************************/
+void AnimationSystem::Clear() {
+    m_keyTimes.clear();
+    m_keyScales.clear();
+    m_keyRotations.clear();
+    m_keyPositions.clear();
+    m_trackFirstKey.clear();
+    m_trackKeyCount.clear();
+    m_trackCursor.clear();
+    m_trackDuration.clear();
+    m_trackLoopTurn.clear();
+    m_previousScales.clear();
+    m_previousRotations.clear();
+    m_previousPositions.clear();
+    m_currentScales.clear();
+    m_currentRotations.clear();
+    m_currentPositions.clear();
+    m_trackMatrices.clear();
+
+    m_colorKeyTimes.clear();
+    m_colorKeyValues.clear();
+    m_colorFirstKey.clear();
+    m_colorKeyCount.clear();
+    m_colorCursor.clear();
+    m_colorDuration.clear();
+    m_previousColors.clear();
+    m_currentColors.clear();
+    m_trackColors.clear();
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used to advance the simulation.  The frame
+ *  time is added to an accumulator that is spent in fixed
+ *  steps, so the animation is the same at any frame rate,
+ *  and the state rendered is blended between the last two
+ *  steps by the time left over.
+ ***********************************************************/
+int AnimationSystem::Update(double frameSeconds) {
+    double startTime = glfwGetTime();
+
+    m_accumulator += std::min(std::max(frameSeconds, 0.0), MAX_FRAME_SECONDS);
+
+    int steps = 0;
+    while ((m_accumulator >= m_stepSeconds) && (steps < MAX_STEPS_PER_UPDATE)) {
+        m_previousScales.swap(m_currentScales);
+        m_previousRotations.swap(m_currentRotations);
+        m_previousPositions.swap(m_currentPositions);
+        m_previousColors.swap(m_currentColors);
+
+        m_simulationTime += m_stepSeconds;
+        EvaluateTransforms(m_simulationTime, 0, TransformTrackCount());
+        EvaluateColors(m_simulationTime, 0, ColorTrackCount());
+
+        m_accumulator -= m_stepSeconds;
+        steps++;
+    }
+    // drop the time that could not be caught up with
+    if (m_accumulator >= m_stepSeconds) {
+        m_accumulator = std::fmod(m_accumulator, m_stepSeconds);
+    }
+
+    Interpolate((float)(m_accumulator / m_stepSeconds));
+
+    m_updateTime = (glfwGetTime() - startTime) * 1.0e6;
+    return steps;
+}
+
+/***********************************************************
+ *  EvaluateTransforms()
+ *
+ *  This method is used to sample a range of transform
+ *  tracks at the passed in time into the current state.
+ ***********************************************************/
+void AnimationSystem::EvaluateTransforms(double time, int beginTrack, int endTrack) {
+    for (int track = beginTrack; track < endTrack; track++) {
+        int first = m_trackFirstKey[track];
+        int last = first + m_trackKeyCount[track] - 1;
+
+        float blend = 0.0f;
+        double loops = 0.0;
+        FindSegment(&m_keyTimes[first], m_trackKeyCount[track], m_trackDuration[track],
+            m_trackCursor[track], time, blend, loops);
+        int a = first + m_trackCursor[track];
+        int b = std::min(a + 1, last);
+
+        // the turn made over each loop is carried into the next, kept in 0 to 360
+        const glm::vec3& loopTurn = m_trackLoopTurn[track];
+        glm::vec3 rotation = glm::mix(m_keyRotations[a], m_keyRotations[b], blend);
+        for (int axis = 0; axis < 3; axis++) {
+            if (loopTurn[axis] != 0.0f) {
+                rotation[axis] += (float)PositiveDegrees(loops * loopTurn[axis]);
+            }
+            rotation[axis] = (float)PositiveDegrees(rotation[axis]);
+        }
+
+        m_currentScales[track] = glm::mix(m_keyScales[a], m_keyScales[b], blend);
+        m_currentRotations[track] = rotation;
+        m_currentPositions[track] = glm::mix(m_keyPositions[a], m_keyPositions[b], blend);
+    }
+}
+
+/***********************************************************
+ *  EvaluateColors()
+ *
+ *  This method is used to sample a range of color tracks at
+ *  the passed in time into the current state.
+ ***********************************************************/
+void AnimationSystem::EvaluateColors(double time, int beginTrack, int endTrack) {
+    for (int track = beginTrack; track < endTrack; track++) {
+        int first = m_colorFirstKey[track];
+        int last = first + m_colorKeyCount[track] - 1;
+
+        float blend = 0.0f;
+        double loops = 0.0;
+        FindSegment(&m_colorKeyTimes[first], m_colorKeyCount[track], m_colorDuration[track],
+            m_colorCursor[track], time, blend, loops);
+        int a = first + m_colorCursor[track];
+        int b = std::min(a + 1, last);
+
+        m_currentColors[track] = glm::mix(m_colorKeyValues[a], m_colorKeyValues[b], blend);
+    }
+}
+
+/***********************************************************
+ *  Interpolate()
+ *
+ *  This method is used to blend the previous and the current
+ *  step into the state that is rendered.  Rotations blend
+ *  the short way around, since they are kept in 0 to 360.
+ ***********************************************************/
+void AnimationSystem::Interpolate(float alpha) {
+    int trackCount = TransformTrackCount();
+    for (int track = 0; track < trackCount; track++) {
+        glm::vec3 turn = m_currentRotations[track] - m_previousRotations[track];
+        turn = glm::vec3(WrapDegrees(turn.x), WrapDegrees(turn.y), WrapDegrees(turn.z));
+
+        m_trackMatrices[track] = ComposeTransform(
+            glm::mix(m_previousScales[track], m_currentScales[track], alpha),
+            m_previousRotations[track] + turn * alpha,
+            glm::mix(m_previousPositions[track], m_currentPositions[track], alpha));
+    }
+
+    int colorCount = ColorTrackCount();
+    for (int track = 0; track < colorCount; track++) {
+        m_trackColors[track] = glm::mix(m_previousColors[track], m_currentColors[track], alpha);
+    }
+}
@@ -0,0 +1,102 @@
+///////////////////////////////////////////////////////////////////////////////
+// animationsystem.h
+// ============
+// evaluate keyframed transform and color tracks at a fixed simulation rate
+// and interpolate between the last two steps for rendering
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+
+class AnimationSystem {
+public:
+    // Struct to hold one transform keyframe, in the same terms as the
+    // scene object placement: scale, then X, Y, Z rotation, then position
+    struct TRANSFORM_KEY {
+        float time;
+        glm::vec3 scaleXYZ;
+        glm::vec3 rotationDegrees;
+        glm::vec3 positionXYZ;
+    };
+
+    // Struct to hold one color keyframe
+    struct COLOR_KEY {
+        float time;
+        glm::vec3 color;
+    };
+
+    // constructor
+    AnimationSystem(double stepSeconds = 1.0 / 60.0);
+
+    // add a track that loops over the time of its last key; the keys must
+    // be sorted by time.  Rotation keeps turning from loop to loop, so a
+    // track that ends a full turn after it starts spins without a jump,
+    // while positions, scales and colors should end where they start
+    int AddTransformTrack(const std::vector<TRANSFORM_KEY>& keys);
+    int AddColorTrack(const std::vector<COLOR_KEY>& keys);
+    // remove every track
+    void Clear();
+
+    // advance the simulation by the frame time in fixed steps and build the
+    // interpolated track state for rendering; returns the steps taken
+    int Update(double frameSeconds);
+
+    // get the interpolated state of a track from the last update
+    const glm::mat4& TrackMatrix(int track) const { return m_trackMatrices[track]; }
+    const glm::vec3& TrackColor(int track) const { return m_trackColors[track]; }
+
+    int TransformTrackCount() const { return (int)m_trackFirstKey.size(); }
+    int ColorTrackCount() const { return (int)m_colorFirstKey.size(); }
+    double SimulationTime() const { return m_simulationTime; }
+    // get the microseconds spent in the last update
+    double UpdateTime() const { return m_updateTime; }
+
+private:
+    // steps taken per update at most, so a long frame cannot snowball
+    static const int MAX_STEPS_PER_UPDATE = 5;
+
+    double m_stepSeconds;
+    double m_accumulator;
+    double m_simulationTime;
+    double m_updateTime;
+
+    // transform keys of every track, one array per component
+    std::vector<float> m_keyTimes;
+    std::vector<glm::vec3> m_keyScales;
+    std::vector<glm::vec3> m_keyRotations;
+    std::vector<glm::vec3> m_keyPositions;
+    // key range, loop length, last used key and rotation made per loop,
+    // in 0 to 360, of every transform track
+    std::vector<int> m_trackFirstKey;
+    std::vector<int> m_trackKeyCount;
+    std::vector<int> m_trackCursor;
+    std::vector<float> m_trackDuration;
+    std::vector<glm::vec3> m_trackLoopTurn;
+    // transform state of the previous and the current step
+    std::vector<glm::vec3> m_previousScales;
+    std::vector<glm::vec3> m_previousRotations;
+    std::vector<glm::vec3> m_previousPositions;
+    std::vector<glm::vec3> m_currentScales;
+    std::vector<glm::vec3> m_currentRotations;
+    std::vector<glm::vec3> m_currentPositions;
+    std::vector<glm::mat4> m_trackMatrices;
+
+    // color keys and tracks, stored the same way
+    std::vector<float> m_colorKeyTimes;
+    std::vector<glm::vec3> m_colorKeyValues;
+    std::vector<int> m_colorFirstKey;
+    std::vector<int> m_colorKeyCount;
+    std::vector<int> m_colorCursor;
+    std::vector<float> m_colorDuration;
+    std::vector<glm::vec3> m_previousColors;
+    std::vector<glm::vec3> m_currentColors;
+    std::vector<glm::vec3> m_trackColors;
+
+    void EvaluateTransforms(double time, int beginTrack, int endTrack);
+    void EvaluateColors(double time, int beginTrack, int endTrack);
+    void Interpolate(float alpha);
+};
@@ -0,0 +1,325 @@
+///////////////////////////////////////////////////////////////////////////////
+// clusteredlighting.cpp
+// ============
+// bin point lights into view space clusters so that each fragment only
+// loops over the lights that can reach it
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ClusteredLighting.h"
+#include "ResourceTracker.h"
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+
+// declaration of the global variables and defines
+namespace {
+    // shader storage buffer binding points shared with the fragment shader
+    const GLuint POINT_LIGHT_BINDING = 0;
+    const GLuint CLUSTER_BINDING = 1;
+    const GLuint LIGHT_INDEX_BINDING = 2;
+
+    /***********************************************************
+     *  UploadBuffer()
+     *
+     *  Replaces the contents of a shader storage buffer,
+     *  orphaning the old storage so the GPU never blocks us.
+     ***********************************************************/
+    void UploadBuffer(GLuint buffer, const void* data, size_t bytes) {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+        // zero sized buffers cannot be bound, so always keep a few bytes
+        size_t size = std::max(bytes, (size_t)16);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, size, nullptr, GL_STREAM_DRAW);
+        ResourceTracker::TrackBuffer(buffer, size, "clustered lights");
+        if (bytes > 0) {
+            glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, bytes, data);
+        }
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+}
+
+/***********************************************************
+ *  ClusteredLighting()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ClusteredLighting::ClusteredLighting()
+    : m_clusterProjection(0.0f), m_nearPlane(0.0f), m_farPlane(0.0f),
+    m_lightBuffer(0), m_clusterBuffer(0), m_indexBuffer(0),
+    m_tileSize(1.0f), m_viewportOrigin(0.0f), m_binningTime(0.0) {
+    m_clusterMin.resize(CLUSTER_COUNT);
+    m_clusterMax.resize(CLUSTER_COUNT);
+    m_clusterRecords.resize(CLUSTER_COUNT * 2);
+    m_clusterCounts.resize(CLUSTER_COUNT);
+}
+
+/***********************************************************
+ *  ~ClusteredLighting()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ClusteredLighting::~ClusteredLighting() {
+    if (m_lightBuffer != 0) {
+        ResourceTracker::Release(ResourceTracker::CATEGORY_BUFFER, m_lightBuffer);
+        glDeleteBuffers(1, &m_lightBuffer);
+    }
+    if (m_clusterBuffer != 0) {
+        ResourceTracker::Release(ResourceTracker::CATEGORY_BUFFER, m_clusterBuffer);
+        glDeleteBuffers(1, &m_clusterBuffer);
+    }
+    if (m_indexBuffer != 0) {
+        ResourceTracker::Release(ResourceTracker::CATEGORY_BUFFER, m_indexBuffer);
+        glDeleteBuffers(1, &m_indexBuffer);
+    }
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used to create the shader storage buffers
+ *  for the lights, the cluster records and the index list.
+ ***********************************************************/
+bool ClusteredLighting::Initialize() {
+    glGenBuffers(1, &m_lightBuffer);
+    glGenBuffers(1, &m_clusterBuffer);
+    glGenBuffers(1, &m_indexBuffer);
+
+    return (m_lightBuffer != 0) && (m_clusterBuffer != 0) && (m_indexBuffer != 0);
+}
+
+/***********************************************************
+ *  ClearLights()
+ *
+ *  This method is used to remove every point light.
+ ***********************************************************/
+void ClusteredLighting::ClearLights() {
+    m_lights.clear();
+}
+
+/***********************************************************
+ *  AddLight()
+ *
+ *  This method is used to add a point light.  The radius is
+ *  the distance at which its contribution falls to zero.
+ ***********************************************************/
+void ClusteredLighting::AddLight(const glm::vec3& position, float radius, const glm::vec3& color, float intensity) {
+    POINT_LIGHT light;
+    light.positionRadius = glm::vec4(position, radius);
+    light.colorIntensity = glm::vec4(color, intensity);
+    m_lights.push_back(light);
+}
+
+/***********************************************************
+ *  SetLightPosition()
+ *
+ *  This method is used to move a point light.  The light is
+ *  binned at its new position in the next update.
+ ***********************************************************/
+void ClusteredLighting::SetLightPosition(int index, const glm::vec3& position) {
+    if ((index < 0) || (index >= (int)m_lights.size())) {
+        return;
+    }
+
+    m_lights[index].positionRadius = glm::vec4(position, m_lights[index].positionRadius.w);
+}
+
+/***********************************************************
+ *  SliceDepth()
+ *
+ *  This method returns the view depth where a slice starts.
+ *  Slices grow exponentially so clusters stay roughly cube
+ *  shaped from the near plane out to the far plane.
+ ***********************************************************/
+float ClusteredLighting::SliceDepth(int slice) const {
+    return m_nearPlane * pow(m_farPlane / m_nearPlane, (float)slice / (float)GRID_Z);
+}
+
+/***********************************************************
+ *  DepthToSlice()
+ *
+ *  This method returns the slice holding a view depth, using
+ *  the same formula as the fragment shader.
+ ***********************************************************/
+int ClusteredLighting::DepthToSlice(float depth) const {
+    float slice = log(depth / m_nearPlane) / log(m_farPlane / m_nearPlane) * GRID_Z;
+    return glm::clamp((int)floor(slice), 0, GRID_Z - 1);
+}
+
+/***********************************************************
+ *  BuildClusterBounds()
+ *
+ *  This method is used to compute the view space box of each
+ *  cluster by unprojecting the corners of its screen tile and
+ *  cutting the corner rays at the depths of its slice.  This
+ *  works for both the perspective and orthographic cameras.
+ ***********************************************************/
+void ClusteredLighting::BuildClusterBounds(const glm::mat4& projection, float nearPlane, float farPlane) {
+    m_clusterProjection = projection;
+    m_nearPlane = nearPlane;
+    m_farPlane = farPlane;
+
+    glm::mat4 inverseProjection = glm::inverse(projection);
+
+    for (int y = 0; y < GRID_Y; y++) {
+        for (int x = 0; x < GRID_X; x++) {
+            // rays through the four tile corners, from the near to the far plane
+            glm::vec3 rayNear[4];
+            glm::vec3 rayFar[4];
+            for (int corner = 0; corner < 4; corner++) {
+                float ndcX = -1.0f + 2.0f * (float)(x + (corner & 1)) / GRID_X;
+                float ndcY = -1.0f + 2.0f * (float)(y + ((corner >> 1) & 1)) / GRID_Y;
+                glm::vec4 nearPoint = inverseProjection * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+                glm::vec4 farPoint = inverseProjection * glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+                rayNear[corner] = glm::vec3(nearPoint) / nearPoint.w;
+                rayFar[corner] = glm::vec3(farPoint) / farPoint.w;
+            }
+
+            for (int z = 0; z < GRID_Z; z++) {
+                float depths[2] = { SliceDepth(z), SliceDepth(z + 1) };
+                glm::vec3 boxMin(FLT_MAX);
+                glm::vec3 boxMax(-FLT_MAX);
+
+                for (int corner = 0; corner < 4; corner++) {
+                    glm::vec3 direction = rayFar[corner] - rayNear[corner];
+                    for (int d = 0; d < 2; d++) {
+                        // the camera looks down -Z, so depth d is the plane z = -d
+                        float t = (-depths[d] - rayNear[corner].z) / direction.z;
+                        glm::vec3 point = rayNear[corner] + direction * t;
+                        boxMin = glm::min(boxMin, point);
+                        boxMax = glm::max(boxMax, point);
+                    }
+                }
+
+                int index = ClusterIndex(x, y, z);
+                m_clusterMin[index] = boxMin;
+                m_clusterMax[index] = boxMax;
+            }
+        }
+    }
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used to bin every light into the clusters
+ *  it can reach.  Each light is first bounded to a range of
+ *  tiles and slices, then tested against the box of each
+ *  cluster in that range.  The assignments are counting
+ *  sorted into one contiguous index list for the GPU.  The
+ *  tiles are counted from the viewport origin, so a viewport
+ *  anywhere in the target finds its own clusters.
+ ***********************************************************/
+void ClusteredLighting::Update(const glm::mat4& view, const glm::mat4& projection,
+    int viewportX, int viewportY, int viewportWidth, int viewportHeight, float nearPlane, float farPlane) {
+    double startTime = glfwGetTime();
+
+    if ((projection != m_clusterProjection) || (nearPlane != m_nearPlane) || (farPlane != m_farPlane)) {
+        BuildClusterBounds(projection, nearPlane, farPlane);
+    }
+    m_tileSize = glm::vec2((float)viewportWidth / GRID_X, (float)viewportHeight / GRID_Y);
+    m_viewportOrigin = glm::vec2((float)viewportX, (float)viewportY);
+
+    m_assignments.clear();
+    std::fill(m_clusterCounts.begin(), m_clusterCounts.end(), 0u);
+
+    for (size_t lightIndex = 0; lightIndex < m_lights.size(); lightIndex++) {
+        const POINT_LIGHT& light = m_lights[lightIndex];
+        float radius = light.positionRadius.w;
+        glm::vec3 center = glm::vec3(view * glm::vec4(glm::vec3(light.positionRadius), 1.0f));
+
+        float depthMin = -center.z - radius;
+        float depthMax = -center.z + radius;
+        if ((depthMax < nearPlane) || (depthMin > farPlane)) {
+            continue;
+        }
+
+        int sliceFirst = DepthToSlice(glm::max(depthMin, nearPlane));
+        int sliceLast = DepthToSlice(glm::min(depthMax, farPlane));
+
+        // bound the tiles by projecting the light box, unless it crosses the near plane
+        int tileFirstX = 0;
+        int tileLastX = GRID_X - 1;
+        int tileFirstY = 0;
+        int tileLastY = GRID_Y - 1;
+        if (depthMin > nearPlane) {
+            glm::vec2 ndcMin(FLT_MAX);
+            glm::vec2 ndcMax(-FLT_MAX);
+            for (int corner = 0; corner < 8; corner++) {
+                glm::vec3 offset(
+                    (corner & 1) ? radius : -radius,
+                    (corner & 2) ? radius : -radius,
+                    (corner & 4) ? radius : -radius);
+                glm::vec4 clip = projection * glm::vec4(center + offset, 1.0f);
+                glm::vec2 ndc = glm::vec2(clip.x, clip.y) / clip.w;
+                ndcMin = glm::min(ndcMin, ndc);
+                ndcMax = glm::max(ndcMax, ndc);
+            }
+            if ((ndcMax.x < -1.0f) || (ndcMin.x > 1.0f) || (ndcMax.y < -1.0f) || (ndcMin.y > 1.0f)) {
+                continue;
+            }
+            tileFirstX = glm::clamp((int)floor((ndcMin.x * 0.5f + 0.5f) * GRID_X), 0, GRID_X - 1);
+            tileLastX = glm::clamp((int)floor((ndcMax.x * 0.5f + 0.5f) * GRID_X), 0, GRID_X - 1);
+            tileFirstY = glm::clamp((int)floor((ndcMin.y * 0.5f + 0.5f) * GRID_Y), 0, GRID_Y - 1);
+            tileLastY = glm::clamp((int)floor((ndcMax.y * 0.5f + 0.5f) * GRID_Y), 0, GRID_Y - 1);
+        }
+
+        float radiusSquared = radius * radius;
+        for (int z = sliceFirst; z <= sliceLast; z++) {
+            for (int y = tileFirstY; y <= tileLastY; y++) {
+                for (int x = tileFirstX; x <= tileLastX; x++) {
+                    int cluster = ClusterIndex(x, y, z);
+
+                    // distance from the light to the closest point of the cluster box
+                    glm::vec3 closest = glm::clamp(center, m_clusterMin[cluster], m_clusterMax[cluster]);
+                    glm::vec3 delta = closest - center;
+                    if (glm::dot(delta, delta) <= radiusSquared) {
+                        m_assignments.push_back(glm::ivec2(cluster, (int)lightIndex));
+                        m_clusterCounts[cluster]++;
+                    }
+                }
+            }
+        }
+    }
+
+    // counting sort the assignments into per cluster ranges
+    unsigned int offset = 0;
+    for (int cluster = 0; cluster < CLUSTER_COUNT; cluster++) {
+        m_clusterRecords[cluster * 2] = offset;
+        m_clusterRecords[cluster * 2 + 1] = 0;
+        offset += m_clusterCounts[cluster];
+    }
+    m_lightIndices.resize(m_assignments.size());
+    for (size_t i = 0; i < m_assignments.size(); i++) {
+        int cluster = m_assignments[i].x;
+        unsigned int& count = m_clusterRecords[cluster * 2 + 1];
+        m_lightIndices[m_clusterRecords[cluster * 2] + count] = (unsigned int)m_assignments[i].y;
+        count++;
+    }
+
+    UploadBuffer(m_lightBuffer, m_lights.data(), m_lights.size() * sizeof(POINT_LIGHT));
+    UploadBuffer(m_clusterBuffer, m_clusterRecords.data(), m_clusterRecords.size() * sizeof(unsigned int));
+    UploadBuffer(m_indexBuffer, m_lightIndices.data(), m_lightIndices.size() * sizeof(unsigned int));
+
+    m_binningTime = (glfwGetTime() - startTime) * 1000.0;
+}
+
+/***********************************************************
+ *  Apply()
+ *
+ *  This method is used to bind the storage buffers and pass
+ *  the grid parameters the fragment shader needs to find the
+ *  cluster of a fragment.
+ ***********************************************************/
+void ClusteredLighting::Apply(ShaderManager* pShaderManager) const {
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, POINT_LIGHT_BINDING, m_lightBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CLUSTER_BINDING, m_clusterBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LIGHT_INDEX_BINDING, m_indexBuffer);
+
+    pShaderManager->setVec3Value("clusterGrid", glm::vec3((float)GRID_X, (float)GRID_Y, (float)GRID_Z));
+    pShaderManager->setVec2Value("clusterTileSize", m_tileSize);
+    pShaderManager->setVec2Value("clusterViewportOrigin", m_viewportOrigin);
+    pShaderManager->setFloatValue("clusterNearPlane", m_nearPlane);
+    pShaderManager->setFloatValue("clusterFarPlane", m_farPlane);
+}
@@ -0,0 +1,86 @@
+///////////////////////////////////////////////////////////////////////////////
+// clusteredlighting.h
+// ============
+// bin point lights into view space clusters so that each fragment only
+// loops over the lights that can reach it
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+class ClusteredLighting {
+public:
+    // Struct to hold a point light, laid out to match the shader buffer
+    struct POINT_LIGHT {
+        glm::vec4 positionRadius;    // world position and range
+        glm::vec4 colorIntensity;    // color and intensity
+    };
+
+    // constructor
+    ClusteredLighting();
+    // destructor
+    ~ClusteredLighting();
+
+    // create the shader storage buffers
+    bool Initialize();
+
+    // manage the point lights
+    void ClearLights();
+    void AddLight(const glm::vec3& position, float radius, const glm::vec3& color, float intensity);
+    void SetLightPosition(int index, const glm::vec3& position);
+    glm::vec3 LightPosition(int index) const { return glm::vec3(m_lights[index].positionRadius); }
+    int LightCount() const { return (int)m_lights.size(); }
+
+    // bin the lights for the passed in camera and viewport and upload the results
+    void Update(const glm::mat4& view, const glm::mat4& projection,
+        int viewportX, int viewportY, int viewportWidth, int viewportHeight, float nearPlane, float farPlane);
+
+    // bind the buffers and pass the cluster grid parameters into the shader
+    void Apply(ShaderManager* pShaderManager) const;
+
+    // get the milliseconds spent binning in the last update
+    double BinningTime() const { return m_binningTime; }
+    // get the number of light to cluster assignments in the last update
+    int AssignmentCount() const { return (int)m_lightIndices.size(); }
+
+private:
+    // dimensions of the cluster grid, the slices are exponential in depth
+    static const int GRID_X = 16;
+    static const int GRID_Y = 9;
+    static const int GRID_Z = 24;
+    static const int CLUSTER_COUNT = GRID_X * GRID_Y * GRID_Z;
+
+    std::vector<POINT_LIGHT> m_lights;
+
+    // view space bounds of every cluster, rebuilt when the projection changes
+    std::vector<glm::vec3> m_clusterMin;
+    std::vector<glm::vec3> m_clusterMax;
+    glm::mat4 m_clusterProjection;
+    float m_nearPlane;
+    float m_farPlane;
+
+    // binning results: (offset, count) per cluster and the light index list
+    std::vector<unsigned int> m_clusterRecords;
+    std::vector<unsigned int> m_lightIndices;
+    std::vector<unsigned int> m_clusterCounts;
+    std::vector<glm::ivec2> m_assignments;
+
+    GLuint m_lightBuffer;
+    GLuint m_clusterBuffer;
+    GLuint m_indexBuffer;
+
+    glm::vec2 m_tileSize;
+    glm::vec2 m_viewportOrigin;       // Lower left pixel of the binned viewport
+    double m_binningTime;
+
+    void BuildClusterBounds(const glm::mat4& projection, float nearPlane, float farPlane);
+    float SliceDepth(int slice) const;
+    int DepthToSlice(float depth) const;
+    int ClusterIndex(int x, int y, int z) const { return (z * GRID_Y + y) * GRID_X + x; }
+};
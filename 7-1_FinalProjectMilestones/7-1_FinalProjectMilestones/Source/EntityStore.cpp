@@ -0,0 +1,216 @@
+///////////////////////////////////////////////////////////////////////////////
+// entitystore.cpp
+// ============
+// keep the per-frame data of the scene entities in contiguous arrays, one
+// per component, addressed through stable handles
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "EntityStore.h"
+
+/***********************************************************
+ *  EntityStore()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+EntityStore::EntityStore() {
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used to add an entity with every component
+ *  at its default and return its handle.  Slots freed by
+ *  removed entities are used again with a new generation.
+ ***********************************************************/
+EntityStore::HANDLE EntityStore::Create() {
+    unsigned int slot = 0;
+    if (!m_freeSlots.empty()) {
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    }
+    else {
+        slot = (unsigned int)m_slotIndices.size();
+        m_slotIndices.push_back(0);
+        m_slotGenerations.push_back(0);
+    }
+    m_slotIndices[slot] = (unsigned int)m_slots.size();
+
+    m_modelMatrices.push_back(glm::mat4(1.0f));
+    m_restMatrices.push_back(glm::mat4(1.0f));
+    m_boundsMin.push_back(glm::vec3(0.0f));
+    m_boundsMax.push_back(glm::vec3(0.0f));
+    m_restBoundsMin.push_back(glm::vec3(0.0f));
+    m_restBoundsMax.push_back(glm::vec3(0.0f));
+    m_meshIds.push_back(-1);
+    m_meshResources.push_back(-1);
+    m_materialIds.push_back(-1);
+    m_flags.push_back(0);
+    m_parentTracks.push_back(-1);
+    m_localTracks.push_back(-1);
+    m_slots.push_back(slot);
+
+    HANDLE handle;
+    handle.slot = slot;
+    handle.generation = m_slotGenerations[slot];
+    return handle;
+}
+
+/***********************************************************
+ *  Remove()
+ *
+ *  This method is used to remove an entity.  The last entity
+ *  is moved into the hole so the arrays stay packed, and the
+ *  slot of the removed entity gets a new generation so that
+ *  its old handles no longer resolve.
+ ***********************************************************/
+void EntityStore::Remove(HANDLE handle) {
+    int index = IndexOf(handle);
+    if (index < 0) {
+        return;
+    }
+
+    int last = Count() - 1;
+    if (index != last) {
+        m_modelMatrices[index] = m_modelMatrices[last];
+        m_restMatrices[index] = m_restMatrices[last];
+        m_boundsMin[index] = m_boundsMin[last];
+        m_boundsMax[index] = m_boundsMax[last];
+        m_restBoundsMin[index] = m_restBoundsMin[last];
+        m_restBoundsMax[index] = m_restBoundsMax[last];
+        m_meshIds[index] = m_meshIds[last];
+        m_meshResources[index] = m_meshResources[last];
+        m_materialIds[index] = m_materialIds[last];
+        m_flags[index] = m_flags[last];
+        m_parentTracks[index] = m_parentTracks[last];
+        m_localTracks[index] = m_localTracks[last];
+        m_slots[index] = m_slots[last];
+        m_slotIndices[m_slots[index]] = (unsigned int)index;
+    }
+
+    m_modelMatrices.pop_back();
+    m_restMatrices.pop_back();
+    m_boundsMin.pop_back();
+    m_boundsMax.pop_back();
+    m_restBoundsMin.pop_back();
+    m_restBoundsMax.pop_back();
+    m_meshIds.pop_back();
+    m_meshResources.pop_back();
+    m_materialIds.pop_back();
+    m_flags.pop_back();
+    m_parentTracks.pop_back();
+    m_localTracks.pop_back();
+    m_slots.pop_back();
+
+    m_slotGenerations[handle.slot]++;
+    m_freeSlots.push_back(handle.slot);
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used to remove every entity.  The slots
+ *  are kept for reuse, each with a new generation.
+ ***********************************************************/
+void EntityStore::Clear() {
+    for (size_t i = 0; i < m_slots.size(); i++) {
+        m_slotGenerations[m_slots[i]]++;
+        m_freeSlots.push_back(m_slots[i]);
+    }
+
+    m_modelMatrices.clear();
+    m_restMatrices.clear();
+    m_boundsMin.clear();
+    m_boundsMax.clear();
+    m_restBoundsMin.clear();
+    m_restBoundsMax.clear();
+    m_meshIds.clear();
+    m_meshResources.clear();
+    m_materialIds.clear();
+    m_flags.clear();
+    m_parentTracks.clear();
+    m_localTracks.clear();
+    m_slots.clear();
+}
+
+/***********************************************************
+ *  Reserve()
+ *
+ *  This method is used to allocate every component array for
+ *  the passed in number of entities up front.
+ ***********************************************************/
+void EntityStore::Reserve(int count) {
+    m_modelMatrices.reserve(count);
+    m_restMatrices.reserve(count);
+    m_boundsMin.reserve(count);
+    m_boundsMax.reserve(count);
+    m_restBoundsMin.reserve(count);
+    m_restBoundsMax.reserve(count);
+    m_meshIds.reserve(count);
+    m_meshResources.reserve(count);
+    m_materialIds.reserve(count);
+    m_flags.reserve(count);
+    m_parentTracks.reserve(count);
+    m_localTracks.reserve(count);
+    m_slots.reserve(count);
+    m_slotIndices.reserve(count);
+    m_slotGenerations.reserve(count);
+}
+
+/***********************************************************
+ *  HostBytes()
+ *
+ *  This method returns the bytes allocated by the component
+ *  and handle arrays, including their unused capacity.
+ ***********************************************************/
+size_t EntityStore::HostBytes() const {
+    return m_modelMatrices.capacity() * sizeof(glm::mat4) +
+        m_restMatrices.capacity() * sizeof(glm::mat4) +
+        (m_boundsMin.capacity() + m_boundsMax.capacity() +
+            m_restBoundsMin.capacity() + m_restBoundsMax.capacity()) * sizeof(glm::vec3) +
+        (m_meshIds.capacity() + m_meshResources.capacity() + m_materialIds.capacity() +
+            m_parentTracks.capacity() + m_localTracks.capacity()) * sizeof(int) +
+        (m_flags.capacity() + m_slots.capacity() + m_slotIndices.capacity() +
+            m_slotGenerations.capacity() + m_freeSlots.capacity()) * sizeof(unsigned int);
+}
+
+/***********************************************************
+ *  IsValid()
+ *
+ *  This method returns true while the entity of the passed
+ *  in handle has not been removed.
+ ***********************************************************/
+bool EntityStore::IsValid(HANDLE handle) const {
+    return (handle.slot < m_slotGenerations.size()) &&
+        (m_slotGenerations[handle.slot] == handle.generation) &&
+        (m_slotIndices[handle.slot] < m_slots.size()) &&
+        (m_slots[m_slotIndices[handle.slot]] == handle.slot);
+}
+
+/***********************************************************
+ *  IndexOf()
+ *
+ *  This method returns the array index of the entity of the
+ *  passed in handle, or -1 once it has been removed.
+ ***********************************************************/
+int EntityStore::IndexOf(HANDLE handle) const {
+    if (!IsValid(handle)) {
+        return -1;
+    }
+
+    return (int)m_slotIndices[handle.slot];
+}
+
+/***********************************************************
+ *  HandleAt()
+ *
+ *  This method returns the handle of the entity at the
+ *  passed in array index.
+ ***********************************************************/
+EntityStore::HANDLE EntityStore::HandleAt(int index) const {
+    HANDLE handle;
+    handle.slot = m_slots[index];
+    handle.generation = m_slotGenerations[handle.slot];
+    return handle;
+}
@@ -0,0 +1,100 @@
+///////////////////////////////////////////////////////////////////////////////
+// entitystore.h
+// ============
+// keep the per-frame data of the scene entities in contiguous arrays, one
+// per component, addressed through stable handles
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+
+class EntityStore {
+public:
+    // Struct to hold a handle to an entity; it stays valid while the entity
+    // lives, no matter how the arrays are reordered by removals
+    struct HANDLE {
+        unsigned int slot = 0xFFFFFFFFu;
+        unsigned int generation = 0;
+    };
+
+    // Enum for the bits of the entity flags
+    enum FLAG {
+        FLAG_CASTS_SHADOW = 1,    // Drawn into the shadow map
+        FLAG_DYNAMIC = 2,         // Kept out of the baked static batches
+        FLAG_LIT = 4,             // Shaded by the lights
+        FLAG_TRANSLUCENT = 8      // Drawn after the opaque objects with blending
+    };
+
+    // constructor
+    EntityStore();
+
+    // add an entity at the end of the arrays and return its handle
+    HANDLE Create();
+    // remove an entity by moving the last entity into its place
+    void Remove(HANDLE handle);
+    // remove every entity, the handles given out so far become invalid
+    void Clear();
+    // reserve room for the passed in number of entities
+    void Reserve(int count);
+
+    bool IsValid(HANDLE handle) const;
+    // get the array index of a live entity, or -1
+    int IndexOf(HANDLE handle) const;
+    HANDLE HandleAt(int index) const;
+    int Count() const { return (int)m_slots.size(); }
+    // get the bytes allocated by the arrays
+    size_t HostBytes() const;
+
+    // component arrays, each Count() long and indexed alike; the pointers
+    // are only good until the next entity is created or removed
+    glm::mat4* ModelMatrices() { return m_modelMatrices.data(); }
+    glm::mat4* RestMatrices() { return m_restMatrices.data(); }
+    glm::vec3* BoundsMin() { return m_boundsMin.data(); }
+    glm::vec3* BoundsMax() { return m_boundsMax.data(); }
+    glm::vec3* RestBoundsMin() { return m_restBoundsMin.data(); }
+    glm::vec3* RestBoundsMax() { return m_restBoundsMax.data(); }
+    int* MeshIds() { return m_meshIds.data(); }
+    int* MeshResources() { return m_meshResources.data(); }
+    int* MaterialIds() { return m_materialIds.data(); }
+    unsigned int* Flags() { return m_flags.data(); }
+    int* ParentTracks() { return m_parentTracks.data(); }
+    int* LocalTracks() { return m_localTracks.data(); }
+
+    const glm::mat4* ModelMatrices() const { return m_modelMatrices.data(); }
+    const glm::mat4* RestMatrices() const { return m_restMatrices.data(); }
+    const glm::vec3* BoundsMin() const { return m_boundsMin.data(); }
+    const glm::vec3* BoundsMax() const { return m_boundsMax.data(); }
+    const glm::vec3* RestBoundsMin() const { return m_restBoundsMin.data(); }
+    const glm::vec3* RestBoundsMax() const { return m_restBoundsMax.data(); }
+    const int* MeshIds() const { return m_meshIds.data(); }
+    const int* MeshResources() const { return m_meshResources.data(); }
+    const int* MaterialIds() const { return m_materialIds.data(); }
+    const unsigned int* Flags() const { return m_flags.data(); }
+    const int* ParentTracks() const { return m_parentTracks.data(); }
+    const int* LocalTracks() const { return m_localTracks.data(); }
+
+private:
+    // per entity components
+    std::vector<glm::mat4> m_modelMatrices;   // Current model matrix
+    std::vector<glm::mat4> m_restMatrices;    // Model matrix before animation
+    std::vector<glm::vec3> m_boundsMin;       // Current world space bounds
+    std::vector<glm::vec3> m_boundsMax;
+    std::vector<glm::vec3> m_restBoundsMin;   // Bounds before animation
+    std::vector<glm::vec3> m_restBoundsMax;
+    std::vector<int> m_meshIds;               // Mesh drawn
+    std::vector<int> m_meshResources;         // Batch or model of the mesh, or -1
+    std::vector<int> m_materialIds;           // Texture or color drawn with
+    std::vector<unsigned int> m_flags;        // FLAG bits
+    std::vector<int> m_parentTracks;          // Animation track moving the entity, or -1
+    std::vector<int> m_localTracks;           // Animation track in object space, or -1
+    std::vector<unsigned int> m_slots;        // Handle slot of each entity
+
+    // handle slots, each pointing at its entity while the slot is in use
+    std::vector<unsigned int> m_slotIndices;
+    std::vector<unsigned int> m_slotGenerations;
+    std::vector<unsigned int> m_freeSlots;
+};
@@ -0,0 +1,435 @@
+///////////////////////////////////////////////////////////////////////////////
+// framecapture.cpp
+// ============
+// record the rendered frames by reading them back through a ring of pixel
+// buffers and writing them out on a background thread
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FrameCapture.h"
+#include "ResourceTracker.h"
+#include <GLFW/glfw3.h>
+#include <iostream>
+#include <cstring>
+
+// declaration of the global variables and defines
+namespace {
+    // bytes per captured pixel, read back as RGBA so rows stay aligned
+    const int CAPTURE_PIXEL_BYTES = 4;
+
+    /***********************************************************
+     *  OpenPipe()
+     *
+     *  Starts the passed in command with its standard input
+     *  connected to the returned stream.
+     ***********************************************************/
+    FILE* OpenPipe(const std::string& command) {
+#ifdef _WIN32
+        return _popen(command.c_str(), "wb");
+#else
+        return popen(command.c_str(), "w");
+#endif
+    }
+
+    /***********************************************************
+     *  ClosePipe()
+     *
+     *  Closes the stream and waits for the command to exit.
+     ***********************************************************/
+    void ClosePipe(FILE* pPipe) {
+#ifdef _WIN32
+        _pclose(pPipe);
+#else
+        pclose(pPipe);
+#endif
+    }
+}
+
+/***********************************************************
+ *  FrameCapture()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FrameCapture::FrameCapture(FrameStats* pFrameStats)
+    : m_pFrameStats(pFrameStats), m_bCapturing(false), m_nextSlot(0), m_pendingSlots(0),
+    m_width(0), m_height(0), m_pPipe(nullptr), m_bStopWriter(false), m_bWriteFailed(false),
+    m_capturedFrames(0), m_writtenFrames(0), m_droppedFrames(0), m_startTime(0.0) {
+    for (int i = 0; i < PBO_RING_SIZE; i++) {
+        m_pixelBuffers[i] = 0;
+        m_fences[i] = 0;
+        m_slotFrames[i] = 0;
+    }
+}
+
+/***********************************************************
+ *  ~FrameCapture()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FrameCapture::~FrameCapture() {
+    Stop();
+}
+
+/***********************************************************
+ *  StartImageSequence()
+ *
+ *  This method is used to start capturing into a numbered
+ *  sequence of PPM images beginning with the path prefix.
+ ***********************************************************/
+bool FrameCapture::StartImageSequence(const std::string& pathPrefix) {
+    if (m_bCapturing) {
+        return false;
+    }
+
+    m_pathPrefix = pathPrefix;
+    m_pPipe = nullptr;
+    if (!Start()) {
+        return false;
+    }
+
+    std::cout << "INFO: Capturing frames to " << pathPrefix << "######.ppm" << std::endl;
+    return true;
+}
+
+/***********************************************************
+ *  StartPipe()
+ *
+ *  This method is used to start capturing into the standard
+ *  input of an encoder process.  The frames are written as
+ *  raw top-down RGBA at the window size, for example for
+ *  ffmpeg -f rawvideo -pix_fmt rgba -s <width>x<height> -i -
+ ***********************************************************/
+bool FrameCapture::StartPipe(const std::string& command) {
+    if (m_bCapturing) {
+        return false;
+    }
+
+    m_pathPrefix.clear();
+    m_pPipe = OpenPipe(command);
+    if (m_pPipe == nullptr) {
+        std::cout << "Error: Could not start the capture command: " << command << std::endl;
+        return false;
+    }
+    if (!Start()) {
+        ClosePipe(m_pPipe);
+        m_pPipe = nullptr;
+        return false;
+    }
+
+    std::cout << "INFO: Capturing frames into: " << command << std::endl;
+    return true;
+}
+
+/***********************************************************
+ *  Start()
+ *
+ *  This method is used to reset the counters and start the
+ *  writer thread.  The pixel buffers are allocated by the
+ *  first captured frame, once its size is known.
+ ***********************************************************/
+bool FrameCapture::Start() {
+    m_capturedFrames = 0;
+    m_writtenFrames = 0;
+    m_droppedFrames = 0;
+    m_bStopWriter = false;
+    m_bWriteFailed = false;
+    m_startTime = glfwGetTime();
+
+    m_writer = std::thread(&FrameCapture::WriterLoop, this);
+    m_bCapturing = true;
+
+    return true;
+}
+
+/***********************************************************
+ *  Stop()
+ *
+ *  This method is used to stop capturing.  The readbacks
+ *  still in flight are waited for, since the capture is over,
+ *  and the writer thread finishes the queue before it exits.
+ ***********************************************************/
+void FrameCapture::Stop() {
+    if (!m_bCapturing) {
+        return;
+    }
+
+    CollectFrames(true);
+    ReleaseBuffers();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_bStopWriter = true;
+    }
+    m_frameReady.notify_one();
+    m_writer.join();
+
+    if (m_pPipe != nullptr) {
+        ClosePipe(m_pPipe);
+        m_pPipe = nullptr;
+    }
+    m_freeBuffers.clear();
+    m_bCapturing = false;
+
+    double seconds = glfwGetTime() - m_startTime;
+    std::cout << "INFO: Capture stopped, " << m_writtenFrames << " frames written, "
+        << m_droppedFrames << " dropped in " << seconds << " s" << std::endl;
+    if (m_bWriteFailed) {
+        std::cout << "Error: Some captured frames could not be written" << std::endl;
+    }
+}
+
+/***********************************************************
+ *  CaptureFrame()
+ *
+ *  This method is used to issue the readback of the current
+ *  back buffer into the next pixel buffer of the ring.  The
+ *  copy runs on the GPU and is only mapped once its fence has
+ *  passed, so the CPU never waits for it.  When every slot is
+ *  still in flight the frame is dropped instead.
+ ***********************************************************/
+void FrameCapture::CaptureFrame(int width, int height) {
+    if (!m_bCapturing) {
+        return;
+    }
+
+    double startTime = glfwGetTime();
+
+    if ((width != m_width) || (height != m_height)) {
+        // the encoder was started for one frame size and cannot follow a resize
+        if ((m_pPipe != nullptr) && (m_width != 0)) {
+            std::cout << "Error: The window was resized, stopping the capture" << std::endl;
+            Stop();
+            return;
+        }
+        CollectFrames(true);
+        AllocateBuffers(width, height);
+    }
+
+    // hand over the readbacks that have finished, oldest first
+    CollectFrames(false);
+
+    if (m_pendingSlots == PBO_RING_SIZE) {
+        m_droppedFrames++;
+        if (m_pFrameStats) {
+            m_pFrameStats->AddCount("capture dropped", 1.0);
+        }
+        return;
+    }
+
+    if (m_pFrameStats) {
+        m_pFrameStats->BeginGpuTimer("capture readback");
+    }
+
+    int slot = m_nextSlot;
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    glReadBuffer(GL_BACK);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pixelBuffers[slot]);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    m_fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    m_slotFrames[slot] = m_capturedFrames++;
+
+    m_nextSlot = (m_nextSlot + 1) % PBO_RING_SIZE;
+    m_pendingSlots++;
+
+    if (m_pFrameStats) {
+        m_pFrameStats->EndGpuTimer();
+        m_pFrameStats->AddCount("capture ms", (glfwGetTime() - startTime) * 1000.0);
+    }
+}
+
+/***********************************************************
+ *  AllocateBuffers()
+ *
+ *  This method is used to create the ring of pixel buffers
+ *  for the passed in frame size.
+ ***********************************************************/
+void FrameCapture::AllocateBuffers(int width, int height) {
+    ReleaseBuffers();
+
+    GLsizeiptr bytes = (GLsizeiptr)width * height * CAPTURE_PIXEL_BYTES;
+    glGenBuffers(PBO_RING_SIZE, m_pixelBuffers);
+    for (int i = 0; i < PBO_RING_SIZE; i++) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pixelBuffers[i]);
+        glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+        ResourceTracker::TrackBuffer(m_pixelBuffers[i], (size_t)bytes, "frame capture");
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    m_width = width;
+    m_height = height;
+}
+
+/***********************************************************
+ *  ReleaseBuffers()
+ *
+ *  This method is used to delete the pixel buffers and any
+ *  fences that were not collected.
+ ***********************************************************/
+void FrameCapture::ReleaseBuffers() {
+    for (int i = 0; i < PBO_RING_SIZE; i++) {
+        if (m_fences[i] != 0) {
+            glDeleteSync(m_fences[i]);
+            m_fences[i] = 0;
+        }
+    }
+    if (m_pixelBuffers[0] != 0) {
+        glDeleteBuffers(PBO_RING_SIZE, m_pixelBuffers);
+        for (int i = 0; i < PBO_RING_SIZE; i++) {
+            ResourceTracker::Release(ResourceTracker::CATEGORY_BUFFER, m_pixelBuffers[i]);
+            m_pixelBuffers[i] = 0;
+        }
+    }
+
+    m_nextSlot = 0;
+    m_pendingSlots = 0;
+    m_width = 0;
+    m_height = 0;
+}
+
+/***********************************************************
+ *  CollectFrames()
+ *
+ *  This method is used to copy the finished readbacks out of
+ *  the pixel buffers and queue them for the writer thread.
+ *  Without bWait it stops at the first readback the GPU has
+ *  not finished yet.
+ ***********************************************************/
+void FrameCapture::CollectFrames(bool bWait) {
+    while (m_pendingSlots > 0) {
+        int slot = (m_nextSlot - m_pendingSlots + PBO_RING_SIZE) % PBO_RING_SIZE;
+
+        GLenum result = glClientWaitSync(m_fences[slot], bWait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0,
+            bWait ? 1000000000 : 0);
+        if ((result != GL_ALREADY_SIGNALED) && (result != GL_CONDITION_SATISFIED)) {
+            return;
+        }
+        glDeleteSync(m_fences[slot]);
+        m_fences[slot] = 0;
+        m_pendingSlots--;
+
+        FRAME frame;
+        frame.width = m_width;
+        frame.height = m_height;
+        frame.index = m_slotFrames[slot];
+        {
+            // reuse a buffer the writer thread has finished with
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_freeBuffers.empty()) {
+                frame.pixels.swap(m_freeBuffers.back());
+                m_freeBuffers.pop_back();
+            }
+        }
+
+        size_t bytes = (size_t)m_width * m_height * CAPTURE_PIXEL_BYTES;
+        frame.pixels.resize(bytes);
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pixelBuffers[slot]);
+        const void* pMapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT);
+        if (pMapped != nullptr) {
+            memcpy(frame.pixels.data(), pMapped, bytes);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            QueueFrame(frame);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+}
+
+/***********************************************************
+ *  QueueFrame()
+ *
+ *  This method is used to hand a frame to the writer thread.
+ *  When the writer has fallen too far behind the frame is
+ *  dropped so that memory use stays bounded.
+ ***********************************************************/
+void FrameCapture::QueueFrame(FRAME& frame) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if ((int)m_queue.size() >= MAX_QUEUED_FRAMES) {
+            m_droppedFrames++;
+            m_freeBuffers.push_back(std::move(frame.pixels));
+            return;
+        }
+        m_queue.push_back(std::move(frame));
+    }
+    m_frameReady.notify_one();
+}
+
+/***********************************************************
+ *  WriterLoop()
+ *
+ *  This method runs on the writer thread.  It writes the
+ *  queued frames in order until it is told to stop and the
+ *  queue is empty.
+ ***********************************************************/
+void FrameCapture::WriterLoop() {
+    std::vector<unsigned char> row;
+
+    while (true) {
+        FRAME frame;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_frameReady.wait(lock, [this]() { return m_bStopWriter || !m_queue.empty(); });
+            if (m_queue.empty()) {
+                return;
+            }
+            frame = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+
+        bool bWritten = WriteFrame(frame, row);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (bWritten) {
+            m_writtenFrames++;
+        }
+        else {
+            m_bWriteFailed = true;
+        }
+        m_freeBuffers.push_back(std::move(frame.pixels));
+    }
+}
+
+/***********************************************************
+ *  WriteFrame()
+ *
+ *  This method is used to write one frame, flipping the rows
+ *  to top-down order.  Image sequences are stored as binary
+ *  PPM with the alpha channel removed.
+ ***********************************************************/
+bool FrameCapture::WriteFrame(const FRAME& frame, std::vector<unsigned char>& row) {
+    size_t rowBytes = (size_t)frame.width * CAPTURE_PIXEL_BYTES;
+
+    if (m_pPipe != nullptr) {
+        for (int y = frame.height - 1; y >= 0; y--) {
+            if (fwrite(&frame.pixels[y * rowBytes], 1, rowBytes, m_pPipe) != rowBytes) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    char filename[512];
+    snprintf(filename, sizeof(filename), "%s%06d.ppm", m_pathPrefix.c_str(), frame.index);
+    FILE* pFile = fopen(filename, "wb");
+    if (pFile == nullptr) {
+        return false;
+    }
+
+    fprintf(pFile, "P6\n%d %d\n255\n", frame.width, frame.height);
+    row.resize((size_t)frame.width * 3);
+    bool bSuccess = true;
+    for (int y = frame.height - 1; (y >= 0) && bSuccess; y--) {
+        const unsigned char* pSource = &frame.pixels[y * rowBytes];
+        for (int x = 0; x < frame.width; x++) {
+            row[x * 3 + 0] = pSource[x * CAPTURE_PIXEL_BYTES + 0];
+            row[x * 3 + 1] = pSource[x * CAPTURE_PIXEL_BYTES + 1];
+            row[x * 3 + 2] = pSource[x * CAPTURE_PIXEL_BYTES + 2];
+        }
+        bSuccess = (fwrite(row.data(), 1, row.size(), pFile) == row.size());
+    }
+    fclose(pFile);
+
+    return bSuccess;
+}
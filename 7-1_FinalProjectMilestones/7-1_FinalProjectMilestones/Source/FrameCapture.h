@@ -0,0 +1,95 @@
+///////////////////////////////////////////////////////////////////////////////
+// framecapture.h
+// ============
+// record the rendered frames by reading them back through a ring of pixel
+// buffers and writing them out on a background thread
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "FrameStats.h"
+#include <GL/glew.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+class FrameCapture {
+public:
+    // constructor
+    FrameCapture(FrameStats* pFrameStats = nullptr);
+    // destructor
+    ~FrameCapture();
+
+    // start writing numbered binary PPM images named <pathPrefix>000000.ppm
+    bool StartImageSequence(const std::string& pathPrefix);
+    // start piping the frames as raw top-down RGBA into the standard
+    // input of an encoder command
+    bool StartPipe(const std::string& command);
+    // stop capturing, writing out every frame that is still in flight
+    void Stop();
+
+    bool IsCapturing() const { return m_bCapturing; }
+
+    // read back the window framebuffer, call after the scene has been
+    // drawn into the back buffer and before the buffers are swapped
+    void CaptureFrame(int width, int height);
+
+private:
+    // number of readbacks in flight, so each one is mapped a few frames
+    // after it was issued when the GPU has finished it
+    static const int PBO_RING_SIZE = 3;
+    // frames waiting for the writer thread before new frames are dropped
+    static const int MAX_QUEUED_FRAMES = 8;
+
+    // Struct to hold one frame handed to the writer thread
+    struct FRAME {
+        std::vector<unsigned char> pixels;  // bottom-up RGBA rows
+        int width = 0;
+        int height = 0;
+        int index = 0;
+    };
+
+    FrameStats* m_pFrameStats;        // Frame statistics, may be null
+    bool m_bCapturing;
+
+    // readback ring, all slots share the current capture size
+    GLuint m_pixelBuffers[PBO_RING_SIZE];
+    GLsync m_fences[PBO_RING_SIZE];
+    int m_slotFrames[PBO_RING_SIZE];
+    int m_nextSlot;
+    int m_pendingSlots;
+    int m_width;
+    int m_height;
+
+    // output, the pipe is null when writing an image sequence
+    std::string m_pathPrefix;
+    FILE* m_pPipe;
+
+    // writer thread and the frames shared with it
+    std::thread m_writer;
+    std::mutex m_mutex;
+    std::condition_variable m_frameReady;
+    std::deque<FRAME> m_queue;
+    std::vector<std::vector<unsigned char>> m_freeBuffers;
+    bool m_bStopWriter;
+    bool m_bWriteFailed;
+
+    int m_capturedFrames;
+    int m_writtenFrames;
+    int m_droppedFrames;
+    double m_startTime;
+
+    bool Start();
+    void AllocateBuffers(int width, int height);
+    void ReleaseBuffers();
+    void CollectFrames(bool bWait);
+    void QueueFrame(FRAME& frame);
+    void WriterLoop();
+    bool WriteFrame(const FRAME& frame, std::vector<unsigned char>& row);
+};
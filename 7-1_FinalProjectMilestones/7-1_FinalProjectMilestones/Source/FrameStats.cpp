@@ -0,0 +1,270 @@
+///////////////////////////////////////////////////////////////////////////////
+// framestats.cpp
+// ============
+// collect per-frame counters and GPU query results and report averages
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FrameStats.h"
+#include <GLFW/glfw3.h>
+#include <iostream>
+#include <iomanip>
+
+/***********************************************************
+ *  FrameStats()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FrameStats::FrameStats()
+    : m_activeTimer(-1), m_activeSampleCount(-1), m_frameStartTime(0.0),
+    m_intervalStartTime(0.0), m_intervalFrames(0), m_reportInterval(2.0), m_reportCount(0) {
+}
+
+/***********************************************************
+ *  ~FrameStats()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FrameStats::~FrameStats() {
+    for (size_t i = 0; i < m_stats.size(); i++) {
+        if (m_stats[i].queries[0] != 0) {
+            glDeleteQueries(QUERY_RING_SIZE, m_stats[i].queries);
+        }
+    }
+    m_stats.clear();
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used to mark the start of a frame.
+ ***********************************************************/
+void FrameStats::BeginFrame() {
+    m_frameStartTime = glfwGetTime();
+    if (m_intervalFrames == 0) {
+        m_intervalStartTime = m_frameStartTime;
+    }
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used to mark the end of a frame, gather
+ *  any GPU query results that have become available, and
+ *  print the averages once per report interval.
+ ***********************************************************/
+void FrameStats::EndFrame() {
+    double now = glfwGetTime();
+    AddCount("frame ms", (now - m_frameStartTime) * 1000.0);
+    m_intervalFrames++;
+
+    for (size_t i = 0; i < m_stats.size(); i++) {
+        CollectQueries(m_stats[i]);
+    }
+
+    double elapsed = now - m_intervalStartTime;
+    if ((m_reportInterval > 0.0) && (elapsed >= m_reportInterval)) {
+        Report(elapsed);
+    }
+}
+
+/***********************************************************
+ *  AddCount()
+ *
+ *  This method is used to add a value to a named counter.
+ *  Counters are reported as an average per frame.
+ ***********************************************************/
+void FrameStats::AddCount(const std::string& name, double value) {
+    int index = FindStat(name, STAT_COUNT);
+    m_stats[index].sum += value;
+}
+
+/***********************************************************
+ *  AddSample()
+ *
+ *  This method is used to add one measurement to a named
+ *  statistic.  These are reported as an average of the
+ *  measurements rather than per frame.
+ ***********************************************************/
+void FrameStats::AddSample(const std::string& name, double value) {
+    int index = FindStat(name, STAT_MEASURE);
+    m_stats[index].sum += value;
+    m_stats[index].samples++;
+}
+
+/***********************************************************
+ *  BeginGpuTimer()
+ *
+ *  This method is used to start timing the GPU work for the
+ *  named statistic.  Only one timer can run at a time.
+ ***********************************************************/
+void FrameStats::BeginGpuTimer(const std::string& name) {
+    if (m_activeTimer < 0) {
+        m_activeTimer = BeginQuery(name, STAT_GPU_TIME, GL_TIME_ELAPSED, 1.0e-6);
+    }
+}
+
+/***********************************************************
+ *  EndGpuTimer()
+ *
+ *  This method is used to stop the running GPU timer.
+ ***********************************************************/
+void FrameStats::EndGpuTimer() {
+    if (m_activeTimer >= 0) {
+        glEndQuery(GL_TIME_ELAPSED);
+        m_activeTimer = -1;
+    }
+}
+
+/***********************************************************
+ *  BeginSampleCount()
+ *
+ *  This method is used to start counting the samples that
+ *  pass the depth test for the named statistic.
+ ***********************************************************/
+void FrameStats::BeginSampleCount(const std::string& name, double scale) {
+    if (m_activeSampleCount < 0) {
+        m_activeSampleCount = BeginQuery(name, STAT_SAMPLES, GL_SAMPLES_PASSED, scale);
+    }
+}
+
+/***********************************************************
+ *  EndSampleCount()
+ *
+ *  This method is used to stop the running sample count.
+ ***********************************************************/
+void FrameStats::EndSampleCount() {
+    if (m_activeSampleCount >= 0) {
+        glEndQuery(GL_SAMPLES_PASSED);
+        m_activeSampleCount = -1;
+    }
+}
+
+/***********************************************************
+ *  GetAverage()
+ *
+ *  This method returns the average of the named statistic
+ *  from the most recent report interval.
+ ***********************************************************/
+double FrameStats::GetAverage(const std::string& name) const {
+    for (size_t i = 0; i < m_stats.size(); i++) {
+        if (m_stats[i].name == name) {
+            return m_stats[i].lastAverage;
+        }
+    }
+
+    return 0.0;
+}
+
+/***********************************************************
+ *  FindStat()
+ *
+ *  This method returns the index of the named statistic,
+ *  adding it to the collection the first time it is used.
+ ***********************************************************/
+int FrameStats::FindStat(const std::string& name, STAT_KIND kind) {
+    for (size_t i = 0; i < m_stats.size(); i++) {
+        if (m_stats[i].name == name) {
+            return (int)i;
+        }
+    }
+
+    STAT stat;
+    stat.name = name;
+    stat.kind = kind;
+    if ((kind == STAT_GPU_TIME) || (kind == STAT_SAMPLES)) {
+        glGenQueries(QUERY_RING_SIZE, stat.queries);
+    }
+    m_stats.push_back(stat);
+
+    return (int)m_stats.size() - 1;
+}
+
+/***********************************************************
+ *  BeginQuery()
+ *
+ *  This method is used to start the next query in the ring
+ *  of the named statistic.  If that query has not returned
+ *  its result yet, this frame is skipped instead of waiting.
+ ***********************************************************/
+int FrameStats::BeginQuery(const std::string& name, STAT_KIND kind, GLenum target, double scale) {
+    int index = FindStat(name, kind);
+    STAT& stat = m_stats[index];
+
+    if (stat.bPending[stat.nextQuery]) {
+        return -1;
+    }
+
+    glBeginQuery(target, stat.queries[stat.nextQuery]);
+    stat.bPending[stat.nextQuery] = true;
+    stat.pendingScale[stat.nextQuery] = scale;
+    stat.nextQuery = (stat.nextQuery + 1) % QUERY_RING_SIZE;
+
+    return index;
+}
+
+/***********************************************************
+ *  CollectQueries()
+ *
+ *  This method is used to read back every finished query of
+ *  the passed in statistic without stalling the pipeline.
+ ***********************************************************/
+void FrameStats::CollectQueries(STAT& stat) {
+    if ((stat.kind == STAT_COUNT) || (stat.kind == STAT_MEASURE)) {
+        return;
+    }
+
+    for (int i = 0; i < QUERY_RING_SIZE; i++) {
+        if (!stat.bPending[i]) {
+            continue;
+        }
+
+        GLint available = 0;
+        glGetQueryObjectiv(stat.queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available) {
+            GLuint64 result = 0;
+            glGetQueryObjectui64v(stat.queries[i], GL_QUERY_RESULT, &result);
+            stat.sum += (double)result * stat.pendingScale[i];
+            stat.samples++;
+            stat.bPending[i] = false;
+        }
+    }
+}
+
+/***********************************************************
+ *  Report()
+ *
+ *  This method is used to compute the averages for the
+ *  interval, print them to the console, and reset the sums.
+ ***********************************************************/
+void FrameStats::Report(double elapsed) {
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "STATS: " << (m_intervalFrames / elapsed) << " fps";
+
+    for (size_t i = 0; i < m_stats.size(); i++) {
+        STAT& stat = m_stats[i];
+
+        if (stat.kind == STAT_COUNT) {
+            stat.lastAverage = stat.sum / m_intervalFrames;
+        }
+        else if (stat.samples > 0) {
+            stat.lastAverage = stat.sum / stat.samples;
+        }
+        else {
+            continue;
+        }
+
+        std::cout << " | " << stat.name << ": " << stat.lastAverage;
+        if (stat.kind == STAT_GPU_TIME) {
+            std::cout << " ms";
+        }
+
+        stat.sum = 0.0;
+        stat.samples = 0;
+    }
+    std::cout << std::defaultfloat << std::endl;
+
+    m_intervalFrames = 0;
+    m_reportCount++;
+}
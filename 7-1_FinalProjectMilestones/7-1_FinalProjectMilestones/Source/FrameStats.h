@@ -0,0 +1,85 @@
+///////////////////////////////////////////////////////////////////////////////
+// framestats.h
+// ============
+// collect per-frame counters and GPU query results and report averages
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <string>
+#include <vector>
+
+class FrameStats {
+public:
+    // constructor
+    FrameStats();
+    // destructor
+    ~FrameStats();
+
+    // mark the start and the end of a rendered frame
+    void BeginFrame();
+    void EndFrame();
+
+    // add a value to a counter that is averaged per frame
+    void AddCount(const std::string& name, double value);
+    // add one measurement that is averaged over the measurements made,
+    // for values that are not produced every frame
+    void AddSample(const std::string& name, double value);
+
+    // time the GPU work issued between the begin and end calls
+    void BeginGpuTimer(const std::string& name);
+    void EndGpuTimer();
+
+    // count the samples that pass the depth test between the begin and end
+    // calls, multiplied by the passed in scale (for example 1 / pixel count)
+    void BeginSampleCount(const std::string& name, double scale = 1.0);
+    void EndSampleCount();
+
+    // get the per-frame average of a statistic from the last report
+    double GetAverage(const std::string& name) const;
+
+    // get the number of reports made so far, to tell when new averages exist
+    int ReportCount() const { return m_reportCount; }
+
+    // set how often the averages are printed, zero disables printing
+    void SetReportInterval(double seconds) { m_reportInterval = seconds; }
+
+private:
+    // kinds of statistics that are collected
+    enum STAT_KIND { STAT_COUNT, STAT_GPU_TIME, STAT_SAMPLES, STAT_MEASURE };
+
+    // number of queries in flight per statistic, results are read
+    // a few frames late so the CPU never waits on the GPU
+    static const int QUERY_RING_SIZE = 4;
+
+    // struct to hold a single named statistic
+    struct STAT {
+        std::string name;
+        STAT_KIND kind = STAT_COUNT;
+        double scale = 1.0;
+        double sum = 0.0;
+        int samples = 0;
+        double lastAverage = 0.0;
+        GLuint queries[QUERY_RING_SIZE] = { 0 };
+        bool bPending[QUERY_RING_SIZE] = { false };
+        double pendingScale[QUERY_RING_SIZE] = { 0.0 };
+        int nextQuery = 0;
+    };
+
+    std::vector<STAT> m_stats;       // statistics in the order they were first used
+    int m_activeTimer;               // index of the running GPU timer, -1 if none
+    int m_activeSampleCount;         // index of the running sample count, -1 if none
+    double m_frameStartTime;         // time at the start of the current frame
+    double m_intervalStartTime;      // time the current report interval started
+    int m_intervalFrames;            // frames rendered in the current interval
+    double m_reportInterval;         // seconds between reports
+    int m_reportCount;               // reports made since construction
+
+    int FindStat(const std::string& name, STAT_KIND kind);
+    int BeginQuery(const std::string& name, STAT_KIND kind, GLenum target, double scale);
+    void CollectQueries(STAT& stat);
+    void Report(double elapsed);
+};
@@ -0,0 +1,97 @@
+///////////////////////////////////////////////////////////////////////////////
+// frustum.cpp
+// ============
+// test bounding boxes against the six planes of a view frustum
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Frustum.h"
+#include <cfloat>
+
+/***********************************************************
+ *  Frustum()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+Frustum::Frustum() {
+    // accept everything until planes are extracted
+    for (int i = 0; i < 6; i++) {
+        m_planes[i] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    }
+}
+
+/***********************************************************
+ *  Extract()
+ *
+ *  This method is used to pull the left, right, bottom, top,
+ *  near and far planes out of the combined matrix by adding
+ *  and subtracting its rows.
+ ***********************************************************/
+void Frustum::Extract(const glm::mat4& viewProjection) {
+    // glm matrices are column major, so gather the rows first
+    glm::vec4 rows[4];
+    for (int row = 0; row < 4; row++) {
+        rows[row] = glm::vec4(viewProjection[0][row], viewProjection[1][row],
+            viewProjection[2][row], viewProjection[3][row]);
+    }
+
+    m_planes[0] = rows[3] + rows[0];
+    m_planes[1] = rows[3] - rows[0];
+    m_planes[2] = rows[3] + rows[1];
+    m_planes[3] = rows[3] - rows[1];
+    m_planes[4] = rows[3] + rows[2];
+    m_planes[5] = rows[3] - rows[2];
+
+    for (int i = 0; i < 6; i++) {
+        float length = glm::length(glm::vec3(m_planes[i]));
+        if (length > 0.0f) {
+            m_planes[i] /= length;
+        }
+    }
+}
+
+/***********************************************************
+ *  IntersectsBox()
+ *
+ *  This method is used to test an axis aligned box.  For each
+ *  plane only the box corner furthest along the plane normal
+ *  is checked; if even that corner is behind the plane the
+ *  whole box is outside.
+ ***********************************************************/
+bool Frustum::IntersectsBox(const glm::vec3& boundsMin, const glm::vec3& boundsMax) const {
+    for (int i = 0; i < 6; i++) {
+        const glm::vec4& plane = m_planes[i];
+        glm::vec3 corner(
+            (plane.x >= 0.0f) ? boundsMax.x : boundsMin.x,
+            (plane.y >= 0.0f) ? boundsMax.y : boundsMin.y,
+            (plane.z >= 0.0f) ? boundsMax.z : boundsMin.z);
+
+        if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/***********************************************************
+ *  GetBounds()
+ *
+ *  This method is used to find the box around the frustum by
+ *  moving the eight corners of the clip space cube back
+ *  through the inverse of the combined matrix.
+ ***********************************************************/
+void Frustum::GetBounds(const glm::mat4& viewProjection, glm::vec3& boundsMin, glm::vec3& boundsMax) {
+    glm::mat4 inverse = glm::inverse(viewProjection);
+
+    boundsMin = glm::vec3(FLT_MAX);
+    boundsMax = glm::vec3(-FLT_MAX);
+    for (int corner = 0; corner < 8; corner++) {
+        glm::vec4 clip((corner & 1) ? 1.0f : -1.0f, (corner & 2) ? 1.0f : -1.0f, (corner & 4) ? 1.0f : -1.0f, 1.0f);
+        glm::vec4 world = inverse * clip;
+        glm::vec3 point = glm::vec3(world) / world.w;
+        boundsMin = glm::min(boundsMin, point);
+        boundsMax = glm::max(boundsMax, point);
+    }
+}
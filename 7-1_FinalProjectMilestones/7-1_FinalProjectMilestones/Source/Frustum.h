@@ -0,0 +1,31 @@
+///////////////////////////////////////////////////////////////////////////////
+// frustum.h
+// ============
+// test bounding boxes against the six planes of a view frustum
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+class Frustum {
+public:
+    // constructor
+    Frustum();
+
+    // extract the planes from a combined projection * view matrix
+    void Extract(const glm::mat4& viewProjection);
+
+    // returns false only when the box is completely outside a plane
+    bool IntersectsBox(const glm::vec3& boundsMin, const glm::vec3& boundsMax) const;
+
+    // find the world space box around the corners of the frustum of a
+    // combined projection * view matrix
+    static void GetBounds(const glm::mat4& viewProjection, glm::vec3& boundsMin, glm::vec3& boundsMax);
+
+private:
+    // plane equations (normal, distance) facing into the frustum
+    glm::vec4 m_planes[6];
+};
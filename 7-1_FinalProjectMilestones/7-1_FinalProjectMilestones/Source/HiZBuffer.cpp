@@ -0,0 +1,392 @@
+///////////////////////////////////////////////////////////////////////////////
+// hizbuffer.cpp
+// ============
+// build a hierarchical max-depth buffer from the previous frame and use it
+// to reject objects that are hidden behind what was already drawn
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "HiZBuffer.h"
+#include "ResourceTracker.h"
+#include "TextureUnits.h"
+#include <glm/gtx/transform.hpp>
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+
+// declaration of the global variables and defines
+namespace {
+    // shader files for the depth reduction pass
+    const char* g_FullscreenVertexShader = "Shaders/fullscreenVertexShader.glsl";
+    const char* g_ReduceFragmentShader = "Shaders/hizReduceFragmentShader.glsl";
+
+    // coarsest footprint, in texels of the chosen level, tested per box
+    const int MAX_TEST_TEXELS = 2;
+}
+
+/***********************************************************
+ *  HiZBuffer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+HiZBuffer::HiZBuffer()
+    : m_pReduceShader(nullptr), m_emptyVAO(0), m_reduceFramebuffer(0), m_reduceTexture(0),
+    m_reduceWidth(0), m_reduceHeight(0), m_nextReadback(0),
+    m_viewProjection(1.0f), m_bHasDepth(false) {
+}
+
+/***********************************************************
+ *  ~HiZBuffer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+HiZBuffer::~HiZBuffer() {
+    for (int i = 0; i < READBACK_RING_SIZE; i++) {
+        if (m_readbacks[i].fence != 0) {
+            glDeleteSync(m_readbacks[i].fence);
+        }
+        if (m_readbacks[i].pixelBuffer != 0) {
+            ResourceTracker::Release(ResourceTracker::CATEGORY_BUFFER, m_readbacks[i].pixelBuffer);
+            glDeleteBuffers(1, &m_readbacks[i].pixelBuffer);
+        }
+    }
+    if (m_reduceFramebuffer != 0) {
+        glDeleteFramebuffers(1, &m_reduceFramebuffer);
+    }
+    if (m_reduceTexture != 0) {
+        ResourceTracker::Release(ResourceTracker::CATEGORY_TEXTURE, m_reduceTexture);
+        glDeleteTextures(1, &m_reduceTexture);
+    }
+    if (m_emptyVAO != 0) {
+        glDeleteVertexArrays(1, &m_emptyVAO);
+    }
+    if (m_pReduceShader) {
+        ResourceTracker::DeleteProgram(m_pReduceShader->m_programID);
+        delete m_pReduceShader;
+        m_pReduceShader = nullptr;
+    }
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used to load the reduction shaders and
+ *  create the objects used by the fullscreen pass.
+ ***********************************************************/
+bool HiZBuffer::Initialize() {
+    m_pReduceShader = new ShaderManager();
+    if (m_pReduceShader->LoadShaders(g_FullscreenVertexShader, g_ReduceFragmentShader) == 0) {
+        std::cout << "Error: Hierarchical depth shaders failed to load" << std::endl;
+        delete m_pReduceShader;
+        m_pReduceShader = nullptr;
+        return false;
+    }
+    ResourceTracker::TrackProgram(m_pReduceShader->m_programID, "occlusion depth");
+
+    // core profile draws need a bound vertex array even without attributes
+    glGenVertexArrays(1, &m_emptyVAO);
+
+    for (int i = 0; i < READBACK_RING_SIZE; i++) {
+        glGenBuffers(1, &m_readbacks[i].pixelBuffer);
+    }
+
+    return true;
+}
+
+/***********************************************************
+ *  ResizeReduceTarget()
+ *
+ *  This method is used to (re)allocate the single channel
+ *  float target that the depth is reduced into.
+ ***********************************************************/
+bool HiZBuffer::ResizeReduceTarget(int width, int height) {
+    if ((width == m_reduceWidth) && (height == m_reduceHeight) && (m_reduceFramebuffer != 0)) {
+        return true;
+    }
+
+    if (m_reduceTexture == 0) {
+        glGenTextures(1, &m_reduceTexture);
+    }
+    glBindTexture(GL_TEXTURE_2D, m_reduceTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, width, height, 0, GL_RED, GL_FLOAT, nullptr);
+    ResourceTracker::TrackTexture(m_reduceTexture, GL_R32F, width, height, 1, 1, "occlusion depth");
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    if (m_reduceFramebuffer == 0) {
+        glGenFramebuffers(1, &m_reduceFramebuffer);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, m_reduceFramebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_reduceTexture, 0);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Error: Hierarchical depth framebuffer is incomplete, status: " << status << std::endl;
+        return false;
+    }
+
+    m_reduceWidth = width;
+    m_reduceHeight = height;
+
+    return true;
+}
+
+/***********************************************************
+ *  Build()
+ *
+ *  This method is used to reduce the scene depth into the
+ *  readback level on the GPU, where every texel keeps the
+ *  farthest depth of the pixels it covers, and to queue an
+ *  asynchronous copy of it into a pixel buffer.  The result
+ *  is picked up a frame or two later, so testing never
+ *  waits on the GPU.
+ ***********************************************************/
+void HiZBuffer::Build(GLuint depthTexture, int sourceWidth, int sourceHeight, const glm::mat4& viewProjection) {
+    if ((m_pReduceShader == nullptr) || (depthTexture == 0) || (sourceWidth <= 0) || (sourceHeight <= 0)) {
+        return;
+    }
+
+    CollectReadbacks();
+
+    READBACK& readback = m_readbacks[m_nextReadback];
+    if (readback.fence != 0) {
+        // every copy is still in flight, so skip this frame
+        return;
+    }
+
+    int width = std::min(READBACK_WIDTH, sourceWidth);
+    int height = std::max(1, (int)std::lround((double)width * sourceHeight / sourceWidth));
+    if (!ResizeReduceTarget(width, height)) {
+        return;
+    }
+
+    // reduce the depth in a single fullscreen pass
+    glBindFramebuffer(GL_FRAMEBUFFER, m_reduceFramebuffer);
+    glViewport(0, 0, width, height);
+    glDisable(GL_DEPTH_TEST);
+
+    glActiveTexture(GL_TEXTURE0 + TEXTURE_UNIT_HIZ_SOURCE);
+    glBindTexture(GL_TEXTURE_2D, depthTexture);
+
+    m_pReduceShader->use();
+    m_pReduceShader->setSampler2DValue("depthTexture", TEXTURE_UNIT_HIZ_SOURCE);
+    m_pReduceShader->setVec2Value("sourceSize", glm::vec2((float)sourceWidth, (float)sourceHeight));
+    m_pReduceShader->setVec2Value("targetSize", glm::vec2((float)width, (float)height));
+
+    glBindVertexArray(m_emptyVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+
+    // queue the copy into the pixel buffer
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pixelBuffer);
+    if ((readback.width != width) || (readback.height != height)) {
+        glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)width * height * sizeof(float), nullptr, GL_STREAM_READ);
+        ResourceTracker::TrackBuffer(readback.pixelBuffer, (size_t)width * height * sizeof(float), "occlusion readback");
+        readback.width = width;
+        readback.height = height;
+    }
+    glReadPixels(0, 0, width, height, GL_RED, GL_FLOAT, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    readback.viewProjection = viewProjection;
+    m_nextReadback = (m_nextReadback + 1) % READBACK_RING_SIZE;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glEnable(GL_DEPTH_TEST);
+}
+
+/***********************************************************
+ *  ShiftOrigin()
+ *
+ *  This method is used to move the depth that was rendered
+ *  before the world origin moved.  A point of the moved
+ *  world is moved back before the stored view projection,
+ *  for the collected depth and the copies in flight alike.
+ ***********************************************************/
+void HiZBuffer::ShiftOrigin(const glm::vec3& offset) {
+    glm::mat4 moveBack = glm::translate(-offset);
+
+    m_viewProjection = m_viewProjection * moveBack;
+    for (int i = 0; i < READBACK_RING_SIZE; i++) {
+        m_readbacks[i].viewProjection = m_readbacks[i].viewProjection * moveBack;
+    }
+}
+
+/***********************************************************
+ *  Invalidate()
+ *
+ *  This method is used to drop the stored depth and the
+ *  copies still in flight, so that nothing is reported as
+ *  occluded until depth rendered afterwards is read back.
+ ***********************************************************/
+void HiZBuffer::Invalidate() {
+    for (int i = 0; i < READBACK_RING_SIZE; i++) {
+        if (m_readbacks[i].fence != 0) {
+            glDeleteSync(m_readbacks[i].fence);
+            m_readbacks[i].fence = 0;
+        }
+    }
+    m_bHasDepth = false;
+}
+
+/***********************************************************
+ *  CollectReadbacks()
+ *
+ *  This method is used to pick up the copies that the GPU
+ *  has finished, oldest first, and rebuild the CPU mip chain
+ *  from the newest of them.
+ ***********************************************************/
+void HiZBuffer::CollectReadbacks() {
+    for (int i = 0; i < READBACK_RING_SIZE; i++) {
+        READBACK& readback = m_readbacks[(m_nextReadback + i) % READBACK_RING_SIZE];
+        if (readback.fence == 0) {
+            continue;
+        }
+
+        GLenum result = glClientWaitSync(readback.fence, 0, 0);
+        if ((result != GL_ALREADY_SIGNALED) && (result != GL_CONDITION_SATISFIED)) {
+            // later copies were queued after this one and cannot be done yet
+            break;
+        }
+
+        glDeleteSync(readback.fence);
+        readback.fence = 0;
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pixelBuffer);
+        const float* pixels = static_cast<const float*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+            (GLsizeiptr)readback.width * readback.height * sizeof(float), GL_MAP_READ_BIT));
+        if (pixels) {
+            BuildMipChain(pixels, readback.width, readback.height);
+            m_viewProjection = readback.viewProjection;
+            m_bHasDepth = true;
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+}
+
+/***********************************************************
+ *  BuildMipChain()
+ *
+ *  This method is used to build the coarser levels on the
+ *  CPU.  Each texel keeps the farthest depth of the 2x2
+ *  texels below it; on odd sizes the last texel covers the
+ *  remaining edge so that nothing is ever dropped.
+ ***********************************************************/
+void HiZBuffer::BuildMipChain(const float* pixels, int width, int height) {
+    m_levels.clear();
+    m_levelSizes.clear();
+
+    m_levels.push_back(std::vector<float>(pixels, pixels + (size_t)width * height));
+    m_levelSizes.push_back(glm::ivec2(width, height));
+
+    while ((width > 1) || (height > 1)) {
+        int coarseWidth = (width + 1) / 2;
+        int coarseHeight = (height + 1) / 2;
+        const std::vector<float>& fine = m_levels.back();
+        std::vector<float> coarse((size_t)coarseWidth * coarseHeight);
+
+        for (int y = 0; y < coarseHeight; y++) {
+            int y0 = y * 2;
+            int y1 = std::min(y0 + 1, height - 1);
+            for (int x = 0; x < coarseWidth; x++) {
+                int x0 = x * 2;
+                int x1 = std::min(x0 + 1, width - 1);
+                float depth = std::max(
+                    std::max(fine[y0 * width + x0], fine[y0 * width + x1]),
+                    std::max(fine[y1 * width + x0], fine[y1 * width + x1]));
+                coarse[y * coarseWidth + x] = depth;
+            }
+        }
+
+        m_levels.push_back(coarse);
+        m_levelSizes.push_back(glm::ivec2(coarseWidth, coarseHeight));
+        width = coarseWidth;
+        height = coarseHeight;
+    }
+}
+
+/***********************************************************
+ *  LevelDepth()
+ *
+ *  This method returns the stored depth of a texel.
+ ***********************************************************/
+float HiZBuffer::LevelDepth(int level, int x, int y) const {
+    return m_levels[level][(size_t)y * m_levelSizes[level].x + x];
+}
+
+/***********************************************************
+ *  IsOccluded()
+ *
+ *  This method is used to test a world space box against the
+ *  stored depth.  The box is projected with the camera that
+ *  produced that depth; the level is chosen so that the box
+ *  covers at most a couple of texels, and the box is hidden
+ *  only if its nearest depth lies behind the farthest depth
+ *  stored under it.
+ ***********************************************************/
+bool HiZBuffer::IsOccluded(const glm::vec3& boundsMin, const glm::vec3& boundsMax) const {
+    if (!m_bHasDepth) {
+        return false;
+    }
+
+    glm::vec2 screenMin(1.0f);
+    glm::vec2 screenMax(0.0f);
+    float nearestDepth = 1.0f;
+
+    for (int corner = 0; corner < 8; corner++) {
+        glm::vec4 clip = m_viewProjection * glm::vec4(
+            (corner & 1) ? boundsMax.x : boundsMin.x,
+            (corner & 2) ? boundsMax.y : boundsMin.y,
+            (corner & 4) ? boundsMax.z : boundsMin.z,
+            1.0f);
+
+        // a corner behind the camera means the box reaches the viewer
+        if (clip.w <= 0.0f) {
+            return false;
+        }
+
+        glm::vec3 ndc = glm::vec3(clip) / clip.w;
+        glm::vec2 screen = glm::vec2(ndc.x, ndc.y) * 0.5f + 0.5f;
+        screenMin = glm::min(screenMin, screen);
+        screenMax = glm::max(screenMax, screen);
+        nearestDepth = std::min(nearestDepth, ndc.z * 0.5f + 0.5f);
+    }
+
+    // nothing is known about the parts of the box outside the stored view
+    if ((screenMin.x < 0.0f) || (screenMin.y < 0.0f) || (screenMax.x > 1.0f) || (screenMax.y > 1.0f)) {
+        return false;
+    }
+
+    // find the level where the box spans only a few texels
+    int level = 0;
+    glm::ivec2 texelMin;
+    glm::ivec2 texelMax;
+    while (true) {
+        const glm::ivec2& size = m_levelSizes[level];
+        texelMin = glm::ivec2((int)(screenMin.x * size.x), (int)(screenMin.y * size.y));
+        texelMax = glm::ivec2((int)(screenMax.x * size.x), (int)(screenMax.y * size.y));
+        texelMin = glm::ivec2(std::min(texelMin.x, size.x - 1), std::min(texelMin.y, size.y - 1));
+        texelMax = glm::ivec2(std::min(texelMax.x, size.x - 1), std::min(texelMax.y, size.y - 1));
+
+        bool bSmallEnough = ((texelMax.x - texelMin.x) < MAX_TEST_TEXELS) &&
+            ((texelMax.y - texelMin.y) < MAX_TEST_TEXELS);
+        if (bSmallEnough || (level + 1 >= (int)m_levels.size())) {
+            break;
+        }
+        level++;
+    }
+
+    float farthestDepth = 0.0f;
+    for (int y = texelMin.y; y <= texelMax.y; y++) {
+        for (int x = texelMin.x; x <= texelMax.x; x++) {
+            farthestDepth = std::max(farthestDepth, LevelDepth(level, x, y));
+        }
+    }
+
+    return (nearestDepth > farthestDepth);
+}
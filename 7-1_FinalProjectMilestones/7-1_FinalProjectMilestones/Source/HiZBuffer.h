@@ -0,0 +1,81 @@
+///////////////////////////////////////////////////////////////////////////////
+// hizbuffer.h
+// ============
+// build a hierarchical max-depth buffer from the previous frame and use it
+// to reject objects that are hidden behind what was already drawn
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+class HiZBuffer {
+public:
+    // constructor
+    HiZBuffer();
+    // destructor
+    ~HiZBuffer();
+
+    // load the reduction shaders, returns false if they are unavailable
+    bool Initialize();
+
+    // reduce the rendered depth into the readback level and start copying
+    // it to the CPU; sourceWidth/Height is the drawn region of the texture
+    void Build(GLuint depthTexture, int sourceWidth, int sourceHeight, const glm::mat4& viewProjection);
+
+    // returns true when the box is certainly hidden in the last depth that
+    // reached the CPU, and false when it may be visible or nothing is known
+    bool IsOccluded(const glm::vec3& boundsMin, const glm::vec3& boundsMax) const;
+
+    // returns true once a depth readback has completed
+    bool HasDepth() const { return m_bHasDepth; }
+
+    // forget the stored depth and the copies in flight, for when the depth
+    // is no longer rendered from the camera the boxes are tested against
+    void Invalidate();
+
+    // move the stored depth by the passed in offset when the world origin
+    // is moved, so that the boxes of the moved world test the same
+    void ShiftOrigin(const glm::vec3& offset);
+
+private:
+    // width of the finest level copied back to the CPU
+    static const int READBACK_WIDTH = 256;
+    // number of readbacks in flight
+    static const int READBACK_RING_SIZE = 3;
+
+    // struct to hold one in-flight copy of the reduced depth
+    struct READBACK {
+        GLuint pixelBuffer = 0;
+        GLsync fence = 0;
+        glm::mat4 viewProjection = glm::mat4(1.0f);
+        int width = 0;
+        int height = 0;
+    };
+
+    ShaderManager* m_pReduceShader;
+    GLuint m_emptyVAO;
+    GLuint m_reduceFramebuffer;
+    GLuint m_reduceTexture;
+    int m_reduceWidth;
+    int m_reduceHeight;
+
+    READBACK m_readbacks[READBACK_RING_SIZE];
+    int m_nextReadback;
+
+    // max-depth mip chain on the CPU, level 0 is the readback level
+    std::vector<std::vector<float>> m_levels;
+    std::vector<glm::ivec2> m_levelSizes;
+    glm::mat4 m_viewProjection;
+    bool m_bHasDepth;
+
+    bool ResizeReduceTarget(int width, int height);
+    void CollectReadbacks();
+    void BuildMipChain(const float* pixels, int width, int height);
+    float LevelDepth(int level, int x, int y) const;
+};
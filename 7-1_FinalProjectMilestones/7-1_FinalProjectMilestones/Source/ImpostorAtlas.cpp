@@ -0,0 +1,310 @@
+///////////////////////////////////////////////////////////////////////////////
+// impostoratlas.cpp
+// ============
+// capture objects from a ring of view directions into a texture atlas and
+// draw distant copies of them as camera-facing quads
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ImpostorAtlas.h"
+#include "ResourceTracker.h"
+#include "TextureUnits.h"
+#include <glm/gtx/transform.hpp>
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+#include <cstddef>
+#include <string>
+
+// declaration of the global variables and defines
+namespace {
+    // shader files for the impostor quads
+    const char* g_ImpostorVertexShader = "Shaders/impostorVertexShader.glsl";
+    const char* g_ImpostorFragmentShader = "Shaders/impostorFragmentShader.glsl";
+
+    // attribute locations used by the impostor vertex shader
+    const GLuint POSITION_SCALE_ATTRIBUTE = 0;
+    const GLuint YAW_GROUP_ATTRIBUTE = 1;
+
+    // elevation between the captured rings of views
+    const float PITCH_STEP_DEGREES = 30.0f;
+    // columns of the atlas, so that it stays close to square
+    const int MAX_ATLAS_COLUMNS = 16;
+}
+
+/***********************************************************
+ *  ImpostorAtlas()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ImpostorAtlas::ImpostorAtlas()
+    : m_pBillboardShader(nullptr), m_framebuffer(0), m_atlasTexture(0), m_depthBuffer(0),
+    m_tileResolution(0), m_columns(0), m_rows(0), m_maxRadius(0.0f) {
+}
+
+/***********************************************************
+ *  ~ImpostorAtlas()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ImpostorAtlas::~ImpostorAtlas() {
+    if (m_framebuffer != 0) {
+        glDeleteFramebuffers(1, &m_framebuffer);
+        m_framebuffer = 0;
+    }
+    if (m_atlasTexture != 0) {
+        ResourceTracker::Release(ResourceTracker::CATEGORY_TEXTURE, m_atlasTexture);
+        glDeleteTextures(1, &m_atlasTexture);
+        m_atlasTexture = 0;
+    }
+    if (m_depthBuffer != 0) {
+        ResourceTracker::Release(ResourceTracker::CATEGORY_RENDERBUFFER, m_depthBuffer);
+        glDeleteRenderbuffers(1, &m_depthBuffer);
+        m_depthBuffer = 0;
+    }
+    if (m_pBillboardShader) {
+        ResourceTracker::DeleteProgram(m_pBillboardShader->m_programID);
+        delete m_pBillboardShader;
+        m_pBillboardShader = nullptr;
+    }
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used to allocate the atlas with one tile
+ *  per view of every group, the depth buffer the views are
+ *  captured with, and the framebuffer that holds them.
+ ***********************************************************/
+bool ImpostorAtlas::Initialize(const std::vector<float>& groupRadii, int tileResolution) {
+    if (groupRadii.empty() || ((int)groupRadii.size() > MAX_GROUPS)) {
+        std::cout << "Error: Impostor atlas supports 1 to " << MAX_GROUPS << " groups" << std::endl;
+        return false;
+    }
+
+    m_pBillboardShader = new ShaderManager();
+    if (m_pBillboardShader->LoadShaders(g_ImpostorVertexShader, g_ImpostorFragmentShader) == 0) {
+        std::cout << "Error: Impostor shaders failed to load" << std::endl;
+        delete m_pBillboardShader;
+        m_pBillboardShader = nullptr;
+        return false;
+    }
+    ResourceTracker::TrackProgram(m_pBillboardShader->m_programID, "impostor atlas");
+
+    m_groupRadii = groupRadii;
+    m_maxRadius = *std::max_element(m_groupRadii.begin(), m_groupRadii.end());
+    m_tileResolution = tileResolution;
+
+    int tiles = (int)m_groupRadii.size() * VIEW_COUNT;
+    m_columns = std::min(tiles, MAX_ATLAS_COLUMNS);
+    m_rows = (tiles + m_columns - 1) / m_columns;
+    int width = m_columns * tileResolution;
+    int height = m_rows * tileResolution;
+
+    // the views are drawn at the size they are shown, so no mipmaps are needed
+    glGenTextures(1, &m_atlasTexture);
+    glBindTexture(GL_TEXTURE_2D, m_atlasTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    ResourceTracker::TrackTexture(m_atlasTexture, GL_RGBA8, width, height, 1, 1, "impostor atlas");
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenRenderbuffers(1, &m_depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    ResourceTracker::TrackRenderbuffer(m_depthBuffer, GL_DEPTH_COMPONENT24, width, height, "impostor atlas");
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &m_framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_atlasTexture, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_depthBuffer);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+
+    // empty texels stay transparent so the quads can drop them
+    if (status == GL_FRAMEBUFFER_COMPLETE) {
+        glViewport(0, 0, width, height);
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Error: Impostor atlas framebuffer is incomplete, status: " << status << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+/***********************************************************
+ *  BeginView()
+ *
+ *  This method is used to direct rendering into the tile of
+ *  one view of a group.  The views circle the group in yaw
+ *  steps at a few elevations, each looking at its origin
+ *  through an orthographic projection that fits the group's
+ *  bounding sphere into the tile.
+ ***********************************************************/
+void ImpostorAtlas::BeginView(int group, int view, glm::mat4& viewMatrix, glm::mat4& projection, glm::vec3& eye) {
+    int tile = group * VIEW_COUNT + view;
+    int column = tile % m_columns;
+    int row = tile / m_columns;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    glViewport(column * m_tileResolution, row * m_tileResolution, m_tileResolution, m_tileResolution);
+    glEnable(GL_DEPTH_TEST);
+
+    // must match the view the billboard shader picks for a direction
+    float yaw = glm::radians(360.0f * (float)(view % YAW_VIEWS) / (float)YAW_VIEWS);
+    float pitch = glm::radians(PITCH_STEP_DEGREES * (float)(view / YAW_VIEWS - PITCH_VIEWS / 2));
+    glm::vec3 direction(cos(pitch) * cos(yaw), sin(pitch), cos(pitch) * sin(yaw));
+
+    float radius = m_groupRadii[group];
+    eye = direction * (2.0f * radius);
+    viewMatrix = glm::lookAt(eye, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    projection = glm::ortho(-radius, radius, -radius, radius, radius, 3.0f * radius);
+}
+
+/***********************************************************
+ *  EndCapture()
+ *
+ *  This method is used to return to the default framebuffer
+ *  after the views have been captured.
+ ***********************************************************/
+void ImpostorAtlas::EndCapture() {
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+/***********************************************************
+ *  SwitchDistance()
+ *
+ *  This method returns the distance from which on the
+ *  largest group is drawn smaller than one tile, from the
+ *  vertical scale of the projection.  An orthographic
+ *  projection never shrinks the objects with distance, so
+ *  nothing switches under it.
+ ***********************************************************/
+float ImpostorAtlas::SwitchDistance(const glm::mat4& projection, int renderHeight) const {
+    // only a perspective projection copies the depth into w
+    if (projection[2][3] == 0.0f) {
+        return FLT_MAX;
+    }
+
+    // the diameter covers 2r * scale * height / 2 / distance pixels
+    return m_maxRadius * projection[1][1] * (float)renderHeight / (float)m_tileResolution;
+}
+
+/***********************************************************
+ *  BeginDraw()
+ *
+ *  This method is used to set up the billboard program and
+ *  the atlas for drawing instances with the frame camera.
+ ***********************************************************/
+void ImpostorAtlas::BeginDraw(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& cameraPosition) {
+    m_pBillboardShader->use();
+    m_pBillboardShader->setMat4Value("view", view);
+    m_pBillboardShader->setMat4Value("projection", projection);
+    m_pBillboardShader->setVec3Value("cameraPosition", cameraPosition);
+    for (size_t i = 0; i < m_groupRadii.size(); i++) {
+        m_pBillboardShader->setFloatValue("groupRadius[" + std::to_string(i) + "]", m_groupRadii[i]);
+    }
+    m_pBillboardShader->setIntValue("yawViews", YAW_VIEWS);
+    m_pBillboardShader->setIntValue("pitchViews", PITCH_VIEWS);
+    m_pBillboardShader->setFloatValue("pitchStep", glm::radians(PITCH_STEP_DEGREES));
+    m_pBillboardShader->setIntValue("atlasColumns", m_columns);
+    m_pBillboardShader->setVec2Value("tileSize", glm::vec2(1.0f / (float)m_columns, 1.0f / (float)m_rows));
+
+    glActiveTexture(GL_TEXTURE0 + TEXTURE_UNIT_IMPOSTOR_ATLAS);
+    glBindTexture(GL_TEXTURE_2D, m_atlasTexture);
+    m_pBillboardShader->setSampler2DValue("atlasTexture", TEXTURE_UNIT_IMPOSTOR_ATLAS);
+}
+
+/***********************************************************
+ *  Draw()
+ *
+ *  This method is used to draw one quad per instance, placed
+ *  by the passed in model matrix.
+ ***********************************************************/
+void ImpostorAtlas::Draw(const INSTANCE_BUFFER& instances, const glm::mat4& model) {
+    if (instances.count == 0) {
+        return;
+    }
+
+    m_pBillboardShader->setMat4Value("model", model);
+    glBindVertexArray(instances.vertexArray);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, instances.count);
+}
+
+/***********************************************************
+ *  EndDraw()
+ *
+ *  This method is used to unbind the instances after the
+ *  last draw.
+ ***********************************************************/
+void ImpostorAtlas::EndDraw() {
+    glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  UploadInstances()
+ *
+ *  This method is used to copy the instances into a static
+ *  buffer with a vertex array that steps once per instance.
+ ***********************************************************/
+bool ImpostorAtlas::UploadInstances(const std::vector<INSTANCE>& instances, INSTANCE_BUFFER& buffer) {
+    DestroyInstances(buffer);
+    if (instances.empty()) {
+        return false;
+    }
+
+    glGenVertexArrays(1, &buffer.vertexArray);
+    glBindVertexArray(buffer.vertexArray);
+
+    glGenBuffers(1, &buffer.buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer.buffer);
+    buffer.bufferBytes = instances.size() * sizeof(INSTANCE);
+    glBufferData(GL_ARRAY_BUFFER, buffer.bufferBytes, instances.data(), GL_STATIC_DRAW);
+    ResourceTracker::TrackBuffer(buffer.buffer, buffer.bufferBytes, "impostor instances");
+
+    glVertexAttribPointer(POSITION_SCALE_ATTRIBUTE, 4, GL_FLOAT, GL_FALSE, sizeof(INSTANCE),
+        (void*)offsetof(INSTANCE, positionScale));
+    glVertexAttribPointer(YAW_GROUP_ATTRIBUTE, 2, GL_FLOAT, GL_FALSE, sizeof(INSTANCE),
+        (void*)offsetof(INSTANCE, yawGroup));
+    glEnableVertexAttribArray(POSITION_SCALE_ATTRIBUTE);
+    glEnableVertexAttribArray(YAW_GROUP_ATTRIBUTE);
+    glVertexAttribDivisor(POSITION_SCALE_ATTRIBUTE, 1);
+    glVertexAttribDivisor(YAW_GROUP_ATTRIBUTE, 1);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    buffer.count = (int)instances.size();
+
+    return true;
+}
+
+/***********************************************************
+ *  DestroyInstances()
+ *
+ *  This method is used to release the GL objects of a set
+ *  of instances.
+ ***********************************************************/
+void ImpostorAtlas::DestroyInstances(INSTANCE_BUFFER& buffer) {
+    if (buffer.vertexArray != 0) {
+        glDeleteVertexArrays(1, &buffer.vertexArray);
+        buffer.vertexArray = 0;
+    }
+    if (buffer.buffer != 0) {
+        ResourceTracker::Release(ResourceTracker::CATEGORY_BUFFER, buffer.buffer);
+        glDeleteBuffers(1, &buffer.buffer);
+        buffer.buffer = 0;
+    }
+    buffer.count = 0;
+    buffer.bufferBytes = 0;
+}
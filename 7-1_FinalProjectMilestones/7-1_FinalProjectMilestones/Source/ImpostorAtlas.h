@@ -0,0 +1,81 @@
+///////////////////////////////////////////////////////////////////////////////
+// impostoratlas.h
+// ============
+// capture objects from a ring of view directions into a texture atlas and
+// draw distant copies of them as camera-facing quads
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+class ImpostorAtlas {
+public:
+    // views captured per group, around and above and below the object
+    static const int YAW_VIEWS = 8;
+    static const int PITCH_VIEWS = 5;
+    static const int VIEW_COUNT = YAW_VIEWS * PITCH_VIEWS;
+    // groups the billboard shader can tell apart
+    static const int MAX_GROUPS = 8;
+
+    // Struct to hold one impostor in an instance buffer
+    struct INSTANCE {
+        glm::vec4 positionScale;   // Position of the object origin and its scale
+        glm::vec2 yawGroup;        // Heading in radians and the captured group
+    };
+
+    // Struct to hold the GL objects of uploaded instances
+    struct INSTANCE_BUFFER {
+        GLuint vertexArray = 0;
+        GLuint buffer = 0;
+        int count = 0;
+        size_t bufferBytes = 0;
+    };
+
+    // constructor
+    ImpostorAtlas();
+    // destructor
+    ~ImpostorAtlas();
+
+    // allocate the atlas for one group per bounding radius and load the
+    // billboard shaders; each view is tileResolution pixels square
+    bool Initialize(const std::vector<float>& groupRadii, int tileResolution);
+
+    // prepare rendering one view of a group into its tile and get the camera
+    // it is captured with; the group is drawn around its own origin
+    void BeginView(int group, int view, glm::mat4& viewMatrix, glm::mat4& projection, glm::vec3& eye);
+    // return to the default framebuffer once every view is captured
+    void EndCapture();
+
+    // distance beyond which the largest group covers fewer pixels than a
+    // tile, so that drawing it as an impostor never magnifies the atlas
+    float SwitchDistance(const glm::mat4& projection, int renderHeight) const;
+
+    // draw instances with the camera of the frame
+    void BeginDraw(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& cameraPosition);
+    void Draw(const INSTANCE_BUFFER& instances, const glm::mat4& model);
+    void EndDraw();
+
+    // upload and release the instances of a set of impostors
+    static bool UploadInstances(const std::vector<INSTANCE>& instances, INSTANCE_BUFFER& buffer);
+    static void DestroyInstances(INSTANCE_BUFFER& buffer);
+
+    GLuint AtlasTexture() const { return m_atlasTexture; }
+    int GroupCount() const { return (int)m_groupRadii.size(); }
+
+private:
+    ShaderManager* m_pBillboardShader;
+    GLuint m_framebuffer;
+    GLuint m_atlasTexture;
+    GLuint m_depthBuffer;
+    int m_tileResolution;
+    int m_columns;
+    int m_rows;
+    std::vector<float> m_groupRadii;
+    float m_maxRadius;
+};
@@ -1,5 +1,6 @@
 #include <iostream>         // error handling and output
 #include <cstdlib>          // EXIT_FAILURE
+#include <string>           // command line options
 
 #include <GL/glew.h>        // GLEW library
 #include "GLFW/glfw3.h"     // GLFW library
@@ -13,6 +14,10 @@
 #include "ViewManager.h"
 #include "ShapeMeshes.h"
 #include "ShaderManager.h"
+#include "FrameStats.h"
+#include "FrameCapture.h"
+#include "ResourceTracker.h"
+#include "StartupTimer.h"
 
 // Namespace for declaring global variables
 namespace
@@ -29,12 +34,27 @@ namespace
 	ShaderManager* g_ShaderManager = nullptr;
 	// view manager object for managing the 3D view setup and projection to 2D
 	ViewManager* g_ViewManager = nullptr;
+	// frame statistics object for per-frame counters and GPU timings
+	FrameStats* g_FrameStats = nullptr;
+	// frame capture object for recording the rendered frames
+	FrameCapture* g_FrameCapture = nullptr;
+	// startup timer object for the phases up to the first frame
+	StartupTimer* g_StartupTimer = nullptr;
+	// file name prefix of the images captured with the C key
+	std::string g_CapturePrefix = "capture_";
+
+	// point light scaling sweep, the index is -1 when no sweep is running
+	const int MAX_POINT_LIGHTS = 1024;
+	int g_LightSweepCount = -1;
+	int g_LightSweepReport = 0;
 }
 
 // Function declarations - all functions that are called manually
 // need to be pre-declared at the beginning of the source code.
 bool InitializeGLFW();
 bool InitializeGLEW();
+void ProcessRenderOptionKeys();
+void UpdateLightSweep();
 
 
 /***********************************************************
@@ -45,13 +65,18 @@ bool InitializeGLEW();
  ***********************************************************/
 int main(int argc, char* argv[])
 {
+	// time the startup phases from here to the first presented frame
+	g_StartupTimer = new StartupTimer();
+
 	// if GLFW fails initialization, then terminate the application
+	g_StartupTimer->BeginPhase("GLFW init");
 	if (InitializeGLFW() == false)
 	{
 		return(EXIT_FAILURE);
 	}
 
 	// try to create a new shader manager object
+	g_StartupTimer->BeginPhase("window");
 	g_ShaderManager = new ShaderManager();
 	// try to create a new view manager object
 	g_ViewManager = new ViewManager(
@@ -61,25 +86,71 @@ int main(int argc, char* argv[])
 	g_Window = g_ViewManager->CreateDisplayWindow(WINDOW_TITLE);
 
 	// if GLEW fails initialization, then terminate the application
+	g_StartupTimer->BeginPhase("GLEW");
 	if (InitializeGLEW() == false)
 	{
 		return(EXIT_FAILURE);
 	}
 
 	// load the shader code from the external GLSL files
+	g_StartupTimer->BeginPhase("shader compile");
 	g_ShaderManager->LoadShaders(
-		"../../Utilities/shaders/vertexShader.glsl",
-		"../../Utilities/shaders/fragmentShader.glsl");
+		"Shaders/sceneVertexShader.glsl",
+		"Shaders/sceneFragmentShader.glsl");
 	g_ShaderManager->use();
+	ResourceTracker::TrackProgram(g_ShaderManager->m_programID, "scene program");
+	g_StartupTimer->EndPhase();
+
+	// create the frame statistics object used by the render passes
+	g_FrameStats = new FrameStats();
+	g_ViewManager->SetFrameStats(g_FrameStats);
 
-	// try to create a new scene manager object and prepare the 3D scene
-	g_SceneManager = new SceneManager(g_ShaderManager);
+	// try to create a new scene manager object and prepare the 3D scene,
+	// the shapes and textures it loads on first use are timed on their own
+	g_StartupTimer->BeginPhase("scene setup");
+	g_SceneManager = new SceneManager(g_ShaderManager, g_ViewManager, g_FrameStats);
+	g_SceneManager->SetStartupTimer(g_StartupTimer);
 	g_SceneManager->PrepareScene();
+	g_StartupTimer->EndPhase();
+
+	// create the frame capture object, it stays idle until started
+	g_FrameCapture = new FrameCapture(g_FrameStats);
+
+	// import any models passed on the command line with -model <file.obj>,
+	// and start capturing with -capture <prefix> or -capturepipe <command>
+	for (int i = 1; i + 1 < argc; i++)
+	{
+		if (std::string(argv[i]) == "-model")
+		{
+			g_SceneManager->ImportModel(argv[++i], "hull", glm::vec3(1.0f), 0.0f, 0.0f, 0.0f, glm::vec3(0.0f, 0.0f, 4.0f));
+		}
+		else if (std::string(argv[i]) == "-capture")
+		{
+			g_CapturePrefix = argv[++i];
+			g_FrameCapture->StartImageSequence(g_CapturePrefix);
+		}
+		else if (std::string(argv[i]) == "-capturepipe")
+		{
+			g_FrameCapture->StartPipe(argv[++i]);
+		}
+	}
 
 	// loop will keep running until the application is closed 
 	// or until an error has occurred
+	g_StartupTimer->BeginPhase("first frame");
 	while (!glfwWindowShouldClose(g_Window))
 	{
+		g_FrameStats->BeginFrame();
+
+		// poll the input and convert from 3D object space to 2D view; the
+		// events are polled here rather than after the swap so the camera
+		// uses the latest input when the frame is submitted, and before the
+		// scene target is bound so a resize is handled between frames
+		g_ViewManager->PrepareSceneView();
+
+		// render into the offscreen scene target at the current render scale
+		g_ViewManager->BeginFrame();
+
 		// Enable z-depth
 		glEnable(GL_DEPTH_TEST);
 
@@ -87,21 +158,39 @@ int main(int argc, char* argv[])
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		// convert from 3D object space to 2D view
-		g_ViewManager->PrepareSceneView();
+		// toggle the render passes from the keyboard
+		ProcessRenderOptionKeys();
 
 		// refresh the 3D scene
 		g_SceneManager->RenderScene();
 
+		// upscale the rendered scene into the display window
+		g_ViewManager->EndFrame();
+
+		// read back the finished frame while capturing
+		g_FrameCapture->CaptureFrame(g_ViewManager->WindowWidth(), g_ViewManager->WindowHeight());
 
 		// Flips the the back buffer with the front buffer every frame.
 		glfwSwapBuffers(g_Window);
+		g_ViewManager->FramePresented();
+
+		// report the startup once the first frame is on screen
+		if (!g_StartupTimer->IsReported())
+		{
+			g_StartupTimer->Report();
+		}
 
-		// query the latest GLFW events
-		glfwPollEvents();
+		g_FrameStats->EndFrame();
+		UpdateLightSweep();
 	}
 
-	// clear the allocated manager objects from memory
+	// clear the allocated manager objects from memory, the capture first
+	// so the frames still in flight are written out
+	if (NULL != g_FrameCapture)
+	{
+		delete g_FrameCapture;
+		g_FrameCapture = NULL;
+	}
 	if (NULL != g_SceneManager)
 	{
 		delete g_SceneManager;
@@ -114,9 +203,20 @@ int main(int argc, char* argv[])
 	}
 	if (NULL != g_ShaderManager)
 	{
+		ResourceTracker::DeleteProgram(g_ShaderManager->m_programID);
 		delete g_ShaderManager;
 		g_ShaderManager = NULL;
 	}
+	if (NULL != g_FrameStats)
+	{
+		delete g_FrameStats;
+		g_FrameStats = NULL;
+	}
+	if (NULL != g_StartupTimer)
+	{
+		delete g_StartupTimer;
+		g_StartupTimer = NULL;
+	}
 
 	// Terminates the program successfully
 	exit(EXIT_SUCCESS); 
@@ -174,4 +274,188 @@ bool InitializeGLEW()
 	std::cout << "INFO: OpenGL Version: " << glGetString(GL_VERSION) << "\n" << std::endl;
 
 	return(true);
+}
+
+/***********************************************************
+ *	ProcessRenderOptionKeys()
+ *
+ *  This function is used to toggle the optional render
+ *  passes from the keyboard.
+ ***********************************************************/
+void ProcessRenderOptionKeys()
+{
+	// Z toggles the depth-only pre-pass
+	if (g_ViewManager->WasKeyPressed(GLFW_KEY_Z))
+	{
+		g_SceneManager->SetDepthPrepass(!g_SceneManager->DepthPrepassEnabled());
+	}
+	// X toggles front-to-back sorting of the opaque objects
+	if (g_ViewManager->WasKeyPressed(GLFW_KEY_X))
+	{
+		g_SceneManager->SetFrontToBackSort(!g_SceneManager->FrontToBackSortEnabled());
+	}
+	// H toggles occlusion culling against the hierarchical depth buffer
+	if (g_ViewManager->WasKeyPressed(GLFW_KEY_H))
+	{
+		g_SceneManager->SetOcclusionCulling(!g_SceneManager->OcclusionCullingEnabled());
+	}
+	// G toggles the primary light shadows
+	if (g_ViewManager->WasKeyPressed(GLFW_KEY_G))
+	{
+		g_SceneManager->SetShadows(!g_SceneManager->ShadowsEnabled());
+	}
+	// J toggles the clustered point lights
+	if (g_ViewManager->WasKeyPressed(GLFW_KEY_J))
+	{
+		g_SceneManager->SetClusteredLights(!g_SceneManager->ClusteredLightsEnabled());
+	}
+	// B toggles drawing the baked static batches
+	if (g_ViewManager->WasKeyPressed(GLFW_KEY_B))
+	{
+		g_SceneManager->SetStaticBatching(!g_SceneManager->StaticBatchingEnabled());
+	}
+	// V toggles the compact vertex layout of the static batches
+	if (g_ViewManager->WasKeyPressed(GLFW_KEY_V))
+	{
+		g_SceneManager->SetCompactVertices(!g_SceneManager->CompactVerticesEnabled());
+	}
+	// U toggles the per-object shader variants against the uber program
+	if (g_ViewManager->WasKeyPressed(GLFW_KEY_U))
+	{
+		g_SceneManager->SetShaderVariants(!g_SceneManager->ShaderVariantsEnabled());
+	}
+	// T toggles timing the lit pass per shader variant
+	if (g_ViewManager->WasKeyPressed(GLFW_KEY_T))
+	{
+		g_SceneManager->SetVariantTiming(!g_SceneManager->VariantTimingEnabled());
+	}
+	// C starts or stops capturing the frames to numbered images
+	if (g_ViewManager->WasKeyPressed(GLFW_KEY_C))
+	{
+		if (g_FrameCapture->IsCapturing())
+		{
+			g_FrameCapture->Stop();
+		}
+		else
+		{
+			g_FrameCapture->StartImageSequence(g_CapturePrefix);
+		}
+	}
+	// N times the float and compact vertex layouts
+	if (g_ViewManager->WasKeyPressed(GLFW_KEY_N))
+	{
+		g_SceneManager->RunVertexBenchmark();
+	}
+	// F pauses or resumes the animation
+	if (g_ViewManager->WasKeyPressed(GLFW_KEY_F))
+	{
+		g_SceneManager->SetAnimation(!g_SceneManager->AnimationEnabled());
+	}
+	// M times the animation update over many generated tracks
+	if (g_ViewManager->WasKeyPressed(GLFW_KEY_M))
+	{
+		g_SceneManager->RunAnimationBenchmark();
+	}
+	// I times culling, sorting and moving a million entities
+	if (g_ViewManager->WasKeyPressed(GLFW_KEY_I))
+	{
+		g_SceneManager->RunEntityBenchmark();
+	}
+	// Y enables or disables streaming the fleet chunks around the camera
+	if (g_ViewManager->WasKeyPressed(GLFW_KEY_Y))
+	{
+		g_SceneManager->SetWorldStreaming(!g_SceneManager->WorldStreamingEnabled());
+	}
+	// 1 toggles drawing the distant fleet chunks as impostors
+	if (g_ViewManager->WasKeyPressed(GLFW_KEY_1))
+	{
+		g_SceneManager->SetImpostors(!g_SceneManager->ImpostorsEnabled());
+	}
+	// 2 toggles weighted blended transparency against sorted blending
+	if (g_ViewManager->WasKeyPressed(GLFW_KEY_2))
+	{
+		g_SceneManager->SetWeightedTransparency(!g_SceneManager->WeightedTransparencyEnabled());
+	}
+	// 3 picks the object under the center of the view
+	if (g_ViewManager->WasKeyPressed(GLFW_KEY_3))
+	{
+		RayQuery::HIT hit;
+		std::string tag;
+		if (g_SceneManager->PickObject(0.0f, 0.0f, hit, tag))
+		{
+			std::cout << "INFO: Picked " << tag << " at distance " << hit.distance << std::endl;
+		}
+		else
+		{
+			std::cout << "INFO: Nothing picked" << std::endl;
+		}
+	}
+	// 4 times casting a ray through every pixel against the scene
+	if (g_ViewManager->WasKeyPressed(GLFW_KEY_4))
+	{
+		g_SceneManager->RunRayBenchmark();
+	}
+	// 5 prints the GPU and host memory held by the render resources
+	if (g_ViewManager->WasKeyPressed(GLFW_KEY_5))
+	{
+		ResourceTracker::PrintSummary();
+	}
+	// 6 cycles through the single, split and cube map face views
+	if (g_ViewManager->WasKeyPressed(GLFW_KEY_6))
+	{
+		int mode = (g_ViewManager->GetViewMode() + 1) % ViewManager::VIEW_MODE_COUNT;
+		g_ViewManager->SetViewMode((ViewManager::VIEW_MODE)mode);
+	}
+	// L doubles the number of point lights, wrapping back to one
+	if (g_ViewManager->WasKeyPressed(GLFW_KEY_L))
+	{
+		int count = g_SceneManager->PointLightCount() * 2;
+		if ((count < 1) || (count > MAX_POINT_LIGHTS))
+		{
+			count = 1;
+		}
+		g_SceneManager->SetPointLightCount(count);
+	}
+	// K measures the frame with 1 to 1024 point lights
+	if (g_ViewManager->WasKeyPressed(GLFW_KEY_K) && (g_LightSweepCount < 0))
+	{
+		std::cout << "INFO: Point light sweep started" << std::endl;
+		g_LightSweepCount = 1;
+		g_LightSweepReport = g_FrameStats->ReportCount();
+		g_SceneManager->SetPointLightCount(g_LightSweepCount);
+	}
+}
+
+/***********************************************************
+ *	UpdateLightSweep()
+ *
+ *  This function is used to step the point light sweep.
+ *  Each light count is held for two report intervals, and
+ *  the averages of the second one, which contains no frames
+ *  rendered with the previous count, are printed.
+ ***********************************************************/
+void UpdateLightSweep()
+{
+	if ((g_LightSweepCount < 0) || (g_FrameStats->ReportCount() < g_LightSweepReport + 2))
+	{
+		return;
+	}
+
+	std::cout << "LIGHT SWEEP: " << g_LightSweepCount << " lights"
+		<< " | frame ms: " << g_FrameStats->GetAverage("frame ms")
+		<< " | lit pass: " << g_FrameStats->GetAverage("lit pass") << " ms"
+		<< " | light binning ms: " << g_FrameStats->GetAverage("light binning ms")
+		<< " | light assignments: " << g_FrameStats->GetAverage("light assignments")
+		<< std::endl;
+
+	g_LightSweepCount *= 2;
+	if (g_LightSweepCount > MAX_POINT_LIGHTS)
+	{
+		std::cout << "INFO: Point light sweep finished" << std::endl;
+		g_LightSweepCount = -1;
+		return;
+	}
+
+	g_LightSweepReport = g_FrameStats->ReportCount();
+	g_SceneManager->SetPointLightCount(g_LightSweepCount);
 }
\ No newline at end of file
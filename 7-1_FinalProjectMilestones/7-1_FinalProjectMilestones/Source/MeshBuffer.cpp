@@ -0,0 +1,238 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshbuffer.cpp
+// ============
+// own the vertex array, vertex buffer and index buffer of one uploaded mesh
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MeshBuffer.h"
+#include "ResourceTracker.h"
+#include <glm/gtx/transform.hpp>
+#include <glm/gtc/packing.hpp>
+#include <cstddef>
+#include <cmath>
+
+// declaration of the global variables and defines
+namespace {
+    // attribute locations used by the scene shaders
+    const GLuint POSITION_ATTRIBUTE = 0;
+    const GLuint NORMAL_ATTRIBUTE = 1;
+    const GLuint TEXTURE_COORDINATE_ATTRIBUTE = 2;
+
+    // Struct to hold one compact vertex, padded to 16 bytes
+    struct COMPACT_VERTEX {
+        GLshort position[4];            // normalized against the mesh bounds
+        GLshort normal[2];              // octahedral encoded unit normal
+        GLushort textureCoordinate[2];  // half floats
+    };
+
+    /***********************************************************
+     *  EncodeOctahedral()
+     *
+     *  Maps a unit normal onto the octahedron |x|+|y|+|z| = 1
+     *  and unfolds the lower half over the upper half, so the
+     *  normal fits in two signed components.  The vertex shader
+     *  reverses this.
+     ***********************************************************/
+    glm::vec2 EncodeOctahedral(const glm::vec3& normal) {
+        float sum = fabs(normal.x) + fabs(normal.y) + fabs(normal.z);
+        glm::vec2 encoded(normal.x / sum, normal.y / sum);
+        if (normal.z < 0.0f) {
+            glm::vec2 folded(
+                (1.0f - fabs(encoded.y)) * ((encoded.x >= 0.0f) ? 1.0f : -1.0f),
+                (1.0f - fabs(encoded.x)) * ((encoded.y >= 0.0f) ? 1.0f : -1.0f));
+            encoded = folded;
+        }
+
+        return encoded;
+    }
+}
+
+/***********************************************************
+ *  MeshBuffer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+MeshBuffer::MeshBuffer()
+    : m_vertexArray(0), m_vertexBuffer(0), m_indexBuffer(0),
+    m_vertexCount(0), m_indexCount(0), m_bufferBytes(0),
+    m_layout(LAYOUT_FLOAT), m_positionScale(1.0f), m_decodeMatrix(1.0f) {
+}
+
+/***********************************************************
+ *  ~MeshBuffer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+MeshBuffer::~MeshBuffer() {
+    Destroy();
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used to release the GL objects.
+ ***********************************************************/
+void MeshBuffer::Destroy() {
+    if (m_vertexArray != 0) {
+        glDeleteVertexArrays(1, &m_vertexArray);
+        m_vertexArray = 0;
+    }
+    if (m_vertexBuffer != 0) {
+        ResourceTracker::Release(ResourceTracker::CATEGORY_BUFFER, m_vertexBuffer);
+        glDeleteBuffers(1, &m_vertexBuffer);
+        m_vertexBuffer = 0;
+    }
+    if (m_indexBuffer != 0) {
+        ResourceTracker::Release(ResourceTracker::CATEGORY_BUFFER, m_indexBuffer);
+        glDeleteBuffers(1, &m_indexBuffer);
+        m_indexBuffer = 0;
+    }
+    m_vertexCount = 0;
+    m_indexCount = 0;
+    m_bufferBytes = 0;
+    m_positionScale = glm::vec3(1.0f);
+    m_decodeMatrix = glm::mat4(1.0f);
+}
+
+/***********************************************************
+ *  Upload()
+ *
+ *  This method is used to copy the geometry into static GL
+ *  buffers in the passed in vertex layout.
+ ***********************************************************/
+bool MeshBuffer::Upload(const PrimitiveGeometry& geometry, VERTEX_LAYOUT layout, const char* owner) {
+    Destroy();
+
+    const std::vector<unsigned int>& indices = geometry.Indices();
+    if (indices.empty()) {
+        return false;
+    }
+
+    size_t indexBytes = indices.size() * sizeof(unsigned int);
+
+    glGenVertexArrays(1, &m_vertexArray);
+    glBindVertexArray(m_vertexArray);
+
+    glGenBuffers(1, &m_vertexBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+    size_t vertexBytes = (layout == LAYOUT_COMPACT) ?
+        UploadCompactVertices(geometry) : UploadFloatVertices(geometry);
+
+    glGenBuffers(1, &m_indexBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, indices.data(), GL_STATIC_DRAW);
+
+    glEnableVertexAttribArray(POSITION_ATTRIBUTE);
+    glEnableVertexAttribArray(NORMAL_ATTRIBUTE);
+    glEnableVertexAttribArray(TEXTURE_COORDINATE_ATTRIBUTE);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    m_layout = layout;
+    m_vertexCount = (int)geometry.Vertices().size();
+    m_indexCount = (int)indices.size();
+    m_bufferBytes = vertexBytes + indexBytes;
+
+    ResourceTracker::TrackBuffer(m_vertexBuffer, vertexBytes, owner);
+    ResourceTracker::TrackBuffer(m_indexBuffer, indexBytes, owner);
+
+    return true;
+}
+
+/***********************************************************
+ *  UploadFloatVertices()
+ *
+ *  This method is used to upload the vertices interleaved
+ *  as full floats, the same way as the shape meshes.
+ ***********************************************************/
+size_t MeshBuffer::UploadFloatVertices(const PrimitiveGeometry& geometry) {
+    const std::vector<PrimitiveGeometry::VERTEX>& vertices = geometry.Vertices();
+    size_t vertexBytes = vertices.size() * sizeof(PrimitiveGeometry::VERTEX);
+    glBufferData(GL_ARRAY_BUFFER, vertexBytes, vertices.data(), GL_STATIC_DRAW);
+
+    GLsizei stride = sizeof(PrimitiveGeometry::VERTEX);
+    glVertexAttribPointer(POSITION_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, stride,
+        (void*)offsetof(PrimitiveGeometry::VERTEX, position));
+    glVertexAttribPointer(NORMAL_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, stride,
+        (void*)offsetof(PrimitiveGeometry::VERTEX, normal));
+    glVertexAttribPointer(TEXTURE_COORDINATE_ATTRIBUTE, 2, GL_FLOAT, GL_FALSE, stride,
+        (void*)offsetof(PrimitiveGeometry::VERTEX, textureCoordinate));
+
+    return vertexBytes;
+}
+
+/***********************************************************
+ *  UploadCompactVertices()
+ *
+ *  This method is used to upload the vertices in 16 bytes
+ *  each.  Positions are stored as normalized shorts across
+ *  the mesh bounds, and the decode matrix built here scales
+ *  and offsets them back, so the position shaders only need
+ *  it folded into their model matrix.  Normals are stored
+ *  octahedral encoded and UVs as half floats.
+ ***********************************************************/
+size_t MeshBuffer::UploadCompactVertices(const PrimitiveGeometry& geometry) {
+    glm::vec3 boundsMin;
+    glm::vec3 boundsMax;
+    geometry.GetBounds(boundsMin, boundsMax);
+
+    glm::vec3 bias = (boundsMin + boundsMax) * 0.5f;
+    glm::vec3 scale = (boundsMax - boundsMin) * 0.5f;
+    // a flat axis still needs a usable scale
+    for (int axis = 0; axis < 3; axis++) {
+        if (scale[axis] <= 0.0f) {
+            scale[axis] = 1.0f;
+        }
+    }
+    m_positionScale = scale;
+    m_decodeMatrix = glm::translate(bias) * glm::scale(scale);
+
+    const std::vector<PrimitiveGeometry::VERTEX>& vertices = geometry.Vertices();
+    std::vector<COMPACT_VERTEX> compactVertices(vertices.size());
+    for (size_t i = 0; i < vertices.size(); i++) {
+        const PrimitiveGeometry::VERTEX& vertex = vertices[i];
+        COMPACT_VERTEX& compact = compactVertices[i];
+
+        glm::vec3 position = (vertex.position - bias) / scale;
+        glm::vec2 normal = EncodeOctahedral(vertex.normal);
+        for (int axis = 0; axis < 3; axis++) {
+            compact.position[axis] = (GLshort)glm::packSnorm1x16(position[axis]);
+        }
+        compact.position[3] = 0;
+        compact.normal[0] = (GLshort)glm::packSnorm1x16(normal.x);
+        compact.normal[1] = (GLshort)glm::packSnorm1x16(normal.y);
+        compact.textureCoordinate[0] = glm::packHalf1x16(vertex.textureCoordinate.x);
+        compact.textureCoordinate[1] = glm::packHalf1x16(vertex.textureCoordinate.y);
+    }
+
+    size_t vertexBytes = compactVertices.size() * sizeof(COMPACT_VERTEX);
+    glBufferData(GL_ARRAY_BUFFER, vertexBytes, compactVertices.data(), GL_STATIC_DRAW);
+
+    GLsizei stride = sizeof(COMPACT_VERTEX);
+    glVertexAttribPointer(POSITION_ATTRIBUTE, 3, GL_SHORT, GL_TRUE, stride,
+        (void*)offsetof(COMPACT_VERTEX, position));
+    glVertexAttribPointer(NORMAL_ATTRIBUTE, 2, GL_SHORT, GL_TRUE, stride,
+        (void*)offsetof(COMPACT_VERTEX, normal));
+    glVertexAttribPointer(TEXTURE_COORDINATE_ATTRIBUTE, 2, GL_HALF_FLOAT, GL_FALSE, stride,
+        (void*)offsetof(COMPACT_VERTEX, textureCoordinate));
+
+    return vertexBytes;
+}
+
+/***********************************************************
+ *  Draw()
+ *
+ *  This method is used to draw the triangles of the mesh.
+ ***********************************************************/
+void MeshBuffer::Draw() const {
+    if (m_vertexArray == 0) {
+        return;
+    }
+
+    glBindVertexArray(m_vertexArray);
+    glDrawElements(GL_TRIANGLES, m_indexCount, GL_UNSIGNED_INT, nullptr);
+    glBindVertexArray(0);
+}
@@ -0,0 +1,62 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshbuffer.h
+// ============
+// own the vertex array, vertex buffer and index buffer of one uploaded mesh
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "PrimitiveGeometry.h"
+#include <GL/glew.h>
+
+class MeshBuffer {
+public:
+    // Enum for the vertex formats a mesh can be stored in
+    enum VERTEX_LAYOUT {
+        LAYOUT_FLOAT,      // 32 bytes: float position, normal and UV
+        LAYOUT_COMPACT     // 16 bytes: 16-bit position, octahedral normal, half UV
+    };
+
+    // constructor
+    MeshBuffer();
+    // destructor
+    ~MeshBuffer();
+
+    // upload the vertices and indices, replacing any earlier contents; the
+    // owner tags the buffers in the resource accounting
+    bool Upload(const PrimitiveGeometry& geometry, VERTEX_LAYOUT layout = LAYOUT_FLOAT,
+        const char* owner = "mesh buffer");
+    // release the GL objects
+    void Destroy();
+
+    // draw every triangle of the mesh
+    void Draw() const;
+
+    // get the matrix that expands compact positions back to object space,
+    // to be applied before the model matrix; identity for float vertices
+    const glm::mat4& DecodeMatrix() const { return m_decodeMatrix; }
+    // get the per axis position scale that the decode matrix applies
+    const glm::vec3& PositionScale() const { return m_positionScale; }
+    VERTEX_LAYOUT Layout() const { return m_layout; }
+
+    int VertexCount() const { return m_vertexCount; }
+    int IndexCount() const { return m_indexCount; }
+    // get the bytes used by the vertex and index buffers
+    size_t BufferBytes() const { return m_bufferBytes; }
+
+private:
+    GLuint m_vertexArray;
+    GLuint m_vertexBuffer;
+    GLuint m_indexBuffer;
+    int m_vertexCount;
+    int m_indexCount;
+    size_t m_bufferBytes;
+    VERTEX_LAYOUT m_layout;
+    glm::vec3 m_positionScale;
+    glm::mat4 m_decodeMatrix;
+
+    size_t UploadFloatVertices(const PrimitiveGeometry& geometry);
+    size_t UploadCompactVertices(const PrimitiveGeometry& geometry);
+};
@@ -0,0 +1,510 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshimporter.cpp
+// ============
+// import large OBJ models by memory mapping the file and parsing chunks of
+// it in parallel
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MeshImporter.h"
+#include <GLFW/glfw3.h>
+#include <iostream>
+#include <thread>
+#include <unordered_map>
+#include <algorithm>
+#include <functional>
+#include <climits>
+#include <cstdint>
+#include <cmath>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// declaration of the global variables and defines
+namespace {
+    // marks a corner without a UV or normal
+    const int NO_INDEX = INT_MIN;
+
+    // smallest chunk worth handing to its own thread
+    const size_t MIN_CHUNK_BYTES = 1 << 20;
+
+    /***********************************************************
+     *  MappedFile
+     *
+     *  Maps a whole file read-only into memory so the parser
+     *  threads can read it without copying.
+     ***********************************************************/
+    class MappedFile {
+    public:
+        MappedFile() : m_pData(nullptr), m_size(0) {
+#ifdef _WIN32
+            m_file = INVALID_HANDLE_VALUE;
+            m_mapping = NULL;
+#endif
+        }
+        ~MappedFile() { Close(); }
+
+        bool Open(const char* filename) {
+#ifdef _WIN32
+            m_file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL,
+                OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+            if (m_file == INVALID_HANDLE_VALUE) {
+                return false;
+            }
+            LARGE_INTEGER size;
+            if (!GetFileSizeEx(m_file, &size) || (size.QuadPart == 0)) {
+                return false;
+            }
+            m_mapping = CreateFileMappingA(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+            if (m_mapping == NULL) {
+                return false;
+            }
+            m_pData = (const char*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+            m_size = (size_t)size.QuadPart;
+#else
+            int file = open(filename, O_RDONLY);
+            if (file < 0) {
+                return false;
+            }
+            struct stat status;
+            if ((fstat(file, &status) != 0) || (status.st_size == 0)) {
+                close(file);
+                return false;
+            }
+            void* pData = mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+            close(file);
+            if (pData == MAP_FAILED) {
+                return false;
+            }
+            madvise(pData, (size_t)status.st_size, MADV_SEQUENTIAL);
+            m_pData = (const char*)pData;
+            m_size = (size_t)status.st_size;
+#endif
+            return m_pData != nullptr;
+        }
+
+        void Close() {
+#ifdef _WIN32
+            if (m_pData) {
+                UnmapViewOfFile(m_pData);
+            }
+            if (m_mapping != NULL) {
+                CloseHandle(m_mapping);
+                m_mapping = NULL;
+            }
+            if (m_file != INVALID_HANDLE_VALUE) {
+                CloseHandle(m_file);
+                m_file = INVALID_HANDLE_VALUE;
+            }
+#else
+            if (m_pData) {
+                munmap((void*)m_pData, m_size);
+            }
+#endif
+            m_pData = nullptr;
+            m_size = 0;
+        }
+
+        const char* Data() const { return m_pData; }
+        size_t Size() const { return m_size; }
+
+    private:
+        const char* m_pData;
+        size_t m_size;
+#ifdef _WIN32
+        HANDLE m_file;
+        HANDLE m_mapping;
+#endif
+    };
+
+    // the tokenizer works on raw pointers and never reads past the chunk end
+
+    inline void SkipSpaces(const char*& p, const char* end) {
+        while ((p < end) && ((*p == ' ') || (*p == '\t'))) {
+            p++;
+        }
+    }
+
+    inline void SkipLine(const char*& p, const char* end) {
+        while ((p < end) && (*p != '\n')) {
+            p++;
+        }
+        if (p < end) {
+            p++;
+        }
+    }
+
+    inline bool ParseInt(const char*& p, const char* end, int& value) {
+        bool bNegative = false;
+        if ((p < end) && ((*p == '-') || (*p == '+'))) {
+            bNegative = (*p == '-');
+            p++;
+        }
+        if ((p >= end) || (*p < '0') || (*p > '9')) {
+            return false;
+        }
+        int result = 0;
+        while ((p < end) && (*p >= '0') && (*p <= '9')) {
+            result = result * 10 + (*p - '0');
+            p++;
+        }
+        value = bNegative ? -result : result;
+        return true;
+    }
+
+    inline float ParseFloat(const char*& p, const char* end) {
+        SkipSpaces(p, end);
+        bool bNegative = false;
+        if ((p < end) && ((*p == '-') || (*p == '+'))) {
+            bNegative = (*p == '-');
+            p++;
+        }
+
+        double mantissa = 0.0;
+        while ((p < end) && (*p >= '0') && (*p <= '9')) {
+            mantissa = mantissa * 10.0 + (*p - '0');
+            p++;
+        }
+        if ((p < end) && (*p == '.')) {
+            p++;
+            double place = 0.1;
+            while ((p < end) && (*p >= '0') && (*p <= '9')) {
+                mantissa += (*p - '0') * place;
+                place *= 0.1;
+                p++;
+            }
+        }
+        if ((p < end) && ((*p == 'e') || (*p == 'E'))) {
+            p++;
+            int exponent = 0;
+            if (ParseInt(p, end, exponent)) {
+                mantissa *= pow(10.0, exponent);
+            }
+        }
+
+        return (float)(bNegative ? -mantissa : mantissa);
+    }
+
+    // Struct to hash the unique position, UV and normal combinations
+    struct CORNER_KEY {
+        int position;
+        int textureCoordinate;
+        int normal;
+        bool operator==(const CORNER_KEY& other) const {
+            return (position == other.position) && (textureCoordinate == other.textureCoordinate) && (normal == other.normal);
+        }
+    };
+    struct CORNER_HASH {
+        size_t operator()(const CORNER_KEY& key) const {
+            uint64_t hash = (uint64_t)(uint32_t)key.position * 0x9E3779B97F4A7C15ull;
+            hash ^= (uint64_t)(uint32_t)key.textureCoordinate * 0xC2B2AE3D27D4EB4Full + (hash >> 29);
+            hash ^= (uint64_t)(uint32_t)key.normal * 0x165667B19E3779F9ull + (hash >> 32);
+            return (size_t)hash;
+        }
+    };
+}
+
+/***********************************************************
+ *  MeshImporter()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+MeshImporter::MeshImporter()
+    : m_threadCount(0), m_importSeconds(0.0), m_fileBytes(0), m_triangleCount(0) {
+}
+
+/***********************************************************
+ *  ParseChunk()
+ *
+ *  This method is used to parse the lines of one chunk.  It
+ *  only touches its own chunk, so every chunk can be parsed
+ *  on its own thread.  Polygons are fanned into triangles.
+ ***********************************************************/
+void MeshImporter::ParseChunk(CHUNK& chunk) {
+    const char* p = chunk.begin;
+    const char* end = chunk.end;
+    std::vector<CORNER> polygon;
+
+    while (p < end) {
+        SkipSpaces(p, end);
+        if (p >= end) {
+            break;
+        }
+
+        if ((p[0] == 'v') && (p + 1 < end) && ((p[1] == ' ') || (p[1] == '\t'))) {
+            p += 2;
+            glm::vec3 position;
+            position.x = ParseFloat(p, end);
+            position.y = ParseFloat(p, end);
+            position.z = ParseFloat(p, end);
+            chunk.positions.push_back(position);
+        }
+        else if ((p[0] == 'v') && (p + 2 < end) && (p[1] == 't')) {
+            p += 2;
+            glm::vec2 textureCoordinate;
+            textureCoordinate.x = ParseFloat(p, end);
+            textureCoordinate.y = ParseFloat(p, end);
+            chunk.textureCoordinates.push_back(textureCoordinate);
+        }
+        else if ((p[0] == 'v') && (p + 2 < end) && (p[1] == 'n')) {
+            p += 2;
+            glm::vec3 normal;
+            normal.x = ParseFloat(p, end);
+            normal.y = ParseFloat(p, end);
+            normal.z = ParseFloat(p, end);
+            chunk.normals.push_back(normal);
+        }
+        else if ((p[0] == 'f') && (p + 1 < end) && ((p[1] == ' ') || (p[1] == '\t'))) {
+            p += 2;
+            polygon.clear();
+
+            // each corner is v, v/vt, v//vn or v/vt/vn
+            while (true) {
+                SkipSpaces(p, end);
+                int indices[3] = { NO_INDEX, NO_INDEX, NO_INDEX };
+                if (!ParseInt(p, end, indices[0])) {
+                    break;
+                }
+                for (int part = 1; (part < 3) && (p < end) && (*p == '/'); part++) {
+                    p++;
+                    ParseInt(p, end, indices[part]);
+                }
+
+                // OBJ indices are one based, or negative counting back from
+                // the newest element, which is only known relative to the
+                // start of this chunk (and may reach into earlier chunks)
+                int counts[3] = { (int)chunk.positions.size(), (int)chunk.textureCoordinates.size(), (int)chunk.normals.size() };
+                CORNER corner;
+                corner.relativeMask = 0;
+                for (int part = 0; part < 3; part++) {
+                    if (indices[part] > 0) {
+                        indices[part] = indices[part] - 1;
+                    }
+                    else if ((indices[part] < 0) && (indices[part] != NO_INDEX)) {
+                        indices[part] = counts[part] + indices[part];
+                        corner.relativeMask |= (unsigned char)(1 << part);
+                    }
+                    else if (indices[part] == 0) {
+                        chunk.bValid = false;
+                    }
+                    corner.indices[part] = indices[part];
+                }
+                polygon.push_back(corner);
+            }
+
+            for (size_t i = 2; i < polygon.size(); i++) {
+                chunk.corners.push_back(polygon[0]);
+                chunk.corners.push_back(polygon[i - 1]);
+                chunk.corners.push_back(polygon[i]);
+            }
+        }
+
+        SkipLine(p, end);
+    }
+}
+
+/***********************************************************
+ *  BuildGeometry()
+ *
+ *  This method is used to join the parsed chunks.  Chunk
+ *  relative indices are made absolute, and every unique
+ *  combination of position, UV and normal becomes one
+ *  vertex through a hash map.  Missing normals are built
+ *  from the area weighted face normals.  A position index
+ *  out of range marks its chunk invalid and fails the build.
+ ***********************************************************/
+bool MeshImporter::BuildGeometry(std::vector<CHUNK>& chunks, PrimitiveGeometry& geometry) {
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec2> textureCoordinates;
+    std::vector<glm::vec3> normals;
+    size_t cornerCount = 0;
+    for (size_t c = 0; c < chunks.size(); c++) {
+        cornerCount += chunks[c].corners.size();
+    }
+
+    std::vector<PrimitiveGeometry::VERTEX> vertices;
+    std::vector<unsigned int> indices;
+    indices.reserve(cornerCount);
+    std::unordered_map<CORNER_KEY, unsigned int, CORNER_HASH> uniqueCorners;
+    uniqueCorners.reserve(cornerCount / 3);
+    bool bMissingNormals = false;
+
+    for (size_t c = 0; c < chunks.size(); c++) {
+        CHUNK& chunk = chunks[c];
+        int firsts[3] = { (int)positions.size(), (int)textureCoordinates.size(), (int)normals.size() };
+        positions.insert(positions.end(), chunk.positions.begin(), chunk.positions.end());
+        textureCoordinates.insert(textureCoordinates.end(), chunk.textureCoordinates.begin(), chunk.textureCoordinates.end());
+        normals.insert(normals.end(), chunk.normals.begin(), chunk.normals.end());
+        int sizes[3] = { (int)positions.size(), (int)textureCoordinates.size(), (int)normals.size() };
+
+        for (size_t i = 0; i < chunk.corners.size(); i++) {
+            const CORNER& corner = chunk.corners[i];
+            int resolved[3];
+            for (int part = 0; part < 3; part++) {
+                resolved[part] = corner.indices[part];
+                if (corner.relativeMask & (1 << part)) {
+                    resolved[part] += firsts[part];
+                }
+                if ((resolved[part] != NO_INDEX) && ((resolved[part] < 0) || (resolved[part] >= sizes[part]))) {
+                    // indices may only refer to elements defined earlier; a
+                    // corner needs its position, the UV and normal are optional
+                    if (part == 0) {
+                        chunk.bValid = false;
+                        return false;
+                    }
+                    resolved[part] = NO_INDEX;
+                }
+            }
+
+            CORNER_KEY key = { resolved[0], resolved[1], resolved[2] };
+            auto found = uniqueCorners.find(key);
+            if (found != uniqueCorners.end()) {
+                indices.push_back(found->second);
+                continue;
+            }
+
+            PrimitiveGeometry::VERTEX vertex;
+            vertex.position = positions[key.position];
+            vertex.textureCoordinate = (key.textureCoordinate != NO_INDEX) ? textureCoordinates[key.textureCoordinate] : glm::vec2(0.0f);
+            vertex.normal = (key.normal != NO_INDEX) ? normals[key.normal] : glm::vec3(0.0f);
+            bMissingNormals = bMissingNormals || (key.normal == NO_INDEX);
+
+            unsigned int index = (unsigned int)vertices.size();
+            vertices.push_back(vertex);
+            uniqueCorners.emplace(key, index);
+            indices.push_back(index);
+        }
+
+        // the chunk data has been copied, free it as early as possible
+        std::vector<glm::vec3>().swap(chunk.positions);
+        std::vector<glm::vec2>().swap(chunk.textureCoordinates);
+        std::vector<glm::vec3>().swap(chunk.normals);
+        std::vector<CORNER>().swap(chunk.corners);
+    }
+
+    if (bMissingNormals) {
+        for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+            PrimitiveGeometry::VERTEX& a = vertices[indices[i]];
+            PrimitiveGeometry::VERTEX& b = vertices[indices[i + 1]];
+            PrimitiveGeometry::VERTEX& c = vertices[indices[i + 2]];
+            glm::vec3 faceNormal = glm::cross(b.position - a.position, c.position - a.position);
+            a.normal += faceNormal;
+            b.normal += faceNormal;
+            c.normal += faceNormal;
+        }
+    }
+    for (size_t i = 0; i < vertices.size(); i++) {
+        float length = glm::length(vertices[i].normal);
+        vertices[i].normal = (length > 0.0f) ? vertices[i].normal / length : glm::vec3(0.0f, 1.0f, 0.0f);
+    }
+
+    geometry.Assign(vertices, indices);
+
+    return true;
+}
+
+/***********************************************************
+ *  ImportObj()
+ *
+ *  This method is used to import an OBJ file.  The file is
+ *  memory mapped and split at line breaks into one chunk per
+ *  thread, the chunks are parsed in parallel and then joined
+ *  in file order.  The throughput is written to the console.
+ ***********************************************************/
+bool MeshImporter::ImportObj(const char* filename, PrimitiveGeometry& geometry) {
+    double startTime = glfwGetTime();
+    m_importSeconds = 0.0;
+    m_fileBytes = 0;
+    m_triangleCount = 0;
+
+    MappedFile file;
+    if (!file.Open(filename)) {
+        std::cout << "Could not open model file: " << filename << std::endl;
+        return false;
+    }
+
+    const char* data = file.Data();
+    size_t size = file.Size();
+    m_fileBytes = size;
+
+    int threads = m_threadCount;
+    if (threads <= 0) {
+        threads = std::max(1, (int)std::thread::hardware_concurrency());
+    }
+    threads = std::max(1, std::min(threads, (int)(size / MIN_CHUNK_BYTES) + 1));
+
+    // split at the first line break after each even share of the file
+    std::vector<CHUNK> chunks(threads);
+    const char* chunkBegin = data;
+    for (int t = 0; t < threads; t++) {
+        const char* chunkEnd = data + size;
+        if (t < threads - 1) {
+            chunkEnd = std::max(chunkBegin, data + size * (t + 1) / threads);
+            while ((chunkEnd < data + size) && (*chunkEnd != '\n')) {
+                chunkEnd++;
+            }
+            if (chunkEnd < data + size) {
+                chunkEnd++;
+            }
+        }
+        chunks[t].begin = chunkBegin;
+        chunks[t].end = chunkEnd;
+        chunkBegin = chunkEnd;
+    }
+
+    std::vector<std::thread> workers;
+    for (int t = 1; t < threads; t++) {
+        workers.push_back(std::thread(ParseChunk, std::ref(chunks[t])));
+    }
+    ParseChunk(chunks[0]);
+    for (size_t t = 0; t < workers.size(); t++) {
+        workers[t].join();
+    }
+    double parseTime = glfwGetTime();
+
+    size_t positionCount = 0;
+    for (int t = 0; t < threads; t++) {
+        if (!chunks[t].bValid) {
+            std::cout << "Invalid face index in model file: " << filename << std::endl;
+            return false;
+        }
+        positionCount += chunks[t].positions.size();
+    }
+    if (positionCount == 0) {
+        std::cout << "No vertex positions in model file: " << filename << std::endl;
+        return false;
+    }
+
+    if (!BuildGeometry(chunks, geometry)) {
+        std::cout << "Invalid face index in model file: " << filename << std::endl;
+        return false;
+    }
+    file.Close();
+
+    double endTime = glfwGetTime();
+    m_importSeconds = endTime - startTime;
+    m_triangleCount = (int)geometry.Indices().size() / 3;
+
+    double megabytes = size / (1024.0 * 1024.0);
+    std::cout << "INFO: Imported " << filename << ": " << megabytes << " MB, "
+        << m_triangleCount << " triangles, " << geometry.Vertices().size() << " vertices in "
+        << m_importSeconds * 1000.0 << " ms (" << threads << " threads, parse "
+        << (parseTime - startTime) * 1000.0 << " ms, merge " << (endTime - parseTime) * 1000.0 << " ms) | "
+        << megabytes / m_importSeconds << " MB/s | "
+        << m_triangleCount / m_importSeconds << " triangles/s" << std::endl;
+
+    return m_triangleCount > 0;
+}
@@ -0,0 +1,59 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshimporter.h
+// ============
+// import large OBJ models by memory mapping the file and parsing chunks of
+// it in parallel
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "PrimitiveGeometry.h"
+#include <glm/glm.hpp>
+#include <vector>
+
+class MeshImporter {
+public:
+    // constructor
+    MeshImporter();
+
+    // import an OBJ file into the passed in geometry, returns false on failure
+    bool ImportObj(const char* filename, PrimitiveGeometry& geometry);
+
+    // set the number of parsing threads, zero uses one per hardware thread
+    void SetThreadCount(int count) { m_threadCount = count; }
+
+    // get the statistics of the last import
+    double ImportSeconds() const { return m_importSeconds; }
+    size_t FileBytes() const { return m_fileBytes; }
+    int TriangleCount() const { return m_triangleCount; }
+
+private:
+    // Struct to hold one triangle corner as OBJ position, UV and normal indices.
+    // Indices are zero based; the ones flagged in the relative mask count
+    // from the first element of the chunk until the chunks are joined
+    struct CORNER {
+        int indices[3];
+        unsigned char relativeMask;
+    };
+
+    // Struct to hold everything parsed from one chunk of the file
+    struct CHUNK {
+        const char* begin = nullptr;
+        const char* end = nullptr;
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec2> textureCoordinates;
+        std::vector<glm::vec3> normals;
+        std::vector<CORNER> corners;     // three per triangle
+        bool bValid = true;
+    };
+
+    int m_threadCount;
+    double m_importSeconds;
+    size_t m_fileBytes;
+    int m_triangleCount;
+
+    static void ParseChunk(CHUNK& chunk);
+    bool BuildGeometry(std::vector<CHUNK>& chunks, PrimitiveGeometry& geometry);
+};
@@ -0,0 +1,480 @@
+///////////////////////////////////////////////////////////////////////////////
+// primitivegeometry.cpp
+// ============
+// build the basic shapes as CPU side vertex and index lists so that they
+// can be transformed and merged before they are uploaded
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "PrimitiveGeometry.h"
+#include <cmath>
+#include <cfloat>
+
+// declaration of the global variables and defines
+namespace {
+    // tessellation of the round shapes, as the shape meshes build them
+    const int CYLINDER_SLICES = 36;
+    const int SPHERE_SLICES = 36;
+    const int SPHERE_STACKS = 18;
+    const int TORUS_MAIN_SEGMENTS = 30;
+    const int TORUS_TUBE_SEGMENTS = 30;
+
+    // torus radii, matching the torus shape mesh
+    const float TORUS_MAIN_RADIUS = 1.0f;
+    const float TORUS_TUBE_RADIUS = 0.2f;
+
+    const float PI = 3.14159265f;
+
+    // faces of the box in the order of the box shape mesh, each with its
+    // normal and its corners in the order the texture is laid from
+    // (0, 1), (0, 0), (1, 0) to (1, 1)
+    struct BOX_FACE {
+        glm::vec3 normal;
+        glm::vec3 corners[4];
+    };
+    const BOX_FACE g_BoxFaces[6] = {
+        { glm::vec3(0.0f, 0.0f, -1.0f), { glm::vec3(0.5f, 0.5f, -0.5f), glm::vec3(0.5f, -0.5f, -0.5f), glm::vec3(-0.5f, -0.5f, -0.5f), glm::vec3(-0.5f, 0.5f, -0.5f) } },
+        { glm::vec3(0.0f, -1.0f, 0.0f), { glm::vec3(-0.5f, -0.5f, 0.5f), glm::vec3(-0.5f, -0.5f, -0.5f), glm::vec3(0.5f, -0.5f, -0.5f), glm::vec3(0.5f, -0.5f, 0.5f) } },
+        { glm::vec3(-1.0f, 0.0f, 0.0f), { glm::vec3(-0.5f, 0.5f, -0.5f), glm::vec3(-0.5f, -0.5f, -0.5f), glm::vec3(-0.5f, -0.5f, 0.5f), glm::vec3(-0.5f, 0.5f, 0.5f) } },
+        { glm::vec3(1.0f, 0.0f, 0.0f), { glm::vec3(0.5f, 0.5f, 0.5f), glm::vec3(0.5f, -0.5f, 0.5f), glm::vec3(0.5f, -0.5f, -0.5f), glm::vec3(0.5f, 0.5f, -0.5f) } },
+        { glm::vec3(0.0f, 1.0f, 0.0f), { glm::vec3(-0.5f, 0.5f, -0.5f), glm::vec3(-0.5f, 0.5f, 0.5f), glm::vec3(0.5f, 0.5f, 0.5f), glm::vec3(0.5f, 0.5f, -0.5f) } },
+        { glm::vec3(0.0f, 0.0f, 1.0f), { glm::vec3(-0.5f, 0.5f, 0.5f), glm::vec3(-0.5f, -0.5f, 0.5f), glm::vec3(0.5f, -0.5f, 0.5f), glm::vec3(0.5f, 0.5f, 0.5f) } }
+    };
+    const glm::vec2 g_BoxFaceCoordinates[4] = {
+        glm::vec2(0.0f, 1.0f), glm::vec2(0.0f, 0.0f), glm::vec2(1.0f, 0.0f), glm::vec2(1.0f, 1.0f)
+    };
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used to remove every vertex and index.
+ ***********************************************************/
+void PrimitiveGeometry::Clear() {
+    m_vertices.clear();
+    m_indices.clear();
+}
+
+/***********************************************************
+ *  Assign()
+ *
+ *  This method is used to take over the passed in vertex and
+ *  index lists without copying them.
+ ***********************************************************/
+void PrimitiveGeometry::Assign(std::vector<VERTEX>& vertices, std::vector<unsigned int>& indices) {
+    Clear();
+    m_vertices.swap(vertices);
+    m_indices.swap(indices);
+}
+
+/***********************************************************
+ *  AddVertex()
+ *
+ *  This method is used to add a vertex and return its index.
+ ***********************************************************/
+unsigned int PrimitiveGeometry::AddVertex(const glm::vec3& position, const glm::vec3& normal, const glm::vec2& textureCoordinate) {
+    VERTEX vertex;
+    vertex.position = position;
+    vertex.normal = normal;
+    vertex.textureCoordinate = textureCoordinate;
+    m_vertices.push_back(vertex);
+
+    return((unsigned int)m_vertices.size() - 1);
+}
+
+/***********************************************************
+ *  AddTriangle()
+ *
+ *  This method is used to add a triangle.  The winding is
+ *  flipped when needed so that the front face always points
+ *  along the vertex normals, which keeps every builder free
+ *  of winding bookkeeping.
+ ***********************************************************/
+void PrimitiveGeometry::AddTriangle(unsigned int a, unsigned int b, unsigned int c) {
+    const glm::vec3& pa = m_vertices[a].position;
+    const glm::vec3& pb = m_vertices[b].position;
+    const glm::vec3& pc = m_vertices[c].position;
+    glm::vec3 faceNormal = glm::cross(pb - pa, pc - pa);
+    glm::vec3 vertexNormal = m_vertices[a].normal + m_vertices[b].normal + m_vertices[c].normal;
+
+    m_indices.push_back(a);
+    if (glm::dot(faceNormal, vertexNormal) < 0.0f) {
+        m_indices.push_back(c);
+        m_indices.push_back(b);
+    }
+    else {
+        m_indices.push_back(b);
+        m_indices.push_back(c);
+    }
+}
+
+/***********************************************************
+ *  AddQuad()
+ *
+ *  This method is used to add a quad from its four corners
+ *  in order around the edge.
+ ***********************************************************/
+void PrimitiveGeometry::AddQuad(unsigned int a, unsigned int b, unsigned int c, unsigned int d) {
+    AddTriangle(a, b, c);
+    AddTriangle(a, c, d);
+}
+
+/***********************************************************
+ *  AddCap()
+ *
+ *  This method is used to add a flat disc around the Y axis.
+ *  Like the shape meshes it is a fan from the first rim
+ *  vertex, with no center vertex, and the texture is laid
+ *  with U along Z and V along X.
+ ***********************************************************/
+void PrimitiveGeometry::AddCap(float radius, float height, const glm::vec3& normal) {
+    unsigned int first = (unsigned int)m_vertices.size();
+    for (int i = 0; i < CYLINDER_SLICES; i++) {
+        float angle = 2.0f * PI * (float)i / CYLINDER_SLICES;
+        float x = cos(angle);
+        float z = -sin(angle);
+        AddVertex(glm::vec3(x * radius, height, z * radius), normal, glm::vec2(0.5f + 0.5f * z, 0.5f + 0.5f * x));
+    }
+    for (int i = 1; i + 1 < CYLINDER_SLICES; i++) {
+        AddTriangle(first, first + i, first + i + 1);
+    }
+}
+
+/***********************************************************
+ *  BuildPlane()
+ *
+ *  This method is used to build a 2x2 plane in XZ facing +Y.
+ ***********************************************************/
+void PrimitiveGeometry::BuildPlane() {
+    Clear();
+
+    glm::vec3 normal(0.0f, 1.0f, 0.0f);
+    unsigned int a = AddVertex(glm::vec3(-1.0f, 0.0f, -1.0f), normal, glm::vec2(0.0f, 1.0f));
+    unsigned int b = AddVertex(glm::vec3(-1.0f, 0.0f, 1.0f), normal, glm::vec2(0.0f, 0.0f));
+    unsigned int c = AddVertex(glm::vec3(1.0f, 0.0f, 1.0f), normal, glm::vec2(1.0f, 0.0f));
+    unsigned int d = AddVertex(glm::vec3(1.0f, 0.0f, -1.0f), normal, glm::vec2(1.0f, 1.0f));
+    AddQuad(a, b, c, d);
+}
+
+/***********************************************************
+ *  BuildBox()
+ *
+ *  This method is used to build a unit box centered on the
+ *  origin, with separate vertices for each face laid out as
+ *  the box shape mesh has them.
+ ***********************************************************/
+void PrimitiveGeometry::BuildBox() {
+    Clear();
+
+    for (int face = 0; face < 6; face++) {
+        const BOX_FACE& boxFace = g_BoxFaces[face];
+        unsigned int corners[4];
+        for (int i = 0; i < 4; i++) {
+            corners[i] = AddVertex(boxFace.corners[i], boxFace.normal, g_BoxFaceCoordinates[i]);
+        }
+        // the shape mesh splits each face from the first corner to the third
+        AddQuad(corners[0], corners[1], corners[2], corners[3]);
+    }
+}
+
+/***********************************************************
+ *  BuildCylinder()
+ *
+ *  This method is used to build a cylinder one unit tall
+ *  standing on the XZ plane.  Different radii make the
+ *  tapered cylinder, and a zero top radius makes a cone.
+ *  The side starts on +X and turns toward -Z, with U going
+ *  once around, as the shape meshes lay it out.
+ ***********************************************************/
+void PrimitiveGeometry::BuildCylinder(float bottomRadius, float topRadius, bool bDrawTop, bool bDrawBottom) {
+    Clear();
+
+    unsigned int first = (unsigned int)m_vertices.size();
+    for (int i = 0; i <= CYLINDER_SLICES; i++) {
+        float angle = 2.0f * PI * (float)i / CYLINDER_SLICES;
+        float x = cos(angle);
+        float z = -sin(angle);
+        // the side slopes inward by the change in radius over a unit height
+        glm::vec3 normal = glm::normalize(glm::vec3(x, bottomRadius - topRadius, z));
+        float u = (float)i / CYLINDER_SLICES;
+        AddVertex(glm::vec3(x * bottomRadius, 0.0f, z * bottomRadius), normal, glm::vec2(u, 0.0f));
+        AddVertex(glm::vec3(x * topRadius, 1.0f, z * topRadius), normal, glm::vec2(u, 1.0f));
+    }
+    for (int i = 0; i < CYLINDER_SLICES; i++) {
+        unsigned int bottom = first + i * 2;
+        AddQuad(bottom, bottom + 1, bottom + 3, bottom + 2);
+    }
+
+    if (bDrawTop && (topRadius > 0.0f)) {
+        AddCap(topRadius, 1.0f, glm::vec3(0.0f, 1.0f, 0.0f));
+    }
+    if (bDrawBottom) {
+        AddCap(bottomRadius, 0.0f, glm::vec3(0.0f, -1.0f, 0.0f));
+    }
+}
+
+/***********************************************************
+ *  BuildSphere()
+ *
+ *  This method is used to build a unit sphere, or only its
+ *  upper half.
+ ***********************************************************/
+void PrimitiveGeometry::BuildSphere(bool bHalf) {
+    Clear();
+
+    int stacks = bHalf ? SPHERE_STACKS / 2 : SPHERE_STACKS;
+    for (int j = 0; j <= stacks; j++) {
+        float polar = PI * (float)j / SPHERE_STACKS;
+        for (int i = 0; i <= SPHERE_SLICES; i++) {
+            float azimuth = 2.0f * PI * (float)i / SPHERE_SLICES;
+            glm::vec3 normal(sin(polar) * cos(azimuth), cos(polar), sin(polar) * sin(azimuth));
+            AddVertex(normal, normal, glm::vec2((float)i / SPHERE_SLICES, 1.0f - (float)j / SPHERE_STACKS));
+        }
+    }
+
+    for (int j = 0; j < stacks; j++) {
+        for (int i = 0; i < SPHERE_SLICES; i++) {
+            unsigned int upper = j * (SPHERE_SLICES + 1) + i;
+            unsigned int lower = upper + SPHERE_SLICES + 1;
+            AddQuad(upper, lower, lower + 1, upper + 1);
+        }
+    }
+}
+
+/***********************************************************
+ *  BuildTorus()
+ *
+ *  This method is used to build a torus around the Z axis,
+ *  with U along the ring and V around the tube.
+ ***********************************************************/
+void PrimitiveGeometry::BuildTorus() {
+    Clear();
+
+    for (int j = 0; j <= TORUS_TUBE_SEGMENTS; j++) {
+        float tubeAngle = 2.0f * PI * (float)j / TORUS_TUBE_SEGMENTS;
+        for (int i = 0; i <= TORUS_MAIN_SEGMENTS; i++) {
+            float ringAngle = 2.0f * PI * (float)i / TORUS_MAIN_SEGMENTS;
+            glm::vec3 normal(cos(tubeAngle) * cos(ringAngle), cos(tubeAngle) * sin(ringAngle), sin(tubeAngle));
+            glm::vec3 center(cos(ringAngle) * TORUS_MAIN_RADIUS, sin(ringAngle) * TORUS_MAIN_RADIUS, 0.0f);
+            AddVertex(center + normal * TORUS_TUBE_RADIUS, normal,
+                glm::vec2((float)i / TORUS_MAIN_SEGMENTS, (float)j / TORUS_TUBE_SEGMENTS));
+        }
+    }
+
+    for (int j = 0; j < TORUS_TUBE_SEGMENTS; j++) {
+        for (int i = 0; i < TORUS_MAIN_SEGMENTS; i++) {
+            unsigned int a = j * (TORUS_MAIN_SEGMENTS + 1) + i;
+            unsigned int b = a + TORUS_MAIN_SEGMENTS + 1;
+            AddQuad(a, b, b + 1, a + 1);
+        }
+    }
+}
+
+/***********************************************************
+ *  Append()
+ *
+ *  This method is used to add the vertices of another shape
+ *  after transforming them into this shape's space.  Normals
+ *  use the inverse transpose so non-uniform scales stay
+ *  correct.
+ ***********************************************************/
+void PrimitiveGeometry::Append(const PrimitiveGeometry& source, const glm::mat4& model) {
+    glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(model)));
+    unsigned int base = (unsigned int)m_vertices.size();
+
+    m_vertices.reserve(m_vertices.size() + source.m_vertices.size());
+    for (size_t i = 0; i < source.m_vertices.size(); i++) {
+        const VERTEX& vertex = source.m_vertices[i];
+        VERTEX transformed;
+        transformed.position = glm::vec3(model * glm::vec4(vertex.position, 1.0f));
+        transformed.normal = glm::normalize(normalMatrix * vertex.normal);
+        transformed.textureCoordinate = vertex.textureCoordinate;
+        m_vertices.push_back(transformed);
+    }
+
+    m_indices.reserve(m_indices.size() + source.m_indices.size());
+    for (size_t i = 0; i < source.m_indices.size(); i++) {
+        m_indices.push_back(base + source.m_indices[i]);
+    }
+}
+
+/***********************************************************
+ *  GetBounds()
+ *
+ *  This method is used to get the box around every vertex.
+ ***********************************************************/
+void PrimitiveGeometry::GetBounds(glm::vec3& boundsMin, glm::vec3& boundsMax) const {
+    boundsMin = glm::vec3(FLT_MAX);
+    boundsMax = glm::vec3(-FLT_MAX);
+    for (size_t i = 0; i < m_vertices.size(); i++) {
+        boundsMin = glm::min(boundsMin, m_vertices[i].position);
+        boundsMax = glm::max(boundsMax, m_vertices[i].position);
+    }
+}
+
+/***********************************************************
+ *  OptimizeVertexCache()
+ *
+ *  This method is used to reorder the triangles so that the
+ *  GPU can reuse recently transformed vertices, using the
+ *  greedy vertex scoring from Tom Forsyth's linear-speed
+ *  vertex cache optimisation.  Vertices recently used and
+ *  vertices with few triangles left score the highest, and
+ *  the triangle with the best total score is emitted next.
+ ***********************************************************/
+void PrimitiveGeometry::OptimizeVertexCache() {
+    const int CACHE_SIZE = 32;
+    size_t vertexCount = m_vertices.size();
+    size_t triangleCount = m_indices.size() / 3;
+    if (triangleCount == 0) {
+        return;
+    }
+
+    // triangles using each vertex, as offsets into one list
+    std::vector<int> remaining(vertexCount, 0);
+    for (size_t i = 0; i < triangleCount * 3; i++) {
+        remaining[m_indices[i]]++;
+    }
+    std::vector<int> offsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; v++) {
+        offsets[v + 1] = offsets[v] + remaining[v];
+    }
+    std::vector<int> vertexTriangles(triangleCount * 3);
+    std::vector<int> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t t = 0; t < triangleCount; t++) {
+        for (int corner = 0; corner < 3; corner++) {
+            vertexTriangles[fill[m_indices[t * 3 + corner]]++] = (int)t;
+        }
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScore(vertexCount, 0.0f);
+    std::vector<float> triangleScore(triangleCount, 0.0f);
+    std::vector<bool> bEmitted(triangleCount, false);
+
+    auto scoreVertex = [&](size_t v) -> float {
+        if (remaining[v] == 0) {
+            return -1.0f;
+        }
+        float score = 0.0f;
+        int position = cachePosition[v];
+        if (position >= 0) {
+            // the last triangle's vertices get a fixed score so that strips
+            // do not always continue in the same direction
+            score = (position < 3) ? 0.75f : pow(1.0f - (float)(position - 3) / (CACHE_SIZE - 3), 1.5f);
+        }
+        // favour finishing vertices with only a few triangles left
+        return score + 2.0f * pow((float)remaining[v], -0.5f);
+    };
+
+    for (size_t v = 0; v < vertexCount; v++) {
+        vertexScore[v] = scoreVertex(v);
+    }
+    for (size_t t = 0; t < triangleCount; t++) {
+        triangleScore[t] = vertexScore[m_indices[t * 3]] + vertexScore[m_indices[t * 3 + 1]] + vertexScore[m_indices[t * 3 + 2]];
+    }
+
+    std::vector<unsigned int> newIndices;
+    newIndices.reserve(m_indices.size());
+    std::vector<int> cache;
+    size_t scanStart = 0;
+    int bestTriangle = -1;
+
+    for (size_t emitted = 0; emitted < triangleCount; emitted++) {
+        // when the cache offers nothing, take the next unused triangle
+        if (bestTriangle < 0) {
+            while (bEmitted[scanStart]) {
+                scanStart++;
+            }
+            bestTriangle = (int)scanStart;
+        }
+
+        bEmitted[bestTriangle] = true;
+        std::vector<int> newCache;
+        for (int corner = 0; corner < 3; corner++) {
+            unsigned int v = m_indices[bestTriangle * 3 + corner];
+            newIndices.push_back(v);
+            remaining[v]--;
+            newCache.push_back((int)v);
+        }
+        for (size_t i = 0; i < cache.size(); i++) {
+            if ((cache[i] != newCache[0]) && (cache[i] != newCache[1]) && (cache[i] != newCache[2])) {
+                newCache.push_back(cache[i]);
+            }
+        }
+
+        // rescore every vertex that is in, or just fell out of, the cache
+        for (size_t i = 0; i < newCache.size(); i++) {
+            size_t v = newCache[i];
+            cachePosition[v] = (i < (size_t)CACHE_SIZE) ? (int)i : -1;
+            vertexScore[v] = scoreVertex(v);
+        }
+        if (newCache.size() > (size_t)CACHE_SIZE) {
+            newCache.resize(CACHE_SIZE);
+        }
+        cache.swap(newCache);
+
+        // the best next triangle is one that uses a cached vertex
+        bestTriangle = -1;
+        float bestScore = -1.0f;
+        for (size_t i = 0; i < cache.size(); i++) {
+            int v = cache[i];
+            for (int j = offsets[v]; j < offsets[v + 1]; j++) {
+                int t = vertexTriangles[j];
+                if (bEmitted[t]) {
+                    continue;
+                }
+                triangleScore[t] = vertexScore[m_indices[t * 3]] + vertexScore[m_indices[t * 3 + 1]] + vertexScore[m_indices[t * 3 + 2]];
+                if (triangleScore[t] > bestScore) {
+                    bestScore = triangleScore[t];
+                    bestTriangle = t;
+                }
+            }
+        }
+    }
+
+    // renumber the vertices in the order the new index list first uses them
+    std::vector<int> remap(vertexCount, -1);
+    std::vector<VERTEX> newVertices;
+    newVertices.reserve(vertexCount);
+    for (size_t i = 0; i < newIndices.size(); i++) {
+        unsigned int v = newIndices[i];
+        if (remap[v] < 0) {
+            remap[v] = (int)newVertices.size();
+            newVertices.push_back(m_vertices[v]);
+        }
+        newIndices[i] = (unsigned int)remap[v];
+    }
+
+    m_vertices.swap(newVertices);
+    m_indices.swap(newIndices);
+}
+
+/***********************************************************
+ *  CacheMissRatio()
+ *
+ *  This method returns the average number of vertices that
+ *  have to be transformed per triangle when the GPU keeps
+ *  the passed in number of vertices in a FIFO cache.  Three
+ *  is the worst case and values near 0.5 are ideal.
+ ***********************************************************/
+float PrimitiveGeometry::CacheMissRatio(int cacheSize) const {
+    size_t triangleCount = m_indices.size() / 3;
+    if (triangleCount == 0) {
+        return(0.0f);
+    }
+
+    std::vector<int> cacheTime(m_vertices.size(), -cacheSize - 1);
+    int misses = 0;
+    for (size_t i = 0; i < m_indices.size(); i++) {
+        unsigned int v = m_indices[i];
+        // a FIFO entry is evicted after cacheSize newer misses
+        if (misses - cacheTime[v] > cacheSize) {
+            cacheTime[v] = misses;
+            misses++;
+        }
+    }
+
+    return((float)misses / (float)triangleCount);
+}
@@ -0,0 +1,64 @@
+///////////////////////////////////////////////////////////////////////////////
+// primitivegeometry.h
+// ============
+// build the basic shapes as CPU side vertex and index lists so that they
+// can be transformed and merged before they are uploaded
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+
+class PrimitiveGeometry {
+public:
+    // Struct to hold one vertex, laid out like the shape mesh buffers
+    struct VERTEX {
+        glm::vec3 position;
+        glm::vec3 normal;
+        glm::vec2 textureCoordinate;
+    };
+
+    // remove every vertex and index
+    void Clear();
+
+    // build a basic shape with the extents, tessellation, UV layout and
+    // normals of the matching shape mesh, so that a batch or a ray query
+    // sees the triangles the per-object draws put on screen; the two must
+    // stay in sync whenever either one changes, and the scene manager
+    // reports a shape mesh that no longer matches when it is loaded
+    void BuildPlane();
+    void BuildBox();
+    void BuildCylinder(float bottomRadius, float topRadius, bool bDrawTop, bool bDrawBottom);
+    void BuildSphere(bool bHalf);
+    void BuildTorus();
+
+    // take over vertex and index lists built elsewhere, leaving them empty
+    void Assign(std::vector<VERTEX>& vertices, std::vector<unsigned int>& indices);
+
+    // append another shape, transformed by the passed in model matrix
+    void Append(const PrimitiveGeometry& source, const glm::mat4& model);
+
+    // reorder the triangles for the post-transform vertex cache, then the
+    // vertices in the order they are first used for fetch locality
+    void OptimizeVertexCache();
+    // get the average vertex shader runs per triangle with a FIFO cache
+    float CacheMissRatio(int cacheSize) const;
+
+    // get the bounding box of every vertex
+    void GetBounds(glm::vec3& boundsMin, glm::vec3& boundsMax) const;
+
+    const std::vector<VERTEX>& Vertices() const { return m_vertices; }
+    const std::vector<unsigned int>& Indices() const { return m_indices; }
+
+private:
+    std::vector<VERTEX> m_vertices;
+    std::vector<unsigned int> m_indices;
+
+    unsigned int AddVertex(const glm::vec3& position, const glm::vec3& normal, const glm::vec2& textureCoordinate);
+    void AddTriangle(unsigned int a, unsigned int b, unsigned int c);
+    void AddQuad(unsigned int a, unsigned int b, unsigned int c, unsigned int d);
+    void AddCap(float radius, float height, const glm::vec3& normal);
+};
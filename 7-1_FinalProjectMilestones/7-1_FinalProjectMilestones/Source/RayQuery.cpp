@@ -0,0 +1,763 @@
+///////////////////////////////////////////////////////////////////////////////
+// rayquery.cpp
+// ============
+// cast rays against the scene objects on the CPU through a bounding volume
+// hierarchy over the objects and one over the triangles of each mesh
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RayQuery.h"
+#include <xmmintrin.h>
+#include <algorithm>
+#include <cmath>
+
+// declaration of the global variables and defines
+namespace {
+    // items per leaf of the triangle and the instance hierarchies
+    const int MESH_LEAF_SIZE = 4;
+    const int INSTANCE_LEAF_SIZE = 1;
+    // depth a hierarchy never reaches with median splits of 2^32 items
+    const int TRAVERSAL_STACK_SIZE = 64;
+    // hits closer than this to the ray origin are ignored
+    const float MIN_HIT_DISTANCE = 1.0e-5f;
+
+    // Struct to hold the items a hierarchy is built over
+    struct BUILD_ITEMS {
+        std::vector<glm::vec3> boundsMin;
+        std::vector<glm::vec3> boundsMax;
+        std::vector<glm::vec3> centers;
+        std::vector<int> order;       // Item indices, reordered into the leaves
+    };
+
+    /***********************************************************
+     *  Subdivide()
+     *
+     *  Fills in a node over a range of the item order and splits
+     *  it at the median center along its longest axis until the
+     *  ranges fit into a leaf.  Both children of a node are
+     *  stored next to each other.
+     ***********************************************************/
+    void Subdivide(std::vector<RayQuery::BVH_NODE>& nodes, BUILD_ITEMS& items, int nodeIndex, int first, int count, int leafSize) {
+        glm::vec3 boundsMin(FLT_MAX);
+        glm::vec3 boundsMax(-FLT_MAX);
+        glm::vec3 centerMin(FLT_MAX);
+        glm::vec3 centerMax(-FLT_MAX);
+        for (int i = first; i < first + count; i++) {
+            int item = items.order[i];
+            boundsMin = glm::min(boundsMin, items.boundsMin[item]);
+            boundsMax = glm::max(boundsMax, items.boundsMax[item]);
+            centerMin = glm::min(centerMin, items.centers[item]);
+            centerMax = glm::max(centerMax, items.centers[item]);
+        }
+        nodes[nodeIndex].boundsMin = boundsMin;
+        nodes[nodeIndex].boundsMax = boundsMax;
+
+        glm::vec3 extent = centerMax - centerMin;
+        int axis = 0;
+        if (extent.y > extent[axis]) {
+            axis = 1;
+        }
+        if (extent.z > extent[axis]) {
+            axis = 2;
+        }
+
+        // items that all share a center cannot be split any further
+        if ((count <= leafSize) || (extent[axis] <= 0.0f)) {
+            nodes[nodeIndex].first = first;
+            nodes[nodeIndex].count = count;
+            return;
+        }
+
+        int middle = first + count / 2;
+        std::nth_element(items.order.begin() + first, items.order.begin() + middle, items.order.begin() + first + count,
+            [&items, axis](int a, int b) { return items.centers[a][axis] < items.centers[b][axis]; });
+
+        int children = (int)nodes.size();
+        nodes.resize(nodes.size() + 2);
+        nodes[nodeIndex].first = children;
+        nodes[nodeIndex].count = 0;
+        Subdivide(nodes, items, children, first, middle - first, leafSize);
+        Subdivide(nodes, items, children + 1, middle, first + count - middle, leafSize);
+    }
+
+    /***********************************************************
+     *  BuildHierarchy()
+     *
+     *  Builds a hierarchy over the passed in items and leaves
+     *  their order in the leaves in items.order.
+     ***********************************************************/
+    void BuildHierarchy(std::vector<RayQuery::BVH_NODE>& nodes, BUILD_ITEMS& items, int leafSize) {
+        int count = (int)items.centers.size();
+        nodes.clear();
+        items.order.resize(count);
+        for (int i = 0; i < count; i++) {
+            items.order[i] = i;
+        }
+        if (count == 0) {
+            return;
+        }
+
+        nodes.reserve(count * 2);
+        nodes.resize(1);
+        Subdivide(nodes, items, 0, 0, count, leafSize);
+    }
+
+    /***********************************************************
+     *  SlabDistance()
+     *
+     *  Returns the distance at which a ray enters a box, or
+     *  FLT_MAX when it misses the box before maxDistance.
+     ***********************************************************/
+    inline float SlabDistance(const RayQuery::BVH_NODE& node, const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance) {
+        glm::vec3 t1 = (node.boundsMin - origin) * inverseDirection;
+        glm::vec3 t2 = (node.boundsMax - origin) * inverseDirection;
+        glm::vec3 tNear = glm::min(t1, t2);
+        glm::vec3 tFar = glm::max(t1, t2);
+        float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+        float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+
+        return (enter <= exit) ? enter : FLT_MAX;
+    }
+
+    /***********************************************************
+     *  IntersectTriangle()
+     *
+     *  Returns the distance at which a ray crosses a triangle
+     *  from either side, or FLT_MAX when it misses it.
+     ***********************************************************/
+    inline float IntersectTriangle(const RayQuery::TRIANGLE& triangle, const glm::vec3& origin, const glm::vec3& direction) {
+        glm::vec3 p = glm::cross(direction, triangle.edge2);
+        float determinant = glm::dot(triangle.edge1, p);
+        if (std::fabs(determinant) < 1.0e-12f) {
+            return FLT_MAX;
+        }
+
+        float inverseDeterminant = 1.0f / determinant;
+        glm::vec3 s = origin - triangle.corner;
+        float u = glm::dot(s, p) * inverseDeterminant;
+        if ((u < 0.0f) || (u > 1.0f)) {
+            return FLT_MAX;
+        }
+
+        glm::vec3 q = glm::cross(s, triangle.edge1);
+        float v = glm::dot(direction, q) * inverseDeterminant;
+        if ((v < 0.0f) || (u + v > 1.0f)) {
+            return FLT_MAX;
+        }
+
+        float t = glm::dot(triangle.edge2, q) * inverseDeterminant;
+        return (t > MIN_HIT_DISTANCE) ? t : FLT_MAX;
+    }
+
+    /***********************************************************
+     *  IntersectMesh()
+     *
+     *  Traces one ray in object space through the triangle
+     *  hierarchy of a mesh, nearer child first, shortening
+     *  maxDistance at every hit.  With bAnyHit set it returns
+     *  at the first hit.
+     ***********************************************************/
+    bool IntersectMesh(const RayQuery::MESH& mesh, const glm::vec3& origin, const glm::vec3& direction,
+        float& maxDistance, int& triangle, bool bAnyHit) {
+        if (mesh.nodes.empty()) {
+            return false;
+        }
+
+        glm::vec3 inverseDirection = 1.0f / direction;
+        bool bHit = false;
+
+        int stack[TRAVERSAL_STACK_SIZE];
+        int stackSize = 0;
+        if (SlabDistance(mesh.nodes[0], origin, inverseDirection, maxDistance) == FLT_MAX) {
+            return false;
+        }
+        stack[stackSize++] = 0;
+
+        while (stackSize > 0) {
+            const RayQuery::BVH_NODE& node = mesh.nodes[stack[--stackSize]];
+            if (node.count > 0) {
+                for (int i = node.first; i < node.first + node.count; i++) {
+                    float t = IntersectTriangle(mesh.triangles[i], origin, direction);
+                    if (t < maxDistance) {
+                        maxDistance = t;
+                        triangle = i;
+                        bHit = true;
+                        if (bAnyHit) {
+                            return true;
+                        }
+                    }
+                }
+                continue;
+            }
+
+            float nearDistance = SlabDistance(mesh.nodes[node.first], origin, inverseDirection, maxDistance);
+            float farDistance = SlabDistance(mesh.nodes[node.first + 1], origin, inverseDirection, maxDistance);
+            int nearChild = node.first;
+            int farChild = node.first + 1;
+            if (farDistance < nearDistance) {
+                std::swap(nearDistance, farDistance);
+                std::swap(nearChild, farChild);
+            }
+            // the nearer child is popped first
+            if (farDistance != FLT_MAX) {
+                stack[stackSize++] = farChild;
+            }
+            if (nearDistance != FLT_MAX) {
+                stack[stackSize++] = nearChild;
+            }
+        }
+
+        return bHit;
+    }
+
+    // Struct to hold PACKET_SIZE rays, one per lane
+    struct PACKET {
+        __m128 originX, originY, originZ;
+        __m128 directionX, directionY, directionZ;
+        __m128 inverseX, inverseY, inverseZ;
+    };
+
+    /***********************************************************
+     *  TransformPacket()
+     *
+     *  Moves the rays of a packet by an affine matrix.  The
+     *  directions are not normalized again, so distances along
+     *  the moved rays match the distances along the originals.
+     ***********************************************************/
+    void TransformPacket(const glm::mat4& matrix, const PACKET& source, PACKET& packet) {
+        const __m128 one = _mm_set1_ps(1.0f);
+        __m128 m[4][3];
+        for (int column = 0; column < 4; column++) {
+            for (int row = 0; row < 3; row++) {
+                m[column][row] = _mm_set1_ps(matrix[column][row]);
+            }
+        }
+
+        packet.originX = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[0][0], source.originX), _mm_mul_ps(m[1][0], source.originY)),
+            _mm_add_ps(_mm_mul_ps(m[2][0], source.originZ), m[3][0]));
+        packet.originY = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[0][1], source.originX), _mm_mul_ps(m[1][1], source.originY)),
+            _mm_add_ps(_mm_mul_ps(m[2][1], source.originZ), m[3][1]));
+        packet.originZ = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[0][2], source.originX), _mm_mul_ps(m[1][2], source.originY)),
+            _mm_add_ps(_mm_mul_ps(m[2][2], source.originZ), m[3][2]));
+
+        packet.directionX = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[0][0], source.directionX), _mm_mul_ps(m[1][0], source.directionY)),
+            _mm_mul_ps(m[2][0], source.directionZ));
+        packet.directionY = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[0][1], source.directionX), _mm_mul_ps(m[1][1], source.directionY)),
+            _mm_mul_ps(m[2][1], source.directionZ));
+        packet.directionZ = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[0][2], source.directionX), _mm_mul_ps(m[1][2], source.directionY)),
+            _mm_mul_ps(m[2][2], source.directionZ));
+
+        packet.inverseX = _mm_div_ps(one, packet.directionX);
+        packet.inverseY = _mm_div_ps(one, packet.directionY);
+        packet.inverseZ = _mm_div_ps(one, packet.directionZ);
+    }
+
+    /***********************************************************
+     *  PacketSlab()
+     *
+     *  Tests every ray of a packet against a box and returns
+     *  the lanes that enter it before their maxDistance.  The
+     *  nearest entry distance of those lanes is passed back so
+     *  that the children can be visited nearer first.
+     ***********************************************************/
+    inline int PacketSlab(const RayQuery::BVH_NODE& node, const PACKET& packet, __m128 maxDistance, float& nearest) {
+        __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.boundsMin.x), packet.originX), packet.inverseX);
+        __m128 t2 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.boundsMax.x), packet.originX), packet.inverseX);
+        __m128 enter = _mm_min_ps(t1, t2);
+        __m128 exit = _mm_max_ps(t1, t2);
+
+        t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.boundsMin.y), packet.originY), packet.inverseY);
+        t2 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.boundsMax.y), packet.originY), packet.inverseY);
+        enter = _mm_max_ps(enter, _mm_min_ps(t1, t2));
+        exit = _mm_min_ps(exit, _mm_max_ps(t1, t2));
+
+        t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.boundsMin.z), packet.originZ), packet.inverseZ);
+        t2 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.boundsMax.z), packet.originZ), packet.inverseZ);
+        enter = _mm_max_ps(_mm_max_ps(enter, _mm_min_ps(t1, t2)), _mm_setzero_ps());
+        exit = _mm_min_ps(_mm_min_ps(exit, _mm_max_ps(t1, t2)), maxDistance);
+
+        __m128 hit = _mm_cmple_ps(enter, exit);
+        int lanes = _mm_movemask_ps(hit);
+        if (lanes != 0) {
+            // the missing lanes must not lower the nearest entry
+            __m128 entries = _mm_or_ps(_mm_and_ps(hit, enter), _mm_andnot_ps(hit, _mm_set1_ps(FLT_MAX)));
+            entries = _mm_min_ps(entries, _mm_shuffle_ps(entries, entries, _MM_SHUFFLE(2, 3, 0, 1)));
+            entries = _mm_min_ps(entries, _mm_shuffle_ps(entries, entries, _MM_SHUFFLE(1, 0, 3, 2)));
+            nearest = _mm_cvtss_f32(entries);
+        }
+
+        return lanes;
+    }
+
+    /***********************************************************
+     *  IntersectMeshPacket()
+     *
+     *  Traces a packet in object space through the triangle
+     *  hierarchy of a mesh.  A node is visited while any lane
+     *  enters it, and every triangle is tested against all four
+     *  lanes at once, keeping the nearest hit per lane.
+     *  Returns the lanes that hit the mesh.
+     ***********************************************************/
+    int IntersectMeshPacket(const RayQuery::MESH& mesh, const PACKET& packet, __m128& maxDistance, int* triangles) {
+        if (mesh.nodes.empty()) {
+            return 0;
+        }
+
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 minDistance = _mm_set1_ps(MIN_HIT_DISTANCE);
+        int hitLanes = 0;
+
+        int stack[TRAVERSAL_STACK_SIZE];
+        int stackSize = 0;
+        float nearest = 0.0f;
+        if (PacketSlab(mesh.nodes[0], packet, maxDistance, nearest) == 0) {
+            return 0;
+        }
+        stack[stackSize++] = 0;
+
+        while (stackSize > 0) {
+            const RayQuery::BVH_NODE& node = mesh.nodes[stack[--stackSize]];
+            if (node.count > 0) {
+                for (int i = node.first; i < node.first + node.count; i++) {
+                    const RayQuery::TRIANGLE& triangle = mesh.triangles[i];
+                    __m128 e1x = _mm_set1_ps(triangle.edge1.x);
+                    __m128 e1y = _mm_set1_ps(triangle.edge1.y);
+                    __m128 e1z = _mm_set1_ps(triangle.edge1.z);
+                    __m128 e2x = _mm_set1_ps(triangle.edge2.x);
+                    __m128 e2y = _mm_set1_ps(triangle.edge2.y);
+                    __m128 e2z = _mm_set1_ps(triangle.edge2.z);
+
+                    // p = direction x edge2
+                    __m128 px = _mm_sub_ps(_mm_mul_ps(packet.directionY, e2z), _mm_mul_ps(packet.directionZ, e2y));
+                    __m128 py = _mm_sub_ps(_mm_mul_ps(packet.directionZ, e2x), _mm_mul_ps(packet.directionX, e2z));
+                    __m128 pz = _mm_sub_ps(_mm_mul_ps(packet.directionX, e2y), _mm_mul_ps(packet.directionY, e2x));
+                    __m128 determinant = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+                    // a ray in the plane of the triangle divides by zero and fails every test below
+                    __m128 inverseDeterminant = _mm_div_ps(one, determinant);
+
+                    __m128 sx = _mm_sub_ps(packet.originX, _mm_set1_ps(triangle.corner.x));
+                    __m128 sy = _mm_sub_ps(packet.originY, _mm_set1_ps(triangle.corner.y));
+                    __m128 sz = _mm_sub_ps(packet.originZ, _mm_set1_ps(triangle.corner.z));
+                    __m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, px), _mm_mul_ps(sy, py)), _mm_mul_ps(sz, pz)), inverseDeterminant);
+
+                    // q = s x edge1
+                    __m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+                    __m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+                    __m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+                    __m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(packet.directionX, qx), _mm_mul_ps(packet.directionY, qy)),
+                        _mm_mul_ps(packet.directionZ, qz)), inverseDeterminant);
+                    __m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), inverseDeterminant);
+
+                    __m128 hit = _mm_and_ps(_mm_cmpge_ps(u, zero), _mm_cmpge_ps(v, zero));
+                    hit = _mm_and_ps(hit, _mm_cmple_ps(_mm_add_ps(u, v), one));
+                    hit = _mm_and_ps(hit, _mm_cmpgt_ps(t, minDistance));
+                    hit = _mm_and_ps(hit, _mm_cmplt_ps(t, maxDistance));
+
+                    int lanes = _mm_movemask_ps(hit);
+                    if (lanes != 0) {
+                        maxDistance = _mm_or_ps(_mm_and_ps(hit, t), _mm_andnot_ps(hit, maxDistance));
+                        for (int lane = 0; lane < RayQuery::PACKET_SIZE; lane++) {
+                            if (lanes & (1 << lane)) {
+                                triangles[lane] = i;
+                            }
+                        }
+                        hitLanes |= lanes;
+                    }
+                }
+                continue;
+            }
+
+            float nearDistance = FLT_MAX;
+            float farDistance = FLT_MAX;
+            int nearLanes = PacketSlab(mesh.nodes[node.first], packet, maxDistance, nearDistance);
+            int farLanes = PacketSlab(mesh.nodes[node.first + 1], packet, maxDistance, farDistance);
+            int nearChild = node.first;
+            int farChild = node.first + 1;
+            if (farDistance < nearDistance) {
+                std::swap(nearLanes, farLanes);
+                std::swap(nearChild, farChild);
+            }
+            if (farLanes != 0) {
+                stack[stackSize++] = farChild;
+            }
+            if (nearLanes != 0) {
+                stack[stackSize++] = nearChild;
+            }
+        }
+
+        return hitLanes;
+    }
+}
+
+/***********************************************************
+ *  BuildMesh()
+ *
+ *  This method is used to copy the triangles of a mesh and
+ *  build the hierarchy over them.
+ ***********************************************************/
+std::shared_ptr<const RayQuery::MESH> RayQuery::BuildMesh(const PrimitiveGeometry& geometry) {
+    const std::vector<PrimitiveGeometry::VERTEX>& vertices = geometry.Vertices();
+    const std::vector<unsigned int>& indices = geometry.Indices();
+    int triangleCount = (int)indices.size() / 3;
+
+    BUILD_ITEMS items;
+    items.boundsMin.resize(triangleCount);
+    items.boundsMax.resize(triangleCount);
+    items.centers.resize(triangleCount);
+    for (int i = 0; i < triangleCount; i++) {
+        const glm::vec3& a = vertices[indices[i * 3]].position;
+        const glm::vec3& b = vertices[indices[i * 3 + 1]].position;
+        const glm::vec3& c = vertices[indices[i * 3 + 2]].position;
+        items.boundsMin[i] = glm::min(a, glm::min(b, c));
+        items.boundsMax[i] = glm::max(a, glm::max(b, c));
+        items.centers[i] = (a + b + c) / 3.0f;
+    }
+
+    std::shared_ptr<MESH> pMesh = std::make_shared<MESH>();
+    BuildHierarchy(pMesh->nodes, items, MESH_LEAF_SIZE);
+
+    // store the triangles in leaf order so each leaf reads a single run
+    pMesh->triangles.resize(triangleCount);
+    for (int i = 0; i < triangleCount; i++) {
+        int source = items.order[i];
+        const glm::vec3& a = vertices[indices[source * 3]].position;
+        const glm::vec3& b = vertices[indices[source * 3 + 1]].position;
+        const glm::vec3& c = vertices[indices[source * 3 + 2]].position;
+        pMesh->triangles[i].corner = a;
+        pMesh->triangles[i].edge1 = b - a;
+        pMesh->triangles[i].edge2 = c - a;
+        pMesh->triangles[i].index = source;
+    }
+
+    return pMesh;
+}
+
+/***********************************************************
+ *  AddInstance()
+ *
+ *  This method is used to place a mesh in the scene.  The
+ *  bounds of the placed mesh come from its root node.
+ ***********************************************************/
+void RayQuery::AddInstance(const std::shared_ptr<const MESH>& pMesh, const glm::mat4& model, int object) {
+    if (!pMesh || pMesh->nodes.empty()) {
+        return;
+    }
+
+    INSTANCE instance;
+    instance.pMesh = pMesh;
+    instance.model = model;
+    instance.inverse = glm::inverse(model);
+    instance.object = object;
+
+    const BVH_NODE& root = pMesh->nodes[0];
+    instance.boundsMin = glm::vec3(FLT_MAX);
+    instance.boundsMax = glm::vec3(-FLT_MAX);
+    for (int corner = 0; corner < 8; corner++) {
+        glm::vec3 point(
+            (corner & 1) ? root.boundsMax.x : root.boundsMin.x,
+            (corner & 2) ? root.boundsMax.y : root.boundsMin.y,
+            (corner & 4) ? root.boundsMax.z : root.boundsMin.z);
+        glm::vec3 world = glm::vec3(model * glm::vec4(point, 1.0f));
+        instance.boundsMin = glm::min(instance.boundsMin, world);
+        instance.boundsMax = glm::max(instance.boundsMax, world);
+    }
+
+    m_instances.push_back(instance);
+}
+
+/***********************************************************
+ *  Build()
+ *
+ *  This method is used to build the hierarchy over the
+ *  instances, reordering them into its leaves.
+ ***********************************************************/
+void RayQuery::Build() {
+    BUILD_ITEMS items;
+    int count = (int)m_instances.size();
+    items.boundsMin.resize(count);
+    items.boundsMax.resize(count);
+    items.centers.resize(count);
+    for (int i = 0; i < count; i++) {
+        items.boundsMin[i] = m_instances[i].boundsMin;
+        items.boundsMax[i] = m_instances[i].boundsMax;
+        items.centers[i] = (m_instances[i].boundsMin + m_instances[i].boundsMax) * 0.5f;
+    }
+
+    BuildHierarchy(m_nodes, items, INSTANCE_LEAF_SIZE);
+
+    std::vector<INSTANCE> ordered(count);
+    for (int i = 0; i < count; i++) {
+        ordered[i] = m_instances[items.order[i]];
+    }
+    m_instances.swap(ordered);
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used to remove every instance.
+ ***********************************************************/
+void RayQuery::Clear() {
+    m_instances.clear();
+    m_nodes.clear();
+}
+
+/***********************************************************
+ *  HostBytes()
+ *
+ *  This method returns the bytes allocated by the query and
+ *  by the meshes its instances place.
+ ***********************************************************/
+size_t RayQuery::HostBytes() const {
+    size_t bytes = m_instances.capacity() * sizeof(INSTANCE) + m_nodes.capacity() * sizeof(BVH_NODE);
+
+    std::vector<const MESH*> meshes;
+    for (size_t i = 0; i < m_instances.size(); i++) {
+        meshes.push_back(m_instances[i].pMesh.get());
+    }
+    std::sort(meshes.begin(), meshes.end());
+    meshes.erase(std::unique(meshes.begin(), meshes.end()), meshes.end());
+    for (size_t i = 0; i < meshes.size(); i++) {
+        bytes += meshes[i]->nodes.capacity() * sizeof(BVH_NODE) +
+            meshes[i]->triangles.capacity() * sizeof(TRIANGLE);
+    }
+
+    return bytes;
+}
+
+/***********************************************************
+ *  FinishHit()
+ *
+ *  This method is used to fill in a hit from the instance,
+ *  triangle and distance the traversal ended with.  The
+ *  normal is moved into world space by the inverse transpose
+ *  and turned to face the ray.
+ ***********************************************************/
+void RayQuery::FinishHit(const RAY& ray, int instance, int triangle, float distance, HIT& hit) const {
+    const INSTANCE& placed = m_instances[instance];
+    const TRIANGLE& face = placed.pMesh->triangles[triangle];
+
+    glm::vec3 normal = glm::cross(face.edge1, face.edge2);
+    normal = glm::normalize(glm::transpose(glm::mat3(placed.inverse)) * normal);
+    if (glm::dot(normal, ray.direction) > 0.0f) {
+        normal = -normal;
+    }
+
+    hit.object = placed.object;
+    hit.triangle = face.index;
+    hit.distance = distance;
+    hit.position = ray.origin + ray.direction * distance;
+    hit.normal = normal;
+}
+
+/***********************************************************
+ *  Intersect()
+ *
+ *  This method is used to find the nearest hit of one ray.
+ *  The instances whose bounds the ray enters are visited
+ *  nearer first, and the ray is moved into the object space
+ *  of each one to walk its triangle hierarchy.
+ ***********************************************************/
+bool RayQuery::Intersect(const RAY& ray, HIT& hit) const {
+    hit = HIT();
+    if (m_nodes.empty()) {
+        return false;
+    }
+
+    glm::vec3 inverseDirection = 1.0f / ray.direction;
+    float maxDistance = ray.maxDistance;
+    int hitInstance = -1;
+    int hitTriangle = -1;
+
+    int stack[TRAVERSAL_STACK_SIZE];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0) {
+        const BVH_NODE& node = m_nodes[stack[--stackSize]];
+        if (SlabDistance(node, ray.origin, inverseDirection, maxDistance) == FLT_MAX) {
+            continue;
+        }
+
+        if (node.count > 0) {
+            for (int i = node.first; i < node.first + node.count; i++) {
+                const INSTANCE& instance = m_instances[i];
+                glm::vec3 origin = glm::vec3(instance.inverse * glm::vec4(ray.origin, 1.0f));
+                glm::vec3 direction = glm::mat3(instance.inverse) * ray.direction;
+                if (IntersectMesh(*instance.pMesh, origin, direction, maxDistance, hitTriangle, false)) {
+                    hitInstance = i;
+                }
+            }
+            continue;
+        }
+
+        // visit the child whose center lies along the ray first
+        const BVH_NODE& left = m_nodes[node.first];
+        const BVH_NODE& right = m_nodes[node.first + 1];
+        float leftCenter = glm::dot((left.boundsMin + left.boundsMax) * 0.5f, ray.direction);
+        float rightCenter = glm::dot((right.boundsMin + right.boundsMax) * 0.5f, ray.direction);
+        if (leftCenter < rightCenter) {
+            stack[stackSize++] = node.first + 1;
+            stack[stackSize++] = node.first;
+        }
+        else {
+            stack[stackSize++] = node.first;
+            stack[stackSize++] = node.first + 1;
+        }
+    }
+
+    if (hitInstance < 0) {
+        return false;
+    }
+
+    FinishHit(ray, hitInstance, hitTriangle, maxDistance, hit);
+    return true;
+}
+
+/***********************************************************
+ *  Occluded()
+ *
+ *  This method is used for line of sight tests, which only
+ *  need to know whether anything is hit before maxDistance.
+ ***********************************************************/
+bool RayQuery::Occluded(const RAY& ray) const {
+    if (m_nodes.empty()) {
+        return false;
+    }
+
+    glm::vec3 inverseDirection = 1.0f / ray.direction;
+    float maxDistance = ray.maxDistance;
+    int triangle = -1;
+
+    int stack[TRAVERSAL_STACK_SIZE];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0) {
+        const BVH_NODE& node = m_nodes[stack[--stackSize]];
+        if (SlabDistance(node, ray.origin, inverseDirection, maxDistance) == FLT_MAX) {
+            continue;
+        }
+
+        if (node.count > 0) {
+            for (int i = node.first; i < node.first + node.count; i++) {
+                const INSTANCE& instance = m_instances[i];
+                glm::vec3 origin = glm::vec3(instance.inverse * glm::vec4(ray.origin, 1.0f));
+                glm::vec3 direction = glm::mat3(instance.inverse) * ray.direction;
+                if (IntersectMesh(*instance.pMesh, origin, direction, maxDistance, triangle, true)) {
+                    return true;
+                }
+            }
+            continue;
+        }
+
+        stack[stackSize++] = node.first;
+        stack[stackSize++] = node.first + 1;
+    }
+
+    return false;
+}
+
+/***********************************************************
+ *  IntersectPacket()
+ *
+ *  This method is used to find the nearest hits of four rays
+ *  traced together with SSE.  Rays that start close together
+ *  and point the same way, like neighbouring pixels, visit
+ *  nearly the same nodes, so every node and triangle fetched
+ *  is tested against all four.
+ ***********************************************************/
+void RayQuery::IntersectPacket(const RAY* rays, HIT* hits) const {
+    for (int lane = 0; lane < PACKET_SIZE; lane++) {
+        hits[lane] = HIT();
+    }
+    if (m_nodes.empty()) {
+        return;
+    }
+
+    PACKET packet;
+    packet.originX = _mm_setr_ps(rays[0].origin.x, rays[1].origin.x, rays[2].origin.x, rays[3].origin.x);
+    packet.originY = _mm_setr_ps(rays[0].origin.y, rays[1].origin.y, rays[2].origin.y, rays[3].origin.y);
+    packet.originZ = _mm_setr_ps(rays[0].origin.z, rays[1].origin.z, rays[2].origin.z, rays[3].origin.z);
+    packet.directionX = _mm_setr_ps(rays[0].direction.x, rays[1].direction.x, rays[2].direction.x, rays[3].direction.x);
+    packet.directionY = _mm_setr_ps(rays[0].direction.y, rays[1].direction.y, rays[2].direction.y, rays[3].direction.y);
+    packet.directionZ = _mm_setr_ps(rays[0].direction.z, rays[1].direction.z, rays[2].direction.z, rays[3].direction.z);
+    const __m128 one = _mm_set1_ps(1.0f);
+    packet.inverseX = _mm_div_ps(one, packet.directionX);
+    packet.inverseY = _mm_div_ps(one, packet.directionY);
+    packet.inverseZ = _mm_div_ps(one, packet.directionZ);
+    __m128 maxDistance = _mm_setr_ps(rays[0].maxDistance, rays[1].maxDistance, rays[2].maxDistance, rays[3].maxDistance);
+
+    int hitInstances[PACKET_SIZE] = { -1, -1, -1, -1 };
+    int hitTriangles[PACKET_SIZE] = { -1, -1, -1, -1 };
+    int triangles[PACKET_SIZE];
+    PACKET local;
+
+    int stack[TRAVERSAL_STACK_SIZE];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0) {
+        const BVH_NODE& node = m_nodes[stack[--stackSize]];
+        float nearest = 0.0f;
+        if (PacketSlab(node, packet, maxDistance, nearest) == 0) {
+            continue;
+        }
+
+        if (node.count > 0) {
+            for (int i = node.first; i < node.first + node.count; i++) {
+                const INSTANCE& instance = m_instances[i];
+                TransformPacket(instance.inverse, packet, local);
+                int lanes = IntersectMeshPacket(*instance.pMesh, local, maxDistance, triangles);
+                for (int lane = 0; lane < PACKET_SIZE; lane++) {
+                    if (lanes & (1 << lane)) {
+                        hitInstances[lane] = i;
+                        hitTriangles[lane] = triangles[lane];
+                    }
+                }
+            }
+            continue;
+        }
+
+        stack[stackSize++] = node.first;
+        stack[stackSize++] = node.first + 1;
+    }
+
+    float distances[PACKET_SIZE];
+    _mm_storeu_ps(distances, maxDistance);
+    for (int lane = 0; lane < PACKET_SIZE; lane++) {
+        if (hitInstances[lane] >= 0) {
+            FinishHit(rays[lane], hitInstances[lane], hitTriangles[lane], distances[lane], hits[lane]);
+        }
+    }
+}
+
+/***********************************************************
+ *  IntersectRays()
+ *
+ *  This method is used to trace any number of rays in
+ *  packets.  The last packet is filled up with rays that
+ *  cannot hit anything.
+ ***********************************************************/
+void RayQuery::IntersectRays(const RAY* rays, HIT* hits, int count) const {
+    int whole = count - count % PACKET_SIZE;
+    for (int i = 0; i < whole; i += PACKET_SIZE) {
+        IntersectPacket(rays + i, hits + i);
+    }
+
+    if (whole < count) {
+        RAY padded[PACKET_SIZE];
+        HIT paddedHits[PACKET_SIZE];
+        for (int lane = 0; lane < PACKET_SIZE; lane++) {
+            if (whole + lane < count) {
+                padded[lane] = rays[whole + lane];
+            }
+            else {
+                padded[lane].maxDistance = -1.0f;
+            }
+        }
+        IntersectPacket(padded, paddedHits);
+        for (int lane = 0; whole + lane < count; lane++) {
+            hits[whole + lane] = paddedHits[lane];
+        }
+    }
+}
@@ -0,0 +1,107 @@
+///////////////////////////////////////////////////////////////////////////////
+// rayquery.h
+// ============
+// cast rays against the scene objects on the CPU through a bounding volume
+// hierarchy over the objects and one over the triangles of each mesh
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "PrimitiveGeometry.h"
+#include <glm/glm.hpp>
+#include <cfloat>
+#include <memory>
+#include <vector>
+
+class RayQuery {
+public:
+    // rays traced together by a packet, one per SSE lane
+    static const int PACKET_SIZE = 4;
+
+    // Struct to hold a ray; distances along it are measured in lengths of
+    // its direction, so a unit direction gives world units
+    struct RAY {
+        glm::vec3 origin = glm::vec3(0.0f);
+        glm::vec3 direction = glm::vec3(0.0f, 0.0f, -1.0f);
+        float maxDistance = FLT_MAX;
+    };
+
+    // Struct to hold the nearest hit of a ray
+    struct HIT {
+        int object = -1;              // Object id the instance was added with, -1 on a miss
+        int triangle = -1;            // Triangle of the object mesh
+        float distance = FLT_MAX;
+        glm::vec3 position = glm::vec3(0.0f);
+        glm::vec3 normal = glm::vec3(0.0f);  // Unit normal facing the ray
+    };
+
+    // Struct to hold one node of a hierarchy; a leaf holds count items from
+    // first, an inner node holds its two children from first
+    struct BVH_NODE {
+        glm::vec3 boundsMin;
+        int first;
+        glm::vec3 boundsMax;
+        int count;
+    };
+
+    // Struct to hold a triangle as a corner and the two edges leaving it
+    struct TRIANGLE {
+        glm::vec3 corner;
+        glm::vec3 edge1;
+        glm::vec3 edge2;
+        int index;                    // Triangle in the source index list
+    };
+
+    // Struct to hold the triangles of a mesh in object space, ordered by
+    // the leaves of the hierarchy over them
+    struct MESH {
+        std::vector<BVH_NODE> nodes;
+        std::vector<TRIANGLE> triangles;
+    };
+
+    // build the triangle hierarchy of a mesh once; a mesh is never changed
+    // afterwards, so it can be shared by instances and by other queries
+    static std::shared_ptr<const MESH> BuildMesh(const PrimitiveGeometry& geometry);
+
+    // place a mesh in the scene, reported in hits by the passed in object id
+    void AddInstance(const std::shared_ptr<const MESH>& pMesh, const glm::mat4& model, int object);
+    // build the hierarchy over the instances once they are all added
+    void Build();
+    // remove every instance
+    void Clear();
+
+    // the queries only read the query, so any number of threads may run
+    // them at once while nothing is added or built
+
+    // find the nearest hit along a ray
+    bool Intersect(const RAY& ray, HIT& hit) const;
+    // find whether anything lies along a ray, stopping at the first hit
+    bool Occluded(const RAY& ray) const;
+    // find the nearest hits of PACKET_SIZE rays traced together
+    void IntersectPacket(const RAY* rays, HIT* hits) const;
+    // find the nearest hits of any number of rays, traced in packets
+    void IntersectRays(const RAY* rays, HIT* hits, int count) const;
+
+    int InstanceCount() const { return (int)m_instances.size(); }
+    // get the bytes allocated by the instances and the meshes they place,
+    // counting each shared mesh once
+    size_t HostBytes() const;
+
+private:
+    // Struct to hold a mesh placed in the scene
+    struct INSTANCE {
+        std::shared_ptr<const MESH> pMesh;
+        glm::mat4 model;
+        glm::mat4 inverse;
+        glm::vec3 boundsMin;
+        glm::vec3 boundsMax;
+        int object;
+    };
+
+    std::vector<INSTANCE> m_instances;    // Ordered by the leaves of the hierarchy
+    std::vector<BVH_NODE> m_nodes;        // Hierarchy over the instances
+
+    void FinishHit(const RAY& ray, int instance, int triangle, float distance, HIT& hit) const;
+};
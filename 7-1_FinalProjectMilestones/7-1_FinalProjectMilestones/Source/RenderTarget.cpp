@@ -0,0 +1,158 @@
+///////////////////////////////////////////////////////////////////////////////
+// rendertarget.cpp
+// ============
+// manage an offscreen framebuffer that the 3D scene is rendered into
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RenderTarget.h"
+#include "ResourceTracker.h"
+#include <iostream>
+
+/***********************************************************
+ *  RenderTarget()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+RenderTarget::RenderTarget()
+    : m_framebuffer(0), m_colorTexture(0), m_depthTexture(0), m_width(0), m_height(0) {
+}
+
+/***********************************************************
+ *  ~RenderTarget()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+RenderTarget::~RenderTarget() {
+    Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used to allocate the framebuffer with a
+ *  color texture and a depth texture of the passed in size.
+ *  The depth is kept in a texture so that later passes can
+ *  sample it.
+ ***********************************************************/
+bool RenderTarget::Create(int width, int height) {
+    Destroy();
+
+    if ((width <= 0) || (height <= 0)) {
+        return false;
+    }
+
+    glGenTextures(1, &m_colorTexture);
+    glBindTexture(GL_TEXTURE_2D, m_colorTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glGenTextures(1, &m_depthTexture);
+    glBindTexture(GL_TEXTURE_2D, m_depthTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32F, width, height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    ResourceTracker::TrackTexture(m_colorTexture, GL_RGBA8, width, height, 1, 1, "scene target");
+    ResourceTracker::TrackTexture(m_depthTexture, GL_DEPTH_COMPONENT32F, width, height, 1, 1, "scene target");
+
+    glGenFramebuffers(1, &m_framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_colorTexture, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_depthTexture, 0);
+
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Error: Offscreen framebuffer is incomplete, status: " << status << std::endl;
+        Destroy();
+        return false;
+    }
+
+    m_width = width;
+    m_height = height;
+
+    return true;
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used to free the framebuffer and its
+ *  attachments from GPU memory.
+ ***********************************************************/
+void RenderTarget::Destroy() {
+    if (m_framebuffer != 0) {
+        glDeleteFramebuffers(1, &m_framebuffer);
+        m_framebuffer = 0;
+    }
+    if (m_colorTexture != 0) {
+        ResourceTracker::Release(ResourceTracker::CATEGORY_TEXTURE, m_colorTexture);
+        glDeleteTextures(1, &m_colorTexture);
+        m_colorTexture = 0;
+    }
+    if (m_depthTexture != 0) {
+        ResourceTracker::Release(ResourceTracker::CATEGORY_TEXTURE, m_depthTexture);
+        glDeleteTextures(1, &m_depthTexture);
+        m_depthTexture = 0;
+    }
+    m_width = 0;
+    m_height = 0;
+}
+
+/***********************************************************
+ *  Resize()
+ *
+ *  This method is used to reallocate the attachments when
+ *  the requested size differs from the current size.
+ ***********************************************************/
+bool RenderTarget::Resize(int width, int height) {
+    if ((width == m_width) && (height == m_height) && (m_framebuffer != 0)) {
+        return true;
+    }
+
+    return Create(width, height);
+}
+
+/***********************************************************
+ *  Bind()
+ *
+ *  This method is used to direct rendering into the offscreen
+ *  framebuffer.  Only the lower left region of the passed in
+ *  size is drawn, which lets the render resolution change
+ *  without reallocating the attachments.
+ ***********************************************************/
+void RenderTarget::Bind(int viewportWidth, int viewportHeight) {
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    glViewport(0, 0, viewportWidth, viewportHeight);
+}
+
+/***********************************************************
+ *  BlitToDefault()
+ *
+ *  This method is used to copy the rendered region into the
+ *  window framebuffer, filtering it up to the window size.
+ ***********************************************************/
+void RenderTarget::BlitToDefault(int sourceWidth, int sourceHeight, int destWidth, int destHeight) {
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_framebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+
+    GLenum filter = GL_LINEAR;
+    if ((sourceWidth == destWidth) && (sourceHeight == destHeight)) {
+        filter = GL_NEAREST;
+    }
+
+    glBlitFramebuffer(0, 0, sourceWidth, sourceHeight, 0, 0, destWidth, destHeight,
+        GL_COLOR_BUFFER_BIT, filter);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, destWidth, destHeight);
+}
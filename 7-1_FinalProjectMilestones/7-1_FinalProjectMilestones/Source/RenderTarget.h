@@ -0,0 +1,44 @@
+///////////////////////////////////////////////////////////////////////////////
+// rendertarget.h
+// ============
+// manage an offscreen framebuffer that the 3D scene is rendered into
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+class RenderTarget {
+public:
+    // constructor
+    RenderTarget();
+    // destructor
+    ~RenderTarget();
+
+    // allocate the color and depth attachments at the passed in size
+    bool Create(int width, int height);
+    // free the framebuffer and its attachments
+    void Destroy();
+    // reallocate the attachments if the size has changed
+    bool Resize(int width, int height);
+
+    // bind the framebuffer and restrict drawing to the passed in region
+    void Bind(int viewportWidth, int viewportHeight);
+    // scale the rendered region up into the default framebuffer
+    void BlitToDefault(int sourceWidth, int sourceHeight, int destWidth, int destHeight);
+
+    GLuint Framebuffer() const { return m_framebuffer; }
+    GLuint ColorTexture() const { return m_colorTexture; }
+    GLuint DepthTexture() const { return m_depthTexture; }
+    int Width() const { return m_width; }
+    int Height() const { return m_height; }
+
+private:
+    GLuint m_framebuffer;
+    GLuint m_colorTexture;
+    GLuint m_depthTexture;
+    int m_width;
+    int m_height;
+};
@@ -0,0 +1,446 @@
+///////////////////////////////////////////////////////////////////////////////
+// resourcetracker.cpp
+// ============
+// account for the GPU buffers, textures and programs and the larger host
+// allocations of the renderer, so their totals and leaks can be reported
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ResourceTracker.h"
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <mutex>
+
+// declaration of the global variables and defines
+namespace {
+    // the live objects, keyed by category and name
+    std::map<std::pair<int, GLuint>, ResourceTracker::RESOURCE> g_Resources;
+    std::map<std::string, size_t> g_HostBytes;
+    std::mutex g_Mutex;
+
+    // scope the objects are created in, only changed by the render thread
+    const char* g_Scope = "";
+
+    /***********************************************************
+     *  Record()
+     *
+     *  Adds or replaces the record of an object.
+     ***********************************************************/
+    void Record(ResourceTracker::CATEGORY category, GLuint name, size_t bytes, GLenum format,
+        int mipCount, const char* owner, bool bAdopted) {
+        if (name == 0) {
+            return;
+        }
+
+        ResourceTracker::RESOURCE resource;
+        resource.category = category;
+        resource.name = name;
+        resource.bytes = bytes;
+        resource.format = format;
+        resource.mipCount = mipCount;
+        resource.owner = owner;
+        resource.scope = g_Scope;
+        resource.bAdopted = bAdopted;
+
+        std::lock_guard<std::mutex> lock(g_Mutex);
+        std::pair<int, GLuint> key((int)category, name);
+        auto it = g_Resources.find(key);
+        if (it != g_Resources.end()) {
+            // storage re-specified in place keeps the scope it was created in
+            resource.scope = it->second.scope;
+            it->second = resource;
+        }
+        else {
+            g_Resources[key] = resource;
+        }
+    }
+}
+
+/***********************************************************
+ *  SCOPE()
+ *
+ *  The constructor for the class, opening the named scope
+ ***********************************************************/
+ResourceTracker::SCOPE::SCOPE(const char* name)
+    : m_previous(g_Scope) {
+    g_Scope = name;
+}
+
+/***********************************************************
+ *  ~SCOPE()
+ *
+ *  The destructor for the class, restoring the outer scope
+ ***********************************************************/
+ResourceTracker::SCOPE::~SCOPE() {
+    g_Scope = m_previous;
+}
+
+/***********************************************************
+ *  TrackBuffer()
+ *
+ *  This method is used to record a buffer, or its new size
+ *  when its storage is specified again.
+ ***********************************************************/
+void ResourceTracker::TrackBuffer(GLuint name, size_t bytes, const char* owner) {
+    Record(CATEGORY_BUFFER, name, bytes, 0, 0, owner, false);
+}
+
+/***********************************************************
+ *  TrackTexture()
+ *
+ *  This method is used to record a texture.  The layers are
+ *  the faces of a cube map or the slices of an array.
+ ***********************************************************/
+void ResourceTracker::TrackTexture(GLuint name, GLenum format, int width, int height, int layers,
+    int mipCount, const char* owner) {
+    Record(CATEGORY_TEXTURE, name, TextureBytes(format, width, height, layers, mipCount),
+        format, mipCount, owner, false);
+}
+
+/***********************************************************
+ *  TrackRenderbuffer()
+ *
+ *  This method is used to record a renderbuffer.
+ ***********************************************************/
+void ResourceTracker::TrackRenderbuffer(GLuint name, GLenum format, int width, int height, const char* owner) {
+    Record(CATEGORY_RENDERBUFFER, name, TextureBytes(format, width, height, 1, 1), format, 1, owner, false);
+}
+
+/***********************************************************
+ *  TrackProgram()
+ *
+ *  This method is used to record a linked program.  Its size
+ *  is the driver binary, which is the closest measure of the
+ *  memory the driver keeps for it.
+ ***********************************************************/
+void ResourceTracker::TrackProgram(GLuint name, const char* owner) {
+    GLint binaryLength = 0;
+    if (name != 0) {
+        glGetProgramiv(name, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+    }
+    Record(CATEGORY_PROGRAM, name, (size_t)std::max(binaryLength, 0), 0, 0, owner, false);
+}
+
+/***********************************************************
+ *  Release()
+ *
+ *  This method is used to forget an object being deleted.
+ ***********************************************************/
+void ResourceTracker::Release(CATEGORY category, GLuint name) {
+    std::lock_guard<std::mutex> lock(g_Mutex);
+    g_Resources.erase(std::pair<int, GLuint>((int)category, name));
+}
+
+/***********************************************************
+ *  DeleteProgram()
+ *
+ *  This method is used to delete a program owned through a
+ *  shader manager, which is not relied on to free it.
+ ***********************************************************/
+void ResourceTracker::DeleteProgram(GLuint& program) {
+    if (program != 0) {
+        Release(CATEGORY_PROGRAM, program);
+        glDeleteProgram(program);
+        program = 0;
+    }
+}
+
+/***********************************************************
+ *  MarkBuffers()
+ *
+ *  This method is used to generate the name that marks where
+ *  the buffers of an object created out of reach begin.  It
+ *  is never bound, so it does not become a buffer.
+ ***********************************************************/
+GLuint ResourceTracker::MarkBuffers() {
+    GLuint mark = 0;
+    glGenBuffers(1, &mark);
+    return(mark);
+}
+
+/***********************************************************
+ *  AdoptBuffers()
+ *
+ *  This method is used to record the buffers created since
+ *  the passed in mark.  A second name is generated, and the
+ *  names between the two are only adopted when every one is
+ *  an untracked buffer, as they are when the driver hands
+ *  the names out in order.  Otherwise the new buffers cannot
+ *  be told apart from older ones, and are left untracked.
+ ***********************************************************/
+bool ResourceTracker::AdoptBuffers(GLuint mark, const char* owner) {
+    GLuint end = 0;
+    glGenBuffers(1, &end);
+
+    std::vector<GLuint> names;
+    bool bInOrder = (end > mark);
+    for (GLuint name = mark + 1; bInOrder && (name < end); name++) {
+        bool bTracked = false;
+        {
+            std::lock_guard<std::mutex> lock(g_Mutex);
+            bTracked = (g_Resources.count(std::pair<int, GLuint>((int)CATEGORY_BUFFER, name)) != 0);
+        }
+        if (bTracked || !glIsBuffer(name)) {
+            bInOrder = false;
+        }
+        else {
+            names.push_back(name);
+        }
+    }
+
+    glDeleteBuffers(1, &mark);
+    glDeleteBuffers(1, &end);
+
+    if (!bInOrder) {
+        std::cout << "INFO: The buffers of " << owner << " are untracked, since their names were not handed out in order"
+            << std::endl;
+        return(false);
+    }
+
+    GLint boundBuffer = 0;
+    glGetIntegerv(GL_COPY_READ_BUFFER_BINDING, &boundBuffer);
+    for (size_t i = 0; i < names.size(); i++) {
+        GLint64 size = 0;
+        glBindBuffer(GL_COPY_READ_BUFFER, names[i]);
+        glGetBufferParameteri64v(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &size);
+        Record(CATEGORY_BUFFER, names[i], (size_t)size, 0, 0, owner, true);
+    }
+    glBindBuffer(GL_COPY_READ_BUFFER, boundBuffer);
+
+    std::cout << "INFO: Adopted " << names.size() << " untracked buffers as " << owner << std::endl;
+    return(true);
+}
+
+/***********************************************************
+ *  DropDeletedBuffers()
+ *
+ *  This method is used to forget the adopted buffers that
+ *  were deleted by the objects that created them.
+ ***********************************************************/
+void ResourceTracker::DropDeletedBuffers() {
+    std::lock_guard<std::mutex> lock(g_Mutex);
+    for (auto it = g_Resources.begin(); it != g_Resources.end();) {
+        if (it->second.bAdopted && !glIsBuffer(it->second.name)) {
+            it = g_Resources.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+/***********************************************************
+ *  SetHostBytes()
+ *
+ *  This method is used to set the host bytes an owner holds.
+ *  Zero bytes removes the owner.
+ ***********************************************************/
+void ResourceTracker::SetHostBytes(const char* owner, size_t bytes) {
+    std::lock_guard<std::mutex> lock(g_Mutex);
+    if (bytes == 0) {
+        g_HostBytes.erase(owner);
+    }
+    else {
+        g_HostBytes[owner] = bytes;
+    }
+}
+
+/***********************************************************
+ *  Snapshot()
+ *
+ *  This method is used to copy everything accounted for.
+ *  It only takes the lock, so profiling tools may call it
+ *  from any thread at any time.
+ ***********************************************************/
+ResourceTracker::SNAPSHOT ResourceTracker::Snapshot() {
+    SNAPSHOT snapshot;
+    std::fill(snapshot.counts, snapshot.counts + CATEGORY_COUNT, (size_t)0);
+    std::fill(snapshot.bytes, snapshot.bytes + CATEGORY_COUNT, (size_t)0);
+    snapshot.hostBytes = 0;
+
+    std::lock_guard<std::mutex> lock(g_Mutex);
+    snapshot.resources.reserve(g_Resources.size());
+    for (auto it = g_Resources.begin(); it != g_Resources.end(); ++it) {
+        const RESOURCE& resource = it->second;
+        snapshot.counts[resource.category]++;
+        snapshot.bytes[resource.category] += resource.bytes;
+        snapshot.resources.push_back(resource);
+    }
+    for (auto it = g_HostBytes.begin(); it != g_HostBytes.end(); ++it) {
+        HOST_ALLOCATION allocation;
+        allocation.owner = it->first;
+        allocation.bytes = it->second;
+        snapshot.hostBytes += it->second;
+        snapshot.hostAllocations.push_back(allocation);
+    }
+
+    return snapshot;
+}
+
+/***********************************************************
+ *  PrintSummary()
+ *
+ *  This method is used to print the totals per category, the
+ *  GPU bytes per owner and the host bytes per owner.
+ ***********************************************************/
+void ResourceTracker::PrintSummary() {
+    SNAPSHOT snapshot = Snapshot();
+
+    size_t gpuBytes = 0;
+    for (int category = 0; category < CATEGORY_COUNT; category++) {
+        gpuBytes += snapshot.bytes[category];
+    }
+
+    std::cout << "RESOURCES: GPU " << gpuBytes / 1024 << " KB | host " << snapshot.hostBytes / 1024 << " KB" << std::endl;
+    for (int category = 0; category < CATEGORY_COUNT; category++) {
+        std::cout << "  " << CategoryName((CATEGORY)category) << ": " << snapshot.counts[category]
+            << " objects, " << snapshot.bytes[category] / 1024 << " KB" << std::endl;
+    }
+
+    std::map<std::string, size_t> ownerBytes;
+    std::map<std::string, int> ownerCounts;
+    for (size_t i = 0; i < snapshot.resources.size(); i++) {
+        ownerBytes[snapshot.resources[i].owner] += snapshot.resources[i].bytes;
+        ownerCounts[snapshot.resources[i].owner]++;
+    }
+    for (auto it = ownerBytes.begin(); it != ownerBytes.end(); ++it) {
+        std::cout << "  GPU " << it->first << ": " << ownerCounts[it->first] << " objects, "
+            << it->second / 1024 << " KB" << std::endl;
+    }
+    for (size_t i = 0; i < snapshot.hostAllocations.size(); i++) {
+        std::cout << "  host " << snapshot.hostAllocations[i].owner << ": "
+            << snapshot.hostAllocations[i].bytes / 1024 << " KB" << std::endl;
+    }
+}
+
+/***********************************************************
+ *  ReportLeaks()
+ *
+ *  This method is used to print every object created in the
+ *  passed in scope that is still alive.  It is meant to be
+ *  called once the owner of the scope has released all it
+ *  holds, so anything listed was never deleted.
+ ***********************************************************/
+int ResourceTracker::ReportLeaks(const char* scope) {
+    SNAPSHOT snapshot = Snapshot();
+
+    int leaks = 0;
+    size_t leakedBytes = 0;
+    for (size_t i = 0; i < snapshot.resources.size(); i++) {
+        if (snapshot.resources[i].scope == scope) {
+            leaks++;
+            leakedBytes += snapshot.resources[i].bytes;
+        }
+    }
+
+    if (leaks == 0) {
+        std::cout << "INFO: No GPU resources leaked by the " << scope << std::endl;
+        return 0;
+    }
+
+    std::cout << "Error: " << leaks << " GPU resources (" << leakedBytes / 1024
+        << " KB) leaked by the " << scope << std::endl;
+    for (size_t i = 0; i < snapshot.resources.size(); i++) {
+        const RESOURCE& resource = snapshot.resources[i];
+        if (resource.scope != scope) {
+            continue;
+        }
+        std::cout << "  " << CategoryName(resource.category) << " " << resource.name
+            << " (" << resource.owner << "): " << resource.bytes << " bytes";
+        if (resource.format != 0) {
+            std::cout << ", " << FormatName(resource.format);
+        }
+        if (resource.mipCount > 1) {
+            std::cout << ", " << resource.mipCount << " mips";
+        }
+        std::cout << std::endl;
+    }
+
+    return leaks;
+}
+
+/***********************************************************
+ *  FullMipCount()
+ *
+ *  This method returns the levels of a full mip chain, down
+ *  to a single texel.
+ ***********************************************************/
+int ResourceTracker::FullMipCount(int width, int height) {
+    int levels = 1;
+    int size = std::max(width, height);
+    while (size > 1) {
+        size >>= 1;
+        levels++;
+    }
+    return levels;
+}
+
+/***********************************************************
+ *  TextureBytes()
+ *
+ *  This method returns the bytes of a texture with the passed
+ *  in levels, at the nominal size of its format.  Drivers may
+ *  pad the storage, so this is a lower bound.
+ ***********************************************************/
+size_t ResourceTracker::TextureBytes(GLenum format, int width, int height, int layers, int mipCount) {
+    size_t texelBytes = 4;
+    switch (format) {
+    case GL_R8:
+        texelBytes = 1;
+        break;
+    case GL_RGB8:
+        texelBytes = 3;
+        break;
+    case GL_RGBA16F:
+        texelBytes = 8;
+        break;
+    case GL_RGBA32F:
+        texelBytes = 16;
+        break;
+    default:
+        break;
+    }
+
+    size_t texels = 0;
+    for (int level = 0; level < mipCount; level++) {
+        texels += (size_t)std::max(width >> level, 1) * (size_t)std::max(height >> level, 1);
+    }
+
+    return texels * texelBytes * (size_t)std::max(layers, 1);
+}
+
+/***********************************************************
+ *  FormatName()
+ *
+ *  This method returns the name of an internal format.
+ ***********************************************************/
+const char* ResourceTracker::FormatName(GLenum format) {
+    switch (format) {
+    case GL_R8: return "R8";
+    case GL_R32F: return "R32F";
+    case GL_RGB8: return "RGB8";
+    case GL_RGBA8: return "RGBA8";
+    case GL_RGBA16F: return "RGBA16F";
+    case GL_RGBA32F: return "RGBA32F";
+    case GL_DEPTH_COMPONENT24: return "DEPTH24";
+    case GL_DEPTH_COMPONENT32F: return "DEPTH32F";
+    default: return "other";
+    }
+}
+
+/***********************************************************
+ *  CategoryName()
+ *
+ *  This method returns the name of a category.
+ ***********************************************************/
+const char* ResourceTracker::CategoryName(CATEGORY category) {
+    switch (category) {
+    case CATEGORY_BUFFER: return "buffer";
+    case CATEGORY_TEXTURE: return "texture";
+    case CATEGORY_RENDERBUFFER: return "renderbuffer";
+    case CATEGORY_PROGRAM: return "program";
+    default: return "unknown";
+    }
+}
@@ -0,0 +1,102 @@
+///////////////////////////////////////////////////////////////////////////////
+// resourcetracker.h
+// ============
+// account for the GPU buffers, textures and programs and the larger host
+// allocations of the renderer, so their totals and leaks can be reported
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <string>
+#include <vector>
+
+class ResourceTracker {
+public:
+    // Enum for the kinds of GL objects that are accounted for
+    enum CATEGORY {
+        CATEGORY_BUFFER,
+        CATEGORY_TEXTURE,
+        CATEGORY_RENDERBUFFER,
+        CATEGORY_PROGRAM,
+        CATEGORY_COUNT
+    };
+
+    // Struct to hold one live GL object
+    struct RESOURCE {
+        CATEGORY category;
+        GLuint name;
+        size_t bytes;             // Storage of every level and layer
+        GLenum format;            // Internal format of textures and renderbuffers, else 0
+        int mipCount;             // Levels of textures, else 0
+        std::string owner;        // Tag of the object or use it was created for
+        std::string scope;        // Scope that was open when it was created
+        bool bAdopted;            // Found between two marks rather than tracked at creation
+    };
+
+    // Struct to hold the host bytes reported by one owner
+    struct HOST_ALLOCATION {
+        std::string owner;
+        size_t bytes;
+    };
+
+    // Struct to hold a copy of everything accounted for at one moment
+    struct SNAPSHOT {
+        size_t counts[CATEGORY_COUNT];
+        size_t bytes[CATEGORY_COUNT];
+        size_t hostBytes;
+        std::vector<RESOURCE> resources;
+        std::vector<HOST_ALLOCATION> hostAllocations;
+    };
+
+    // Class to tag the resources created while it lives with a scope name,
+    // so the leaks of one system can be told apart from longer lived objects
+    class SCOPE {
+    public:
+        explicit SCOPE(const char* name);
+        ~SCOPE();
+    private:
+        const char* m_previous;
+    };
+
+    // record a buffer, or its new size when its storage is re-specified
+    static void TrackBuffer(GLuint name, size_t bytes, const char* owner);
+    // record a texture of the passed in size, with layers for arrays and cubes
+    static void TrackTexture(GLuint name, GLenum format, int width, int height, int layers, int mipCount, const char* owner);
+    static void TrackRenderbuffer(GLuint name, GLenum format, int width, int height, const char* owner);
+    // record a linked program, sized by its binary
+    static void TrackProgram(GLuint name, const char* owner);
+    // forget an object that is being deleted
+    static void Release(CATEGORY category, GLuint name);
+    // forget and delete the program of a shader manager, zeroing the name
+    // so the shader manager is left with nothing to free
+    static void DeleteProgram(GLuint& program);
+
+    // generate a buffer name that marks where the buffers of an object
+    // that creates them out of reach, such as the shape meshes, begin
+    static GLuint MarkBuffers();
+    // record the buffers created since the mark and delete the mark; the
+    // buffers are reported as untracked when they cannot be told apart
+    static bool AdoptBuffers(GLuint mark, const char* owner);
+    // forget the adopted buffers that no longer exist
+    static void DropDeletedBuffers();
+
+    // set the host bytes currently held by an owner
+    static void SetHostBytes(const char* owner, size_t bytes);
+
+    // copy everything accounted for, safe to call from any thread
+    static SNAPSHOT Snapshot();
+    // print the totals per category and every host owner
+    static void PrintSummary();
+    // print the objects created in a scope that are still alive, and return their number
+    static int ReportLeaks(const char* scope);
+
+    // get the levels of a full mip chain for the passed in size
+    static int FullMipCount(int width, int height);
+    // get the bytes of a texture with the passed in levels
+    static size_t TextureBytes(GLenum format, int width, int height, int layers, int mipCount);
+    static const char* FormatName(GLenum format);
+    static const char* CategoryName(CATEGORY category);
+};
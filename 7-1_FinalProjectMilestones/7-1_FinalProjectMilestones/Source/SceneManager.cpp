@@ -11,22 +11,346 @@
 #include "stb_image.h"
 
 #include "SceneManager.h"
+#include "ViewManager.h"
+#include "TextureUnits.h"
+#include "PrimitiveGeometry.h"
+#include "ResourceTracker.h"
 #include <glm/gtx/transform.hpp>
 #include <vector>
+#include <algorithm>
+#include <cfloat>
+#include <random>
+#include <iomanip>
+#include <thread>
+#include <cstring>
+
+// declaration of the global variables and defines
+namespace {
+    // edge length in texels of each shadow cube face
+    const int SHADOW_MAP_RESOLUTION = 1024;
+
+    // material the objects are shaded with when no material tag is set,
+    // which leaves the lights and the base color as they are
+    const glm::vec3 DEFAULT_MATERIAL_COLOR = glm::vec3(1.0f);
+    const float DEFAULT_MATERIAL_SHININESS = 32.0f;
+
+    // shader files for the depth-only pre-pass
+    const char* g_DepthVertexShader = "Shaders/depthPrepassVertexShader.glsl";
+    const char* g_DepthFragmentShader = "Shaders/depthPrepassFragmentShader.glsl";
+
+    // FIFO size the vertex cache misses are reported for
+    const int VERTEX_CACHE_SIZE = 16;
+    // passes over the static batches per layout in the vertex benchmark
+    const int VERTEX_BENCHMARK_DRAWS = 200;
+
+    // seed for the scattered point lights so every run tests the same layout
+    const unsigned int POINT_LIGHT_SEED = 330;
+
+    // shader files the scene variants are compiled from
+    const char* g_SceneVertexShader = "Shaders/sceneVertexShader.glsl";
+    const char* g_SceneFragmentShader = "Shaders/sceneFragmentShader.glsl";
+
+    // seconds for one orbit of the ship, one turn of the deflector dish and
+    // one pulse of the primary light
+    const float SHIP_ORBIT_SECONDS = 60.0f;
+    const float DISH_SPIN_SECONDS = 4.0f;
+    const float LIGHT_PULSE_SECONDS = 2.0f;
+    // keys over one orbit, and how far the ship bobs up and down
+    const int SHIP_ORBIT_KEYS = 24;
+    const float SHIP_BOB_HEIGHT = 0.25f;
+
+    // generated tracks and fixed steps timed by the animation benchmark
+    const int ANIMATION_BENCHMARK_TRACKS = 10000;
+    const int ANIMATION_BENCHMARK_UPDATES = 600;
+    const unsigned int ANIMATION_BENCHMARK_SEED = 330;
+
+    // entities and the half width of the box they are scattered over in the
+    // entity benchmark
+    const int ENTITY_BENCHMARK_COUNT = 1000000;
+    const float ENTITY_BENCHMARK_EXTENT = 100.0f;
+    const unsigned int ENTITY_BENCHMARK_SEED = 330;
+
+    // rays per side of the pixel grid cast by the ray benchmark
+    const int RAY_BENCHMARK_RESOLUTION = 1024;
+
+    // scope the GL objects of the scene are created in, checked for leaks
+    // once the scene manager has released everything
+    const char* g_ResourceScope = "scene manager";
+
+    // binary world of fleet chunks, generated on the first run
+    const char* g_WorldFile = "fleet.world";
+    // the world origin moves to the camera once it gets this far away, in
+    // whole steps so that the chunk corners stay exact in float
+    const float ORIGIN_REBASE_DISTANCE = 512.0f;
+    const float ORIGIN_REBASE_STEP = 64.0f;
+    // color the streamed ships are drawn with
+    const glm::vec4 FLEET_HULL_COLOR = glm::vec4(0.62f, 0.64f, 0.68f, 1.0f);
+
+    // pixels per side of each captured impostor view
+    const int IMPOSTOR_TILE_RESOLUTION = 128;
+
+    // color of the translucent warp fields around the nacelles
+    const glm::vec4 WARP_FIELD_COLOR = glm::vec4(0.35f, 0.6f, 1.0f, 0.3f);
+
+    // names of the basic shapes, for the shape mesh check
+    const char* g_ShapeMeshNames[SceneManager::MESH_STATIC_BATCH] = {
+        "plane", "box", "cone", "cylinder", "tapered cylinder", "sphere", "half sphere", "torus" };
+    // largest difference allowed between the bounds of a shape mesh and its CPU copy
+    const float SHAPE_BOUNDS_TOLERANCE = 0.001f;
+
+    /***********************************************************
+     *  GetMeshBounds()
+     *
+     *  Returns the object space bounding box of a basic shape
+     *  mesh before any transformation is applied.
+     ***********************************************************/
+    void GetMeshBounds(SceneManager::MESH_TYPE mesh, glm::vec3& boundsMin, glm::vec3& boundsMax) {
+        switch (mesh) {
+        case SceneManager::MESH_PLANE:
+            boundsMin = glm::vec3(-1.0f, 0.0f, -1.0f);
+            boundsMax = glm::vec3(1.0f, 0.0f, 1.0f);
+            break;
+        case SceneManager::MESH_BOX:
+            boundsMin = glm::vec3(-0.5f);
+            boundsMax = glm::vec3(0.5f);
+            break;
+        case SceneManager::MESH_CONE:
+        case SceneManager::MESH_CYLINDER:
+        case SceneManager::MESH_TAPERED_CYLINDER:
+        case SceneManager::MESH_HALF_SPHERE:
+            boundsMin = glm::vec3(-1.0f, 0.0f, -1.0f);
+            boundsMax = glm::vec3(1.0f, 1.0f, 1.0f);
+            break;
+        case SceneManager::MESH_SPHERE:
+            boundsMin = glm::vec3(-1.0f);
+            boundsMax = glm::vec3(1.0f);
+            break;
+        case SceneManager::MESH_TORUS:
+            boundsMin = glm::vec3(-1.2f, -1.2f, -0.2f);
+            boundsMax = glm::vec3(1.2f, 1.2f, 0.2f);
+            break;
+        case SceneManager::MESH_STATIC_BATCH:
+        case SceneManager::MESH_MODEL:
+        case SceneManager::MESH_CHUNK:
+            // batches, models and chunks carry their own bounds
+            boundsMin = glm::vec3(0.0f);
+            boundsMax = glm::vec3(0.0f);
+            break;
+        }
+    }
+
+    /***********************************************************
+     *  TransformBounds()
+     *
+     *  Transforms the corners of the passed in box and returns
+     *  the box that encloses them.
+     ***********************************************************/
+    void TransformBounds(const glm::mat4& matrix, const glm::vec3& localMin, const glm::vec3& localMax,
+        glm::vec3& boundsMin, glm::vec3& boundsMax) {
+        boundsMin = glm::vec3(FLT_MAX);
+        boundsMax = glm::vec3(-FLT_MAX);
+        for (int corner = 0; corner < 8; corner++) {
+            glm::vec3 point(
+                (corner & 1) ? localMax.x : localMin.x,
+                (corner & 2) ? localMax.y : localMin.y,
+                (corner & 4) ? localMax.z : localMin.z);
+            glm::vec3 world = glm::vec3(matrix * glm::vec4(point, 1.0f));
+            boundsMin = glm::min(boundsMin, world);
+            boundsMax = glm::max(boundsMax, world);
+        }
+    }
+
+    /***********************************************************
+     *  BuildMeshGeometry()
+     *
+     *  Builds the CPU side geometry of a basic shape mesh, drawn
+     *  the same way as the matching Draw*Mesh() call.
+     ***********************************************************/
+    void BuildMeshGeometry(SceneManager::MESH_TYPE mesh, PrimitiveGeometry& geometry) {
+        switch (mesh) {
+        case SceneManager::MESH_PLANE:
+            geometry.BuildPlane();
+            break;
+        case SceneManager::MESH_BOX:
+            geometry.BuildBox();
+            break;
+        case SceneManager::MESH_CONE:
+            geometry.BuildCylinder(1.0f, 0.0f, false, true);
+            break;
+        case SceneManager::MESH_CYLINDER:
+            geometry.BuildCylinder(1.0f, 1.0f, true, true);
+            break;
+        case SceneManager::MESH_TAPERED_CYLINDER:
+            geometry.BuildCylinder(1.0f, 0.5f, true, true);
+            break;
+        case SceneManager::MESH_SPHERE:
+            geometry.BuildSphere(false);
+            break;
+        case SceneManager::MESH_HALF_SPHERE:
+            geometry.BuildSphere(true);
+            break;
+        case SceneManager::MESH_TORUS:
+            geometry.BuildTorus();
+            break;
+        case SceneManager::MESH_STATIC_BATCH:
+        case SceneManager::MESH_MODEL:
+        case SceneManager::MESH_CHUNK:
+            geometry.Clear();
+            break;
+        }
+    }
+
+    /***********************************************************
+     *  FindNewVertexArray()
+     *
+     *  Returns the vertex array created since the passed in
+     *  mark name was generated, and deletes the mark.  The name
+     *  is only trusted when exactly one was handed out between
+     *  the mark and the next, otherwise 0 is returned.
+     ***********************************************************/
+    GLuint FindNewVertexArray(GLuint mark) {
+        GLuint end = 0;
+        glGenVertexArrays(1, &end);
+
+        GLuint vertexArray = 0;
+        if ((end == mark + 2) && glIsVertexArray(mark + 1)) {
+            vertexArray = mark + 1;
+        }
+
+        glDeleteVertexArrays(1, &mark);
+        glDeleteVertexArrays(1, &end);
+        return(vertexArray);
+    }
+
+    /***********************************************************
+     *  CheckShapeMesh()
+     *
+     *  Compares a loaded shape mesh against the CPU copy that
+     *  the batches and the ray queries are built from.  The
+     *  vertex count, index buffer size and bounds are read back
+     *  from the shape mesh's vertex array, so a shape that has
+     *  gone out of sync is reported when it is loaded.
+     ***********************************************************/
+    bool CheckShapeMesh(SceneManager::MESH_TYPE mesh, GLuint vertexArray) {
+        PrimitiveGeometry geometry;
+        BuildMeshGeometry(mesh, geometry);
+        glm::vec3 copyMin;
+        glm::vec3 copyMax;
+        geometry.GetBounds(copyMin, copyMax);
+
+        GLint boundArray = 0;
+        GLint boundBuffer = 0;
+        glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &boundArray);
+        glGetIntegerv(GL_COPY_READ_BUFFER_BINDING, &boundBuffer);
+
+        // the position is attribute 0, as in the scene vertex shader
+        GLint vertexBuffer = 0;
+        GLint components = 0;
+        GLint stride = 0;
+        GLint indexBuffer = 0;
+        void* pointer = nullptr;
+        glBindVertexArray(vertexArray);
+        glGetVertexAttribiv(0, GL_VERTEX_ATTRIB_ARRAY_BUFFER_BINDING, &vertexBuffer);
+        glGetVertexAttribiv(0, GL_VERTEX_ATTRIB_ARRAY_SIZE, &components);
+        glGetVertexAttribiv(0, GL_VERTEX_ATTRIB_ARRAY_STRIDE, &stride);
+        glGetVertexAttribPointerv(0, GL_VERTEX_ATTRIB_ARRAY_POINTER, &pointer);
+        glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &indexBuffer);
+        glBindVertexArray(boundArray);
+
+        std::vector<unsigned char> data;
+        GLint64 indexBytes = 0;
+        if (vertexBuffer != 0) {
+            GLint64 size = 0;
+            glBindBuffer(GL_COPY_READ_BUFFER, vertexBuffer);
+            glGetBufferParameteri64v(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &size);
+            data.resize((size_t)size);
+            if (!data.empty()) {
+                glGetBufferSubData(GL_COPY_READ_BUFFER, 0, (GLsizeiptr)data.size(), &data[0]);
+            }
+        }
+        if (indexBuffer != 0) {
+            glBindBuffer(GL_COPY_READ_BUFFER, indexBuffer);
+            glGetBufferParameteri64v(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &indexBytes);
+        }
+        glBindBuffer(GL_COPY_READ_BUFFER, boundBuffer);
+
+        // a stride of 0 means the positions are tightly packed
+        size_t positionBytes = (size_t)glm::clamp(components, 0, 3) * sizeof(float);
+        size_t offset = (size_t)pointer;
+        size_t step = (stride > 0) ? (size_t)stride : positionBytes;
+        size_t vertexCount = 0;
+        if ((positionBytes > 0) && (data.size() >= offset + positionBytes)) {
+            vertexCount = (data.size() - offset - positionBytes) / step + 1;
+        }
+
+        glm::vec3 shapeMin(FLT_MAX);
+        glm::vec3 shapeMax(-FLT_MAX);
+        for (size_t i = 0; i < vertexCount; i++) {
+            glm::vec3 position(0.0f);
+            memcpy(&position[0], &data[offset + i * step], positionBytes);
+            shapeMin = glm::min(shapeMin, position);
+            shapeMax = glm::max(shapeMax, position);
+        }
+
+        // an indexed mesh is compared vertex for vertex and by its index
+        // buffer, which may hold 16 or 32 bit indices since the type is not
+        // kept with the vertex array; otherwise its vertices are drawn in
+        // order and stand for the copy's index list
+        size_t indexCount = geometry.Indices().size();
+        bool bCountsMatch = (vertexCount == indexCount);
+        if (indexBuffer != 0) {
+            bCountsMatch = (vertexCount == geometry.Vertices().size()) &&
+                (((size_t)indexBytes == indexCount * sizeof(GLushort)) ||
+                ((size_t)indexBytes == indexCount * sizeof(GLuint)));
+        }
+        glm::vec3 boundsError = glm::max(glm::abs(shapeMin - copyMin), glm::abs(shapeMax - copyMax));
+        bool bBoundsMatch = glm::max(boundsError.x, glm::max(boundsError.y, boundsError.z)) <= SHAPE_BOUNDS_TOLERANCE;
+
+        if (!bCountsMatch || !bBoundsMatch) {
+            std::cout << "Error: The " << g_ShapeMeshNames[mesh] << " shape mesh does not match its CPU copy: "
+                << vertexCount << " vertices, " << indexBytes << " index bytes, bounds ("
+                << shapeMin.x << ", " << shapeMin.y << ", " << shapeMin.z << ") to ("
+                << shapeMax.x << ", " << shapeMax.y << ", " << shapeMax.z << ") against "
+                << geometry.Vertices().size() << " vertices, " << indexCount << " indices, bounds ("
+                << copyMin.x << ", " << copyMin.y << ", " << copyMin.z << ") to ("
+                << copyMax.x << ", " << copyMax.y << ", " << copyMax.z << ")" << std::endl;
+            return(false);
+        }
+
+        return(true);
+    }
+}
 
 /***********************************************************
  *  SceneManager()
  *
  *  The constructor for the class
  ***********************************************************/
-SceneManager::SceneManager(ShaderManager* pShaderManager)
-    : m_pShaderManager(pShaderManager), m_basicMeshes(new ShapeMeshes()), m_loadedTextures(0) {
+SceneManager::SceneManager(ShaderManager* pShaderManager, ViewManager* pViewManager, FrameStats* pFrameStats)
+    : m_pShaderManager(pShaderManager), m_pViewManager(pViewManager), m_pFrameStats(pFrameStats),
+    m_pStartupTimer(nullptr), m_basicMeshes(new ShapeMeshes()), m_loadedTextures(0),
+    m_pDepthShader(nullptr), m_bDepthPrepass(true), m_bFrontToBackSort(true),
+    m_pHiZBuffer(nullptr), m_bOcclusionCulling(true),
+    m_pShadowMap(nullptr), m_bShadows(true), m_sceneBoundsMin(0.0f), m_sceneBoundsMax(0.0f),
+    m_pClusteredLighting(nullptr), m_bClusteredLights(true), m_bStaticBatching(true),
+    m_vertexLayout(MeshBuffer::LAYOUT_FLOAT),
+    m_pShaderVariants(nullptr), m_bShaderVariants(true), m_bVariantTiming(false),
+    m_uberProgram(0), m_frameIndex(0), m_activeView(-1), m_lastViewMode(-1),
+    m_bAnimation(true), m_shipTrack(-1), m_dishTrack(-1), m_lightColorTrack(-1),
+    m_pWorldStreamer(nullptr), m_bWorldStreaming(true), m_worldOrigin(0.0), m_homeOffset(0.0f),
+    m_bOriginMoved(false), m_pImpostorAtlas(nullptr), m_bImpostors(true),
+    m_pTransparencyBuffer(nullptr), m_bWeightedTransparency(true), m_bRaySceneDirty(true) {
     // initialize the texture collection
     for (int i = 0; i < 16; i++) {
         m_textureIDs[i].tag = "";
         m_textureIDs[i].ID = -1;
     }
 
+    // the basic shapes are generated the first time an object uses them
+    for (int i = 0; i < MESH_STATIC_BATCH; i++) {
+        m_bMeshLoaded[i] = false;
+    }
+
     // Initialize primary light (prominent orange glow from just above the plane)
     m_primaryLight.position = glm::vec3(0.0f, 2.0f, 0.0f);
     m_primaryLight.color = glm::vec3(1.0f, 0.55f, 0.0f);  // A more prominent orange
@@ -48,24 +372,220 @@ SceneManager::~SceneManager() {
         delete m_basicMeshes;
         m_basicMeshes = nullptr;
     }
+    if (m_pDepthShader) {
+        ResourceTracker::DeleteProgram(m_pDepthShader->m_programID);
+        delete m_pDepthShader;
+        m_pDepthShader = nullptr;
+    }
+    if (m_pHiZBuffer) {
+        delete m_pHiZBuffer;
+        m_pHiZBuffer = nullptr;
+    }
+    if (m_pShadowMap) {
+        delete m_pShadowMap;
+        m_pShadowMap = nullptr;
+    }
+    if (m_pClusteredLighting) {
+        delete m_pClusteredLighting;
+        m_pClusteredLighting = nullptr;
+    }
+    if (m_pWorldStreamer) {
+        delete m_pWorldStreamer;
+        m_pWorldStreamer = nullptr;
+    }
+    if (m_pImpostorAtlas) {
+        delete m_pImpostorAtlas;
+        m_pImpostorAtlas = nullptr;
+    }
+    if (m_pTransparencyBuffer) {
+        delete m_pTransparencyBuffer;
+        m_pTransparencyBuffer = nullptr;
+    }
+    for (size_t i = 0; i < m_staticBatches.size(); i++) {
+        delete m_staticBatches[i];
+    }
+    m_staticBatches.clear();
+    for (size_t i = 0; i < m_modelMeshes.size(); i++) {
+        delete m_modelMeshes[i];
+    }
+    m_modelMeshes.clear();
+    if (m_pShaderVariants) {
+        // hand the uber program back before the variants are deleted
+        if (NULL != m_pShaderManager) {
+            m_pShaderManager->m_programID = m_uberProgram;
+        }
+        delete m_pShaderVariants;
+        m_pShaderVariants = nullptr;
+    }
+    DestroyGLTextures();
 
-    // Additional cleanup if necessary
+    // anything created for the scene that is still alive was never freed;
+    // the shape mesh buffers are adopted rather than tracked, so the ones
+    // the meshes did free are dropped first
+    ResourceTracker::DropDeletedBuffers();
+    ResourceTracker::ReportLeaks(g_ResourceScope);
 }
 
 /***********************************************************
  *  SetLighting()
  *
  *  This method is used for passing the lighting values
- *  into the shader.
+ *  and the default material into the shader.
  ***********************************************************/
 void SceneManager::SetLighting() {
     if (NULL != m_pShaderManager) {
-        m_pShaderManager->setVec3Value("primaryLight.position", m_primaryLight.position);
+        m_pShaderManager->setVec3Value("primaryLight.position", m_primaryLight.position + m_homeOffset);
         m_pShaderManager->setVec3Value("primaryLight.color", m_primaryLight.color);
         m_pShaderManager->setFloatValue("primaryLight.intensity", m_primaryLight.intensity);
 
         m_pShaderManager->setVec3Value("ambientLight.color", m_ambientLight.color);
         m_pShaderManager->setFloatValue("ambientLight.intensity", m_ambientLight.intensity);
+
+        m_pShaderManager->setVec3Value("material.ambientColor", DEFAULT_MATERIAL_COLOR);
+        m_pShaderManager->setFloatValue("material.ambientStrength", 1.0f);
+        m_pShaderManager->setVec3Value("material.diffuseColor", DEFAULT_MATERIAL_COLOR);
+        m_pShaderManager->setVec3Value("material.specularColor", DEFAULT_MATERIAL_COLOR);
+        m_pShaderManager->setFloatValue("material.shininess", DEFAULT_MATERIAL_SHININESS);
+
+        // the cube sampler always needs its own unit, even with shadows off,
+        // since two sampler types cannot share a texture unit
+        bool bShadows = m_bShadows && (NULL != m_pShadowMap);
+        m_pShaderManager->setSampler2DValue("shadowMap", TEXTURE_UNIT_SHADOW_MAP);
+        m_pShaderManager->setIntValue("bUseShadows", bShadows);
+        if (bShadows) {
+            glActiveTexture(GL_TEXTURE0 + TEXTURE_UNIT_SHADOW_MAP);
+            glBindTexture(GL_TEXTURE_CUBE_MAP, m_pShadowMap->DepthTexture());
+            m_pShaderManager->setFloatValue("shadowFarPlane", m_pShadowMap->FarPlane());
+        }
+    }
+}
+
+/***********************************************************
+ *  UpdateClusteredLights()
+ *
+ *  This method is used for binning the point lights into the
+ *  clusters of the current camera.  The clusters are passed
+ *  into each program with the other frame uniforms.  While
+ *  several views are drawn, each view is binned for its own
+ *  camera and viewport just before it is drawn.
+ ***********************************************************/
+void SceneManager::UpdateClusteredLights() {
+    bool bClustered = m_bClusteredLights && (NULL != m_pClusteredLighting) && (NULL != m_pViewManager);
+    if (!bClustered || (MultiViewActive() && (m_activeView < 0))) {
+        return;
+    }
+
+    if (m_activeView >= 0) {
+        const ViewManager::VIEW& view = m_pViewManager->GetView(m_activeView);
+        int x, y, width, height;
+        m_pViewManager->GetViewport(m_activeView, x, y, width, height);
+        m_pClusteredLighting->Update(view.view, view.projection, x, y, width, height,
+            m_pViewManager->NearPlane(), m_pViewManager->FarPlane());
+    }
+    else {
+        // gl_FragCoord is in render target pixels, so bin for the scaled size
+        m_pClusteredLighting->Update(
+            m_pViewManager->GetViewMatrix(), m_pViewManager->GetProjectionMatrix(),
+            0, 0, m_pViewManager->RenderWidth(), m_pViewManager->RenderHeight(),
+            m_pViewManager->NearPlane(), m_pViewManager->FarPlane());
+    }
+
+    if (NULL != m_pFrameStats) {
+        m_pFrameStats->AddCount("lights", m_pClusteredLighting->LightCount());
+        m_pFrameStats->AddCount("light assignments", m_pClusteredLighting->AssignmentCount());
+        m_pFrameStats->AddCount("light binning ms", m_pClusteredLighting->BinningTime());
+    }
+}
+
+/***********************************************************
+ *  ApplyFrameUniforms()
+ *
+ *  This method is used for passing the values that stay the
+ *  same for the whole frame into the current program: the
+ *  camera, the lights and the point light clusters.  While
+ *  a view of several is drawn its camera is passed instead.
+ ***********************************************************/
+void SceneManager::ApplyFrameUniforms() {
+    if ((NULL != m_pViewManager) && (m_activeView >= 0)) {
+        const ViewManager::VIEW& view = m_pViewManager->GetView(m_activeView);
+        m_pShaderManager->setMat4Value("view", view.view);
+        m_pShaderManager->setMat4Value("projection", view.projection);
+        m_pShaderManager->setVec3Value("viewPosition", view.position);
+    }
+    else if (NULL != m_pViewManager) {
+        m_pShaderManager->setMat4Value("view", m_pViewManager->GetViewMatrix());
+        m_pShaderManager->setMat4Value("projection", m_pViewManager->GetProjectionMatrix());
+        m_pShaderManager->setVec3Value("viewPosition", m_pViewManager->GetCameraPosition());
+    }
+
+    SetLighting();
+    m_pShaderManager->setIntValue("bWeightedOIT", false);
+
+    bool bClustered = m_bClusteredLights && (NULL != m_pClusteredLighting) && (NULL != m_pViewManager);
+    m_pShaderManager->setIntValue("bUseClusteredLights", bClustered);
+    if (bClustered) {
+        m_pClusteredLighting->Apply(m_pShaderManager);
+    }
+}
+
+/***********************************************************
+ *  ObjectVariant()
+ *
+ *  This method returns the features the passed in object is
+ *  drawn with this frame, so that it gets the smallest
+ *  shader variant that can draw it.
+ ***********************************************************/
+unsigned int SceneManager::ObjectVariant(const EntityStore& entities, int index) const {
+    unsigned int features = 0;
+
+    if (m_drawMaterials[entities.MaterialIds()[index]].textureSlot != -1) {
+        features |= ShaderVariantCache::FEATURE_TEXTURE;
+    }
+    if (entities.Flags()[index] & EntityStore::FLAG_LIT) {
+        features |= ShaderVariantCache::FEATURE_LIGHTING;
+        if (m_bShadows && (NULL != m_pShadowMap)) {
+            features |= ShaderVariantCache::FEATURE_SHADOWS;
+        }
+        if (m_bClusteredLights && (NULL != m_pClusteredLighting) && (m_pClusteredLighting->LightCount() > 0)) {
+            features |= ShaderVariantCache::FEATURE_POINT_LIGHTS;
+        }
+    }
+
+    const MeshBuffer* pBuffer = ObjectMeshBuffer(entities.MeshIds()[index], entities.MeshResources()[index]);
+    if ((NULL != pBuffer) && (pBuffer->Layout() == MeshBuffer::LAYOUT_COMPACT)) {
+        features |= ShaderVariantCache::FEATURE_COMPACT_VERTEX;
+    }
+
+    return features;
+}
+
+/***********************************************************
+ *  UseVariant()
+ *
+ *  This method is used for making the program for the passed
+ *  in features current, compiling it on first use.  The uber
+ *  program is used when the variants are disabled or fail to
+ *  compile.  Each program gets the frame uniforms the first
+ *  time it is used in a frame.
+ ***********************************************************/
+void SceneManager::UseVariant(unsigned int features) {
+    GLuint program = m_uberProgram;
+    if (m_bShaderVariants && (NULL != m_pShaderVariants)) {
+        GLuint variant = m_pShaderVariants->GetProgram(features);
+        if (variant != 0) {
+            program = variant;
+        }
+    }
+
+    if (m_pShaderManager->m_programID != program) {
+        m_pShaderManager->m_programID = program;
+        m_pShaderManager->use();
+    }
+
+    auto stamp = m_programFrames.find(program);
+    if ((stamp == m_programFrames.end()) || (stamp->second != m_frameIndex)) {
+        m_programFrames[program] = m_frameIndex;
+        ApplyFrameUniforms();
     }
 }
 
@@ -74,40 +594,306 @@ void SceneManager::SetLighting() {
  *
  *  This method is used for preparing the 3D scene by loading
  *  the shapes, textures in memory to support the 3D scene
- *  rendering
+ *  rendering.  The shapes and textures are only loaded when
+ *  an object first uses them, so the time to the first frame
+ *  follows what the scene actually draws.
  ***********************************************************/
 void SceneManager::PrepareScene() {
-    // load the textures for the 3D scene
+    ResourceTracker::SCOPE scope(g_ResourceScope);
+
+    // register the textures for the 3D scene
     LoadSceneTextures();
 
-    // only one instance of a particular mesh needs to be
-    // loaded in memory no matter how many times it is drawn
-    // in the rendered 3D scene
-    m_basicMeshes->LoadPlaneMesh();
-    m_basicMeshes->LoadConeMesh();
-    m_basicMeshes->LoadCylinderMesh();
-    m_basicMeshes->LoadSphereMesh();
-    m_basicMeshes->LoadTaperedCylinderMesh();
-    m_basicMeshes->LoadBoxMesh();
-    m_basicMeshes->LoadTorusMesh();
+    // load the minimal program used for the depth-only pre-pass
+    m_pDepthShader = new ShaderManager();
+    if (m_pDepthShader->LoadShaders(g_DepthVertexShader, g_DepthFragmentShader) == 0) {
+        std::cout << "Error: Depth pre-pass shaders failed to load, pre-pass disabled" << std::endl;
+        delete m_pDepthShader;
+        m_pDepthShader = nullptr;
+    }
+    else {
+        ResourceTracker::TrackProgram(m_pDepthShader->m_programID, "depth pre-pass");
+    }
+
+    // load the reduction pass used to build the occlusion depth pyramid
+    m_pHiZBuffer = new HiZBuffer();
+    if (!m_pHiZBuffer->Initialize()) {
+        std::cout << "Error: Occlusion culling disabled" << std::endl;
+        delete m_pHiZBuffer;
+        m_pHiZBuffer = nullptr;
+    }
+
+    // load the composite pass of the translucent objects
+    m_pTransparencyBuffer = new TransparencyBuffer();
+    if (!m_pTransparencyBuffer->Initialize()) {
+        std::cout << "Error: Weighted transparency disabled" << std::endl;
+        delete m_pTransparencyBuffer;
+        m_pTransparencyBuffer = nullptr;
+    }
+
+    // allocate the shadow cube map of the primary light
+    m_pShadowMap = new ShadowMap();
+    if (!m_pShadowMap->Initialize(SHADOW_MAP_RESOLUTION)) {
+        std::cout << "Error: Shadows disabled" << std::endl;
+        delete m_pShadowMap;
+        m_pShadowMap = nullptr;
+    }
+
+    // create the buffers the point lights are binned into
+    m_pClusteredLighting = new ClusteredLighting();
+    if (!m_pClusteredLighting->Initialize()) {
+        std::cout << "Error: Point lights disabled" << std::endl;
+        delete m_pClusteredLighting;
+        m_pClusteredLighting = nullptr;
+    }
+
+    // open the fleet world that is streamed in around the camera
+    m_pWorldStreamer = new WorldStreamer(m_pFrameStats);
+    if (!m_pWorldStreamer->Initialize(g_WorldFile)) {
+        std::cout << "Error: World streaming disabled" << std::endl;
+        delete m_pWorldStreamer;
+        m_pWorldStreamer = nullptr;
+    }
+
+    if (NULL != m_pShaderManager) {
+        m_pShaderManager->use();
+
+        // the variants are compiled from the same files as the uber program
+        m_uberProgram = m_pShaderManager->m_programID;
+        m_pShaderVariants = new ShaderVariantCache();
+        if (!m_pShaderVariants->Initialize(g_SceneVertexShader, g_SceneFragmentShader)) {
+            std::cout << "Error: Shader variants disabled" << std::endl;
+            delete m_pShaderVariants;
+            m_pShaderVariants = nullptr;
+        }
+    }
+
+    // capture the ship classes the distant chunks are drawn with
+    BuildImpostors();
+
+    // place the objects that make up the 3D scene
+    DefineSceneObjects();
+    DefineAnimationTracks();
+    UpdateSceneBounds();
+    BakeStaticObjects();
+
+    // place the objects for the ray queries, the triangles of
+    // each shape were built when an object first used it
+    UpdateRayScene();
+
+    // place the lights on the ship, the scene bounds are needed first
+    DefineSceneLights();
+    SetPointLightCount((int)m_shipLights.size());
 }
 
 /***********************************************************
- *  LoadSceneTextures()
+ *  SetDepthPrepass()
  *
- *  This method is used for preparing the 3D scene by loading
- *  the shapes, textures in memory to support the 3D scene
- *  rendering
+ *  This method is used to enable or disable the depth-only
+ *  pre-pass that runs before the lit pass.
  ***********************************************************/
-void SceneManager::LoadSceneTextures() {
-    bool bReturn = false;
+void SceneManager::SetDepthPrepass(bool bEnable) {
+    m_bDepthPrepass = bEnable;
+    std::cout << "INFO: Depth pre-pass " << (bEnable ? "enabled" : "disabled") << std::endl;
+}
+
+/***********************************************************
+ *  SetOcclusionCulling()
+ *
+ *  This method is used to enable or disable skipping the
+ *  objects that were hidden in the depth of earlier frames.
+ ***********************************************************/
+void SceneManager::SetOcclusionCulling(bool bEnable) {
+    m_bOcclusionCulling = bEnable;
+    std::cout << "INFO: Occlusion culling " << (bEnable ? "enabled" : "disabled") << std::endl;
+}
+
+/***********************************************************
+ *  SetShadows()
+ *
+ *  This method is used to enable or disable the shadows of
+ *  the primary light.
+ ***********************************************************/
+void SceneManager::SetShadows(bool bEnable) {
+    m_bShadows = bEnable;
+    std::cout << "INFO: Shadows " << (bEnable ? "enabled" : "disabled") << std::endl;
+}
+
+/***********************************************************
+ *  SetClusteredLights()
+ *
+ *  This method is used to enable or disable shading the
+ *  point lights in the lit pass.
+ ***********************************************************/
+void SceneManager::SetClusteredLights(bool bEnable) {
+    m_bClusteredLights = bEnable;
+    std::cout << "INFO: Clustered point lights " << (bEnable ? "enabled" : "disabled") << std::endl;
+}
+
+/***********************************************************
+ *  SetPointLightCount()
+ *
+ *  This method is used to set the number of point lights.
+ *  The ship lights are used first, then the remainder are
+ *  scattered over the scene bounds with a fixed seed.
+ ***********************************************************/
+void SceneManager::SetPointLightCount(int count) {
+    if (NULL == m_pClusteredLighting) {
+        return;
+    }
+
+    m_pClusteredLighting->ClearLights();
+
+    int shipLights = std::min(count, (int)m_shipLights.size());
+    for (int i = 0; i < shipLights; i++) {
+        const ClusteredLighting::POINT_LIGHT& light = m_shipLights[i];
+        m_pClusteredLighting->AddLight(glm::vec3(light.positionRadius) + m_homeOffset, light.positionRadius.w,
+            glm::vec3(light.colorIntensity), light.colorIntensity.w);
+    }
+
+    std::mt19937 generator(POINT_LIGHT_SEED);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    for (int i = shipLights; i < count; i++) {
+        glm::vec3 position(
+            glm::mix(m_sceneBoundsMin.x, m_sceneBoundsMax.x, unit(generator)),
+            glm::mix(m_sceneBoundsMin.y, m_sceneBoundsMax.y + 2.0f, unit(generator)),
+            glm::mix(m_sceneBoundsMin.z, m_sceneBoundsMax.z, unit(generator)));
+        glm::vec3 color(unit(generator), unit(generator), unit(generator));
+        float radius = 1.0f + 2.0f * unit(generator);
+        m_pClusteredLighting->AddLight(position + m_homeOffset, radius, color, 2.0f);
+    }
+
+    std::cout << "INFO: " << count << " point lights" << std::endl;
+}
+
+/***********************************************************
+ *  PointLightCount()
+ *
+ *  This method returns the number of point lights.
+ ***********************************************************/
+int SceneManager::PointLightCount() const {
+    if (NULL == m_pClusteredLighting) {
+        return(0);
+    }
+
+    return(m_pClusteredLighting->LightCount());
+}
+
+/***********************************************************
+ *  SetStaticBatching()
+ *
+ *  This method is used to switch between drawing the baked
+ *  static batches and drawing every object on its own.
+ ***********************************************************/
+void SceneManager::SetStaticBatching(bool bEnable) {
+    m_bStaticBatching = bEnable;
+    std::cout << "INFO: Static batching " << (bEnable ? "enabled" : "disabled") << std::endl;
+}
+
+/***********************************************************
+ *  SetShaderVariants()
+ *
+ *  This method is used to switch between drawing with the
+ *  minimal shader variant per object and drawing everything
+ *  with the uber program and its feature uniforms.
+ ***********************************************************/
+void SceneManager::SetShaderVariants(bool bEnable) {
+    m_bShaderVariants = bEnable;
+    std::cout << "INFO: Shader variants " << (bEnable ? "enabled" : "disabled") << std::endl;
+}
+
+/***********************************************************
+ *  SetVariantTiming()
+ *
+ *  This method is used to time the lit pass per shader
+ *  variant.  The draws are grouped by variant so that each
+ *  one is timed once per frame; the single lit pass timer
+ *  is not recorded meanwhile, since timers cannot nest.
+ ***********************************************************/
+void SceneManager::SetVariantTiming(bool bEnable) {
+    m_bVariantTiming = bEnable;
+    std::cout << "INFO: Per-variant GPU timing " << (bEnable ? "enabled" : "disabled") << std::endl;
+}
+
+/***********************************************************
+ *  SetAnimation()
+ *
+ *  This method is used to pause or resume the animation.
+ *  A paused scene keeps the pose it was stopped in.
+ ***********************************************************/
+void SceneManager::SetAnimation(bool bEnable) {
+    m_bAnimation = bEnable;
+    std::cout << "INFO: Animation " << (bEnable ? "enabled" : "paused") << std::endl;
+}
+
+/***********************************************************
+ *  SetWorldStreaming()
+ *
+ *  This method is used to enable or disable streaming the
+ *  fleet chunks.  Disabling it releases every chunk.
+ ***********************************************************/
+void SceneManager::SetWorldStreaming(bool bEnable) {
+    m_bWorldStreaming = bEnable;
+    if (!bEnable && (NULL != m_pWorldStreamer)) {
+        m_pWorldStreamer->UnloadAll();
+        for (size_t i = 0; i < m_pWorldStreamer->UnloadedSlots().size(); i++) {
+            RemoveChunkEntities(m_pWorldStreamer->UnloadedSlots()[i]);
+        }
+    }
+    std::cout << "INFO: World streaming " << (bEnable ? "enabled" : "disabled") << std::endl;
+}
+
+/***********************************************************
+ *  SetImpostors()
+ *
+ *  This method is used to switch between drawing the distant
+ *  chunks as impostor quads and drawing their full geometry.
+ ***********************************************************/
+void SceneManager::SetImpostors(bool bEnable) {
+    m_bImpostors = bEnable;
+    std::cout << "INFO: Impostors " << (bEnable ? "enabled" : "disabled") << std::endl;
+}
+
+/***********************************************************
+ *  SetWeightedTransparency()
+ *
+ *  This method is used to switch between blending the
+ *  translucent objects in any order through the weighted
+ *  transparency targets and blending them straight over the
+ *  scene after sorting them farthest first.
+ ***********************************************************/
+void SceneManager::SetWeightedTransparency(bool bEnable) {
+    m_bWeightedTransparency = bEnable;
+    std::cout << "INFO: Weighted blended transparency " << (bEnable ? "enabled" : "disabled") << std::endl;
+}
 
-    bReturn = CreateGLTexture("C:\\CS330Content\\Projects\\Utilities\\textures\\circular-brushed-gold-texture.jpg", "dome");
-    bReturn = CreateGLTexture("C:\\CS330Content\\Projects\\Utilities\\textures\\stainless.jpg", "hull");
-    bReturn = CreateGLTexture("C:\\CS330Content\\Utilities\\textures\\stainless_end.jpg", "shuttlebay");
-    bReturn = CreateGLTexture("C:\\CS330Content\\Utilities\\textures\\abstract.jpg", "planet");
+/***********************************************************
+ *  SetFrontToBackSort()
+ *
+ *  This method is used to enable or disable sorting the
+ *  opaque objects nearest first before they are submitted.
+ ***********************************************************/
+void SceneManager::SetFrontToBackSort(bool bEnable) {
+    m_bFrontToBackSort = bEnable;
+    std::cout << "INFO: Front-to-back sorting " << (bEnable ? "enabled" : "disabled") << std::endl;
+}
 
-    BindGLTextures();
+/***********************************************************
+ *  LoadSceneTextures()
+ *
+ *  This method is used for registering the texture files of
+ *  the 3D scene with their tags.  Each file is read the first
+ *  time its tag is used, in FindTextureSlot().
+ ***********************************************************/
+void SceneManager::LoadSceneTextures() {
+    const TEXTURE_FILE textures[] = {
+        { "C:\\CS330Content\\Projects\\Utilities\\textures\\circular-brushed-gold-texture.jpg", "dome" },
+        { "C:\\CS330Content\\Projects\\Utilities\\textures\\stainless.jpg", "hull" },
+        { "C:\\CS330Content\\Utilities\\textures\\stainless_end.jpg", "shuttlebay" },
+        { "C:\\CS330Content\\Utilities\\textures\\abstract.jpg", "planet" }
+    };
+
+    m_textureFiles.assign(std::begin(textures), std::end(textures));
 }
 
 /***********************************************************
@@ -163,6 +949,8 @@ bool SceneManager::CreateGLTexture(const char* filename, std::string tag) {
 
         // generate the texture mipmaps for mapping textures to lower resolutions
         glGenerateMipmap(GL_TEXTURE_2D);
+        ResourceTracker::TrackTexture(textureID, (colorChannels == 3) ? GL_RGB8 : GL_RGBA8, width, height, 1,
+            ResourceTracker::FullMipCount(width, height), tag.c_str());
 
         // free the image data from local memory
         stbi_image_free(image);
@@ -207,8 +995,12 @@ void SceneManager::BindGLTextures() {
  ***********************************************************/
 void SceneManager::DestroyGLTextures() {
     for (int i = 0; i < m_loadedTextures; i++) {
+        ResourceTracker::Release(ResourceTracker::CATEGORY_TEXTURE, m_textureIDs[i].ID);
         glDeleteTextures(1, &m_textureIDs[i].ID);
+        m_textureIDs[i].tag = "";
+        m_textureIDs[i].ID = -1;
     }
+    m_loadedTextures = 0;
 }
 
 /***********************************************************
@@ -238,7 +1030,8 @@ int SceneManager::FindTextureID(std::string tag) {
  *  FindTextureSlot()
  *
  *  This method is used for getting a slot index for the previously
- *  loaded texture bitmap associated with the passed in tag.
+ *  loaded texture bitmap associated with the passed in tag.  A
+ *  registered texture that is not loaded yet is loaded here.
  ***********************************************************/
 int SceneManager::FindTextureSlot(std::string tag) {
     static std::unordered_set<std::string> missingTextures;
@@ -250,6 +1043,24 @@ int SceneManager::FindTextureSlot(std::string tag) {
         }
     }
 
+    // the file is only tried once, a texture that fails to load is missing
+    for (size_t i = 0; i < m_textureFiles.size(); i++) {
+        if (m_textureFiles[i].tag == tag) {
+            TEXTURE_FILE texture = m_textureFiles[i];
+            m_textureFiles.erase(m_textureFiles.begin() + i);
+
+            double startTime = glfwGetTime();
+            bool bLoaded = CreateGLTexture(texture.filename.c_str(), texture.tag);
+            if (NULL != m_pStartupTimer) {
+                m_pStartupTimer->AddPhaseTime("textures", glfwGetTime() - startTime);
+            }
+            if (bLoaded) {
+                return m_loadedTextures - 1;
+            }
+            break;
+        }
+    }
+
     if (missingTextures.find(tag) == missingTextures.end()) {
         std::cout << "Error: Could not find texture slot for tag: " << tag << std::endl;
         missingTextures.insert(tag);  // Add tag to missingTextures to prevent repeated logging
@@ -289,12 +1100,12 @@ bool SceneManager::FindMaterial(std::string tag, OBJECT_MATERIAL& material) {
 }
 
 /***********************************************************
- *  SetTransformations()
+ *  BuildTransformation()
  *
- *  This method is used for setting the transform buffer
- *  using the passed in transformation values.
+ *  This method is used for building the model matrix from
+ *  the passed in transformation values.
  ***********************************************************/
-void SceneManager::SetTransformations(
+glm::mat4 SceneManager::BuildTransformation(
     glm::vec3 scaleXYZ,
     float XrotationDegrees,
     float YrotationDegrees,
@@ -315,6 +1126,23 @@ void SceneManager::SetTransformations(
 
     modelView = translation * rotationX * rotationY * rotationZ * scale;
 
+    return(modelView);
+}
+
+/***********************************************************
+ *  SetTransformations()
+ *
+ *  This method is used for setting the transform buffer
+ *  using the passed in transformation values.
+ ***********************************************************/
+void SceneManager::SetTransformations(
+    glm::vec3 scaleXYZ,
+    float XrotationDegrees,
+    float YrotationDegrees,
+    float ZrotationDegrees,
+    glm::vec3 positionXYZ) {
+    glm::mat4 modelView = BuildTransformation(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
+
     if (NULL != m_pShaderManager) {
         m_pShaderManager->setMat4Value("model", modelView);
     }
@@ -395,130 +1223,2120 @@ void SceneManager::SetShaderMaterial(std::string materialTag) {
 }
 
 /***********************************************************
- *  RenderScene()
+ *  AddSceneObject()
  *
- *  This method is used for rendering the 3D scene by
- *  transforming and drawing the basic 3D shapes
+ *  This method is used for adding an object to the scene.
+ *  The model matrix and world space bounds are computed once
+ *  here instead of every frame, and a basic shape is loaded
+ *  the first time an object uses it.
  ***********************************************************/
-void SceneManager::RenderScene() {
+SceneManager::SCENE_OBJECT& SceneManager::AddSceneObject(
+    std::string tag,
+    MESH_TYPE mesh,
+    glm::vec3 scaleXYZ,
+    float XrotationDegrees,
+    float YrotationDegrees,
+    float ZrotationDegrees,
+    glm::vec3 positionXYZ) {
+    SCENE_OBJECT object;
+    object.tag = tag;
+    object.mesh = mesh;
+    object.modelMatrix = BuildTransformation(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
+    if ((mesh < MESH_STATIC_BATCH) && !m_bMeshLoaded[mesh]) {
+        LoadBasicMesh(mesh);
+    }
+
+    // transform the corners of the mesh bounds into world space
+    glm::vec3 localMin;
+    glm::vec3 localMax;
+    GetMeshBounds(mesh, localMin, localMax);
+    TransformBounds(object.modelMatrix, localMin, localMax, object.boundsMin, object.boundsMax);
+
+    m_sceneObjects.push_back(object);
+
+    return(m_sceneObjects.back());
+}
+
+/***********************************************************
+ *  DefineSceneObjects()
+ *
+ *  This method is used for placing the basic 3D shapes that
+ *  make up the scene.
+ ***********************************************************/
+void SceneManager::DefineSceneObjects() {
     glm::vec3 scaleXYZ;
     float XrotationDegrees = 0.0f;
     float YrotationDegrees = 0.0f;
     float ZrotationDegrees = 0.0f;
     glm::vec3 positionXYZ;
 
-    // Set lighting
-    SetLighting();
-
-    // Render plane
+    // Plane
     scaleXYZ = glm::vec3(20.0f, 1.0f, 10.0f);
     positionXYZ = glm::vec3(0.0f, 0.0f, 0.0f);
-    SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-    SetShaderTexture("planet");
-    m_basicMeshes->DrawPlaneMesh();
+    SCENE_OBJECT& plane = AddSceneObject("plane", MESH_PLANE, scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
+    plane.textureTag = "planet";
+    // the plane only receives shadows
+    plane.bCastsShadow = false;
 
-    // Render upper saucer module
+    // Upper saucer module
     scaleXYZ = glm::vec3(4.0f, 0.2f, 4.0f);
     positionXYZ = glm::vec3(-3.0f, 4.0f, 0.0f);
-    SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-    SetShaderTexture("hull");
-    m_basicMeshes->DrawCylinderMesh();
+    AddSceneObject("upper saucer", MESH_CYLINDER, scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ).textureTag = "hull";
 
-    // Render lower saucer module
+    // Lower saucer module
     scaleXYZ = glm::vec3(4.0f, 0.2f, 4.0f);
     positionXYZ = glm::vec3(-3.0f, 4.0f, 0.0f);
-    SetTransformations(scaleXYZ, 180.0f, YrotationDegrees, ZrotationDegrees, positionXYZ);
-    SetShaderTexture("hull");
-    m_basicMeshes->DrawTaperedCylinderMesh();
+    AddSceneObject("lower saucer", MESH_TAPERED_CYLINDER, scaleXYZ, 180.0f, YrotationDegrees, ZrotationDegrees, positionXYZ).textureTag = "hull";
 
-    // Render bridge & phaser array
+    // Bridge & phaser array
     scaleXYZ = glm::vec3(0.5f, 1.0f, 1.0f);
     positionXYZ = glm::vec3(-3.0f, 4.1f, 0.0f);
-    SetTransformations(scaleXYZ, 90.0f, 90.0f, ZrotationDegrees, positionXYZ);
-    SetShaderTexture("dome");
-    m_basicMeshes->DrawSphereMesh();
+    AddSceneObject("bridge", MESH_SPHERE, scaleXYZ, 90.0f, 90.0f, ZrotationDegrees, positionXYZ).textureTag = "dome";
 
-    // Render neck
+    // Neck
     scaleXYZ = glm::vec3(1.25f, 1.5f, 0.5f);
     positionXYZ = glm::vec3(0.0f, 3.25f, 0.0f);
-    SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, 15.0f, positionXYZ);
-    SetShaderTexture("hull");
-    m_basicMeshes->DrawBoxMesh();
+    AddSceneObject("neck", MESH_BOX, scaleXYZ, XrotationDegrees, YrotationDegrees, 15.0f, positionXYZ).textureTag = "hull";
 
-    // Render deflector cone at front of main hull
+    // Deflector cone at front of main hull
     scaleXYZ = glm::vec3(0.75f, 0.5f, 0.75f);
     positionXYZ = glm::vec3(-0.59f, 2.0f, 0.0f);
-    SetTransformations(scaleXYZ, 90.0f, YrotationDegrees, 90.0f, positionXYZ);
-    SetShaderTexture("hull");
-    m_basicMeshes->DrawTaperedCylinderMesh();
+    AddSceneObject("deflector cone", MESH_TAPERED_CYLINDER, scaleXYZ, 90.0f, YrotationDegrees, 90.0f, positionXYZ).textureTag = "hull";
 
-    // Render main hull
+    // Main hull
     scaleXYZ = glm::vec3(0.74f, 4.5f, 0.74f);
     positionXYZ = glm::vec3(3.9f, 2.0f, 0.0f);
-    SetTransformations(scaleXYZ, 90.0f, YrotationDegrees, 90.0f, positionXYZ);
-    SetShaderTexture("hull");
-    m_basicMeshes->DrawCylinderMesh();
+    AddSceneObject("main hull", MESH_CYLINDER, scaleXYZ, 90.0f, YrotationDegrees, 90.0f, positionXYZ).textureTag = "hull";
 
-    // Render shuttlebay
+    // Shuttlebay
     scaleXYZ = glm::vec3(0.74f, 0.74f, 0.74f);
     positionXYZ = glm::vec3(3.9f, 2.0f, 0.0f);
-    SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-    SetShaderTexture("shuttlebay");
-    m_basicMeshes->DrawHalfSphereMesh();
+    AddSceneObject("shuttlebay", MESH_HALF_SPHERE, scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ).textureTag = "shuttlebay";
 
-    // Render shuttlebay floor
+    // Shuttlebay floor
     scaleXYZ = glm::vec3(0.01f, 0.74f, 0.74f);
     positionXYZ = glm::vec3(3.9f, 2.0f, 0.0f);
-    SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, 90.0f, positionXYZ);
-    SetShaderTexture("hall");
-    m_basicMeshes->DrawSphereMesh();
+    AddSceneObject("shuttlebay floor", MESH_SPHERE, scaleXYZ, XrotationDegrees, YrotationDegrees, 90.0f, positionXYZ).textureTag = "hull";
 
-    // Render deflector dish
+    // Deflector dish
     scaleXYZ = glm::vec3(0.35f, 0.35f, 0.35f);
     positionXYZ = glm::vec3(-1.1f, 2.0f, 0.0f);
-    SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, -90.0f, positionXYZ);
-    SetShaderColor(0.35f, 0.65f, 0.80f, 1.0f);
-    m_basicMeshes->DrawConeMesh();
+    AddSceneObject("deflector dish", MESH_CONE, scaleXYZ, XrotationDegrees, YrotationDegrees, -90.0f, positionXYZ).color = glm::vec4(0.35f, 0.65f, 0.80f, 1.0f);
 
-    // Render left pylon
+    // Left pylon
     scaleXYZ = glm::vec3(0.75f, 2.5f, 0.10f);
     positionXYZ = glm::vec3(3.5f, 3.4f, 1.0f);
-    SetTransformations(scaleXYZ, 40.0f, YrotationDegrees, -20.0f, positionXYZ);
-    SetShaderTexture("hull");
-    m_basicMeshes->DrawBoxMesh();
+    AddSceneObject("left pylon", MESH_BOX, scaleXYZ, 40.0f, YrotationDegrees, -20.0f, positionXYZ).textureTag = "hull";
 
-    // Render left nacelle
+    // Left nacelle
     scaleXYZ = glm::vec3(0.25f, 4.5f, 0.25f);
     positionXYZ = glm::vec3(6.5f, 4.25f, 1.75f);
-    SetTransformations(scaleXYZ, 90.0f, YrotationDegrees, 90.0f, positionXYZ);
-    SetShaderTexture("hull");
-    m_basicMeshes->DrawCylinderMesh();
+    AddSceneObject("left nacelle", MESH_CYLINDER, scaleXYZ, 90.0f, YrotationDegrees, 90.0f, positionXYZ).textureTag = "hull";
 
-    // Render left buzzard ram scoop
+    // Left buzzard ram scoop
     scaleXYZ = glm::vec3(0.25f, 0.25f, 0.25f);
     positionXYZ = glm::vec3(2.0f, 4.25f, 1.75f);
-    SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-    SetShaderColor(1.0f, 0.0f, 0.0f, 1.0f);
-    m_basicMeshes->DrawSphereMesh();
+    SCENE_OBJECT& leftRamScoop = AddSceneObject("left ram scoop", MESH_SPHERE, scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
+    leftRamScoop.color = glm::vec4(1.0f, 0.0f, 0.0f, 1.0f);
+    // the ram scoops glow, so the lights do not shade them
+    leftRamScoop.bLit = false;
 
-    // Render right pylon
+    // Right pylon
     scaleXYZ = glm::vec3(0.75f, 2.5f, 0.10f);
     positionXYZ = glm::vec3(3.5f, 3.4f, -1.0f);
-    SetTransformations(scaleXYZ, -40.0f, YrotationDegrees, -20.0f, positionXYZ);
-    SetShaderTexture("hull");
-    m_basicMeshes->DrawBoxMesh();
+    AddSceneObject("right pylon", MESH_BOX, scaleXYZ, -40.0f, YrotationDegrees, -20.0f, positionXYZ).textureTag = "hull";
 
-    // Render right nacelle
+    // Right nacelle
     scaleXYZ = glm::vec3(0.25f, 4.5f, 0.25f);
     positionXYZ = glm::vec3(6.5f, 4.25f, -1.75f);
-    SetTransformations(scaleXYZ, 90.0f, YrotationDegrees, 90.0f, positionXYZ);
-    SetShaderTexture("hull");
-    m_basicMeshes->DrawCylinderMesh();
+    AddSceneObject("right nacelle", MESH_CYLINDER, scaleXYZ, 90.0f, YrotationDegrees, 90.0f, positionXYZ).textureTag = "hull";
 
-    // Render right buzzard ram scoop
+    // Right buzzard ram scoop
     scaleXYZ = glm::vec3(0.25f, 0.25f, 0.25f);
     positionXYZ = glm::vec3(2.0f, 4.25f, -1.75f);
-    SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-    SetShaderColor(1.0f, 0.0f, 0.0f, 1.0f);
-    m_basicMeshes->DrawSphereMesh();
+    SCENE_OBJECT& rightRamScoop = AddSceneObject("right ram scoop", MESH_SPHERE, scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
+    rightRamScoop.color = glm::vec4(1.0f, 0.0f, 0.0f, 1.0f);
+    // the ram scoops glow, so the lights do not shade them
+    rightRamScoop.bLit = false;
+
+    // Translucent warp fields around the nacelles, which overlap each other
+    // and the hull from most views
+    scaleXYZ = glm::vec3(0.4f, 4.7f, 0.4f);
+    positionXYZ = glm::vec3(6.6f, 4.25f, 1.75f);
+    SCENE_OBJECT& leftWarpField = AddSceneObject("left warp field", MESH_CYLINDER, scaleXYZ, 90.0f, YrotationDegrees, 90.0f, positionXYZ);
+    leftWarpField.color = WARP_FIELD_COLOR;
+    leftWarpField.bLit = false;
+    leftWarpField.bCastsShadow = false;
+
+    positionXYZ = glm::vec3(6.6f, 4.25f, -1.75f);
+    SCENE_OBJECT& rightWarpField = AddSceneObject("right warp field", MESH_CYLINDER, scaleXYZ, 90.0f, YrotationDegrees, 90.0f, positionXYZ);
+    rightWarpField.color = WARP_FIELD_COLOR;
+    rightWarpField.bLit = false;
+    rightWarpField.bCastsShadow = false;
+}
+
+/***********************************************************
+ *  DefineSceneLights()
+ *
+ *  This method is used for placing the point lights that are
+ *  part of the ship: the nacelle glows, the ram scoops, the
+ *  deflector dish and the saucer running lights.
+ ***********************************************************/
+void SceneManager::DefineSceneLights() {
+    struct SHIP_LIGHT {
+        glm::vec3 position;
+        float radius;
+        glm::vec3 color;
+        float intensity;
+    };
+    const SHIP_LIGHT shipLights[] = {
+        // nacelle glows along the inner side of each nacelle
+        { glm::vec3(4.25f, 4.25f, 1.4f), 2.5f, glm::vec3(0.3f, 0.5f, 1.0f), 3.0f },
+        { glm::vec3(4.25f, 4.25f, -1.4f), 2.5f, glm::vec3(0.3f, 0.5f, 1.0f), 3.0f },
+        // buzzard ram scoops
+        { glm::vec3(1.6f, 4.25f, 1.75f), 1.5f, glm::vec3(1.0f, 0.1f, 0.05f), 3.0f },
+        { glm::vec3(1.6f, 4.25f, -1.75f), 1.5f, glm::vec3(1.0f, 0.1f, 0.05f), 3.0f },
+        // deflector dish
+        { glm::vec3(-1.6f, 2.0f, 0.0f), 2.0f, glm::vec3(0.35f, 0.65f, 0.8f), 3.0f },
+        // saucer running lights, red to port and green to starboard
+        { glm::vec3(-3.0f, 4.3f, 4.1f), 1.5f, glm::vec3(1.0f, 0.0f, 0.0f), 2.0f },
+        { glm::vec3(-3.0f, 4.3f, -4.1f), 1.5f, glm::vec3(0.0f, 1.0f, 0.0f), 2.0f },
+        { glm::vec3(-7.1f, 4.3f, 0.0f), 1.5f, glm::vec3(1.0f, 1.0f, 1.0f), 2.0f },
+        { glm::vec3(7.0f, 4.6f, 0.0f), 1.5f, glm::vec3(1.0f, 1.0f, 1.0f), 2.0f }
+    };
+
+    m_shipLights.clear();
+    for (size_t i = 0; i < sizeof(shipLights) / sizeof(shipLights[0]); i++) {
+        ClusteredLighting::POINT_LIGHT light;
+        light.positionRadius = glm::vec4(shipLights[i].position, shipLights[i].radius);
+        light.colorIntensity = glm::vec4(shipLights[i].color, shipLights[i].intensity);
+        m_shipLights.push_back(light);
+    }
+}
+
+/***********************************************************
+ *  DefineAnimationTracks()
+ *
+ *  This method is used for creating the keyframe tracks: the
+ *  ship orbits the middle of the plane while bobbing gently,
+ *  the deflector dish spins about its own axis and the
+ *  primary light pulses.  The ship parts are moved by the
+ *  orbit from where they were placed; the plane stays put.
+ ***********************************************************/
+void SceneManager::DefineAnimationTracks() {
+    m_animation.Clear();
+
+    // the rotation ends a full turn on, so the orbit loops without a jump
+    std::vector<AnimationSystem::TRANSFORM_KEY> orbitKeys;
+    for (int i = 0; i <= SHIP_ORBIT_KEYS; i++) {
+        float turn = (float)i / (float)SHIP_ORBIT_KEYS;
+        AnimationSystem::TRANSFORM_KEY key;
+        key.time = turn * SHIP_ORBIT_SECONDS;
+        key.scaleXYZ = glm::vec3(1.0f);
+        key.rotationDegrees = glm::vec3(0.0f, turn * 360.0f, 0.0f);
+        key.positionXYZ = glm::vec3(0.0f, SHIP_BOB_HEIGHT * sin(glm::radians(turn * 720.0f)), 0.0f);
+        orbitKeys.push_back(key);
+    }
+    m_shipTrack = m_animation.AddTransformTrack(orbitKeys);
+
+    // the dish cone points along its own Y axis before it is placed
+    std::vector<AnimationSystem::TRANSFORM_KEY> spinKeys = {
+        { 0.0f, glm::vec3(1.0f), glm::vec3(0.0f), glm::vec3(0.0f) },
+        { DISH_SPIN_SECONDS, glm::vec3(1.0f), glm::vec3(0.0f, 360.0f, 0.0f), glm::vec3(0.0f) }
+    };
+    m_dishTrack = m_animation.AddTransformTrack(spinKeys);
+
+    std::vector<AnimationSystem::COLOR_KEY> pulseKeys = {
+        { 0.0f, m_primaryLight.color },
+        { LIGHT_PULSE_SECONDS * 0.5f, glm::vec3(1.0f, 0.35f, 0.05f) },
+        { LIGHT_PULSE_SECONDS, m_primaryLight.color }
+    };
+    m_lightColorTrack = m_animation.AddColorTrack(pulseKeys);
+
+    for (size_t i = 0; i < m_sceneObjects.size(); i++) {
+        SCENE_OBJECT& object = m_sceneObjects[i];
+        if (object.tag == "plane") {
+            continue;
+        }
+
+        object.parentTrack = m_shipTrack;
+        if (object.tag == "deflector dish") {
+            object.localTrack = m_dishTrack;
+            // the spinning dish is drawn on its own instead of baked
+            object.bDynamic = true;
+        }
+    }
+}
+
+/***********************************************************
+ *  UpdateAnimation()
+ *
+ *  This method is used for stepping the animation by the
+ *  frame time and moving the objects and ship lights to the
+ *  interpolated pose.  A paused animation keeps its pose.
+ ***********************************************************/
+void SceneManager::UpdateAnimation() {
+    if (m_bAnimation && (NULL != m_pViewManager)) {
+        int steps = m_animation.Update(m_pViewManager->DeltaTime());
+
+        if (NULL != m_pFrameStats) {
+            m_pFrameStats->AddCount("animation us", m_animation.UpdateTime());
+            m_pFrameStats->AddCount("animation steps", steps);
+        }
+    }
+
+    // the entities that are not drawn are kept in step, so switching is seamless
+    AnimateObjects(m_objectEntities, &RenderEntities() == &m_objectEntities);
+    AnimateObjects(m_batchEntities, &RenderEntities() == &m_batchEntities);
+
+    if (m_lightColorTrack >= 0) {
+        m_primaryLight.color = m_animation.TrackColor(m_lightColorTrack);
+    }
+
+    // the ship lights come first and follow the ship
+    if ((NULL != m_pClusteredLighting) && (m_shipTrack >= 0)) {
+        const glm::mat4& shipMatrix = m_animation.TrackMatrix(m_shipTrack);
+        int shipLights = std::min(m_pClusteredLighting->LightCount(), (int)m_shipLights.size());
+        for (int i = 0; i < shipLights; i++) {
+            glm::vec3 position = glm::vec3(m_shipLights[i].positionRadius);
+            m_pClusteredLighting->SetLightPosition(i, m_homeOffset + glm::vec3(shipMatrix * glm::vec4(position, 1.0f)));
+        }
+    }
+
+    m_bOriginMoved = false;
+}
+
+/***********************************************************
+ *  AnimateObjects()
+ *
+ *  This method is used for placing the animated entities of
+ *  the passed in store at the current pose, around where the
+ *  world origin is rendered.  After the origin has moved the
+ *  entities without a track are placed again as well.
+ *  Entities that moved get new bounds, and when the store is
+ *  the one drawn the shadow faces around their old and new
+ *  bounds are marked for rendering again.  Moved object
+ *  entities mark the ray scene for building again.
+ ***********************************************************/
+void SceneManager::AnimateObjects(EntityStore& entities, bool bMarkShadows) {
+    glm::mat4* modelMatrices = entities.ModelMatrices();
+    const glm::mat4* restMatrices = entities.RestMatrices();
+    glm::vec3* boundsMin = entities.BoundsMin();
+    glm::vec3* boundsMax = entities.BoundsMax();
+    const glm::vec3* restBoundsMin = entities.RestBoundsMin();
+    const glm::vec3* restBoundsMax = entities.RestBoundsMax();
+    const int* parentTracks = entities.ParentTracks();
+    const int* localTracks = entities.LocalTracks();
+    const int* meshIds = entities.MeshIds();
+    const unsigned int* flags = entities.Flags();
+
+    glm::mat4 home = glm::translate(m_homeOffset);
+    // the ray scene places the objects from the object entities
+    bool bRayObjects = (&entities == &m_objectEntities);
+
+    int count = entities.Count();
+    for (int i = 0; i < count; i++) {
+        // the chunks are placed by the world streaming
+        if (meshIds[i] == MESH_CHUNK) {
+            continue;
+        }
+        if ((parentTracks[i] < 0) && (localTracks[i] < 0) && !m_bOriginMoved) {
+            continue;
+        }
+
+        glm::mat4 model = restMatrices[i];
+        if (localTracks[i] >= 0) {
+            model = model * m_animation.TrackMatrix(localTracks[i]);
+        }
+        glm::mat4 parent = home;
+        if (parentTracks[i] >= 0) {
+            parent = parent * m_animation.TrackMatrix(parentTracks[i]);
+        }
+        model = parent * model;
+        if (model == modelMatrices[i]) {
+            continue;
+        }
+
+        glm::vec3 oldMin = boundsMin[i];
+        glm::vec3 oldMax = boundsMax[i];
+        modelMatrices[i] = model;
+        if (bRayObjects) {
+            m_bRaySceneDirty = true;
+        }
+        if (localTracks[i] >= 0) {
+            // the spin changes the shape of the bounds, so start from the mesh
+            glm::vec3 localMin;
+            glm::vec3 localMax;
+            GetMeshBounds((MESH_TYPE)meshIds[i], localMin, localMax);
+            TransformBounds(model, localMin, localMax, boundsMin[i], boundsMax[i]);
+        }
+        else {
+            TransformBounds(parent, restBoundsMin[i], restBoundsMax[i], boundsMin[i], boundsMax[i]);
+        }
+
+        if (bMarkShadows && (flags[i] & EntityStore::FLAG_CASTS_SHADOW) && (NULL != m_pShadowMap)) {
+            m_pShadowMap->MarkDirtyBox(oldMin, oldMax);
+            m_pShadowMap->MarkDirtyBox(boundsMin[i], boundsMax[i]);
+        }
+
+        // the scene bounds only grow, so the shadow range settles after an
+        // orbit; they are kept around the world origin like the lights
+        m_sceneBoundsMin = glm::min(m_sceneBoundsMin, boundsMin[i] - m_homeOffset);
+        m_sceneBoundsMax = glm::max(m_sceneBoundsMax, boundsMax[i] - m_homeOffset);
+    }
+}
+
+/***********************************************************
+ *  UpdateWorldOrigin()
+ *
+ *  This method is used for moving the world origin to the
+ *  camera once the camera gets far from it, so that what is
+ *  drawn around the camera keeps the full float precision.
+ *  The world position of the origin is kept in double, and
+ *  the camera, the depth pyramid, the lights and the chunks
+ *  are moved back by the same whole step.
+ ***********************************************************/
+void SceneManager::UpdateWorldOrigin() {
+    if (NULL == m_pViewManager) {
+        return;
+    }
+
+    glm::vec3 camera = m_pViewManager->GetCameraPosition();
+    if ((fabs(camera.x) < ORIGIN_REBASE_DISTANCE) && (fabs(camera.z) < ORIGIN_REBASE_DISTANCE)) {
+        return;
+    }
+
+    glm::vec3 shift(
+        floor(camera.x / ORIGIN_REBASE_STEP) * ORIGIN_REBASE_STEP, 0.0f,
+        floor(camera.z / ORIGIN_REBASE_STEP) * ORIGIN_REBASE_STEP);
+    m_worldOrigin += glm::dvec3(shift);
+    m_homeOffset = glm::vec3(-m_worldOrigin);
+
+    m_pViewManager->ShiftOrigin(-shift);
+    if (NULL != m_pHiZBuffer) {
+        m_pHiZBuffer->ShiftOrigin(-shift);
+    }
+    if (NULL != m_pClusteredLighting) {
+        for (int i = 0; i < m_pClusteredLighting->LightCount(); i++) {
+            m_pClusteredLighting->SetLightPosition(i, m_pClusteredLighting->LightPosition(i) - shift);
+        }
+    }
+
+    // the chunks are placed again from their double precision corners
+    if (NULL != m_pWorldStreamer) {
+        for (size_t slot = 0; slot < m_chunkObjectEntities.size(); slot++) {
+            int objectIndex = m_objectEntities.IndexOf(m_chunkObjectEntities[slot]);
+            if (objectIndex >= 0) {
+                WriteChunkEntity(m_objectEntities, objectIndex, (int)slot);
+            }
+            int batchIndex = m_batchEntities.IndexOf(m_chunkBatchEntities[slot]);
+            if (batchIndex >= 0) {
+                WriteChunkEntity(m_batchEntities, batchIndex, (int)slot);
+            }
+        }
+    }
+
+    // the scene objects are placed again by the animation update, and the
+    // ray scene is built again around the new origin
+    m_bOriginMoved = true;
+    m_bRaySceneDirty = true;
+
+    std::cout << "INFO: World origin moved to " << m_worldOrigin.x << ", " << m_worldOrigin.z << std::endl;
+}
+
+/***********************************************************
+ *  UpdateWorldStreaming()
+ *
+ *  This method is used for streaming the fleet chunks around
+ *  the camera and keeping their entities in step with the
+ *  resident chunks.
+ ***********************************************************/
+void SceneManager::UpdateWorldStreaming() {
+    if ((!m_bWorldStreaming) || (NULL == m_pWorldStreamer) || (NULL == m_pViewManager)) {
+        return;
+    }
+
+    glm::dvec3 camera = m_worldOrigin + glm::dvec3(m_pViewManager->GetCameraPosition());
+    m_pWorldStreamer->Update(camera, m_vertexLayout);
+
+    // unloaded slots may be given to chunks loaded in the same update
+    const std::vector<int>& unloadedSlots = m_pWorldStreamer->UnloadedSlots();
+    for (size_t i = 0; i < unloadedSlots.size(); i++) {
+        RemoveChunkEntities(unloadedSlots[i]);
+    }
+    const std::vector<int>& loadedSlots = m_pWorldStreamer->LoadedSlots();
+    for (size_t i = 0; i < loadedSlots.size(); i++) {
+        AddChunkEntities(loadedSlots[i]);
+    }
+}
+
+/***********************************************************
+ *  AddChunkEntities()
+ *
+ *  This method is used for adding the entity of a resident
+ *  chunk to both entity stores.
+ ***********************************************************/
+void SceneManager::AddChunkEntities(int slot) {
+    if ((int)m_chunkObjectEntities.size() <= slot) {
+        m_chunkObjectEntities.resize(slot + 1);
+        m_chunkBatchEntities.resize(slot + 1);
+    }
+
+    m_chunkObjectEntities[slot] = m_objectEntities.Create();
+    WriteChunkEntity(m_objectEntities, m_objectEntities.IndexOf(m_chunkObjectEntities[slot]), slot);
+    m_chunkBatchEntities[slot] = m_batchEntities.Create();
+    WriteChunkEntity(m_batchEntities, m_batchEntities.IndexOf(m_chunkBatchEntities[slot]), slot);
+}
+
+/***********************************************************
+ *  RemoveChunkEntities()
+ *
+ *  This method is used for removing the entity of an
+ *  unloaded chunk from both entity stores.
+ ***********************************************************/
+void SceneManager::RemoveChunkEntities(int slot) {
+    if ((int)m_chunkObjectEntities.size() <= slot) {
+        return;
+    }
+
+    m_objectEntities.Remove(m_chunkObjectEntities[slot]);
+    m_batchEntities.Remove(m_chunkBatchEntities[slot]);
+}
+
+/***********************************************************
+ *  WriteChunkEntity()
+ *
+ *  This method is used for placing the entity of a resident
+ *  chunk.  The chunk corner is taken relative to the world
+ *  origin in double before it becomes a float translation.
+ *  The ships are lit but cast no shadows, since the shadow
+ *  map only covers the scene around the world origin.
+ ***********************************************************/
+void SceneManager::WriteChunkEntity(EntityStore& entities, int index, int slot) {
+    glm::vec3 offset = glm::vec3(m_pWorldStreamer->ChunkOrigin(slot) - m_worldOrigin);
+    glm::vec3 localMin;
+    glm::vec3 localMax;
+    m_pWorldStreamer->GetChunkBounds(slot, localMin, localMax);
+
+    glm::mat4 model = glm::translate(offset) * m_pWorldStreamer->ChunkBuffer(slot)->DecodeMatrix();
+    entities.ModelMatrices()[index] = model;
+    entities.RestMatrices()[index] = model;
+    entities.BoundsMin()[index] = localMin + offset;
+    entities.BoundsMax()[index] = localMax + offset;
+    entities.RestBoundsMin()[index] = localMin + offset;
+    entities.RestBoundsMax()[index] = localMax + offset;
+
+    entities.MeshIds()[index] = MESH_CHUNK;
+    entities.MeshResources()[index] = slot;
+    entities.MaterialIds()[index] = FindDrawMaterial("", FLEET_HULL_COLOR);
+    entities.Flags()[index] = EntityStore::FLAG_DYNAMIC | EntityStore::FLAG_LIT;
+    entities.ParentTracks()[index] = -1;
+    entities.LocalTracks()[index] = -1;
+}
+
+/***********************************************************
+ *  BuildImpostors()
+ *
+ *  This method is used for capturing every ship class of the
+ *  streamed world into the impostor atlas.  The views are
+ *  drawn with the scene program and the fleet color, lit
+ *  from above the capture camera so that every view is lit
+ *  the same way.
+ ***********************************************************/
+void SceneManager::BuildImpostors() {
+    if ((NULL == m_pWorldStreamer) || (NULL == m_pShaderManager)) {
+        return;
+    }
+
+    // each class is one group, bounded by a sphere around its origin
+    std::vector<float> radii;
+    std::vector<MeshBuffer*> shapes;
+    for (int shipClass = 0; shipClass < m_pWorldStreamer->ShipClassCount(); shipClass++) {
+        const PrimitiveGeometry& shape = m_pWorldStreamer->ShipShape(shipClass);
+        glm::vec3 localMin;
+        glm::vec3 localMax;
+        shape.GetBounds(localMin, localMax);
+        radii.push_back(glm::length(glm::max(glm::abs(localMin), glm::abs(localMax))));
+
+        MeshBuffer* pBuffer = new MeshBuffer();
+        pBuffer->Upload(shape, MeshBuffer::LAYOUT_FLOAT, "impostor capture");
+        shapes.push_back(pBuffer);
+    }
+
+    m_pImpostorAtlas = new ImpostorAtlas();
+    if (!m_pImpostorAtlas->Initialize(radii, IMPOSTOR_TILE_RESOLUTION)) {
+        std::cout << "Error: Impostors disabled" << std::endl;
+        delete m_pImpostorAtlas;
+        m_pImpostorAtlas = nullptr;
+    }
+    else {
+        double startTime = glfwGetTime();
+
+        m_pShaderManager->m_programID = m_uberProgram;
+        m_pShaderManager->use();
+        m_pShaderManager->setIntValue("bUseShadows", false);
+        m_pShaderManager->setIntValue("bUseClusteredLights", false);
+        m_pShaderManager->setIntValue("bCompactVertex", false);
+        m_pShaderManager->setMat4Value("model", glm::mat4(1.0f));
+        SetShaderColor(FLEET_HULL_COLOR.r, FLEET_HULL_COLOR.g, FLEET_HULL_COLOR.b, FLEET_HULL_COLOR.a);
+        m_pShaderManager->setVec3Value("primaryLight.color", m_primaryLight.color);
+        m_pShaderManager->setFloatValue("primaryLight.intensity", m_primaryLight.intensity);
+        m_pShaderManager->setVec3Value("ambientLight.color", m_ambientLight.color);
+        m_pShaderManager->setFloatValue("ambientLight.intensity", m_ambientLight.intensity);
+
+        for (int group = 0; group < (int)shapes.size(); group++) {
+            for (int view = 0; view < ImpostorAtlas::VIEW_COUNT; view++) {
+                glm::mat4 viewMatrix;
+                glm::mat4 projection;
+                glm::vec3 eye;
+                m_pImpostorAtlas->BeginView(group, view, viewMatrix, projection, eye);
+
+                m_pShaderManager->setMat4Value("view", viewMatrix);
+                m_pShaderManager->setMat4Value("projection", projection);
+                m_pShaderManager->setVec3Value("viewPosition", eye);
+                m_pShaderManager->setVec3Value("primaryLight.position", eye * 2.0f + glm::vec3(0.0f, 4.0f * radii[group], 0.0f));
+                shapes[group]->Draw();
+            }
+        }
+        m_pImpostorAtlas->EndCapture();
+
+        std::cout << "INFO: Captured " << shapes.size() * ImpostorAtlas::VIEW_COUNT << " impostor views of "
+            << shapes.size() << " ship classes in " << (glfwGetTime() - startTime) * 1000.0 << " ms" << std::endl;
+    }
+
+    for (size_t i = 0; i < shapes.size(); i++) {
+        delete shapes[i];
+    }
+}
+
+/***********************************************************
+ *  RenderImpostors()
+ *
+ *  This method is used for drawing the ships of the distant
+ *  chunks as camera-facing quads, one instanced draw per
+ *  chunk.  The quads write depth like any opaque object.
+ ***********************************************************/
+void SceneManager::RenderImpostors() {
+    if (m_impostorDraws.empty()) {
+        return;
+    }
+
+    const EntityStore& entities = RenderEntities();
+    if (NULL != m_pFrameStats) {
+        m_pFrameStats->BeginGpuTimer("impostor pass");
+    }
+
+    int ships = 0;
+    m_pImpostorAtlas->BeginDraw(m_pViewManager->GetViewMatrix(), m_pViewManager->GetProjectionMatrix(),
+        m_pViewManager->GetCameraPosition());
+    for (size_t i = 0; i < m_impostorDraws.size(); i++) {
+        int slot = entities.MeshResources()[m_impostorDraws[i]];
+        glm::vec3 offset = glm::vec3(m_pWorldStreamer->ChunkOrigin(slot) - m_worldOrigin);
+        m_pImpostorAtlas->Draw(m_pWorldStreamer->ChunkImpostors(slot), glm::translate(offset));
+        ships += m_pWorldStreamer->ChunkImpostors(slot).count;
+    }
+    m_pImpostorAtlas->EndDraw();
+
+    if (NULL != m_pFrameStats) {
+        m_pFrameStats->EndGpuTimer();
+        m_pFrameStats->AddCount("impostor chunks", (double)m_impostorDraws.size());
+        m_pFrameStats->AddCount("impostor ships", ships);
+    }
+
+    m_pShaderManager->use();
+}
+
+/***********************************************************
+ *  BakeStaticObjects()
+ *
+ *  This method is used for merging the static objects into
+ *  one pre-transformed vertex and index buffer per material.
+ *  Objects share a batch when they are shaded the same way,
+ *  agree on casting shadows and follow the same animation
+ *  track.  The batches are baked from where the objects were
+ *  placed and moved as a whole.  Dynamic objects are copied
+ *  through unchanged so they keep their own draw.  Both
+ *  entity stores are filled from the result.
+ ***********************************************************/
+void SceneManager::BakeStaticObjects() {
+    for (size_t i = 0; i < m_staticBatches.size(); i++) {
+        delete m_staticBatches[i];
+    }
+    m_staticBatches.clear();
+    std::vector<SCENE_OBJECT> batchedObjects;
+
+    // each shape only has to be built once no matter how often it is merged
+    PrimitiveGeometry shapes[MESH_STATIC_BATCH];
+    bool bShapeBuilt[MESH_STATIC_BATCH] = { false };
+
+    std::vector<PrimitiveGeometry> batchGeometry;
+    std::vector<int> batchObjects;
+    int bakedObjects = 0;
+
+    for (size_t i = 0; i < m_sceneObjects.size(); i++) {
+        const SCENE_OBJECT& object = m_sceneObjects[i];
+        // imported models are large enough to be drawn on their own
+        if (object.bDynamic || (object.mesh >= MESH_STATIC_BATCH)) {
+            batchedObjects.push_back(object);
+            continue;
+        }
+
+        // find the batch with the same shading, or start a new one
+        int batch = -1;
+        for (size_t b = 0; b < batchObjects.size(); b++) {
+            const SCENE_OBJECT& batchObject = batchedObjects[batchObjects[b]];
+            if ((batchObject.textureTag == object.textureTag) &&
+                (!object.textureTag.empty() || (batchObject.color == object.color)) &&
+                (batchObject.bCastsShadow == object.bCastsShadow) &&
+                (batchObject.bLit == object.bLit) &&
+                (batchObject.parentTrack == object.parentTrack)) {
+                batch = (int)b;
+                break;
+            }
+        }
+        if (batch < 0) {
+            SCENE_OBJECT batchObject;
+            batchObject.tag = "static batch: " + (object.textureTag.empty() ? std::string("color") : object.textureTag);
+            batchObject.mesh = MESH_STATIC_BATCH;
+            batchObject.textureTag = object.textureTag;
+            batchObject.color = object.color;
+            batchObject.bCastsShadow = object.bCastsShadow;
+            batchObject.bLit = object.bLit;
+            batchObject.parentTrack = object.parentTrack;
+            batchObject.batch = (int)batchObjects.size();
+
+            batch = (int)batchObjects.size();
+            batchObjects.push_back((int)batchedObjects.size());
+            batchedObjects.push_back(batchObject);
+            batchGeometry.push_back(PrimitiveGeometry());
+        }
+
+        if (!bShapeBuilt[object.mesh]) {
+            BuildMeshGeometry(object.mesh, shapes[object.mesh]);
+            bShapeBuilt[object.mesh] = true;
+        }
+        batchGeometry[batch].Append(shapes[object.mesh], object.modelMatrix);
+        bakedObjects++;
+    }
+
+    // reorder for the vertex cache, upload the merged buffers in the chosen
+    // layout and take the batch bounds from the vertices
+    int bakedVertices = 0;
+    int bakedTriangles = 0;
+    float missesBefore = 0.0f;
+    float missesAfter = 0.0f;
+    size_t bufferBytes = 0;
+    for (size_t b = 0; b < batchObjects.size(); b++) {
+        int triangles = (int)batchGeometry[b].Indices().size() / 3;
+        missesBefore += batchGeometry[b].CacheMissRatio(VERTEX_CACHE_SIZE) * triangles;
+        batchGeometry[b].OptimizeVertexCache();
+        missesAfter += batchGeometry[b].CacheMissRatio(VERTEX_CACHE_SIZE) * triangles;
+
+        MeshBuffer* pBuffer = new MeshBuffer();
+        pBuffer->Upload(batchGeometry[b], m_vertexLayout, "static batch");
+        m_staticBatches.push_back(pBuffer);
+        bakedVertices += pBuffer->VertexCount();
+        bakedTriangles += triangles;
+        bufferBytes += pBuffer->BufferBytes();
+
+        SCENE_OBJECT& batchObject = batchedObjects[batchObjects[b]];
+        batchGeometry[b].GetBounds(batchObject.boundsMin, batchObject.boundsMax);
+        // compact positions are expanded by the decode matrix
+        batchObject.modelMatrix = pBuffer->DecodeMatrix();
+    }
+
+    SyncObjectEntities();
+    m_batchEntities.Clear();
+    for (size_t i = 0; i < batchedObjects.size(); i++) {
+        m_batchEntities.Create();
+        WriteEntity(m_batchEntities, (int)i, batchedObjects[i]);
+    }
+    for (size_t slot = 0; slot < m_chunkBatchEntities.size(); slot++) {
+        if (m_pWorldStreamer->IsResident((int)slot)) {
+            m_chunkBatchEntities[slot] = m_batchEntities.Create();
+            WriteChunkEntity(m_batchEntities, m_batchEntities.IndexOf(m_chunkBatchEntities[slot]), (int)slot);
+        }
+    }
+
+    // put the entities where the animation has moved their objects
+    AnimateObjects(m_objectEntities, false);
+    AnimateObjects(m_batchEntities, false);
+
+    std::cout << "INFO: Baked " << bakedObjects << " static objects into "
+        << m_staticBatches.size() << " batches (" << bakedVertices << " vertices, "
+        << bufferBytes / 1024 << " KB " << ((m_vertexLayout == MeshBuffer::LAYOUT_COMPACT) ? "compact" : "float")
+        << " buffers)" << std::endl;
+    if (bakedTriangles > 0) {
+        std::cout << "INFO: Vertex cache misses per triangle " << missesBefore / bakedTriangles
+            << " -> " << missesAfter / bakedTriangles << std::endl;
+    }
+}
+
+/***********************************************************
+ *  SyncObjectEntities()
+ *
+ *  This method is used for copying every scene object into
+ *  its own entity, creating the entities of new objects.
+ *  Existing entities keep their handles, and the ray scene
+ *  is built again from them.
+ ***********************************************************/
+void SceneManager::SyncObjectEntities() {
+    m_bRaySceneDirty = true;
+    for (size_t i = 0; i < m_sceneObjects.size(); i++) {
+        SCENE_OBJECT& object = m_sceneObjects[i];
+        int index = m_objectEntities.IndexOf(object.entity);
+        if (index < 0) {
+            object.entity = m_objectEntities.Create();
+            index = m_objectEntities.IndexOf(object.entity);
+        }
+        WriteEntity(m_objectEntities, index, object);
+    }
+}
+
+/***********************************************************
+ *  WriteEntity()
+ *
+ *  This method is used for copying the passed in object into
+ *  the components of an entity.  The placement becomes the
+ *  rest pose the animation starts from, and the entity is
+ *  drawn where the world origin is rendered.  The texture
+ *  and color are looked up once here instead of at every
+ *  draw.
+ ***********************************************************/
+void SceneManager::WriteEntity(EntityStore& entities, int index, const SCENE_OBJECT& object) {
+    entities.ModelMatrices()[index] = glm::translate(m_homeOffset) * object.modelMatrix;
+    entities.RestMatrices()[index] = object.modelMatrix;
+    entities.BoundsMin()[index] = object.boundsMin + m_homeOffset;
+    entities.BoundsMax()[index] = object.boundsMax + m_homeOffset;
+    entities.RestBoundsMin()[index] = object.boundsMin;
+    entities.RestBoundsMax()[index] = object.boundsMax;
+
+    entities.MeshIds()[index] = object.mesh;
+    if (object.mesh == MESH_STATIC_BATCH) {
+        entities.MeshResources()[index] = object.batch;
+    }
+    else if (object.mesh == MESH_MODEL) {
+        entities.MeshResources()[index] = object.model;
+    }
+    else {
+        entities.MeshResources()[index] = -1;
+    }
+    entities.MaterialIds()[index] = FindDrawMaterial(object.textureTag, object.color);
+
+    unsigned int flags = 0;
+    if (object.bCastsShadow) {
+        flags |= EntityStore::FLAG_CASTS_SHADOW;
+    }
+    if (object.bDynamic) {
+        flags |= EntityStore::FLAG_DYNAMIC;
+    }
+    if (object.bLit) {
+        flags |= EntityStore::FLAG_LIT;
+    }
+    if (object.textureTag.empty() && (object.color.a < 1.0f)) {
+        flags |= EntityStore::FLAG_TRANSLUCENT;
+    }
+    entities.Flags()[index] = flags;
+
+    entities.ParentTracks()[index] = object.parentTrack;
+    entities.LocalTracks()[index] = object.localTrack;
+}
+
+/***********************************************************
+ *  FindDrawMaterial()
+ *
+ *  This method returns the index of the material for the
+ *  passed in texture, or for the color when there is no
+ *  texture, adding it the first time it is used.
+ ***********************************************************/
+int SceneManager::FindDrawMaterial(const std::string& textureTag, const glm::vec4& color) {
+    for (size_t i = 0; i < m_drawMaterials.size(); i++) {
+        const DRAW_MATERIAL& material = m_drawMaterials[i];
+        if ((material.textureTag == textureTag) && (!textureTag.empty() || (material.color == color))) {
+            return (int)i;
+        }
+    }
+
+    DRAW_MATERIAL material;
+    material.textureTag = textureTag;
+    material.color = color;
+    if (!textureTag.empty()) {
+        material.textureSlot = FindTextureSlot(textureTag);
+    }
+    m_drawMaterials.push_back(material);
+
+    return (int)m_drawMaterials.size() - 1;
+}
+
+/***********************************************************
+ *  SetCompactVertices()
+ *
+ *  This method is used to choose between the float and the
+ *  compact vertex layout for the static batches, which are
+ *  baked again in the new layout.
+ ***********************************************************/
+void SceneManager::SetCompactVertices(bool bEnable) {
+    ResourceTracker::SCOPE scope(g_ResourceScope);
+
+    m_vertexLayout = bEnable ? MeshBuffer::LAYOUT_COMPACT : MeshBuffer::LAYOUT_FLOAT;
+    std::cout << "INFO: Compact vertices " << (bEnable ? "enabled" : "disabled") << std::endl;
+    BakeStaticObjects();
+}
+
+/***********************************************************
+ *  RunVertexBenchmark()
+ *
+ *  This method is used for comparing the two vertex layouts.
+ *  The static batches are baked in each layout and drawn many
+ *  times with rasterization discarded, so the GPU time is the
+ *  vertex fetch and transform cost alone.  The query result
+ *  is waited on, which is only acceptable in a benchmark.
+ ***********************************************************/
+void SceneManager::RunVertexBenchmark() {
+    if ((NULL == m_pDepthShader) || (NULL == m_pViewManager)) {
+        return;
+    }
+
+    ResourceTracker::SCOPE scope(g_ResourceScope);
+    const MeshBuffer::VERTEX_LAYOUT layouts[2] = { MeshBuffer::LAYOUT_FLOAT, MeshBuffer::LAYOUT_COMPACT };
+    const char* layoutNames[2] = { "float", "compact" };
+    MeshBuffer::VERTEX_LAYOUT savedLayout = m_vertexLayout;
+
+    GLuint query = 0;
+    glGenQueries(1, &query);
+    glEnable(GL_RASTERIZER_DISCARD);
+
+    for (int l = 0; l < 2; l++) {
+        m_vertexLayout = layouts[l];
+        BakeStaticObjects();
+
+        m_pDepthShader->use();
+        m_pDepthShader->setMat4Value("view", m_pViewManager->GetViewMatrix());
+        m_pDepthShader->setMat4Value("projection", m_pViewManager->GetProjectionMatrix());
+
+        size_t bufferBytes = 0;
+        double indices = 0.0;
+        for (size_t b = 0; b < m_staticBatches.size(); b++) {
+            bufferBytes += m_staticBatches[b]->BufferBytes();
+        }
+
+        glBeginQuery(GL_TIME_ELAPSED, query);
+        for (int repeat = 0; repeat < VERTEX_BENCHMARK_DRAWS; repeat++) {
+            for (int i = 0; i < m_batchEntities.Count(); i++) {
+                if (m_batchEntities.MeshIds()[i] == MESH_STATIC_BATCH) {
+                    m_pDepthShader->setMat4Value("model", m_batchEntities.ModelMatrices()[i]);
+                    DrawEntity(m_batchEntities, i);
+                    indices += m_staticBatches[m_batchEntities.MeshResources()[i]]->IndexCount();
+                }
+            }
+        }
+        glEndQuery(GL_TIME_ELAPSED);
+
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+        double milliseconds = elapsed * 1.0e-6;
+
+        std::cout << "VERTEX BENCHMARK: " << layoutNames[l] << " layout | buffers: "
+            << bufferBytes / 1024 << " KB | " << VERTEX_BENCHMARK_DRAWS << " passes: "
+            << milliseconds << " ms | " << indices / (milliseconds * 1000.0) << " M indices/s" << std::endl;
+    }
+
+    glDisable(GL_RASTERIZER_DISCARD);
+    glDeleteQueries(1, &query);
+
+    m_vertexLayout = savedLayout;
+    BakeStaticObjects();
+    m_pShaderManager->use();
+}
+
+/***********************************************************
+ *  RunAnimationBenchmark()
+ *
+ *  This method is used for timing the animation update over
+ *  many generated tracks, each with its own keys and loop
+ *  length, stepped once per update at the fixed rate.
+ ***********************************************************/
+void SceneManager::RunAnimationBenchmark() {
+    AnimationSystem animation;
+
+    std::mt19937 generator(ANIMATION_BENCHMARK_SEED);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::vector<AnimationSystem::TRANSFORM_KEY> keys(4);
+    for (int track = 0; track < ANIMATION_BENCHMARK_TRACKS; track++) {
+        float keyTime = 0.0f;
+        for (size_t k = 0; k < keys.size(); k++) {
+            keys[k].time = keyTime;
+            keys[k].scaleXYZ = glm::vec3(0.5f + unit(generator));
+            keys[k].rotationDegrees = glm::vec3(unit(generator), unit(generator), unit(generator)) * 360.0f;
+            keys[k].positionXYZ = glm::vec3(unit(generator), unit(generator), unit(generator)) * 20.0f;
+            keyTime += 0.5f + unit(generator);
+        }
+        animation.AddTransformTrack(keys);
+    }
+
+    double updateTime = 0.0;
+    int steps = 0;
+    for (int update = 0; update < ANIMATION_BENCHMARK_UPDATES; update++) {
+        steps += animation.Update(1.0 / 60.0);
+        updateTime += animation.UpdateTime();
+    }
+
+    std::cout << "ANIMATION BENCHMARK: " << ANIMATION_BENCHMARK_TRACKS << " tracks | "
+        << ANIMATION_BENCHMARK_UPDATES << " updates, " << steps << " steps | "
+        << updateTime / ANIMATION_BENCHMARK_UPDATES << " us per update | "
+        << updateTime * 1000.0 / ((double)ANIMATION_BENCHMARK_UPDATES * ANIMATION_BENCHMARK_TRACKS)
+        << " ns per track" << std::endl;
+}
+
+/***********************************************************
+ *  RunEntityBenchmark()
+ *
+ *  This method is used for timing the per-frame kernels over
+ *  a million generated entities: frustum culling, the depth
+ *  sort of the visible entities and moving them by the ship
+ *  orbit.  Half of the entities are then removed through
+ *  their handles and the culling is timed again, against the
+ *  same bounds read from a vector of scene objects.
+ ***********************************************************/
+void SceneManager::RunEntityBenchmark() {
+    if (NULL == m_pViewManager) {
+        return;
+    }
+
+    double startTime = glfwGetTime();
+
+    EntityStore entities;
+    entities.Reserve(ENTITY_BENCHMARK_COUNT);
+    std::vector<EntityStore::HANDLE> handles;
+    handles.reserve(ENTITY_BENCHMARK_COUNT);
+
+    std::mt19937 generator(ENTITY_BENCHMARK_SEED);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    for (int i = 0; i < ENTITY_BENCHMARK_COUNT; i++) {
+        handles.push_back(entities.Create());
+        glm::vec3 center = glm::vec3(unit(generator), unit(generator) * 0.1f, unit(generator)) * ENTITY_BENCHMARK_EXTENT;
+        glm::vec3 extent = glm::vec3(0.5f + 0.5f * unit(generator));
+        entities.RestMatrices()[i] = glm::translate(center);
+        entities.BoundsMin()[i] = center - extent;
+        entities.BoundsMax()[i] = center + extent;
+        entities.MeshIds()[i] = MESH_BOX;
+        entities.Flags()[i] = EntityStore::FLAG_CASTS_SHADOW | EntityStore::FLAG_LIT;
+        entities.ParentTracks()[i] = m_shipTrack;
+    }
+    double createTime = glfwGetTime() - startTime;
+
+    Frustum frustum;
+    frustum.Extract(m_pViewManager->GetProjectionMatrix() * m_pViewManager->GetViewMatrix());
+    const glm::mat4& view = m_pViewManager->GetViewMatrix();
+
+    // cull by streaming through the bounds arrays only
+    startTime = glfwGetTime();
+    std::vector<int> visible;
+    visible.reserve(ENTITY_BENCHMARK_COUNT);
+    const glm::vec3* boundsMin = entities.BoundsMin();
+    const glm::vec3* boundsMax = entities.BoundsMax();
+    for (int i = 0; i < entities.Count(); i++) {
+        if (frustum.IntersectsBox(boundsMin[i], boundsMax[i])) {
+            visible.push_back(i);
+        }
+    }
+    double cullTime = glfwGetTime() - startTime;
+
+    startTime = glfwGetTime();
+    std::vector<float> depths(entities.Count());
+    for (size_t i = 0; i < visible.size(); i++) {
+        glm::vec3 center = (boundsMin[visible[i]] + boundsMax[visible[i]]) * 0.5f;
+        depths[visible[i]] = -(view * glm::vec4(center, 1.0f)).z;
+    }
+    std::sort(visible.begin(), visible.end(),
+        [&depths](int a, int b) { return depths[a] < depths[b]; });
+    double sortTime = glfwGetTime() - startTime;
+
+    startTime = glfwGetTime();
+    glm::mat4 orbit = (m_shipTrack >= 0) ? m_animation.TrackMatrix(m_shipTrack) : glm::mat4(1.0f);
+    glm::mat4* modelMatrices = entities.ModelMatrices();
+    const glm::mat4* restMatrices = entities.RestMatrices();
+    for (int i = 0; i < entities.Count(); i++) {
+        modelMatrices[i] = orbit * restMatrices[i];
+    }
+    double matrixTime = glfwGetTime() - startTime;
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "ENTITY BENCHMARK: " << ENTITY_BENCHMARK_COUNT << " entities | create: "
+        << createTime * 1000.0 << " ms | cull: " << cullTime * 1000.0 << " ms ("
+        << visible.size() << " visible) | depth sort: " << sortTime * 1000.0 << " ms | matrices: "
+        << matrixTime * 1000.0 << " ms" << std::endl;
+
+    // removing every other entity moves the last ones into the holes
+    startTime = glfwGetTime();
+    for (size_t i = 0; i < handles.size(); i += 2) {
+        entities.Remove(handles[i]);
+    }
+    double removeTime = glfwGetTime() - startTime;
+    bool bHandlesValid = !entities.IsValid(handles[0]) && entities.IsValid(handles[1]) &&
+        (entities.IndexOf(handles[handles.size() - 1]) >= 0);
+
+    int remaining = entities.Count();
+    startTime = glfwGetTime();
+    int visibleCount = 0;
+    boundsMin = entities.BoundsMin();
+    boundsMax = entities.BoundsMax();
+    for (int i = 0; i < remaining; i++) {
+        if (frustum.IntersectsBox(boundsMin[i], boundsMax[i])) {
+            visibleCount++;
+        }
+    }
+    double packedCullTime = glfwGetTime() - startTime;
+
+    // the same test reading the bounds out of whole scene objects
+    std::vector<SCENE_OBJECT> objects(remaining);
+    for (int i = 0; i < remaining; i++) {
+        objects[i].boundsMin = boundsMin[i];
+        objects[i].boundsMax = boundsMax[i];
+    }
+    startTime = glfwGetTime();
+    int objectVisibleCount = 0;
+    for (int i = 0; i < remaining; i++) {
+        if (frustum.IntersectsBox(objects[i].boundsMin, objects[i].boundsMax)) {
+            objectVisibleCount++;
+        }
+    }
+    double objectCullTime = glfwGetTime() - startTime;
+
+    std::cout << "ENTITY BENCHMARK: removed half in " << removeTime * 1000.0 << " ms, handles "
+        << (bHandlesValid ? "valid" : "INVALID") << " | " << remaining << " entities cull: "
+        << packedCullTime * 1000.0 << " ms (" << visibleCount << " visible) | scene objects cull: "
+        << objectCullTime * 1000.0 << " ms (" << objectVisibleCount << " visible, "
+        << sizeof(SCENE_OBJECT) << " bytes each)" << std::endl;
+    std::cout << std::defaultfloat;
+}
+
+/***********************************************************
+ *  RunRayBenchmark()
+ *
+ *  This method is used for timing a ray cast through every
+ *  pixel of a grid over the view, one ray at a time, in
+ *  packets of 2x2 pixels, and in packets spread over worker
+ *  threads that share the same ray scene.
+ ***********************************************************/
+void SceneManager::RunRayBenchmark() {
+    std::shared_ptr<const RayQuery> pScene = GetRayScene();
+    if ((NULL == m_pViewManager) || !pScene) {
+        return;
+    }
+
+    // neighbouring pixels go into the same packet
+    int rayCount = RAY_BENCHMARK_RESOLUTION * RAY_BENCHMARK_RESOLUTION;
+    std::vector<RayQuery::RAY> rays(rayCount);
+    int ray = 0;
+    for (int y = 0; y < RAY_BENCHMARK_RESOLUTION; y += 2) {
+        for (int x = 0; x < RAY_BENCHMARK_RESOLUTION; x += 2) {
+            for (int pixel = 0; pixel < RayQuery::PACKET_SIZE; pixel++) {
+                float ndcX = ((x + (pixel & 1)) + 0.5f) / RAY_BENCHMARK_RESOLUTION * 2.0f - 1.0f;
+                float ndcY = ((y + (pixel >> 1)) + 0.5f) / RAY_BENCHMARK_RESOLUTION * 2.0f - 1.0f;
+                m_pViewManager->GetCameraRay(ndcX, ndcY, rays[ray].origin, rays[ray].direction);
+                ray++;
+            }
+        }
+    }
+    std::vector<RayQuery::HIT> hits(rayCount);
+
+    double startTime = glfwGetTime();
+    for (int i = 0; i < rayCount; i++) {
+        pScene->Intersect(rays[i], hits[i]);
+    }
+    double singleTime = glfwGetTime() - startTime;
+    int singleHits = 0;
+    for (int i = 0; i < rayCount; i++) {
+        singleHits += (hits[i].object >= 0) ? 1 : 0;
+    }
+
+    startTime = glfwGetTime();
+    pScene->IntersectRays(rays.data(), hits.data(), rayCount);
+    double packetTime = glfwGetTime() - startTime;
+    int packetHits = 0;
+    for (int i = 0; i < rayCount; i++) {
+        packetHits += (hits[i].object >= 0) ? 1 : 0;
+    }
+
+    // each worker traces its own run of whole packets
+    int threadCount = std::max(1, (int)std::thread::hardware_concurrency());
+    int packetsPerThread = (rayCount / RayQuery::PACKET_SIZE + threadCount - 1) / threadCount;
+    startTime = glfwGetTime();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threadCount; t++) {
+        int first = std::min(rayCount, t * packetsPerThread * RayQuery::PACKET_SIZE);
+        int count = std::min(rayCount - first, packetsPerThread * RayQuery::PACKET_SIZE);
+        workers.push_back(std::thread([pScene, &rays, &hits, first, count]() {
+            pScene->IntersectRays(rays.data() + first, hits.data() + first, count);
+        }));
+    }
+    for (size_t t = 0; t < workers.size(); t++) {
+        workers[t].join();
+    }
+    double threadedTime = glfwGetTime() - startTime;
+
+    std::cout << "RAY BENCHMARK: " << pScene->InstanceCount() << " objects | " << rayCount << " rays, "
+        << singleHits << " hits | single: " << rayCount / (singleTime * 1.0e6) << " M rays/s | packets: "
+        << rayCount / (packetTime * 1.0e6) << " M rays/s (" << packetHits << " hits) | packets on "
+        << threadCount << " threads: " << rayCount / (threadedTime * 1.0e6) << " M rays/s" << std::endl;
+}
+
+/***********************************************************
+ *  LoadBasicMesh()
+ *
+ *  This method is used for generating one basic shape the
+ *  first time it is used, along with the triangle hierarchy
+ *  the ray queries are answered from.  The half sphere is
+ *  drawn from the sphere mesh, so they are loaded together.
+ *  Each loaded shape mesh is checked against its CPU copy.
+ ***********************************************************/
+void SceneManager::LoadBasicMesh(MESH_TYPE mesh) {
+    double startTime = glfwGetTime();
+
+    // the shape mesh keeps its buffers and vertex array to itself, so names
+    // generated on either side of the load find them, to be accounted for
+    // and checked against the CPU copy
+    GLuint bufferMark = ResourceTracker::MarkBuffers();
+    GLuint vertexArrayMark = 0;
+    glGenVertexArrays(1, &vertexArrayMark);
+
+    switch (mesh) {
+    case MESH_PLANE:
+        m_basicMeshes->LoadPlaneMesh();
+        break;
+    case MESH_BOX:
+        m_basicMeshes->LoadBoxMesh();
+        break;
+    case MESH_CONE:
+        m_basicMeshes->LoadConeMesh();
+        break;
+    case MESH_CYLINDER:
+        m_basicMeshes->LoadCylinderMesh();
+        break;
+    case MESH_TAPERED_CYLINDER:
+        m_basicMeshes->LoadTaperedCylinderMesh();
+        break;
+    case MESH_SPHERE:
+    case MESH_HALF_SPHERE:
+        if (!m_bMeshLoaded[MESH_SPHERE] && !m_bMeshLoaded[MESH_HALF_SPHERE]) {
+            m_basicMeshes->LoadSphereMesh();
+        }
+        break;
+    case MESH_TORUS:
+        m_basicMeshes->LoadTorusMesh();
+        break;
+    default:
+        glDeleteBuffers(1, &bufferMark);
+        glDeleteVertexArrays(1, &vertexArrayMark);
+        return;
+    }
+    m_bMeshLoaded[mesh] = true;
+    ResourceTracker::AdoptBuffers(bufferMark, "shape meshes");
+
+    // the half sphere is drawn from part of the sphere mesh, which is
+    // checked whole; no vertex array is found when it was already loaded
+    GLuint vertexArray = FindNewVertexArray(vertexArrayMark);
+    if (vertexArray != 0) {
+        CheckShapeMesh((mesh == MESH_HALF_SPHERE) ? MESH_SPHERE : mesh, vertexArray);
+    }
+
+    PrimitiveGeometry geometry;
+    BuildMeshGeometry(mesh, geometry);
+    m_rayShapes[mesh] = RayQuery::BuildMesh(geometry);
+
+    if (NULL != m_pStartupTimer) {
+        m_pStartupTimer->AddPhaseTime("meshes", glfwGetTime() - startTime);
+    }
+}
+
+/***********************************************************
+ *  UpdateRayScene()
+ *
+ *  This method is used for placing the scene objects in a
+ *  new ray query where they are drawn this frame.  The mesh
+ *  hierarchies are shared, so only the small hierarchy over
+ *  the objects is built.  A query handed out earlier stays
+ *  as it was until its last user lets go of it.  The query
+ *  is only built again once an object has moved, the objects
+ *  have changed or the world origin has moved; otherwise the
+ *  previous one is kept.
+ ***********************************************************/
+void SceneManager::UpdateRayScene() {
+    // the entity stores grow and shrink with the streamed chunks
+    ResourceTracker::SetHostBytes("scene entities", m_objectEntities.HostBytes() + m_batchEntities.HostBytes());
+
+    if (!m_bRaySceneDirty) {
+        return;
+    }
+    double startTime = glfwGetTime();
+
+    std::shared_ptr<RayQuery> pScene = std::make_shared<RayQuery>();
+    for (size_t i = 0; i < m_sceneObjects.size(); i++) {
+        const SCENE_OBJECT& object = m_sceneObjects[i];
+        int index = m_objectEntities.IndexOf(object.entity);
+        if (index < 0) {
+            continue;
+        }
+
+        glm::mat4 model = m_objectEntities.ModelMatrices()[index];
+        if (object.mesh == MESH_MODEL) {
+            // the ray mesh keeps the imported positions, so the compact decode is undone
+            model = model * glm::inverse(m_modelMeshes[object.model]->DecodeMatrix());
+            pScene->AddInstance(m_rayModels[object.model], model, (int)i);
+        }
+        else if (object.mesh < MESH_STATIC_BATCH) {
+            pScene->AddInstance(m_rayShapes[object.mesh], model, (int)i);
+        }
+    }
+    pScene->Build();
+
+    {
+        std::lock_guard<std::mutex> lock(m_rayMutex);
+        m_pRayScene = pScene;
+    }
+    m_bRaySceneDirty = false;
+    ResourceTracker::SetHostBytes("ray scene", pScene->HostBytes());
+
+    if (NULL != m_pFrameStats) {
+        m_pFrameStats->AddCount("ray scene us", (glfwGetTime() - startTime) * 1.0e6);
+    }
+}
+
+/***********************************************************
+ *  GetRayScene()
+ *
+ *  This method returns the ray query over the scene objects
+ *  where they are drawn this frame.
+ ***********************************************************/
+std::shared_ptr<const RayQuery> SceneManager::GetRayScene() const {
+    std::lock_guard<std::mutex> lock(m_rayMutex);
+    return(m_pRayScene);
+}
+
+/***********************************************************
+ *  PickObject()
+ *
+ *  This method is used for casting the camera ray through a
+ *  point of the view and returning the nearest object hit.
+ ***********************************************************/
+bool SceneManager::PickObject(float ndcX, float ndcY, RayQuery::HIT& hit, std::string& tag) const {
+    std::shared_ptr<const RayQuery> pScene = GetRayScene();
+    if ((NULL == m_pViewManager) || !pScene) {
+        return false;
+    }
+
+    RayQuery::RAY ray;
+    m_pViewManager->GetCameraRay(ndcX, ndcY, ray.origin, ray.direction);
+    if (!pScene->Intersect(ray, hit)) {
+        return false;
+    }
+
+    tag = m_sceneObjects[hit.object].tag;
+    return true;
+}
+
+/***********************************************************
+ *  RenderEntities()
+ *
+ *  This method returns the entities submitted this frame,
+ *  either the baked batches or every object on its own.
+ ***********************************************************/
+const EntityStore& SceneManager::RenderEntities() const {
+    if (m_bStaticBatching && !m_staticBatches.empty()) {
+        return(m_batchEntities);
+    }
+
+    return(m_objectEntities);
+}
+
+/***********************************************************
+ *  ObjectMeshBuffer()
+ *
+ *  This method returns the buffer a batch or model mesh is
+ *  drawn from, or null for the basic shape meshes.
+ ***********************************************************/
+const MeshBuffer* SceneManager::ObjectMeshBuffer(int mesh, int resource) const {
+    if (mesh == MESH_STATIC_BATCH) {
+        return(m_staticBatches[resource]);
+    }
+    if (mesh == MESH_MODEL) {
+        return(m_modelMeshes[resource]);
+    }
+    if (mesh == MESH_CHUNK) {
+        return(m_pWorldStreamer->ChunkBuffer(resource));
+    }
+
+    return(NULL);
+}
+
+/***********************************************************
+ *  ImportModel()
+ *
+ *  This method is used to import an OBJ model and add it to
+ *  the scene as its own object.  The compact position decode
+ *  is folded into the object's model matrix, and the bounds
+ *  come from the imported vertices.
+ ***********************************************************/
+bool SceneManager::ImportModel(
+    const char* filename,
+    std::string textureTag,
+    glm::vec3 scaleXYZ,
+    float XrotationDegrees,
+    float YrotationDegrees,
+    float ZrotationDegrees,
+    glm::vec3 positionXYZ) {
+    ResourceTracker::SCOPE scope(g_ResourceScope);
+
+    MeshImporter importer;
+    PrimitiveGeometry geometry;
+    if (!importer.ImportObj(filename, geometry)) {
+        return false;
+    }
+
+    MeshBuffer* pBuffer = new MeshBuffer();
+    if (!pBuffer->Upload(geometry, m_vertexLayout, "imported model")) {
+        delete pBuffer;
+        return false;
+    }
+    m_modelMeshes.push_back(pBuffer);
+    m_rayModels.push_back(RayQuery::BuildMesh(geometry));
+
+    SCENE_OBJECT& object = AddSceneObject(filename, MESH_MODEL, scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
+    object.model = (int)m_modelMeshes.size() - 1;
+    object.textureTag = textureTag;
+
+    // transform the corners of the imported bounds into world space
+    glm::vec3 localMin;
+    glm::vec3 localMax;
+    geometry.GetBounds(localMin, localMax);
+    TransformBounds(object.modelMatrix, localMin, localMax, object.boundsMin, object.boundsMax);
+    object.modelMatrix = object.modelMatrix * pBuffer->DecodeMatrix();
+
+    // the new object changes the scene bounds and the batched object list
+    UpdateSceneBounds();
+    BakeStaticObjects();
+    if (NULL != m_pShadowMap) {
+        m_pShadowMap->MarkDirtyBox(object.boundsMin + m_homeOffset, object.boundsMax + m_homeOffset);
+    }
+
+    return true;
+}
+
+/***********************************************************
+ *  CullSceneObjects()
+ *
+ *  This method is used for collecting the objects that may
+ *  be visible this frame.  Objects outside the camera frustum
+ *  are skipped first, then objects whose bounds lie behind
+ *  the depth pyramid built from an earlier frame.  Visible
+ *  chunks that are entirely beyond the impostor distance are
+ *  set aside to be drawn as impostors.
+ ***********************************************************/
+void SceneManager::CullSceneObjects() {
+    const EntityStore& entities = RenderEntities();
+    const glm::vec3* boundsMin = entities.BoundsMin();
+    const glm::vec3* boundsMax = entities.BoundsMax();
+    int count = entities.Count();
+
+    m_drawOrder.clear();
+    m_impostorDraws.clear();
+    m_translucentDraws.clear();
+    m_drawDepths.resize(count, 0.0f);
+    m_drawVariants.resize(count, 0);
+
+    if (NULL == m_pViewManager) {
+        for (int i = 0; i < count; i++) {
+            m_drawOrder.push_back(i);
+        }
+        return;
+    }
+
+    m_viewFrustum.Extract(m_pViewManager->GetProjectionMatrix() * m_pViewManager->GetViewMatrix());
+    bool bOcclusion = m_bOcclusionCulling && (NULL != m_pHiZBuffer) && m_pHiZBuffer->HasDepth();
+
+    bool bImpostors = m_bImpostors && (NULL != m_pImpostorAtlas);
+    float impostorDistance = 0.0f;
+    if (bImpostors) {
+        impostorDistance = m_pImpostorAtlas->SwitchDistance(m_pViewManager->GetProjectionMatrix(), m_pViewManager->RenderHeight());
+    }
+    const glm::vec3& camera = m_pViewManager->GetCameraPosition();
+    const int* meshIds = entities.MeshIds();
+
+    int frustumCulled = 0;
+    int occlusionCulled = 0;
+    for (int i = 0; i < count; i++) {
+        if (!m_viewFrustum.IntersectsBox(boundsMin[i], boundsMax[i])) {
+            frustumCulled++;
+        }
+        else if (bOcclusion && m_pHiZBuffer->IsOccluded(boundsMin[i], boundsMax[i])) {
+            occlusionCulled++;
+        }
+        else if (bImpostors && (meshIds[i] == MESH_CHUNK) &&
+            (glm::length(glm::clamp(camera, boundsMin[i], boundsMax[i]) - camera) > impostorDistance)) {
+            m_impostorDraws.push_back(i);
+        }
+        else if (entities.Flags()[i] & EntityStore::FLAG_TRANSLUCENT) {
+            m_translucentDraws.push_back(i);
+        }
+        else {
+            m_drawOrder.push_back(i);
+        }
+    }
+
+    if (NULL != m_pFrameStats) {
+        m_pFrameStats->AddCount("frustum culled", frustumCulled);
+        m_pFrameStats->AddCount("occlusion culled", occlusionCulled);
+    }
+}
+
+/***********************************************************
+ *  UpdateHiZBuffer()
+ *
+ *  This method is used for handing the finished depth of
+ *  this frame to the depth pyramid, so that the next frames
+ *  can test against it.
+ ***********************************************************/
+void SceneManager::UpdateHiZBuffer() {
+    if ((!m_bOcclusionCulling) || (NULL == m_pHiZBuffer) || (NULL == m_pViewManager)) {
+        return;
+    }
+
+    RenderTarget* pSceneTarget = m_pViewManager->GetSceneTarget();
+    if (NULL == pSceneTarget) {
+        return;
+    }
+
+    m_pHiZBuffer->Build(pSceneTarget->DepthTexture(),
+        m_pViewManager->RenderWidth(), m_pViewManager->RenderHeight(),
+        m_pViewManager->GetProjectionMatrix() * m_pViewManager->GetViewMatrix());
+
+    // the build pass leaves its own framebuffer and program behind
+    pSceneTarget->Bind(m_pViewManager->RenderWidth(), m_pViewManager->RenderHeight());
+    m_pShaderManager->use();
+}
+
+/***********************************************************
+ *  UpdateSceneBounds()
+ *
+ *  This method is used for computing the box that encloses
+ *  every scene object.
+ ***********************************************************/
+void SceneManager::UpdateSceneBounds() {
+    m_sceneBoundsMin = glm::vec3(FLT_MAX);
+    m_sceneBoundsMax = glm::vec3(-FLT_MAX);
+    for (size_t i = 0; i < m_sceneObjects.size(); i++) {
+        m_sceneBoundsMin = glm::min(m_sceneBoundsMin, m_sceneObjects[i].boundsMin);
+        m_sceneBoundsMax = glm::max(m_sceneBoundsMax, m_sceneObjects[i].boundsMax);
+    }
+}
+
+/***********************************************************
+ *  ShadowFarPlane()
+ *
+ *  This method returns the distance from the primary light
+ *  to the farthest corner of the scene, so that a single
+ *  shadow map covers the whole scene.
+ ***********************************************************/
+float SceneManager::ShadowFarPlane() const {
+    float farthest = 1.0f;
+    for (int corner = 0; corner < 8; corner++) {
+        glm::vec3 point(
+            (corner & 1) ? m_sceneBoundsMax.x : m_sceneBoundsMin.x,
+            (corner & 2) ? m_sceneBoundsMax.y : m_sceneBoundsMin.y,
+            (corner & 4) ? m_sceneBoundsMax.z : m_sceneBoundsMin.z);
+        farthest = glm::max(farthest, glm::length(point - m_primaryLight.position));
+    }
+
+    return(farthest);
+}
+
+/***********************************************************
+ *  RenderShadowMap()
+ *
+ *  This method is used for bringing the primary light shadow
+ *  map up to date.  Faces are only rendered again after the
+ *  light or a caster inside them has moved, and each face
+ *  only draws the casters inside its own frustum.
+ ***********************************************************/
+void SceneManager::RenderShadowMap() {
+    const EntityStore& entities = RenderEntities();
+    const glm::mat4* modelMatrices = entities.ModelMatrices();
+    const glm::vec3* boundsMin = entities.BoundsMin();
+    const glm::vec3* boundsMax = entities.BoundsMax();
+    const unsigned int* flags = entities.Flags();
+
+    if ((!m_bShadows) || (NULL == m_pShadowMap)) {
+        return;
+    }
+
+    m_pShadowMap->SetLight(m_primaryLight.position + m_homeOffset, ShadowFarPlane());
+    if (!m_pShadowMap->NeedsUpdate()) {
+        return;
+    }
+
+    double startTime = glfwGetTime();
+    if (NULL != m_pFrameStats) {
+        m_pFrameStats->BeginGpuTimer("shadow pass");
+    }
+
+    int facesRendered = 0;
+    int castersDrawn = 0;
+    ShaderManager* pShadowShader = m_pShadowMap->GetShader();
+    for (int face = 0; face < 6; face++) {
+        if (!m_pShadowMap->IsFaceDirty(face)) {
+            continue;
+        }
+
+        m_pShadowMap->BeginFace(face);
+        const Frustum& faceFrustum = m_pShadowMap->FaceFrustum(face);
+        for (int i = 0; i < entities.Count(); i++) {
+            if ((flags[i] & EntityStore::FLAG_CASTS_SHADOW) && faceFrustum.IntersectsBox(boundsMin[i], boundsMax[i])) {
+                pShadowShader->setMat4Value("model", modelMatrices[i]);
+                DrawEntity(entities, i);
+                castersDrawn++;
+            }
+        }
+        m_pShadowMap->EndFace(face);
+        facesRendered++;
+    }
+
+    if (NULL != m_pFrameStats) {
+        m_pFrameStats->EndGpuTimer();
+        m_pFrameStats->AddCount("shadow cpu ms", (glfwGetTime() - startTime) * 1000.0);
+        m_pFrameStats->AddCount("shadow faces", facesRendered);
+        m_pFrameStats->AddCount("shadow casters", castersDrawn);
+    }
+
+    // return to the scene target and program
+    if (NULL != m_pViewManager) {
+        RenderTarget* pSceneTarget = m_pViewManager->GetSceneTarget();
+        if (NULL != pSceneTarget) {
+            pSceneTarget->Bind(m_pViewManager->RenderWidth(), m_pViewManager->RenderHeight());
+        }
+        else {
+            glViewport(0, 0, m_pViewManager->WindowWidth(), m_pViewManager->WindowHeight());
+        }
+    }
+    m_pShaderManager->use();
+}
+
+/***********************************************************
+ *  SortDrawOrder()
+ *
+ *  This method is used for ordering the opaque objects by
+ *  the view space depth of their bounds center, nearest
+ *  first, so that early depth testing rejects the hidden
+ *  fragments of the objects drawn later.
+ ***********************************************************/
+void SceneManager::SortDrawOrder() {
+    const EntityStore& entities = RenderEntities();
+    const glm::vec3* boundsMin = entities.BoundsMin();
+    const glm::vec3* boundsMax = entities.BoundsMax();
+
+    if ((!m_bFrontToBackSort) || (NULL == m_pViewManager)) {
+        return;
+    }
+
+    const glm::mat4& view = m_pViewManager->GetViewMatrix();
+    for (size_t i = 0; i < m_drawOrder.size(); i++) {
+        int index = m_drawOrder[i];
+        glm::vec3 center = (boundsMin[index] + boundsMax[index]) * 0.5f;
+        // the camera looks down -Z in view space
+        m_drawDepths[index] = -(view * glm::vec4(center, 1.0f)).z;
+    }
+
+    std::sort(m_drawOrder.begin(), m_drawOrder.end(),
+        [this](int a, int b) { return m_drawDepths[a] < m_drawDepths[b]; });
+}
+
+/***********************************************************
+ *  SortDrawVariants()
+ *
+ *  This method is used for finding the shader variant of
+ *  each visible object and grouping the draws by variant to
+ *  save program switches.  The grouping keeps the depth
+ *  order within each variant, and is only done when the
+ *  depth pre-pass makes the order free or when the variants
+ *  are timed one at a time.
+ ***********************************************************/
+void SceneManager::SortDrawVariants() {
+    const EntityStore& entities = RenderEntities();
+
+    for (size_t i = 0; i < m_drawOrder.size(); i++) {
+        m_drawVariants[m_drawOrder[i]] = ObjectVariant(entities, m_drawOrder[i]);
+    }
+
+    bool bPrepass = m_bDepthPrepass && (NULL != m_pDepthShader) && (NULL != m_pViewManager);
+    if (!m_bShaderVariants || (!bPrepass && !m_bVariantTiming)) {
+        return;
+    }
+
+    std::stable_sort(m_drawOrder.begin(), m_drawOrder.end(),
+        [this](int a, int b) { return m_drawVariants[a] < m_drawVariants[b]; });
+}
+
+/***********************************************************
+ *  RenderDepthPrepass()
+ *
+ *  This method is used for writing the depth of every
+ *  opaque object with a minimal program and color writes
+ *  disabled, so the lit pass only shades visible fragments.
+ ***********************************************************/
+void SceneManager::RenderDepthPrepass() {
+    const EntityStore& entities = RenderEntities();
+
+    m_pDepthShader->use();
+    m_pDepthShader->setMat4Value("view", m_pViewManager->GetViewMatrix());
+    m_pDepthShader->setMat4Value("projection", m_pViewManager->GetProjectionMatrix());
+
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    for (size_t i = 0; i < m_drawOrder.size(); i++) {
+        m_pDepthShader->setMat4Value("model", entities.ModelMatrices()[m_drawOrder[i]]);
+        DrawEntity(entities, m_drawOrder[i]);
+    }
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+    m_pShaderManager->use();
+}
+
+/***********************************************************
+ *  ApplyObjectShading()
+ *
+ *  This method is used for passing the texture or color of
+ *  the passed in entity, and whether it is lit, into the
+ *  shader.
+ ***********************************************************/
+void SceneManager::ApplyObjectShading(const EntityStore& entities, int index) {
+    const MeshBuffer* pBuffer = ObjectMeshBuffer(entities.MeshIds()[index], entities.MeshResources()[index]);
+    bool bCompact = (NULL != pBuffer) && (pBuffer->Layout() == MeshBuffer::LAYOUT_COMPACT);
+    m_pShaderManager->setIntValue("bCompactVertex", bCompact);
+    if (bCompact) {
+        m_pShaderManager->setVec3Value("compactPositionScale", pBuffer->PositionScale());
+    }
+    // the variants have lighting compiled in or out, the uber program
+    // has to be told per draw so both paths shade alike
+    m_pShaderManager->setIntValue("bUseLighting", (entities.Flags()[index] & EntityStore::FLAG_LIT) != 0);
+
+    const DRAW_MATERIAL& material = m_drawMaterials[entities.MaterialIds()[index]];
+    if (material.textureSlot == -1) {
+        SetShaderColor(material.color.r, material.color.g, material.color.b, material.color.a);
+    }
+    else {
+        m_pShaderManager->setIntValue("bUseTexture", true);
+        m_pShaderManager->setSampler2DValue("objectTexture", material.textureSlot);
+    }
+}
+
+/***********************************************************
+ *  DrawEntity()
+ *
+ *  This method is used for drawing the mesh of the passed in
+ *  entity with the currently bound program.
+ ***********************************************************/
+void SceneManager::DrawEntity(const EntityStore& entities, int index) {
+    switch (entities.MeshIds()[index]) {
+    case MESH_PLANE:
+        m_basicMeshes->DrawPlaneMesh();
+        break;
+    case MESH_BOX:
+        m_basicMeshes->DrawBoxMesh();
+        break;
+    case MESH_CONE:
+        m_basicMeshes->DrawConeMesh();
+        break;
+    case MESH_CYLINDER:
+        m_basicMeshes->DrawCylinderMesh();
+        break;
+    case MESH_TAPERED_CYLINDER:
+        m_basicMeshes->DrawTaperedCylinderMesh();
+        break;
+    case MESH_SPHERE:
+        m_basicMeshes->DrawSphereMesh();
+        break;
+    case MESH_HALF_SPHERE:
+        m_basicMeshes->DrawHalfSphereMesh();
+        break;
+    case MESH_TORUS:
+        m_basicMeshes->DrawTorusMesh();
+        break;
+    case MESH_STATIC_BATCH:
+        m_staticBatches[entities.MeshResources()[index]]->Draw();
+        break;
+    case MESH_MODEL:
+        m_modelMeshes[entities.MeshResources()[index]]->Draw();
+        break;
+    case MESH_CHUNK:
+        m_pWorldStreamer->ChunkBuffer(entities.MeshResources()[index])->Draw();
+        break;
+    }
+}
+
+/***********************************************************
+ *  RenderTranslucentObjects()
+ *
+ *  This method is used for drawing the translucent objects
+ *  after the opaque ones.  With the weighted transparency
+ *  targets they are drawn in any order and composited in
+ *  one fullscreen pass.  Otherwise they are sorted farthest
+ *  first and blended straight over the scene.  Neither way
+ *  writes depth.
+ ***********************************************************/
+void SceneManager::RenderTranslucentObjects() {
+    if (m_translucentDraws.empty() || (NULL == m_pViewManager)) {
+        return;
+    }
+
+    const EntityStore& entities = RenderEntities();
+    RenderTarget* pSceneTarget = m_pViewManager->GetSceneTarget();
+    int renderWidth = m_pViewManager->RenderWidth();
+    int renderHeight = m_pViewManager->RenderHeight();
+
+    if (NULL != m_pFrameStats) {
+        m_pFrameStats->BeginGpuTimer("translucent pass");
+    }
+
+    bool bWeighted = m_bWeightedTransparency && (NULL != m_pTransparencyBuffer) && (NULL != pSceneTarget) &&
+        m_pTransparencyBuffer->BeginAccumulate(pSceneTarget->DepthTexture(), pSceneTarget->Width(), pSceneTarget->Height(),
+            renderWidth, renderHeight);
+    if (!bWeighted) {
+        SortFarthestFirst(m_translucentDraws, m_pViewManager->GetViewMatrix());
+
+        glDepthMask(GL_FALSE);
+        glEnable(GL_BLEND);
+    }
+
+    for (size_t i = 0; i < m_translucentDraws.size(); i++) {
+        int index = m_translucentDraws[i];
+        unsigned int features = ObjectVariant(entities, index);
+        if (bWeighted) {
+            features |= ShaderVariantCache::FEATURE_WEIGHTED_OIT;
+        }
+        UseVariant(features);
+        m_pShaderManager->setIntValue("bWeightedOIT", bWeighted);
+
+        ApplyObjectShading(entities, index);
+        m_pShaderManager->setMat4Value("model", entities.ModelMatrices()[index]);
+        DrawEntity(entities, index);
+    }
+
+    if (bWeighted) {
+        pSceneTarget->Bind(renderWidth, renderHeight);
+        m_pTransparencyBuffer->Composite(renderWidth, renderHeight);
+    }
+    else {
+        glDisable(GL_BLEND);
+        glDepthMask(GL_TRUE);
+    }
+
+    if (NULL != m_pFrameStats) {
+        m_pFrameStats->EndGpuTimer();
+        m_pFrameStats->AddCount("translucent draws", (double)m_translucentDraws.size());
+    }
+
+    m_pShaderManager->use();
+}
+
+/***********************************************************
+ *  SortFarthestFirst()
+ *
+ *  This method is used for ordering the passed in draws by
+ *  the view space depth of their bounds center, farthest
+ *  first, as blending straight over the scene needs.
+ ***********************************************************/
+void SceneManager::SortFarthestFirst(std::vector<int>& draws, const glm::mat4& view) {
+    const EntityStore& entities = RenderEntities();
+    const glm::vec3* boundsMin = entities.BoundsMin();
+    const glm::vec3* boundsMax = entities.BoundsMax();
+
+    for (size_t i = 0; i < draws.size(); i++) {
+        int index = draws[i];
+        glm::vec3 center = (boundsMin[index] + boundsMax[index]) * 0.5f;
+        m_drawDepths[index] = -(view * glm::vec4(center, 1.0f)).z;
+    }
+    std::sort(draws.begin(), draws.end(),
+        [this](int a, int b) { return m_drawDepths[a] > m_drawDepths[b]; });
+}
+
+/***********************************************************
+ *  MultiViewActive()
+ *
+ *  This method returns true when the view manager asks for
+ *  more than one view this frame.
+ ***********************************************************/
+bool SceneManager::MultiViewActive() const {
+    return (NULL != m_pViewManager) && (m_pViewManager->ViewCount() > 1);
+}
+
+/***********************************************************
+ *  CullViews()
+ *
+ *  This method is used for culling the objects once for all
+ *  the views of the frame.  Every object is first tested
+ *  against the box around the union of the view frustums,
+ *  and only the survivors get their shader variant and are
+ *  tested against each view frustum, so the cost of the
+ *  views grows with what is near them rather than with the
+ *  whole scene.  The distant chunks are drawn as geometry,
+ *  since the impostor switch depends on a single camera.
+ ***********************************************************/
+void SceneManager::CullViews() {
+    const EntityStore& entities = RenderEntities();
+    const glm::vec3* boundsMin = entities.BoundsMin();
+    const glm::vec3* boundsMax = entities.BoundsMax();
+    const unsigned int* flags = entities.Flags();
+    int count = entities.Count();
+    int viewCount = m_pViewManager->ViewCount();
+
+    m_drawDepths.resize(count, 0.0f);
+    m_drawVariants.resize(count, 0);
+    m_viewDraws.resize(viewCount);
+    m_viewTranslucentDraws.resize(viewCount);
+
+    glm::vec3 unionMin(FLT_MAX);
+    glm::vec3 unionMax(-FLT_MAX);
+    std::vector<Frustum> frustums(viewCount);
+    for (int v = 0; v < viewCount; v++) {
+        const ViewManager::VIEW& view = m_pViewManager->GetView(v);
+        glm::mat4 viewProjection = view.projection * view.view;
+        frustums[v].Extract(viewProjection);
+
+        glm::vec3 frustumMin;
+        glm::vec3 frustumMax;
+        Frustum::GetBounds(viewProjection, frustumMin, frustumMax);
+        unionMin = glm::min(unionMin, frustumMin);
+        unionMax = glm::max(unionMax, frustumMax);
+
+        m_viewDraws[v].clear();
+        m_viewTranslucentDraws[v].clear();
+    }
+
+    int unionCulled = 0;
+    int viewCulled = 0;
+    for (int i = 0; i < count; i++) {
+        if (glm::any(glm::lessThan(boundsMax[i], unionMin)) || glm::any(glm::greaterThan(boundsMin[i], unionMax))) {
+            unionCulled++;
+            continue;
+        }
+
+        // the variant only depends on the object, so the views share it
+        m_drawVariants[i] = ObjectVariant(entities, i);
+        bool bTranslucent = (flags[i] & EntityStore::FLAG_TRANSLUCENT) != 0;
+        for (int v = 0; v < viewCount; v++) {
+            if (!frustums[v].IntersectsBox(boundsMin[i], boundsMax[i])) {
+                viewCulled++;
+            }
+            else if (bTranslucent) {
+                m_viewTranslucentDraws[v].push_back(i);
+            }
+            else {
+                m_viewDraws[v].push_back(i);
+            }
+        }
+    }
+
+    // group each view's draws by variant to save program switches
+    for (int v = 0; v < viewCount; v++) {
+        std::stable_sort(m_viewDraws[v].begin(), m_viewDraws[v].end(),
+            [this](int a, int b) { return m_drawVariants[a] < m_drawVariants[b]; });
+    }
+
+    if (NULL != m_pFrameStats) {
+        m_pFrameStats->AddCount("union culled", unionCulled);
+        m_pFrameStats->AddCount("view culled", viewCulled);
+    }
+}
+
+/***********************************************************
+ *  RenderViews()
+ *
+ *  This method is used for drawing the scene once into each
+ *  view region after culling it once for all of them.  The
+ *  shadow map and the animation are shared, and the point
+ *  lights are binned again for each view.  The passes that
+ *  depend on a single camera's screen, namely the depth
+ *  pre-pass, occlusion culling, the impostors and the
+ *  weighted transparency composite, are left out, and
+ *  translucent objects are sorted and blended per view
+ *  instead.
+ ***********************************************************/
+void SceneManager::RenderViews() {
+    const EntityStore& entities = RenderEntities();
+    double startTime = glfwGetTime();
+
+    CullViews();
+
+    if (NULL != m_pFrameStats) {
+        m_pFrameStats->AddCount("multi-view cull ms", (glfwGetTime() - startTime) * 1000.0);
+        m_pFrameStats->BeginGpuTimer("multi-view pass");
+    }
+
+    int draws = 0;
+    for (int v = 0; v < m_pViewManager->ViewCount(); v++) {
+        int x, y, width, height;
+        m_pViewManager->GetViewport(v, x, y, width, height);
+        glViewport(x, y, width, height);
+
+        // a new stamp passes this view's camera and clusters into each
+        // program it uses
+        m_activeView = v;
+        m_frameIndex++;
+        UpdateClusteredLights();
+
+        const std::vector<int>& opaqueDraws = m_viewDraws[v];
+        for (size_t i = 0; i < opaqueDraws.size(); i++) {
+            int index = opaqueDraws[i];
+            UseVariant(m_drawVariants[index]);
+            ApplyObjectShading(entities, index);
+            m_pShaderManager->setMat4Value("model", entities.ModelMatrices()[index]);
+            DrawEntity(entities, index);
+        }
+
+        std::vector<int>& translucentDraws = m_viewTranslucentDraws[v];
+        if (!translucentDraws.empty()) {
+            SortFarthestFirst(translucentDraws, m_pViewManager->GetView(v).view);
+            glDepthMask(GL_FALSE);
+            glEnable(GL_BLEND);
+            for (size_t i = 0; i < translucentDraws.size(); i++) {
+                int index = translucentDraws[i];
+                UseVariant(m_drawVariants[index]);
+                ApplyObjectShading(entities, index);
+                m_pShaderManager->setMat4Value("model", entities.ModelMatrices()[index]);
+                DrawEntity(entities, index);
+            }
+            glDisable(GL_BLEND);
+            glDepthMask(GL_TRUE);
+        }
+
+        draws += (int)(opaqueDraws.size() + translucentDraws.size());
+    }
+
+    m_activeView = -1;
+    if (NULL != m_pViewManager->GetSceneTarget()) {
+        glViewport(0, 0, m_pViewManager->RenderWidth(), m_pViewManager->RenderHeight());
+    }
+    else {
+        glViewport(0, 0, m_pViewManager->WindowWidth(), m_pViewManager->WindowHeight());
+    }
+
+    if (NULL != m_pFrameStats) {
+        m_pFrameStats->EndGpuTimer();
+        m_pFrameStats->AddCount("views", m_pViewManager->ViewCount());
+        m_pFrameStats->AddCount("draw calls", draws);
+    }
+}
+
+/***********************************************************
+ *  RenderScene()
+ *
+ *  This method is used for rendering the 3D scene by
+ *  drawing the scene objects, optionally after a depth-only
+ *  pre-pass so that the lit pass shades each pixel once.
+ ***********************************************************/
+void SceneManager::RenderScene() {
+    ResourceTracker::SCOPE scope(g_ResourceScope);
+    const EntityStore& entities = RenderEntities();
+
+    // follow the camera through the world, then move the animated objects
+    // and lights before anything is drawn
+    UpdateWorldOrigin();
+    UpdateWorldStreaming();
+    UpdateAnimation();
+    UpdateRayScene();
+
+    // the frame uniforms are passed again into each program used this frame
+    m_frameIndex++;
+
+    // bring the shadow map up to date before it is sampled
+    RenderShadowMap();
+
+    UpdateClusteredLights();
+
+    // the depth pyramid is only built while one view is drawn, so the depth
+    // from before a change of view mode does not match what is drawn now
+    if ((NULL != m_pViewManager) && ((int)m_pViewManager->GetViewMode() != m_lastViewMode)) {
+        if (NULL != m_pHiZBuffer) {
+            m_pHiZBuffer->Invalidate();
+        }
+        m_lastViewMode = (int)m_pViewManager->GetViewMode();
+    }
+
+    // several views share the updates above and one culling pass
+    if (MultiViewActive()) {
+        RenderViews();
+        return;
+    }
+
+    CullSceneObjects();
+    SortDrawOrder();
+    SortDrawVariants();
+
+    bool bPrepass = m_bDepthPrepass && (NULL != m_pDepthShader) && (NULL != m_pViewManager);
+    if (bPrepass) {
+        RenderDepthPrepass();
+
+        // only the nearest fragment of each pixel passes, and depth is already final
+        glDepthFunc(GL_EQUAL);
+        glDepthMask(GL_FALSE);
+    }
+
+    // count the fragments the lit pass shades per rendered pixel
+    if ((NULL != m_pFrameStats) && (NULL != m_pViewManager)) {
+        double pixels = (double)m_pViewManager->RenderWidth() * (double)m_pViewManager->RenderHeight();
+        m_pFrameStats->BeginSampleCount("shaded fragments/pixel", 1.0 / pixels);
+    }
+    bool bVariantTiming = m_bVariantTiming && m_bShaderVariants && (NULL != m_pFrameStats);
+    if ((NULL != m_pFrameStats) && !bVariantTiming) {
+        m_pFrameStats->BeginGpuTimer("lit pass");
+    }
+
+    int programSwitches = 0;
+    for (size_t i = 0; i < m_drawOrder.size(); i++) {
+        int index = m_drawOrder[i];
+        unsigned int features = m_drawVariants[index];
+
+        // the draws are grouped by variant, so each timer covers one variant
+        bool bNewVariant = (i == 0) || (features != m_drawVariants[m_drawOrder[i - 1]]);
+        if (bNewVariant && bVariantTiming) {
+            if (i > 0) {
+                m_pFrameStats->EndGpuTimer();
+            }
+            m_pFrameStats->BeginGpuTimer("lit pass: " + ShaderVariantCache::FeatureName(features));
+        }
+
+        GLuint previousProgram = m_pShaderManager->m_programID;
+        UseVariant(features);
+        if (m_pShaderManager->m_programID != previousProgram) {
+            programSwitches++;
+        }
+
+        ApplyObjectShading(entities, index);
+        m_pShaderManager->setMat4Value("model", entities.ModelMatrices()[index]);
+        DrawEntity(entities, index);
+    }
+
+    if (NULL != m_pFrameStats) {
+        if (!bVariantTiming || !m_drawOrder.empty()) {
+            m_pFrameStats->EndGpuTimer();
+        }
+        m_pFrameStats->EndSampleCount();
+        m_pFrameStats->AddCount("draw calls", (double)m_drawOrder.size() * (bPrepass ? 2 : 1));
+        m_pFrameStats->AddCount("program switches", programSwitches);
+        if (NULL != m_pShaderVariants) {
+            m_pFrameStats->AddCount("shader variants", m_pShaderVariants->VariantCount());
+        }
+    }
+
+    if (bPrepass) {
+        glDepthFunc(GL_LESS);
+        glDepthMask(GL_TRUE);
+    }
+
+    // the impostors are not in the pre-pass, so they are drawn after it
+    RenderImpostors();
+
+    // the translucent objects are blended over everything opaque
+    RenderTranslucentObjects();
+
+    UpdateHiZBuffer();
 }
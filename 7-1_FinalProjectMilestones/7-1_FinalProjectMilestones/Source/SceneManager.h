@@ -11,15 +11,35 @@
 
 #include "ShaderManager.h"
 #include "ShapeMeshes.h"
+#include "FrameStats.h"
+#include "Frustum.h"
+#include "HiZBuffer.h"
+#include "ShadowMap.h"
+#include "ClusteredLighting.h"
+#include "MeshBuffer.h"
+#include "MeshImporter.h"
+#include "ShaderVariantCache.h"
+#include "AnimationSystem.h"
+#include "EntityStore.h"
+#include "WorldStreamer.h"
+#include "ImpostorAtlas.h"
+#include "TransparencyBuffer.h"
+#include "RayQuery.h"
+#include "StartupTimer.h"
 #include <vector>
 #include <glm/glm.hpp>
 #include <string>
+#include <memory>
+#include <mutex>
 #include <unordered_set>
+#include <unordered_map>
+
+class ViewManager;
 
 class SceneManager {
 public:
     // Constructor
-    SceneManager(ShaderManager* pShaderManager);
+    SceneManager(ShaderManager* pShaderManager, ViewManager* pViewManager = nullptr, FrameStats* pFrameStats = nullptr);
 
     // Destructor
     ~SceneManager();
@@ -29,12 +49,76 @@ public:
     void LoadSceneTextures();
     void RenderScene();
 
+    // Method to set the timer the meshes and textures loaded on first use
+    // are added to until the first frame is reported, may be null
+    void SetStartupTimer(StartupTimer* pStartupTimer) { m_pStartupTimer = pStartupTimer; }
+
+    // Methods to configure the render passes
+    void SetDepthPrepass(bool bEnable);
+    void SetFrontToBackSort(bool bEnable);
+    bool DepthPrepassEnabled() const { return m_bDepthPrepass; }
+    bool FrontToBackSortEnabled() const { return m_bFrontToBackSort; }
+    void SetOcclusionCulling(bool bEnable);
+    bool OcclusionCullingEnabled() const { return m_bOcclusionCulling; }
+    void SetShadows(bool bEnable);
+    bool ShadowsEnabled() const { return m_bShadows; }
+    void SetClusteredLights(bool bEnable);
+    bool ClusteredLightsEnabled() const { return m_bClusteredLights; }
+    void SetStaticBatching(bool bEnable);
+    bool StaticBatchingEnabled() const { return m_bStaticBatching; }
+    void SetCompactVertices(bool bEnable);
+    bool CompactVerticesEnabled() const { return m_vertexLayout == MeshBuffer::LAYOUT_COMPACT; }
+    void SetShaderVariants(bool bEnable);
+    bool ShaderVariantsEnabled() const { return m_bShaderVariants; }
+    void SetVariantTiming(bool bEnable);
+    bool VariantTimingEnabled() const { return m_bVariantTiming; }
+    void SetAnimation(bool bEnable);
+    bool AnimationEnabled() const { return m_bAnimation; }
+    void SetWorldStreaming(bool bEnable);
+    bool WorldStreamingEnabled() const { return m_bWorldStreaming; }
+    void SetImpostors(bool bEnable);
+    bool ImpostorsEnabled() const { return m_bImpostors; }
+    void SetWeightedTransparency(bool bEnable);
+    bool WeightedTransparencyEnabled() const { return m_bWeightedTransparency; }
+
+    // Method to time the static batches in the float and compact vertex layouts
+    void RunVertexBenchmark();
+    // Method to time the animation update over many generated tracks
+    void RunAnimationBenchmark();
+    // Method to time culling, sorting and transforming many entities
+    void RunEntityBenchmark();
+    // Method to time casting a ray through every pixel against the scene
+    void RunRayBenchmark();
+
+    // Method to get the ray query over the scene objects as they were
+    // placed this frame; it never touches GL and is never changed, so any
+    // thread may keep it and query it while the next frame is built
+    std::shared_ptr<const RayQuery> GetRayScene() const;
+    // Method to find the scene object under a point of the view, in
+    // normalized device coordinates
+    bool PickObject(float ndcX, float ndcY, RayQuery::HIT& hit, std::string& tag) const;
+
+    // Method to import an OBJ model and place it in the scene; the model is
+    // uploaded in the vertex layout that is active at the time
+    bool ImportModel(const char* filename, std::string textureTag, glm::vec3 scaleXYZ, float XrotationDegrees, float YrotationDegrees, float ZrotationDegrees, glm::vec3 positionXYZ);
+
+    // Methods to set the number of point lights, the ship lights come first
+    // and the rest are scattered through the scene for scaling tests
+    void SetPointLightCount(int count);
+    int PointLightCount() const;
+
     // Struct to hold texture information
     struct TEXTURE_ID {
         unsigned int ID = 0;   // Initialize ID
         std::string tag;
     };
 
+    // Struct to hold a texture file that is loaded the first time its tag is used
+    struct TEXTURE_FILE {
+        std::string filename;
+        std::string tag;
+    };
+
     // Struct to hold object material properties
     struct OBJECT_MATERIAL {
         std::string tag;  // Material tag
@@ -52,16 +136,132 @@ public:
         float intensity;
     };
 
+    // Enum for the basic shape meshes an object can be drawn with
+    enum MESH_TYPE {
+        MESH_PLANE,
+        MESH_BOX,
+        MESH_CONE,
+        MESH_CYLINDER,
+        MESH_TAPERED_CYLINDER,
+        MESH_SPHERE,
+        MESH_HALF_SPHERE,
+        MESH_TORUS,
+        MESH_STATIC_BATCH,
+        MESH_MODEL,
+        MESH_CHUNK
+    };
+
+    // Struct to hold an object placed in the scene
+    struct SCENE_OBJECT {
+        std::string tag;                  // Object name
+        MESH_TYPE mesh = MESH_BOX;        // Shape mesh to draw
+        std::string textureTag;           // Texture, empty when drawn with a color
+        glm::vec4 color = glm::vec4(1.0f);
+        glm::mat4 modelMatrix = glm::mat4(1.0f);
+        glm::vec3 boundsMin = glm::vec3(0.0f);  // World space bounding box
+        glm::vec3 boundsMax = glm::vec3(0.0f);
+        bool bCastsShadow = true;         // Drawn into the primary light shadow map
+        bool bDynamic = false;            // Kept out of the baked static batches
+        bool bLit = true;                 // Shaded by the lights, otherwise drawn at full color
+        int batch = -1;                   // Baked batch drawn by a MESH_STATIC_BATCH object
+        int model = -1;                   // Imported mesh drawn by a MESH_MODEL object
+        int parentTrack = -1;             // Animation track the object moves with
+        int localTrack = -1;              // Animation track applied in object space
+        EntityStore::HANDLE entity;       // Entity the object is drawn as on its own
+    };
+
+    // Struct to hold the texture or color an entity is drawn with
+    struct DRAW_MATERIAL {
+        std::string textureTag;           // Texture, empty when drawn with a color
+        int textureSlot = -1;             // Texture unit, -1 when drawn with the color
+        glm::vec4 color = glm::vec4(1.0f);
+    };
+
 private:
     ShaderManager* m_pShaderManager;  // Shader manager pointer
+    ViewManager* m_pViewManager;      // View manager pointer for the camera
+    FrameStats* m_pFrameStats;        // Frame statistics, may be null
+    StartupTimer* m_pStartupTimer;    // Startup phase timer, may be null
     ShapeMeshes* m_basicMeshes;       // Basic shapes meshes
+    bool m_bMeshLoaded[MESH_STATIC_BATCH];  // Basic shapes generated so far
     int m_loadedTextures;         // Number of loaded textures
     TEXTURE_ID m_textureIDs[16];    // Array of texture information
+    std::vector<TEXTURE_FILE> m_textureFiles;  // Textures registered but not loaded yet
     std::vector<OBJECT_MATERIAL> m_objectMaterials;  // Vector of object materials
 
     Light m_primaryLight;             // Primary light
     Light m_ambientLight;             // Ambient light
 
+    std::vector<SCENE_OBJECT> m_sceneObjects;  // Objects placed in the scene
+    EntityStore m_objectEntities;              // Every object on its own, drawn without batching
+    std::vector<DRAW_MATERIAL> m_drawMaterials;  // Materials the entities refer to
+    std::vector<int> m_drawOrder;              // Visible object indices in submission order
+    std::vector<float> m_drawDepths;           // View space depth per object
+
+    ShaderManager* m_pDepthShader;    // Minimal depth-only program
+    bool m_bDepthPrepass;             // Lay down depth before shading
+    bool m_bFrontToBackSort;          // Submit opaque objects nearest first
+
+    Frustum m_viewFrustum;            // Camera frustum for the current frame
+    HiZBuffer* m_pHiZBuffer;          // Depth of earlier frames for occlusion tests
+    bool m_bOcclusionCulling;         // Skip objects hidden in the depth pyramid
+
+    ShadowMap* m_pShadowMap;          // Cached shadow cube map of the primary light
+    bool m_bShadows;                  // Primary light casts shadows
+    glm::vec3 m_sceneBoundsMin;       // Bounds of every scene object
+    glm::vec3 m_sceneBoundsMax;
+
+    ClusteredLighting* m_pClusteredLighting;  // Point lights binned per view cluster
+    bool m_bClusteredLights;          // Shade the point lights in the lit pass
+    std::vector<ClusteredLighting::POINT_LIGHT> m_shipLights;  // Lights fixed to the ship
+
+    std::vector<MeshBuffer*> m_staticBatches;      // Merged static geometry per material
+    EntityStore m_batchEntities;                   // Dynamic objects plus one entity per batch
+    bool m_bStaticBatching;           // Draw the baked batches instead of the static objects
+    MeshBuffer::VERTEX_LAYOUT m_vertexLayout;  // Vertex format of the baked batches
+    std::vector<MeshBuffer*> m_modelMeshes;        // Imported model meshes
+
+    ShaderVariantCache* m_pShaderVariants;  // Scene programs compiled per feature mask
+    bool m_bShaderVariants;           // Draw with the minimal variant instead of the uber program
+    bool m_bVariantTiming;            // Time the lit pass per variant instead of as a whole
+    GLuint m_uberProgram;             // Program loaded by the shader manager
+    std::vector<unsigned int> m_drawVariants;      // Feature mask per object
+    std::unordered_map<GLuint, int> m_programFrames;  // Frame each program last got the frame uniforms
+    int m_frameIndex;                 // Frames and views rendered, stamps the frame uniforms
+
+    int m_activeView;                 // View the frame uniforms are taken from, -1 for the camera
+    int m_lastViewMode;               // View mode of the previous frame, -1 before the first
+    std::vector<std::vector<int>> m_viewDraws;  // Opaque draws refined per view
+    std::vector<std::vector<int>> m_viewTranslucentDraws;  // Translucent draws refined per view
+
+    AnimationSystem m_animation;      // Keyframed tracks stepped at a fixed rate
+    bool m_bAnimation;                // Advance the animation every frame
+    int m_shipTrack;                  // Orbit the whole ship follows
+    int m_dishTrack;                  // Spin of the deflector dish
+    int m_lightColorTrack;            // Pulse of the primary light color
+
+    WorldStreamer* m_pWorldStreamer;  // Fleet chunks streamed around the camera
+    bool m_bWorldStreaming;           // Stream the fleet chunks in and out
+    glm::dvec3 m_worldOrigin;         // World position the scene is rendered around
+    glm::vec3 m_homeOffset;           // Where the world origin is rendered
+    bool m_bOriginMoved;              // The world origin moved this frame
+    std::vector<EntityStore::HANDLE> m_chunkObjectEntities;  // Entity of each chunk slot per store
+    std::vector<EntityStore::HANDLE> m_chunkBatchEntities;
+
+    ImpostorAtlas* m_pImpostorAtlas;  // Captured views of the ship classes
+    bool m_bImpostors;                // Draw distant chunks as impostor quads
+    std::vector<int> m_impostorDraws; // Visible chunk entities drawn as impostors
+
+    TransparencyBuffer* m_pTransparencyBuffer;  // Weighted blended transparency targets
+    bool m_bWeightedTransparency;     // Blend the translucent objects in any order
+    std::vector<int> m_translucentDraws;  // Visible translucent object indices
+
+    std::shared_ptr<const RayQuery::MESH> m_rayShapes[MESH_STATIC_BATCH];  // Triangles of each basic shape
+    std::vector<std::shared_ptr<const RayQuery::MESH>> m_rayModels;  // Triangles of each imported model
+    std::shared_ptr<const RayQuery> m_pRayScene;  // Scene objects where they are drawn
+    bool m_bRaySceneDirty;            // Scene objects moved since the ray scene was built
+    mutable std::mutex m_rayMutex;    // Guards swapping the ray scene
+
     // Helper methods for texture and shader operations
     bool CreateGLTexture(const char* filename, std::string tag);
     void BindGLTextures();
@@ -75,4 +275,47 @@ private:
     void SetTextureUVScale(float u, float v);
     void SetShaderMaterial(std::string materialTag);
     void SetLighting(); // Method to set lighting
+    void UpdateClusteredLights();
+    void ApplyFrameUniforms();
+    unsigned int ObjectVariant(const EntityStore& entities, int index) const;
+    void UseVariant(unsigned int features);
+
+    // Helper methods for the scene object list
+    void DefineSceneObjects();
+    void DefineSceneLights();
+    void DefineAnimationTracks();
+    void UpdateAnimation();
+    void AnimateObjects(EntityStore& entities, bool bMarkShadows);
+    void UpdateWorldOrigin();
+    void UpdateWorldStreaming();
+    void AddChunkEntities(int slot);
+    void RemoveChunkEntities(int slot);
+    void WriteChunkEntity(EntityStore& entities, int index, int slot);
+    void BuildImpostors();
+    void RenderImpostors();
+    void RenderTranslucentObjects();
+    void SortFarthestFirst(std::vector<int>& draws, const glm::mat4& view);
+    bool MultiViewActive() const;
+    void CullViews();
+    void RenderViews();
+    void LoadBasicMesh(MESH_TYPE mesh);
+    void UpdateRayScene();
+    void BakeStaticObjects();
+    void SyncObjectEntities();
+    void WriteEntity(EntityStore& entities, int index, const SCENE_OBJECT& object);
+    int FindDrawMaterial(const std::string& textureTag, const glm::vec4& color);
+    const EntityStore& RenderEntities() const;
+    const MeshBuffer* ObjectMeshBuffer(int mesh, int resource) const;
+    SCENE_OBJECT& AddSceneObject(std::string tag, MESH_TYPE mesh, glm::vec3 scaleXYZ, float XrotationDegrees, float YrotationDegrees, float ZrotationDegrees, glm::vec3 positionXYZ);
+    glm::mat4 BuildTransformation(glm::vec3 scaleXYZ, float XrotationDegrees, float YrotationDegrees, float ZrotationDegrees, glm::vec3 positionXYZ);
+    void CullSceneObjects();
+    void SortDrawOrder();
+    void SortDrawVariants();
+    void UpdateHiZBuffer();
+    void UpdateSceneBounds();
+    float ShadowFarPlane() const;
+    void RenderShadowMap();
+    void RenderDepthPrepass();
+    void ApplyObjectShading(const EntityStore& entities, int index);
+    void DrawEntity(const EntityStore& entities, int index);
 };
@@ -0,0 +1,196 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadervariantcache.cpp
+// ============
+// compile feature permutations of one shader pair on first use and cache
+// them by feature mask
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShaderVariantCache.h"
+#include "ResourceTracker.h"
+#include <GLFW/glfw3.h>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace {
+    // preprocessor names of the features, in FEATURE bit order
+    const char* g_FeatureDefines[ShaderVariantCache::FEATURE_COUNT] = {
+        "TEXTURED", "LIT", "SHADOWS", "POINT_LIGHTS", "COMPACT_VERTEX", "WEIGHTED_OIT"
+    };
+
+    /***********************************************************
+     *  ReadFile()
+     *
+     *  Reads a whole text file into the passed in string.
+     ***********************************************************/
+    bool ReadFile(const char* filename, std::string& contents) {
+        std::ifstream file(filename);
+        if (!file.is_open()) {
+            return false;
+        }
+        std::stringstream stream;
+        stream << file.rdbuf();
+        contents = stream.str();
+        return true;
+    }
+}
+
+/***********************************************************
+ *  ShaderVariantCache()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ShaderVariantCache::ShaderVariantCache() {
+}
+
+/***********************************************************
+ *  ~ShaderVariantCache()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ShaderVariantCache::~ShaderVariantCache() {
+    for (auto it = m_programs.begin(); it != m_programs.end(); ++it) {
+        if (it->second != 0) {
+            ResourceTracker::Release(ResourceTracker::CATEGORY_PROGRAM, it->second);
+            glDeleteProgram(it->second);
+        }
+    }
+    m_programs.clear();
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used to read the shader sources that the
+ *  variants are compiled from.
+ ***********************************************************/
+bool ShaderVariantCache::Initialize(const char* vertexShaderPath, const char* fragmentShaderPath) {
+    if (!ReadFile(vertexShaderPath, m_vertexSource) || !ReadFile(fragmentShaderPath, m_fragmentSource)) {
+        std::cout << "Error: Could not read the shader variant sources" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+/***********************************************************
+ *  GetProgram()
+ *
+ *  This method returns the program for a feature mask.  A
+ *  variant is compiled the first time it is requested, and
+ *  failures are cached too so they are only reported once.
+ ***********************************************************/
+GLuint ShaderVariantCache::GetProgram(unsigned int features) {
+    auto found = m_programs.find(features);
+    if (found != m_programs.end()) {
+        return found->second;
+    }
+
+    GLuint program = CompileVariant(features);
+    m_programs[features] = program;
+
+    return program;
+}
+
+/***********************************************************
+ *  FeatureName()
+ *
+ *  This method returns the features of a mask as a string.
+ ***********************************************************/
+std::string ShaderVariantCache::FeatureName(unsigned int features) {
+    std::string name;
+    for (int feature = 0; feature < FEATURE_COUNT; feature++) {
+        if (features & (1u << feature)) {
+            if (!name.empty()) {
+                name += "+";
+            }
+            name += g_FeatureDefines[feature];
+        }
+    }
+
+    return name.empty() ? std::string("UNLIT") : name;
+}
+
+/***********************************************************
+ *  CompileVariant()
+ *
+ *  This method is used to compile and link one variant.  The
+ *  shaders check VARIANT to read their feature switches from
+ *  the defines instead of from uniforms, so that the disabled
+ *  paths are removed by the compiler.
+ ***********************************************************/
+GLuint ShaderVariantCache::CompileVariant(unsigned int features) {
+    double startTime = glfwGetTime();
+
+    std::string defines = "#define VARIANT\n";
+    for (int feature = 0; feature < FEATURE_COUNT; feature++) {
+        defines += std::string("#define ") + g_FeatureDefines[feature] +
+            ((features & (1u << feature)) ? " true\n" : " false\n");
+    }
+
+    GLuint vertexShader = CompileStage(GL_VERTEX_SHADER, m_vertexSource, defines);
+    GLuint fragmentShader = CompileStage(GL_FRAGMENT_SHADER, m_fragmentSource, defines);
+    if ((vertexShader == 0) || (fragmentShader == 0)) {
+        glDeleteShader(vertexShader);
+        glDeleteShader(fragmentShader);
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    glLinkProgram(program);
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+
+    GLint success = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        char infoLog[1024];
+        glGetProgramInfoLog(program, sizeof(infoLog), NULL, infoLog);
+        std::cout << "Error: Shader variant " << FeatureName(features) << " failed to link\n" << infoLog << std::endl;
+        glDeleteProgram(program);
+        return 0;
+    }
+
+    ResourceTracker::TrackProgram(program, "shader variant");
+
+    std::cout << "INFO: Compiled shader variant " << FeatureName(features) << " in "
+        << (glfwGetTime() - startTime) * 1000.0 << " ms" << std::endl;
+
+    return program;
+}
+
+/***********************************************************
+ *  CompileStage()
+ *
+ *  This method is used to compile one shader stage with the
+ *  defines inserted right after the #version line.
+ ***********************************************************/
+GLuint ShaderVariantCache::CompileStage(GLenum stage, const std::string& source, const std::string& defines) {
+    std::string text = source;
+    size_t versionLine = text.find("#version");
+    size_t insertAt = (versionLine == std::string::npos) ? 0 : text.find('\n', versionLine);
+    insertAt = (insertAt == std::string::npos) ? text.size() : insertAt + 1;
+    text.insert(insertAt, defines);
+
+    GLuint shader = glCreateShader(stage);
+    const char* pText = text.c_str();
+    glShaderSource(shader, 1, &pText, NULL);
+    glCompileShader(shader);
+
+    GLint success = 0;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        char infoLog[1024];
+        glGetShaderInfoLog(shader, sizeof(infoLog), NULL, infoLog);
+        std::cout << "Error: Shader variant stage failed to compile\n" << infoLog << std::endl;
+        glDeleteShader(shader);
+        return 0;
+    }
+
+    return shader;
+}
@@ -0,0 +1,53 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadervariantcache.h
+// ============
+// compile feature permutations of one shader pair on first use and cache
+// them by feature mask
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <string>
+#include <unordered_map>
+
+class ShaderVariantCache {
+public:
+    // Enum for the features a variant can be compiled with
+    enum FEATURE {
+        FEATURE_TEXTURE = 1 << 0,         // sample the object texture
+        FEATURE_LIGHTING = 1 << 1,        // ambient and primary light shading
+        FEATURE_SHADOWS = 1 << 2,         // primary light shadow map
+        FEATURE_POINT_LIGHTS = 1 << 3,    // clustered point light loop
+        FEATURE_COMPACT_VERTEX = 1 << 4,  // decode compact vertex normals
+        FEATURE_WEIGHTED_OIT = 1 << 5,    // write the weighted transparency targets
+        FEATURE_COUNT = 6
+    };
+
+    // constructor
+    ShaderVariantCache();
+    // destructor
+    ~ShaderVariantCache();
+
+    // read the shader sources every variant is compiled from
+    bool Initialize(const char* vertexShaderPath, const char* fragmentShaderPath);
+
+    // get the program for a feature mask, compiling it on first use;
+    // returns 0 when the variant failed to compile
+    GLuint GetProgram(unsigned int features);
+
+    // get a readable list of the features in a mask
+    static std::string FeatureName(unsigned int features);
+
+    int VariantCount() const { return (int)m_programs.size(); }
+
+private:
+    std::string m_vertexSource;
+    std::string m_fragmentSource;
+    std::unordered_map<unsigned int, GLuint> m_programs;
+
+    GLuint CompileVariant(unsigned int features);
+    GLuint CompileStage(GLenum stage, const std::string& source, const std::string& defines);
+};
@@ -0,0 +1,226 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadowmap.cpp
+// ============
+// manage a cached omnidirectional shadow map for a point light
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShadowMap.h"
+#include "ResourceTracker.h"
+#include <glm/gtx/transform.hpp>
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace {
+    // shader files for the shadow depth pass
+    const char* g_ShadowVertexShader = "Shaders/shadowDepthVertexShader.glsl";
+    const char* g_ShadowFragmentShader = "Shaders/shadowDepthFragmentShader.glsl";
+
+    // near plane of the face projections
+    const float SHADOW_NEAR_PLANE = 0.05f;
+
+    // look direction and up vector of each cube face, in GL face order
+    const glm::vec3 g_FaceDirections[6] = {
+        glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f),
+        glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
+        glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f)
+    };
+    const glm::vec3 g_FaceUps[6] = {
+        glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
+        glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f),
+        glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f)
+    };
+}
+
+/***********************************************************
+ *  ShadowMap()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ShadowMap::ShadowMap()
+    : m_pDepthShader(nullptr), m_framebuffer(0), m_depthTexture(0), m_resolution(0),
+    m_lightPosition(0.0f), m_farPlane(1.0f), m_bHasLight(false) {
+    for (int face = 0; face < 6; face++) {
+        m_faceViewProjections[face] = glm::mat4(1.0f);
+        m_bFaceDirty[face] = true;
+    }
+}
+
+/***********************************************************
+ *  ~ShadowMap()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ShadowMap::~ShadowMap() {
+    if (m_framebuffer != 0) {
+        glDeleteFramebuffers(1, &m_framebuffer);
+        m_framebuffer = 0;
+    }
+    if (m_depthTexture != 0) {
+        ResourceTracker::Release(ResourceTracker::CATEGORY_TEXTURE, m_depthTexture);
+        glDeleteTextures(1, &m_depthTexture);
+        m_depthTexture = 0;
+    }
+    if (m_pDepthShader) {
+        ResourceTracker::DeleteProgram(m_pDepthShader->m_programID);
+        delete m_pDepthShader;
+        m_pDepthShader = nullptr;
+    }
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used to allocate the cube depth texture
+ *  and the framebuffer its faces are rendered through.
+ ***********************************************************/
+bool ShadowMap::Initialize(int resolution) {
+    m_pDepthShader = new ShaderManager();
+    if (m_pDepthShader->LoadShaders(g_ShadowVertexShader, g_ShadowFragmentShader) == 0) {
+        std::cout << "Error: Shadow depth shaders failed to load" << std::endl;
+        delete m_pDepthShader;
+        m_pDepthShader = nullptr;
+        return false;
+    }
+    ResourceTracker::TrackProgram(m_pDepthShader->m_programID, "shadow map");
+
+    m_resolution = resolution;
+
+    glGenTextures(1, &m_depthTexture);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, m_depthTexture);
+    for (int face = 0; face < 6; face++) {
+        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_DEPTH_COMPONENT32F,
+            resolution, resolution, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+    }
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_COMPARE_MODE, GL_NONE);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    ResourceTracker::TrackTexture(m_depthTexture, GL_DEPTH_COMPONENT32F, resolution, resolution, 6, 1, "shadow map");
+
+    glGenFramebuffers(1, &m_framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_CUBE_MAP_POSITIVE_X, m_depthTexture, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Error: Shadow map framebuffer is incomplete, status: " << status << std::endl;
+        return false;
+    }
+
+    Invalidate();
+
+    return true;
+}
+
+/***********************************************************
+ *  SetLight()
+ *
+ *  This method is used to pass in the light for the frame.
+ *  The cached faces stay valid for as long as the light and
+ *  the shadow casters do not move.
+ ***********************************************************/
+void ShadowMap::SetLight(const glm::vec3& position, float farPlane) {
+    if (m_bHasLight && (position == m_lightPosition) && (farPlane == m_farPlane)) {
+        return;
+    }
+
+    m_lightPosition = position;
+    m_farPlane = farPlane;
+    m_bHasLight = true;
+
+    UpdateFaceMatrices();
+    Invalidate();
+}
+
+/***********************************************************
+ *  MarkDirtyBox()
+ *
+ *  This method is used to invalidate only the faces whose
+ *  frustum contains the passed in box.  A moving caster is
+ *  marked with both its old and its new bounds.
+ ***********************************************************/
+void ShadowMap::MarkDirtyBox(const glm::vec3& boundsMin, const glm::vec3& boundsMax) {
+    for (int face = 0; face < 6; face++) {
+        if (m_faceFrustums[face].IntersectsBox(boundsMin, boundsMax)) {
+            m_bFaceDirty[face] = true;
+        }
+    }
+}
+
+/***********************************************************
+ *  Invalidate()
+ *
+ *  This method is used to force every face to be rendered.
+ ***********************************************************/
+void ShadowMap::Invalidate() {
+    for (int face = 0; face < 6; face++) {
+        m_bFaceDirty[face] = true;
+    }
+}
+
+/***********************************************************
+ *  NeedsUpdate()
+ *
+ *  This method returns true when any face is out of date.
+ ***********************************************************/
+bool ShadowMap::NeedsUpdate() const {
+    for (int face = 0; face < 6; face++) {
+        if (m_bFaceDirty[face]) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/***********************************************************
+ *  UpdateFaceMatrices()
+ *
+ *  This method is used to build the 90 degree projection of
+ *  each face around the light and its culling frustum.
+ ***********************************************************/
+void ShadowMap::UpdateFaceMatrices() {
+    glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, SHADOW_NEAR_PLANE, m_farPlane);
+
+    for (int face = 0; face < 6; face++) {
+        glm::mat4 view = glm::lookAt(m_lightPosition, m_lightPosition + g_FaceDirections[face], g_FaceUps[face]);
+        m_faceViewProjections[face] = projection * view;
+        m_faceFrustums[face].Extract(m_faceViewProjections[face]);
+    }
+}
+
+/***********************************************************
+ *  BeginFace()
+ *
+ *  This method is used to direct rendering into one face of
+ *  the cube and set up the depth program for it.
+ ***********************************************************/
+void ShadowMap::BeginFace(int face) {
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, m_depthTexture, 0);
+    glViewport(0, 0, m_resolution, m_resolution);
+    glClear(GL_DEPTH_BUFFER_BIT);
+
+    m_pDepthShader->use();
+    m_pDepthShader->setMat4Value("lightViewProjection", m_faceViewProjections[face]);
+    m_pDepthShader->setVec3Value("lightPosition", m_lightPosition);
+    m_pDepthShader->setFloatValue("farPlane", m_farPlane);
+}
+
+/***********************************************************
+ *  EndFace()
+ *
+ *  This method is used to mark a rendered face as current.
+ ***********************************************************/
+void ShadowMap::EndFace(int face) {
+    m_bFaceDirty[face] = false;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
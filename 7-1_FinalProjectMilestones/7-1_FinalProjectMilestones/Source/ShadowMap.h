@@ -0,0 +1,62 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadowmap.h
+// ============
+// manage a cached omnidirectional shadow map for a point light
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+#include "Frustum.h"
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+class ShadowMap {
+public:
+    // constructor
+    ShadowMap();
+    // destructor
+    ~ShadowMap();
+
+    // allocate the cube depth texture and load the depth shaders
+    bool Initialize(int resolution);
+
+    // set the light for this frame; every face is invalidated if it moved
+    void SetLight(const glm::vec3& position, float farPlane);
+    // invalidate the faces that can see the passed in world space box
+    void MarkDirtyBox(const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+    // invalidate every face
+    void Invalidate();
+
+    // returns true when any face has to be rendered again
+    bool NeedsUpdate() const;
+    bool IsFaceDirty(int face) const { return m_bFaceDirty[face]; }
+
+    // prepare rendering into one cube face, and mark it clean afterwards
+    void BeginFace(int face);
+    void EndFace(int face);
+
+    // get the culling frustum of one face and the program used to draw casters
+    const Frustum& FaceFrustum(int face) const { return m_faceFrustums[face]; }
+    ShaderManager* GetShader() const { return m_pDepthShader; }
+
+    GLuint DepthTexture() const { return m_depthTexture; }
+    float FarPlane() const { return m_farPlane; }
+
+private:
+    ShaderManager* m_pDepthShader;
+    GLuint m_framebuffer;
+    GLuint m_depthTexture;
+    int m_resolution;
+
+    glm::vec3 m_lightPosition;
+    float m_farPlane;
+    glm::mat4 m_faceViewProjections[6];
+    Frustum m_faceFrustums[6];
+    bool m_bFaceDirty[6];
+    bool m_bHasLight;
+
+    void UpdateFaceMatrices();
+};
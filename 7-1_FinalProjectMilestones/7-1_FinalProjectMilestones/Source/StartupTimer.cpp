@@ -0,0 +1,121 @@
+///////////////////////////////////////////////////////////////////////////////
+// startuptimer.cpp
+// ============
+// time the phases from launch to the first presented frame and report them
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "StartupTimer.h"
+#include <iomanip>
+#include <iostream>
+
+/***********************************************************
+ *  StartupTimer()
+ *
+ *  The constructor for the class.  The steady clock is used
+ *  rather than the GLFW timer, which cannot be read before
+ *  GLFW is initialized.
+ ***********************************************************/
+StartupTimer::StartupTimer()
+    : m_launchTime(std::chrono::steady_clock::now()), m_phaseStart(m_launchTime),
+    m_openPhase(-1), m_movedSeconds(0.0), m_bReported(false) {
+}
+
+/***********************************************************
+ *  BeginPhase()
+ *
+ *  This method is used to start timing the named phase.  A
+ *  phase that is already open is ended first.
+ ***********************************************************/
+void StartupTimer::BeginPhase(const std::string& name) {
+    if (m_openPhase >= 0) {
+        EndPhase();
+    }
+
+    m_openPhase = FindPhase(name);
+    m_movedSeconds = 0.0;
+    m_phaseStart = std::chrono::steady_clock::now();
+}
+
+/***********************************************************
+ *  EndPhase()
+ *
+ *  This method is used to add the time since BeginPhase() to
+ *  the open phase, less the time added to other phases.
+ ***********************************************************/
+void StartupTimer::EndPhase() {
+    if (m_openPhase < 0) {
+        return;
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - m_phaseStart;
+    m_phases[m_openPhase].seconds += elapsed.count() - m_movedSeconds;
+    m_openPhase = -1;
+    m_movedSeconds = 0.0;
+}
+
+/***********************************************************
+ *  AddPhaseTime()
+ *
+ *  This method is used to add time to the named phase for
+ *  work that is done when it is first needed, which may be
+ *  inside another phase.
+ ***********************************************************/
+void StartupTimer::AddPhaseTime(const std::string& name, double seconds) {
+    if (m_bReported) {
+        return;
+    }
+
+    int phase = FindPhase(name);
+    m_phases[phase].seconds += seconds;
+    if ((m_openPhase >= 0) && (m_openPhase != phase)) {
+        m_movedSeconds += seconds;
+    }
+}
+
+/***********************************************************
+ *  Report()
+ *
+ *  This method is used to print the phases and the time from
+ *  launch.  Anything not covered by a phase is reported as
+ *  other.
+ ***********************************************************/
+void StartupTimer::Report() {
+    EndPhase();
+
+    std::chrono::duration<double> total = std::chrono::steady_clock::now() - m_launchTime;
+    double covered = 0.0;
+
+    std::cout << "STARTUP: " << std::fixed << std::setprecision(1) << total.count() * 1000.0 << " ms to the first frame" << std::endl;
+    for (size_t i = 0; i < m_phases.size(); i++) {
+        std::cout << "  " << m_phases[i].name << ": " << m_phases[i].seconds * 1000.0 << " ms" << std::endl;
+        covered += m_phases[i].seconds;
+    }
+    std::cout << "  other: " << (total.count() - covered) * 1000.0 << " ms" << std::endl;
+    std::cout.unsetf(std::ios::floatfield);
+    std::cout << std::setprecision(6);
+
+    m_bReported = true;
+}
+
+/***********************************************************
+ *  FindPhase()
+ *
+ *  This method returns the index of the named phase, adding
+ *  it after the phases seen so far when it is new.
+ ***********************************************************/
+int StartupTimer::FindPhase(const std::string& name) {
+    for (size_t i = 0; i < m_phases.size(); i++) {
+        if (m_phases[i].name == name) {
+            return (int)i;
+        }
+    }
+
+    PHASE phase;
+    phase.name = name;
+    phase.seconds = 0.0;
+    m_phases.push_back(phase);
+
+    return (int)m_phases.size() - 1;
+}
@@ -0,0 +1,47 @@
+///////////////////////////////////////////////////////////////////////////////
+// startuptimer.h
+// ============
+// time the phases from launch to the first presented frame and report them
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+class StartupTimer {
+public:
+    // constructor, the launch is timed from here
+    StartupTimer();
+
+    // time the work until EndPhase() as the named phase; phases do not nest
+    void BeginPhase(const std::string& name);
+    void EndPhase();
+
+    // add work done on demand to the named phase, such as a texture loaded
+    // on first use; the time is taken out of the phase that is open
+    void AddPhaseTime(const std::string& name, double seconds);
+
+    // print every phase in the order it was first timed and the total
+    void Report();
+    bool IsReported() const { return m_bReported; }
+
+private:
+    // struct to hold the time of one phase
+    struct PHASE {
+        std::string name;
+        double seconds;
+    };
+
+    std::chrono::steady_clock::time_point m_launchTime;
+    std::chrono::steady_clock::time_point m_phaseStart;
+    std::vector<PHASE> m_phases;
+    int m_openPhase;                  // Index of the open phase, -1 when none
+    double m_movedSeconds;            // Time added to other phases while it is open
+    bool m_bReported;
+
+    int FindPhase(const std::string& name);
+};
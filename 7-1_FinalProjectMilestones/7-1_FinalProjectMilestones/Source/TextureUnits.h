@@ -0,0 +1,19 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureunits.h
+// ============
+// texture units reserved for the render passes
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// the scene textures are bound once to units 0 - 15 by the scene manager,
+// so the render passes sample their own inputs from the units above them
+enum TEXTURE_UNIT {
+    TEXTURE_UNIT_HIZ_SOURCE = 16,     // scene depth read by the hierarchical depth build
+    TEXTURE_UNIT_SHADOW_MAP = 17,     // primary light shadow cube map
+    TEXTURE_UNIT_IMPOSTOR_ATLAS = 18, // captured views of the impostor groups
+    TEXTURE_UNIT_OIT_ACCUMULATION = 19, // weighted translucent color sum
+    TEXTURE_UNIT_OIT_REVEALAGE = 20   // product of the translucent transmittance
+};
@@ -0,0 +1,201 @@
+///////////////////////////////////////////////////////////////////////////////
+// transparencybuffer.cpp
+// ============
+// accumulate translucent surfaces in any order into weighted blended
+// transparency targets and composite them over the opaque scene
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TransparencyBuffer.h"
+#include "ResourceTracker.h"
+#include "TextureUnits.h"
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace {
+    // shader files for the composite pass
+    const char* g_FullscreenVertexShader = "Shaders/fullscreenVertexShader.glsl";
+    const char* g_CompositeFragmentShader = "Shaders/oitCompositeFragmentShader.glsl";
+}
+
+/***********************************************************
+ *  TransparencyBuffer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TransparencyBuffer::TransparencyBuffer()
+    : m_pCompositeShader(nullptr), m_emptyVAO(0), m_framebuffer(0), m_accumulationTexture(0),
+    m_revealageTexture(0), m_depthTexture(0), m_width(0), m_height(0) {
+}
+
+/***********************************************************
+ *  ~TransparencyBuffer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TransparencyBuffer::~TransparencyBuffer() {
+    if (m_framebuffer != 0) {
+        glDeleteFramebuffers(1, &m_framebuffer);
+    }
+    if (m_accumulationTexture != 0) {
+        ResourceTracker::Release(ResourceTracker::CATEGORY_TEXTURE, m_accumulationTexture);
+        glDeleteTextures(1, &m_accumulationTexture);
+    }
+    if (m_revealageTexture != 0) {
+        ResourceTracker::Release(ResourceTracker::CATEGORY_TEXTURE, m_revealageTexture);
+        glDeleteTextures(1, &m_revealageTexture);
+    }
+    if (m_emptyVAO != 0) {
+        glDeleteVertexArrays(1, &m_emptyVAO);
+    }
+    if (m_pCompositeShader) {
+        ResourceTracker::DeleteProgram(m_pCompositeShader->m_programID);
+        delete m_pCompositeShader;
+        m_pCompositeShader = nullptr;
+    }
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used to load the composite shaders and
+ *  create the objects used by the fullscreen pass.
+ ***********************************************************/
+bool TransparencyBuffer::Initialize() {
+    m_pCompositeShader = new ShaderManager();
+    if (m_pCompositeShader->LoadShaders(g_FullscreenVertexShader, g_CompositeFragmentShader) == 0) {
+        std::cout << "Error: Transparency composite shaders failed to load" << std::endl;
+        delete m_pCompositeShader;
+        m_pCompositeShader = nullptr;
+        return false;
+    }
+    ResourceTracker::TrackProgram(m_pCompositeShader->m_programID, "transparency composite");
+
+    // core profile draws need a bound vertex array even without attributes
+    glGenVertexArrays(1, &m_emptyVAO);
+
+    return true;
+}
+
+/***********************************************************
+ *  ResizeTargets()
+ *
+ *  This method is used to (re)allocate the accumulation and
+ *  revealage targets at the size of the scene depth, which
+ *  is attached so the translucent surfaces are hidden by
+ *  the opaque ones in front of them.
+ ***********************************************************/
+bool TransparencyBuffer::ResizeTargets(GLuint depthTexture, int width, int height) {
+    if ((width == m_width) && (height == m_height) && (depthTexture == m_depthTexture) && (m_framebuffer != 0)) {
+        return true;
+    }
+
+    // the weighted sums need more range than 8 bits, the coverage does not
+    if (m_accumulationTexture == 0) {
+        glGenTextures(1, &m_accumulationTexture);
+    }
+    glBindTexture(GL_TEXTURE_2D, m_accumulationTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_HALF_FLOAT, nullptr);
+    ResourceTracker::TrackTexture(m_accumulationTexture, GL_RGBA16F, width, height, 1, 1, "transparency targets");
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    if (m_revealageTexture == 0) {
+        glGenTextures(1, &m_revealageTexture);
+    }
+    glBindTexture(GL_TEXTURE_2D, m_revealageTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, width, height, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+    ResourceTracker::TrackTexture(m_revealageTexture, GL_R8, width, height, 1, 1, "transparency targets");
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    if (m_framebuffer == 0) {
+        glGenFramebuffers(1, &m_framebuffer);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_accumulationTexture, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, m_revealageTexture, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+    const GLenum drawBuffers[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+    glDrawBuffers(2, drawBuffers);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Error: Transparency framebuffer is incomplete, status: " << status << std::endl;
+        m_width = 0;
+        m_height = 0;
+        return false;
+    }
+
+    m_depthTexture = depthTexture;
+    m_width = width;
+    m_height = height;
+
+    return true;
+}
+
+/***********************************************************
+ *  BeginAccumulate()
+ *
+ *  This method is used to clear the transparency targets and
+ *  set the blending that lets the translucent surfaces be
+ *  drawn in any order.  The color target adds up the weighted
+ *  premultiplied colors, and the revealage target multiplies
+ *  together the transmittance of every surface.
+ ***********************************************************/
+bool TransparencyBuffer::BeginAccumulate(GLuint depthTexture, int width, int height, int viewportWidth, int viewportHeight) {
+    if ((m_pCompositeShader == nullptr) || (depthTexture == 0) || !ResizeTargets(depthTexture, width, height)) {
+        return false;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    glViewport(0, 0, viewportWidth, viewportHeight);
+
+    const GLfloat clearAccumulation[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    const GLfloat clearRevealage[4] = { 1.0f, 0.0f, 0.0f, 0.0f };
+    glClearBufferfv(GL_COLOR, 0, clearAccumulation);
+    glClearBufferfv(GL_COLOR, 1, clearRevealage);
+
+    // test against the opaque depth, but never hide one translucent
+    // surface behind another
+    glDepthMask(GL_FALSE);
+    glEnable(GL_BLEND);
+    glBlendFunci(0, GL_ONE, GL_ONE);
+    glBlendFunci(1, GL_ZERO, GL_ONE_MINUS_SRC_COLOR);
+
+    return true;
+}
+
+/***********************************************************
+ *  Composite()
+ *
+ *  This method is used to resolve the transparency targets
+ *  over the framebuffer that is bound when it is called, in
+ *  one fullscreen pass over the drawn region.
+ ***********************************************************/
+void TransparencyBuffer::Composite(int viewportWidth, int viewportHeight) {
+    glViewport(0, 0, viewportWidth, viewportHeight);
+    glDisable(GL_DEPTH_TEST);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    glActiveTexture(GL_TEXTURE0 + TEXTURE_UNIT_OIT_ACCUMULATION);
+    glBindTexture(GL_TEXTURE_2D, m_accumulationTexture);
+    glActiveTexture(GL_TEXTURE0 + TEXTURE_UNIT_OIT_REVEALAGE);
+    glBindTexture(GL_TEXTURE_2D, m_revealageTexture);
+
+    m_pCompositeShader->use();
+    m_pCompositeShader->setSampler2DValue("accumulationTexture", TEXTURE_UNIT_OIT_ACCUMULATION);
+    m_pCompositeShader->setSampler2DValue("revealageTexture", TEXTURE_UNIT_OIT_REVEALAGE);
+
+    glBindVertexArray(m_emptyVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+
+    // the opaque passes draw without blending
+    glDisable(GL_BLEND);
+    glEnable(GL_DEPTH_TEST);
+    glDepthMask(GL_TRUE);
+}
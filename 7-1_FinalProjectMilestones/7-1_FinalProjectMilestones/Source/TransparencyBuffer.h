@@ -0,0 +1,43 @@
+///////////////////////////////////////////////////////////////////////////////
+// transparencybuffer.h
+// ============
+// accumulate translucent surfaces in any order into weighted blended
+// transparency targets and composite them over the opaque scene
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+#include <GL/glew.h>
+
+class TransparencyBuffer {
+public:
+    // constructor
+    TransparencyBuffer();
+    // destructor
+    ~TransparencyBuffer();
+
+    // load the composite shaders
+    bool Initialize();
+
+    // direct rendering into the accumulation and revealage targets, testing
+    // against the passed in scene depth without writing it; the targets
+    // follow the size of the depth texture
+    bool BeginAccumulate(GLuint depthTexture, int width, int height, int viewportWidth, int viewportHeight);
+    // blend the averaged translucent color over the bound framebuffer
+    void Composite(int viewportWidth, int viewportHeight);
+
+private:
+    ShaderManager* m_pCompositeShader;
+    GLuint m_emptyVAO;
+    GLuint m_framebuffer;
+    GLuint m_accumulationTexture;
+    GLuint m_revealageTexture;
+    GLuint m_depthTexture;
+    int m_width;
+    int m_height;
+
+    bool ResizeTargets(GLuint depthTexture, int width, int height);
+};
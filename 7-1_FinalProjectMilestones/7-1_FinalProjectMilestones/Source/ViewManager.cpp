@@ -20,14 +20,34 @@ namespace {
     const char* g_ViewName = "view";
     const char* g_ProjectionName = "projection";
 
-    // these variables are used for mouse movement processing
-    float gLastX = WINDOW_WIDTH / 2.0f;
-    float gLastY = WINDOW_HEIGHT / 2.0f;
-    bool gFirstMouse = true;
+    // limits and tuning for the dynamic resolution controller
+    const float MIN_RENDER_SCALE = 0.5f;
+    const float MAX_RENDER_SCALE = 1.0f;
+    const float RENDER_SCALE_STEP = 0.05f;
+    const float FRAME_TIME_SMOOTHING = 0.1f;
+    const int SCALE_COOLDOWN_FRAMES = 15;
 
-    // time between current frame and last frame
-    float gDeltaTime = 0.0f;
-    float gLastFrame = 0.0f;
+    // clip planes shared by both projection modes
+    const float NEAR_PLANE = 0.1f;
+    const float FAR_PLANE = 100.0f;
+
+    // height and distance behind the target of the split view overview
+    const float OVERVIEW_HEIGHT = 40.0f;
+    const float OVERVIEW_DISTANCE = 20.0f;
+
+    // look directions and up vectors of the cube map faces, in the order
+    // and orientation of GL_TEXTURE_CUBE_MAP_POSITIVE_X onward
+    const glm::vec3 g_CubeFaceDirections[6] = {
+        glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f),
+        glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
+        glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f)
+    };
+    const glm::vec3 g_CubeFaceUps[6] = {
+        glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
+        glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f),
+        glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f)
+    };
+    const char* g_ViewModeNames[ViewManager::VIEW_MODE_COUNT] = { "single view", "split view", "cube map faces" };
 }
 
 /***********************************************************
@@ -41,7 +61,25 @@ ViewManager::ViewManager(ShaderManager* pShaderManager)
     Up(glm::vec3(0.0f, 1.0f, 0.0f)), WorldUp(glm::vec3(0.0f, 1.0f, 0.0f)),
     Target(glm::vec3(0.0f, 0.0f, 0.0f)),
     Yaw(-90.0f), Pitch(0.0f), MovementSpeed(2.5f), MouseSensitivity(0.1f), DistanceToTarget(10.0f),
-    currentProjectionMode(PERSPECTIVE), deltaTime(0.0f), lastFrame(0.0f) {
+    currentProjectionMode(PERSPECTIVE), deltaTime(0.0f), lastFrame(0.0f),
+    m_windowWidth(WINDOW_WIDTH), m_windowHeight(WINDOW_HEIGHT),
+    m_pSceneTarget(nullptr), m_bDynamicResolution(false),
+    m_renderScale(1.0f), m_targetFrameTime(1.0f / 60.0f), m_smoothedGpuTime(1.0f / 60.0f),
+    m_scaleCooldownFrames(0), m_nextRenderQuery(0), m_bRenderTimed(false), m_viewMatrix(1.0f), m_projectionMatrix(1.0f),
+    m_viewMode(VIEW_SINGLE), m_viewCount(0),
+    m_lastCursorX(0.0), m_lastCursorY(0.0), m_bFirstMouse(true),
+    m_pendingMouseX(0.0f), m_pendingMouseY(0.0f), m_pendingScroll(0.0f), m_pendingMovement(0.0f),
+    m_pendingEvents(0), m_pendingInputTime(-1.0), m_frameInputTime(-1.0),
+    m_nextLatencyFence(0), m_pFrameStats(nullptr) {
+    for (int i = 0; i < LATENCY_RING_SIZE; i++) {
+        m_latencyFences[i] = 0;
+        m_latencyInputTimes[i] = 0.0;
+    }
+    for (int i = 0; i < RENDER_QUERY_RING_SIZE; i++) {
+        m_renderQueries[i][0] = 0;
+        m_renderQueries[i][1] = 0;
+        m_bRenderQueryPending[i] = false;
+    }
     updateCameraVectors();
 }
 
@@ -52,6 +90,19 @@ ViewManager::ViewManager(ShaderManager* pShaderManager)
  ***********************************************************/
 ViewManager::~ViewManager() {
     // free up allocated memory
+    if (m_pSceneTarget) {
+        delete m_pSceneTarget;
+        m_pSceneTarget = nullptr;
+    }
+    for (int i = 0; i < LATENCY_RING_SIZE; i++) {
+        if (m_latencyFences[i] != 0) {
+            glDeleteSync(m_latencyFences[i]);
+            m_latencyFences[i] = 0;
+        }
+    }
+    if (m_renderQueries[0][0] != 0) {
+        glDeleteQueries(RENDER_QUERY_RING_SIZE * 2, &m_renderQueries[0][0]);
+    }
     m_pShaderManager = nullptr;
     m_pWindow = nullptr;
 }
@@ -72,10 +123,16 @@ GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle) {
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
     glfwSetCursorPosCallback(window, Mouse_Position_Callback);
     glfwSetScrollCallback(window, Mouse_Scroll_Callback);
-    glEnable(GL_BLEND);
+    glfwSetKeyCallback(window, Key_Callback);
+    glfwSetFramebufferSizeCallback(window, Framebuffer_Size_Callback);
+    // opaque objects draw without blending, the translucent pass enables it
+    glDisable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     m_pWindow = window;
     glfwSetWindowUserPointer(window, this);
+
+    // the framebuffer can differ from the requested window size on high DPI displays
+    glfwGetFramebufferSize(window, &m_windowWidth, &m_windowHeight);
     return window;
 }
 
@@ -84,23 +141,27 @@ GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle) {
  *
  *  This method is automatically called from GLFW whenever
  *  the mouse is moved within the active GLFW display window.
+ *  The motion is only accumulated here, since many events
+ *  can arrive per frame; the camera is updated once before
+ *  the view matrix is built.
  ***********************************************************/
 void ViewManager::Mouse_Position_Callback(GLFWwindow* window, double xMousePos, double yMousePos) {
     ViewManager* viewManager = static_cast<ViewManager*>(glfwGetWindowUserPointer(window));
     if (viewManager) {
-        if (gFirstMouse) {
-            gLastX = xMousePos;
-            gLastY = yMousePos;
-            gFirstMouse = false;
+        if (viewManager->m_bFirstMouse) {
+            viewManager->m_lastCursorX = xMousePos;
+            viewManager->m_lastCursorY = yMousePos;
+            viewManager->m_bFirstMouse = false;
         }
 
-        float xOffset = xMousePos - gLastX;
-        float yOffset = gLastY - yMousePos; // reversed since y-coordinates range from bottom to top
+        viewManager->m_pendingMouseX += (float)(xMousePos - viewManager->m_lastCursorX);
+        // reversed since y-coordinates range from bottom to top
+        viewManager->m_pendingMouseY += (float)(viewManager->m_lastCursorY - yMousePos);
 
-        gLastX = xMousePos;
-        gLastY = yMousePos;
+        viewManager->m_lastCursorX = xMousePos;
+        viewManager->m_lastCursorY = yMousePos;
 
-        viewManager->ProcessMouseMovement(xOffset, yOffset);
+        viewManager->MarkInputEvent();
     }
 }
 
@@ -113,7 +174,60 @@ void ViewManager::Mouse_Position_Callback(GLFWwindow* window, double xMousePos,
 void ViewManager::Mouse_Scroll_Callback(GLFWwindow* window, double xOffset, double yOffset) {
     ViewManager* viewManager = static_cast<ViewManager*>(glfwGetWindowUserPointer(window));
     if (viewManager) {
-        viewManager->ProcessMouseScroll(yOffset);
+        viewManager->m_pendingScroll += (float)yOffset;
+        viewManager->MarkInputEvent();
+    }
+}
+
+/***********************************************************
+ *  Key_Callback()
+ *
+ *  This method is automatically called from GLFW whenever a
+ *  key changes state.  The keys are still polled, so presses
+ *  are only timestamped for the latency measurement.
+ ***********************************************************/
+void ViewManager::Key_Callback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+    ViewManager* viewManager = static_cast<ViewManager*>(glfwGetWindowUserPointer(window));
+    if (viewManager && (action == GLFW_PRESS)) {
+        viewManager->MarkInputEvent();
+    }
+}
+
+/***********************************************************
+ *  MarkInputEvent()
+ *
+ *  This method is used to count an input event and remember
+ *  the arrival time of the oldest one not yet applied.
+ ***********************************************************/
+void ViewManager::MarkInputEvent() {
+    if (m_pendingInputTime < 0.0) {
+        m_pendingInputTime = glfwGetTime();
+    }
+    m_pendingEvents++;
+}
+
+/***********************************************************
+ *  Framebuffer_Size_Callback()
+ *
+ *  This method is automatically called from GLFW whenever
+ *  the display window is resized.  The viewport follows the
+ *  new size and the offscreen scene target is reallocated.
+ ***********************************************************/
+void ViewManager::Framebuffer_Size_Callback(GLFWwindow* window, int width, int height) {
+    ViewManager* viewManager = static_cast<ViewManager*>(glfwGetWindowUserPointer(window));
+    if (viewManager) {
+        // a minimized window reports a zero size, so keep the last usable one
+        if ((width <= 0) || (height <= 0)) {
+            return;
+        }
+
+        viewManager->m_windowWidth = width;
+        viewManager->m_windowHeight = height;
+        glViewport(0, 0, width, height);
+
+        if (viewManager->m_pSceneTarget) {
+            viewManager->m_pSceneTarget->Resize(width, height);
+        }
     }
 }
 
@@ -121,30 +235,52 @@ void ViewManager::Mouse_Scroll_Callback(GLFWwindow* window, double xOffset, doub
  *  ProcessKeyboardEvents()
  *
  *  This method is called to process any keyboard events
- *  that may be waiting in the event queue.
+ *  that may be waiting in the event queue.  The camera
+ *  movement is accumulated and applied with the mouse input.
  ***********************************************************/
 void ViewManager::ProcessKeyboardEvents() {
     if (glfwGetKey(m_pWindow, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
         glfwSetWindowShouldClose(m_pWindow, true);
     }
 
+    glm::vec3 movement(0.0f);
     if (glfwGetKey(m_pWindow, GLFW_KEY_W) == GLFW_PRESS)
-        ProcessKeyboard(0, gDeltaTime);
+        movement += Front;
     if (glfwGetKey(m_pWindow, GLFW_KEY_S) == GLFW_PRESS)
-        ProcessKeyboard(1, gDeltaTime);
+        movement -= Front;
     if (glfwGetKey(m_pWindow, GLFW_KEY_A) == GLFW_PRESS)
-        ProcessKeyboard(2, gDeltaTime);
+        movement -= Right;
     if (glfwGetKey(m_pWindow, GLFW_KEY_D) == GLFW_PRESS)
-        ProcessKeyboard(3, gDeltaTime);
+        movement += Right;
     if (glfwGetKey(m_pWindow, GLFW_KEY_Q) == GLFW_PRESS)
-        ProcessKeyboard(4, gDeltaTime);
+        movement += Up;
     if (glfwGetKey(m_pWindow, GLFW_KEY_E) == GLFW_PRESS)
-        ProcessKeyboard(5, gDeltaTime);
+        movement -= Up;
+    m_pendingMovement += movement * (MovementSpeed * deltaTime);
 
     if (glfwGetKey(m_pWindow, GLFW_KEY_P) == GLFW_PRESS)
         SetProjectionMode(PERSPECTIVE);
     if (glfwGetKey(m_pWindow, GLFW_KEY_O) == GLFW_PRESS)
         SetProjectionMode(ORTHOGRAPHIC);
+
+    // toggle dynamic resolution once per key press
+    if (WasKeyPressed(GLFW_KEY_R))
+        SetDynamicResolution(!m_bDynamicResolution, m_targetFrameTime);
+}
+
+/***********************************************************
+ *  WasKeyPressed()
+ *
+ *  This method returns true only on the first poll after the
+ *  passed in key goes down, which is used for toggles.  Each
+ *  key should be polled once per frame.
+ ***********************************************************/
+bool ViewManager::WasKeyPressed(int key) {
+    bool bDown = (glfwGetKey(m_pWindow, key) == GLFW_PRESS);
+    bool bWasDown = m_keyStates[key];
+    m_keyStates[key] = bDown;
+
+    return (bDown && !bWasDown);
 }
 
 /***********************************************************
@@ -152,24 +288,30 @@ void ViewManager::ProcessKeyboardEvents() {
  *
  *  This method is used for preparing the 3D scene by loading
  *  the shapes, textures in memory to support the 3D scene
- *  rendering
+ *  rendering.  The input is polled here, as late as possible
+ *  before the frame is submitted, and applied before the
+ *  view matrix is built so it shows in this frame.
  ***********************************************************/
 void ViewManager::PrepareSceneView() {
-    glm::mat4 view = glm::lookAt(Position, Target, Up);
-    glm::mat4 projection;
+    glfwPollEvents();
+    CollectLatencyFences();
 
     float currentFrame = glfwGetTime();
-    gDeltaTime = currentFrame - gLastFrame;
-    gLastFrame = currentFrame;
+    deltaTime = currentFrame - lastFrame;
+    lastFrame = currentFrame;
 
     ProcessKeyboardEvents();
+    ApplyPendingInput();
 
-    if (currentProjectionMode == PERSPECTIVE) {
-        projection = glm::perspective(glm::radians(45.0f), (float)WINDOW_WIDTH / (float)WINDOW_HEIGHT, 0.1f, 100.0f);
-    }
-    else if (currentProjectionMode == ORTHOGRAPHIC) {
-        projection = glm::ortho(-10.0f, 10.0f, -10.0f, 10.0f, 0.1f, 100.0f);
-    }
+    glm::mat4 view = glm::lookAt(Position, Target, Up);
+
+    // the render region keeps the window aspect ratio at any render scale
+    float aspectRatio = (float)m_windowWidth / (float)m_windowHeight;
+    glm::mat4 projection = CameraProjection(aspectRatio);
+
+    m_viewMatrix = view;
+    m_projectionMatrix = projection;
+    BuildViews();
 
     if (m_pShaderManager) {
         m_pShaderManager->setMat4Value(g_ViewName, view);
@@ -178,6 +320,372 @@ void ViewManager::PrepareSceneView() {
     }
 }
 
+/***********************************************************
+ *  SetViewMode()
+ *
+ *  This method is used to select the views drawn each frame.
+ ***********************************************************/
+void ViewManager::SetViewMode(VIEW_MODE mode) {
+    m_viewMode = mode;
+    std::cout << "INFO: View mode: " << g_ViewModeNames[mode] << std::endl;
+}
+
+/***********************************************************
+ *  BuildViews()
+ *
+ *  This method is used to build the views of the current
+ *  mode from the camera.  The split view puts the camera on
+ *  the left, in the current projection mode, and a
+ *  perspective overview looking down on its target on the
+ *  right.  The cube faces share the camera position and are
+ *  laid out three by two in square regions; they are always
+ *  perspective, since together they cover every direction.
+ ***********************************************************/
+void ViewManager::BuildViews() {
+    float aspectRatio = (float)m_windowWidth / (float)m_windowHeight;
+
+    if (m_viewMode == VIEW_SPLIT) {
+        glm::mat4 overviewProjection = glm::perspective(glm::radians(45.0f), aspectRatio * 0.5f, NEAR_PLANE, FAR_PLANE);
+
+        m_views[0].view = m_viewMatrix;
+        m_views[0].projection = CameraProjection(aspectRatio * 0.5f);
+        m_views[0].position = Position;
+        m_views[0].region = glm::vec4(0.0f, 0.0f, 0.5f, 1.0f);
+
+        glm::vec3 back = glm::vec3(Position.x - Target.x, 0.0f, Position.z - Target.z);
+        back = (glm::length(back) > 0.001f) ? glm::normalize(back) : glm::vec3(0.0f, 0.0f, 1.0f);
+        glm::vec3 eye = Target + back * OVERVIEW_DISTANCE + glm::vec3(0.0f, OVERVIEW_HEIGHT, 0.0f);
+
+        m_views[1].view = glm::lookAt(eye, Target, WorldUp);
+        m_views[1].projection = overviewProjection;
+        m_views[1].position = eye;
+        m_views[1].region = glm::vec4(0.5f, 0.0f, 0.5f, 1.0f);
+        m_viewCount = 2;
+    }
+    else if (m_viewMode == VIEW_CUBE) {
+        glm::mat4 faceProjection = glm::perspective(glm::radians(90.0f), 1.0f, NEAR_PLANE, FAR_PLANE);
+
+        // the largest square tile that fits three across and two down
+        float tile = glm::min(m_windowWidth / 3.0f, m_windowHeight / 2.0f);
+        glm::vec2 tileSize(tile / m_windowWidth, tile / m_windowHeight);
+        for (int face = 0; face < 6; face++) {
+            m_views[face].view = glm::lookAt(Position, Position + g_CubeFaceDirections[face], g_CubeFaceUps[face]);
+            m_views[face].projection = faceProjection;
+            m_views[face].position = Position;
+            m_views[face].region = glm::vec4((face % 3) * tileSize.x, (face / 3) * tileSize.y, tileSize.x, tileSize.y);
+        }
+        m_viewCount = 6;
+    }
+    else {
+        m_views[0].view = m_viewMatrix;
+        m_views[0].projection = m_projectionMatrix;
+        m_views[0].position = Position;
+        m_views[0].region = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+        m_viewCount = 1;
+    }
+}
+
+/***********************************************************
+ *  CameraProjection()
+ *
+ *  This method is used to build the camera projection of the
+ *  current projection mode for the passed in aspect ratio.
+ ***********************************************************/
+glm::mat4 ViewManager::CameraProjection(float aspectRatio) const {
+    if (currentProjectionMode == ORTHOGRAPHIC) {
+        return(glm::ortho(-10.0f * aspectRatio, 10.0f * aspectRatio, -10.0f, 10.0f, NEAR_PLANE, FAR_PLANE));
+    }
+
+    return(glm::perspective(glm::radians(45.0f), aspectRatio, NEAR_PLANE, FAR_PLANE));
+}
+
+/***********************************************************
+ *  GetViewport()
+ *
+ *  This method is used to turn the region of a view into
+ *  pixels of the scaled render region.
+ ***********************************************************/
+void ViewManager::GetViewport(int index, int& x, int& y, int& width, int& height) const {
+    const glm::vec4& region = m_views[index].region;
+    int renderWidth = RenderWidth();
+    int renderHeight = RenderHeight();
+
+    x = (int)(region.x * renderWidth);
+    y = (int)(region.y * renderHeight);
+    width = glm::max(1, (int)((region.x + region.z) * renderWidth) - x);
+    height = glm::max(1, (int)((region.y + region.w) * renderHeight) - y);
+}
+
+/***********************************************************
+ *  ApplyPendingInput()
+ *
+ *  This method is used for applying the movement, mouse
+ *  motion and scrolling accumulated since the last frame,
+ *  so the camera vectors are rebuilt once per frame rather
+ *  than once per event.
+ ***********************************************************/
+void ViewManager::ApplyPendingInput() {
+    bool bCameraChanged = false;
+
+    if (m_pendingMovement != glm::vec3(0.0f)) {
+        Target += m_pendingMovement;
+        m_pendingMovement = glm::vec3(0.0f);
+        bCameraChanged = true;
+    }
+    if ((m_pendingMouseX != 0.0f) || (m_pendingMouseY != 0.0f)) {
+        ProcessMouseMovement(m_pendingMouseX, m_pendingMouseY);
+        m_pendingMouseX = 0.0f;
+        m_pendingMouseY = 0.0f;
+        bCameraChanged = true;
+    }
+    if (m_pendingScroll != 0.0f) {
+        ProcessMouseScroll(m_pendingScroll);
+        m_pendingScroll = 0.0f;
+    }
+
+    if (bCameraChanged) {
+        updateCameraVectors();
+    }
+
+    if (m_pFrameStats) {
+        m_pFrameStats->AddCount("input events", m_pendingEvents);
+    }
+    m_pendingEvents = 0;
+
+    // the oldest event applied this frame is timed until the frame is presented
+    m_frameInputTime = m_pendingInputTime;
+    m_pendingInputTime = -1.0;
+}
+
+/***********************************************************
+ *  FramePresented()
+ *
+ *  This method is used to place a fence after the swap of a
+ *  frame that applied input.  Once the GPU passes the fence
+ *  the frame has been presented, and the time since its
+ *  oldest input event is the input to present latency.  The
+ *  fences are only checked once or twice per frame, so the
+ *  measurement can be late by up to that polling interval.
+ ***********************************************************/
+void ViewManager::FramePresented() {
+    if (m_frameInputTime >= 0.0) {
+        // skip the measurement rather than wait when the ring is full
+        if (m_latencyFences[m_nextLatencyFence] == 0) {
+            m_latencyFences[m_nextLatencyFence] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            m_latencyInputTimes[m_nextLatencyFence] = m_frameInputTime;
+            m_nextLatencyFence = (m_nextLatencyFence + 1) % LATENCY_RING_SIZE;
+        }
+        m_frameInputTime = -1.0;
+    }
+
+    CollectLatencyFences();
+}
+
+/***********************************************************
+ *  CollectLatencyFences()
+ *
+ *  This method is used to read back the latency fences that
+ *  the GPU has passed, without waiting for the others.
+ ***********************************************************/
+void ViewManager::CollectLatencyFences() {
+    for (int i = 0; i < LATENCY_RING_SIZE; i++) {
+        if (m_latencyFences[i] == 0) {
+            continue;
+        }
+
+        GLenum result = glClientWaitSync(m_latencyFences[i], 0, 0);
+        if ((result == GL_ALREADY_SIGNALED) || (result == GL_CONDITION_SATISFIED)) {
+            if (m_pFrameStats) {
+                m_pFrameStats->AddSample("input latency ms", (glfwGetTime() - m_latencyInputTimes[i]) * 1000.0);
+            }
+            glDeleteSync(m_latencyFences[i]);
+            m_latencyFences[i] = 0;
+        }
+    }
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used to direct the scene rendering into
+ *  the offscreen target.  When dynamic resolution is enabled
+ *  only a scaled region of the target is drawn.
+ ***********************************************************/
+void ViewManager::BeginFrame() {
+    if (m_pSceneTarget == nullptr) {
+        m_pSceneTarget = new RenderTarget();
+        if (!m_pSceneTarget->Create(m_windowWidth, m_windowHeight)) {
+            delete m_pSceneTarget;
+            m_pSceneTarget = nullptr;
+        }
+    }
+
+    UpdateRenderScale();
+
+    if (m_pSceneTarget) {
+        m_pSceneTarget->Bind(RenderWidth(), RenderHeight());
+    }
+    else {
+        // fall back to drawing straight into the window
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(0, 0, m_windowWidth, m_windowHeight);
+    }
+
+    // timestamps rather than an elapsed time query, which would keep the
+    // passes inside the frame from timing themselves, as those cannot nest
+    m_bRenderTimed = false;
+    if (m_bDynamicResolution) {
+        if (m_renderQueries[0][0] == 0) {
+            glGenQueries(RENDER_QUERY_RING_SIZE * 2, &m_renderQueries[0][0]);
+        }
+        if (!m_bRenderQueryPending[m_nextRenderQuery]) {
+            glQueryCounter(m_renderQueries[m_nextRenderQuery][0], GL_TIMESTAMP);
+            m_bRenderTimed = true;
+        }
+    }
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used to upscale the rendered scene region
+ *  into the display window before the buffers are swapped.
+ ***********************************************************/
+void ViewManager::EndFrame() {
+    if (m_bRenderTimed) {
+        glQueryCounter(m_renderQueries[m_nextRenderQuery][1], GL_TIMESTAMP);
+        m_bRenderQueryPending[m_nextRenderQuery] = true;
+        m_nextRenderQuery = (m_nextRenderQuery + 1) % RENDER_QUERY_RING_SIZE;
+        m_bRenderTimed = false;
+    }
+
+    if (m_pSceneTarget) {
+        m_pSceneTarget->BlitToDefault(RenderWidth(), RenderHeight(), m_windowWidth, m_windowHeight);
+    }
+}
+
+/***********************************************************
+ *  SetDynamicResolution()
+ *
+ *  This method is used to enable or disable scaling of the
+ *  render resolution toward the passed in frame time.
+ ***********************************************************/
+void ViewManager::SetDynamicResolution(bool bEnable, float targetFrameTime) {
+    m_bDynamicResolution = bEnable;
+    m_targetFrameTime = targetFrameTime;
+    m_smoothedGpuTime = targetFrameTime;
+    m_scaleCooldownFrames = 0;
+
+    if (!bEnable) {
+        m_renderScale = MAX_RENDER_SCALE;
+    }
+
+    std::cout << "INFO: Dynamic resolution " << (bEnable ? "enabled" : "disabled")
+        << ", target frame time: " << (targetFrameTime * 1000.0f) << " ms" << std::endl;
+}
+
+/***********************************************************
+ *  UpdateRenderScale()
+ *
+ *  This method is used to move the render scale toward the
+ *  target frame time.  The GPU time of the scene render is
+ *  used rather than the presented frame time, which vsync
+ *  holds at the target however much headroom is left, so
+ *  the scale could never grow back.  The time is smoothed,
+ *  and after each change the scale is held for a few
+ *  measurements so that it can settle before the next one.
+ ***********************************************************/
+void ViewManager::UpdateRenderScale() {
+    if (!m_bDynamicResolution) {
+        return;
+    }
+
+    // read the finished timestamp pairs, oldest first
+    bool bMeasured = false;
+    for (int i = 0; i < RENDER_QUERY_RING_SIZE; i++) {
+        int slot = (m_nextRenderQuery + i) % RENDER_QUERY_RING_SIZE;
+        if (!m_bRenderQueryPending[slot]) {
+            continue;
+        }
+
+        GLint available = 0;
+        glGetQueryObjectiv(m_renderQueries[slot][1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            break;
+        }
+
+        GLuint64 start = 0;
+        GLuint64 end = 0;
+        glGetQueryObjectui64v(m_renderQueries[slot][0], GL_QUERY_RESULT, &start);
+        glGetQueryObjectui64v(m_renderQueries[slot][1], GL_QUERY_RESULT, &end);
+        m_bRenderQueryPending[slot] = false;
+
+        float gpuTime = (float)((end - start) * 1.0e-9);
+        m_smoothedGpuTime += (gpuTime - m_smoothedGpuTime) * FRAME_TIME_SMOOTHING;
+        bMeasured = true;
+    }
+    if (!bMeasured) {
+        return;
+    }
+
+    if (m_scaleCooldownFrames > 0) {
+        m_scaleCooldownFrames--;
+        return;
+    }
+
+    float newScale = m_renderScale;
+    if (m_smoothedGpuTime > m_targetFrameTime * 1.05f) {
+        // fragment cost follows the pixel count, so shrink by the square root of the overrun
+        float ratio = sqrt(m_targetFrameTime / m_smoothedGpuTime);
+        newScale = glm::min(m_renderScale * ratio, m_renderScale - RENDER_SCALE_STEP);
+    }
+    else if (m_smoothedGpuTime < m_targetFrameTime * 0.85f) {
+        newScale = m_renderScale + RENDER_SCALE_STEP;
+    }
+
+    newScale = glm::clamp(newScale, MIN_RENDER_SCALE, MAX_RENDER_SCALE);
+    if (newScale != m_renderScale) {
+        m_renderScale = newScale;
+        m_scaleCooldownFrames = SCALE_COOLDOWN_FRAMES;
+    }
+}
+
+/***********************************************************
+ *  RenderWidth()
+ *
+ *  This method returns the width of the scaled render region.
+ ***********************************************************/
+int ViewManager::RenderWidth() const {
+    return glm::max(1, (int)(m_windowWidth * m_renderScale));
+}
+
+/***********************************************************
+ *  RenderHeight()
+ *
+ *  This method returns the height of the scaled render region.
+ ***********************************************************/
+int ViewManager::RenderHeight() const {
+    return glm::max(1, (int)(m_windowHeight * m_renderScale));
+}
+
+/***********************************************************
+ *  NearPlane()
+ *
+ *  This method returns the distance to the near clip plane.
+ ***********************************************************/
+float ViewManager::NearPlane() const {
+    return NEAR_PLANE;
+}
+
+/***********************************************************
+ *  FarPlane()
+ *
+ *  This method returns the distance to the far clip plane.
+ ***********************************************************/
+float ViewManager::FarPlane() const {
+    return FAR_PLANE;
+}
+
 /***********************************************************
  *  ProcessKeyboard()
  *
@@ -201,6 +709,38 @@ void ViewManager::ProcessKeyboard(int direction, float deltaTime) {
     updateCameraVectors();
 }
 
+/***********************************************************
+ *  ShiftOrigin()
+ *
+ *  This method moves the camera and its target by the
+ *  passed in offset and rebuilds the view matrix and the
+ *  views built from it, so that the rest of the frame sees
+ *  the camera where the moved world expects it.
+ ***********************************************************/
+void ViewManager::ShiftOrigin(const glm::vec3& offset) {
+    Position += offset;
+    Target += offset;
+    m_viewMatrix = glm::lookAt(Position, Target, Up);
+    BuildViews();
+}
+
+/***********************************************************
+ *  GetCameraRay()
+ *
+ *  This method is used to find the ray through a point of
+ *  the view by moving the point on the near and the far
+ *  plane back through the camera matrices, which works for
+ *  both projection modes.
+ ***********************************************************/
+void ViewManager::GetCameraRay(float ndcX, float ndcY, glm::vec3& origin, glm::vec3& direction) const {
+    glm::mat4 inverseViewProjection = glm::inverse(m_projectionMatrix * m_viewMatrix);
+    glm::vec4 nearPoint = inverseViewProjection * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+    glm::vec4 farPoint = inverseViewProjection * glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+
+    origin = glm::vec3(nearPoint) / nearPoint.w;
+    direction = glm::normalize(glm::vec3(farPoint) / farPoint.w - origin);
+}
+
 /***********************************************************
  *  SetProjectionMode()
  *
@@ -217,7 +757,7 @@ void ViewManager::SetProjectionMode(ViewManager::ProjectionMode mode) {
  *  This method returns the time between frames.
  ***********************************************************/
 float ViewManager::DeltaTime() const {
-    return gDeltaTime;
+    return deltaTime;
 }
 
 /***********************************************************
@@ -240,7 +780,8 @@ void ViewManager::updateCameraVectors() {
  *  ProcessMouseMovement()
  *
  *  This method processes mouse movement to update the camera
- *  orientation.
+ *  orientation.  The camera vectors are rebuilt by the
+ *  caller once all of the frame's input is applied.
  ***********************************************************/
 void ViewManager::ProcessMouseMovement(float xOffset, float yOffset, bool constrainPitch) {
     xOffset *= MouseSensitivity;
@@ -255,8 +796,6 @@ void ViewManager::ProcessMouseMovement(float xOffset, float yOffset, bool constr
         if (Pitch < -89.0f)
             Pitch = -89.0f;
     }
-
-    updateCameraVectors();
 }
 
 /***********************************************************
@@ -10,14 +10,36 @@
 #pragma once
 
 #include "ShaderManager.h"
+#include "RenderTarget.h"
+#include "FrameStats.h"
 #include <glm/glm.hpp>
 #include <GLFW/glfw3.h>
+#include <unordered_map>
 
 class ViewManager {
 public:
     // Enum for Projection Mode
     enum ProjectionMode { PERSPECTIVE, ORTHOGRAPHIC };
 
+    // Enum for the sets of views drawn each frame
+    enum VIEW_MODE {
+        VIEW_SINGLE,      // The camera across the whole window
+        VIEW_SPLIT,       // The camera beside an overview from above
+        VIEW_CUBE,        // Six cube map faces around the camera
+        VIEW_MODE_COUNT
+    };
+
+    // most views drawn in one frame
+    static const int MAX_VIEWS = 6;
+
+    // Struct to hold one camera definition and the region it is drawn into
+    struct VIEW {
+        glm::mat4 view;
+        glm::mat4 projection;
+        glm::vec3 position;
+        glm::vec4 region;         // x, y, width and height as fractions of the render region
+    };
+
     // constructor
     ViewManager(ShaderManager* pShaderManager);
     // destructor
@@ -26,22 +48,81 @@ public:
     // mouse position callback for mouse interaction with the 3D scene
     static void Mouse_Position_Callback(GLFWwindow* window, double xMousePos, double yMousePos);
     static void Mouse_Scroll_Callback(GLFWwindow* window, double xOffset, double yOffset);
+    // key callback that only timestamps key presses for the latency measurement
+    static void Key_Callback(GLFWwindow* window, int key, int scancode, int action, int mods);
+    // framebuffer size callback for keeping the viewport and projection in sync with the window
+    static void Framebuffer_Size_Callback(GLFWwindow* window, int width, int height);
 
     // create the initial OpenGL display window
     GLFWwindow* CreateDisplayWindow(const char* windowTitle);
 
-    // prepare the conversion from 3D object display to 2D scene display
+    // poll and apply the input of this frame, then prepare the conversion
+    // from 3D object display to 2D scene display
     void PrepareSceneView();
 
+    // mark the frame as presented, call right after the buffers are swapped
+    void FramePresented();
+
+    // set the frame statistics the input counters are added to, may be null
+    void SetFrameStats(FrameStats* pFrameStats) { m_pFrameStats = pFrameStats; }
+
+    // direct rendering into the offscreen scene target at the current render scale
+    void BeginFrame();
+    // upscale the rendered scene into the display window
+    void EndFrame();
+
+    // enable or disable render scaling toward the passed in frame time (seconds)
+    void SetDynamicResolution(bool bEnable, float targetFrameTime = 1.0f / 60.0f);
+
     // process keyboard input for camera movement
     void ProcessKeyboard(int direction, float deltaTime);
 
+    // move the camera by the passed in offset when the world origin is
+    // moved, so that the view of the world stays the same
+    void ShiftOrigin(const glm::vec3& offset);
+
+    // get the ray through a point of the view in normalized device
+    // coordinates, from -1 to 1 across the window; the direction is unit
+    // length and the ray starts on the near plane
+    void GetCameraRay(float ndcX, float ndcY, glm::vec3& origin, glm::vec3& direction) const;
+
     // set projection mode
     void SetProjectionMode(ProjectionMode mode);
 
     // get delta time
     float DeltaTime() const;
 
+    // get the camera matrices and position built by PrepareSceneView()
+    const glm::mat4& GetViewMatrix() const { return m_viewMatrix; }
+    const glm::mat4& GetProjectionMatrix() const { return m_projectionMatrix; }
+    const glm::vec3& GetCameraPosition() const { return Position; }
+    // get the clip plane distances used by both projection modes
+    float NearPlane() const;
+    float FarPlane() const;
+
+    // returns true once each time the passed in key goes down
+    bool WasKeyPressed(int key);
+
+    // get the current window framebuffer size and the scaled render size
+    int WindowWidth() const { return m_windowWidth; }
+    int WindowHeight() const { return m_windowHeight; }
+    int RenderWidth() const;
+    int RenderHeight() const;
+    float RenderScale() const { return m_renderScale; }
+
+    // get the offscreen target the scene is rendered into, may be null
+    RenderTarget* GetSceneTarget() const { return m_pSceneTarget; }
+
+    // select the views drawn from the next PrepareSceneView() on
+    void SetViewMode(VIEW_MODE mode);
+    VIEW_MODE GetViewMode() const { return m_viewMode; }
+    // get the views built by PrepareSceneView(); in single view mode the
+    // only view is the camera matrices above
+    int ViewCount() const { return m_viewCount; }
+    const VIEW& GetView(int index) const { return m_views[index]; }
+    // get the pixel rectangle of a view inside the scaled render region
+    void GetViewport(int index, int& x, int& y, int& width, int& height) const;
+
 private:
     ProjectionMode currentProjectionMode;
     float deltaTime;
@@ -53,6 +134,63 @@ private:
     // active OpenGL display window
     GLFWwindow* m_pWindow;
 
+    // current size of the window framebuffer in pixels
+    int m_windowWidth;
+    int m_windowHeight;
+
+    // offscreen target the scene is rendered into before upscaling
+    RenderTarget* m_pSceneTarget;
+    // dynamic resolution state; the scale follows the GPU time of the
+    // scene render, since the presented frame time is pinned by vsync
+    bool m_bDynamicResolution;
+    float m_renderScale;
+    float m_targetFrameTime;
+    float m_smoothedGpuTime;
+    int m_scaleCooldownFrames;
+
+    // timestamps before and after the scene render, read back a few
+    // frames late so the CPU never waits on the GPU
+    static const int RENDER_QUERY_RING_SIZE = 4;
+    GLuint m_renderQueries[RENDER_QUERY_RING_SIZE][2];
+    bool m_bRenderQueryPending[RENDER_QUERY_RING_SIZE];
+    int m_nextRenderQuery;
+    bool m_bRenderTimed;              // the current frame started a timestamp pair
+
+    // camera matrices from the most recent PrepareSceneView() call
+    glm::mat4 m_viewMatrix;
+    glm::mat4 m_projectionMatrix;
+
+    // views drawn this frame
+    VIEW_MODE m_viewMode;
+    VIEW m_views[MAX_VIEWS];
+    int m_viewCount;
+
+    // last seen state of the keys polled through WasKeyPressed()
+    std::unordered_map<int, bool> m_keyStates;
+
+    // input accumulated by the callbacks and the key polling until the
+    // next PrepareSceneView() applies it in one camera update
+    double m_lastCursorX;
+    double m_lastCursorY;
+    bool m_bFirstMouse;
+    float m_pendingMouseX;
+    float m_pendingMouseY;
+    float m_pendingScroll;
+    glm::vec3 m_pendingMovement;
+    int m_pendingEvents;
+    double m_pendingInputTime;        // time of the oldest unapplied event, negative if none
+    double m_frameInputTime;          // oldest event applied in the current frame
+
+    // fences placed after the presents of frames that applied input, read
+    // back without waiting to measure the input to present latency
+    static const int LATENCY_RING_SIZE = 4;
+    GLsync m_latencyFences[LATENCY_RING_SIZE];
+    double m_latencyInputTimes[LATENCY_RING_SIZE];
+    int m_nextLatencyFence;
+
+    // frame statistics for the input counters, may be null
+    FrameStats* m_pFrameStats;
+
     // Camera attributes and methods
     glm::vec3 Position;
     glm::vec3 Front;
@@ -73,4 +211,19 @@ private:
 
     // process keyboard events for interaction with the 3D scene
     void ProcessKeyboardEvents();
+
+    // remember when the oldest input event since the last frame arrived
+    void MarkInputEvent();
+    // apply the accumulated input with a single camera update
+    void ApplyPendingInput();
+    // read back the latency fences that have been passed
+    void CollectLatencyFences();
+
+    // adjust the render scale from the measured frame time
+    void UpdateRenderScale();
+
+    // build the views of the current view mode from the camera
+    void BuildViews();
+    // get the camera projection of the current projection mode
+    glm::mat4 CameraProjection(float aspectRatio) const;
 };
\ No newline at end of file
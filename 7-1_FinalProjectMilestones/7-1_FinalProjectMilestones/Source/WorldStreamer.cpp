@@ -0,0 +1,603 @@
+///////////////////////////////////////////////////////////////////////////////
+// worldstreamer.cpp
+// ============
+// stream the chunks of a large fleet world in and out around the camera,
+// reading them from a binary world file on a background thread
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "WorldStreamer.h"
+#include <GLFW/glfw3.h>
+#include <glm/gtx/transform.hpp>
+#include <iostream>
+#include <algorithm>
+#include <random>
+#include <cmath>
+#include <cstring>
+
+// declaration of the global variables and defines
+namespace {
+    // identifies the world file and its layout
+    const char WORLD_MAGIC[4] = { 'W', 'R', 'L', 'D' };
+    const uint32_t WORLD_VERSION = 1;
+
+    // layout of the generated world, centered on the scene
+    const int WORLD_CHUNKS = 128;
+    const float WORLD_CHUNK_SIZE = 64.0f;
+    const int MAX_SHIPS_PER_CHUNK = 48;
+    const int FLEET_COUNT = 40;
+    const unsigned int WORLD_SEED = 330;
+    // the ships keep clear of the scene around the origin
+    const float HOME_CLEAR_RADIUS = 40.0f;
+
+    // chunks are loaded this many chunks around the camera, which covers
+    // the far plane, and unloaded one chunk further out so that a camera
+    // moving along a chunk edge does not load and unload the same chunks
+    const int LOAD_RADIUS = 2;
+    const int UNLOAD_RADIUS = LOAD_RADIUS + 1;
+    // uploads per frame at most, so a burst of finished chunks cannot stall
+    const int MAX_UPLOADS_PER_FRAME = 2;
+
+    const double BYTES_PER_MB = 1024.0 * 1024.0;
+}
+
+/***********************************************************
+ *  WorldStreamer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+WorldStreamer::WorldStreamer(FrameStats* pFrameStats)
+    : m_pFrameStats(pFrameStats), m_pFile(nullptr), m_bStopLoader(false),
+    m_residentBytes(0), m_pendingBytes(0), m_peakBytes(0), m_residentShips(0) {
+    memset(&m_header, 0, sizeof(m_header));
+}
+
+/***********************************************************
+ *  ~WorldStreamer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+WorldStreamer::~WorldStreamer() {
+    if (m_loader.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_bStopLoader = true;
+        }
+        m_requestReady.notify_one();
+        m_loader.join();
+    }
+
+    UnloadAll();
+
+    if (m_pFile) {
+        fclose(m_pFile);
+        m_pFile = nullptr;
+    }
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used to open the world file and read its
+ *  chunk table.  A missing file is generated first, so the
+ *  world only has to be built on the first run.
+ ***********************************************************/
+bool WorldStreamer::Initialize(const char* filename) {
+    m_pFile = fopen(filename, "rb");
+    if (!m_pFile) {
+        std::cout << "INFO: Generating world file " << filename << std::endl;
+        if (!GenerateWorld(filename)) {
+            return false;
+        }
+        m_pFile = fopen(filename, "rb");
+    }
+    if (!m_pFile) {
+        std::cout << "Error: Could not open world file " << filename << std::endl;
+        return false;
+    }
+
+    if (!ReadWorld()) {
+        std::cout << "Error: " << filename << " is not a valid world file" << std::endl;
+        fclose(m_pFile);
+        m_pFile = nullptr;
+        return false;
+    }
+
+    BuildShipShapes();
+    m_loader = std::thread(&WorldStreamer::LoaderLoop, this);
+
+    std::cout << "INFO: World " << filename << ": " << m_header.shipCount << " ships in "
+        << m_header.chunksX << "x" << m_header.chunksZ << " chunks of "
+        << m_header.chunkSize << " units" << std::endl;
+    return true;
+}
+
+/***********************************************************
+ *  GenerateWorld()
+ *
+ *  This method is used to write a world file of fleets
+ *  scattered over the whole grid.  Each fleet flies at its
+ *  own height and heading, and thins out from its center.
+ ***********************************************************/
+bool WorldStreamer::GenerateWorld(const char* filename) {
+    struct FLEET {
+        glm::vec2 center;
+        float radius;
+        float altitude;
+        float heading;
+    };
+
+    std::mt19937 generator(WORLD_SEED);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    float worldSize = WORLD_CHUNKS * WORLD_CHUNK_SIZE;
+    int firstChunk = -WORLD_CHUNKS / 2;
+
+    std::vector<FLEET> fleets(FLEET_COUNT);
+    for (size_t i = 0; i < fleets.size(); i++) {
+        fleets[i].center = glm::vec2(unit(generator) - 0.5f, unit(generator) - 0.5f) * worldSize;
+        fleets[i].radius = 300.0f + 900.0f * unit(generator);
+        fleets[i].altitude = 10.0f + 50.0f * unit(generator);
+        fleets[i].heading = 360.0f * unit(generator);
+    }
+
+    std::vector<CHUNK_ENTRY> table((size_t)WORLD_CHUNKS * WORLD_CHUNKS);
+    std::vector<SHIP_RECORD> ships;
+    for (int z = 0; z < WORLD_CHUNKS; z++) {
+        for (int x = 0; x < WORLD_CHUNKS; x++) {
+            glm::vec2 corner = glm::vec2((float)(firstChunk + x), (float)(firstChunk + z)) * WORLD_CHUNK_SIZE;
+            glm::vec2 center = corner + glm::vec2(WORLD_CHUNK_SIZE * 0.5f);
+
+            // the densest fleet over the chunk sets how its ships fly
+            float density = 0.0f;
+            const FLEET* pFleet = &fleets[0];
+            float strongest = -1.0f;
+            for (size_t f = 0; f < fleets.size(); f++) {
+                float distance = glm::length(center - fleets[f].center) / fleets[f].radius;
+                float weight = exp(-distance * distance);
+                density += weight;
+                if (weight > strongest) {
+                    strongest = weight;
+                    pFleet = &fleets[f];
+                }
+            }
+
+            CHUNK_ENTRY& entry = table[(size_t)z * WORLD_CHUNKS + x];
+            entry.offset = ships.size();
+            entry.shipCount = 0;
+            entry.reserved = 0;
+
+            int count = (int)(std::min(density, 1.0f) * MAX_SHIPS_PER_CHUNK * unit(generator));
+            for (int i = 0; i < count; i++) {
+                SHIP_RECORD ship;
+                ship.position[0] = WORLD_CHUNK_SIZE * unit(generator);
+                ship.position[1] = pFleet->altitude + 10.0f * unit(generator);
+                ship.position[2] = WORLD_CHUNK_SIZE * unit(generator);
+                ship.yawDegrees = pFleet->heading + 20.0f * (unit(generator) - 0.5f);
+                ship.scale = 0.6f + 0.8f * unit(generator);
+                ship.shipClass = (unit(generator) < 0.3f) ? 1 : 0;
+
+                glm::vec2 world = corner + glm::vec2(ship.position[0], ship.position[2]);
+                if (glm::length(world) < HOME_CLEAR_RADIUS) {
+                    continue;
+                }
+                ships.push_back(ship);
+                entry.shipCount++;
+            }
+        }
+    }
+
+    WORLD_HEADER header;
+    memcpy(header.magic, WORLD_MAGIC, sizeof(header.magic));
+    header.version = WORLD_VERSION;
+    header.firstChunkX = firstChunk;
+    header.firstChunkZ = firstChunk;
+    header.chunksX = WORLD_CHUNKS;
+    header.chunksZ = WORLD_CHUNKS;
+    header.chunkSize = WORLD_CHUNK_SIZE;
+    header.shipCount = (uint32_t)ships.size();
+
+    // the records follow the table, so the offsets are made absolute here
+    uint64_t recordStart = sizeof(WORLD_HEADER) + table.size() * sizeof(CHUNK_ENTRY);
+    for (size_t i = 0; i < table.size(); i++) {
+        table[i].offset = recordStart + table[i].offset * sizeof(SHIP_RECORD);
+    }
+
+    FILE* pFile = fopen(filename, "wb");
+    if (!pFile) {
+        std::cout << "Error: Could not create world file " << filename << std::endl;
+        return false;
+    }
+
+    bool bSuccess = (fwrite(&header, sizeof(header), 1, pFile) == 1) &&
+        (fwrite(table.data(), sizeof(CHUNK_ENTRY), table.size(), pFile) == table.size()) &&
+        (fwrite(ships.data(), sizeof(SHIP_RECORD), ships.size(), pFile) == ships.size());
+    if (fclose(pFile) != 0) {
+        bSuccess = false;
+    }
+
+    if (!bSuccess) {
+        std::cout << "Error: Could not write world file " << filename << std::endl;
+        remove(filename);
+    }
+    return bSuccess;
+}
+
+/***********************************************************
+ *  ReadWorld()
+ *
+ *  This method is used to read the header and chunk table
+ *  of the open world file.  The ship records stay on disk
+ *  until their chunk is loaded.
+ ***********************************************************/
+bool WorldStreamer::ReadWorld() {
+    if (fread(&m_header, sizeof(m_header), 1, m_pFile) != 1) {
+        return false;
+    }
+    if ((memcmp(m_header.magic, WORLD_MAGIC, sizeof(WORLD_MAGIC)) != 0) || (m_header.version != WORLD_VERSION) ||
+        (m_header.chunksX <= 0) || (m_header.chunksZ <= 0) || (m_header.chunkSize <= 0.0f)) {
+        return false;
+    }
+
+    m_table.resize((size_t)m_header.chunksX * m_header.chunksZ);
+    return (fread(m_table.data(), sizeof(CHUNK_ENTRY), m_table.size(), m_pFile) == m_table.size());
+}
+
+/***********************************************************
+ *  BuildShipShapes()
+ *
+ *  This method is used to build the ship shapes out of a
+ *  few boxes each, facing -X like the ship in the scene: a
+ *  cruiser with a saucer and two nacelles, and an escort.
+ ***********************************************************/
+void WorldStreamer::BuildShipShapes() {
+    PrimitiveGeometry box;
+    box.BuildBox();
+
+    m_shipShapes.assign(2, PrimitiveGeometry());
+
+    // cruiser
+    m_shipShapes[0].Append(box, glm::translate(glm::vec3(-0.9f, 0.35f, 0.0f)) * glm::scale(glm::vec3(1.6f, 0.15f, 1.6f)));
+    m_shipShapes[0].Append(box, glm::translate(glm::vec3(0.4f, 0.0f, 0.0f)) * glm::scale(glm::vec3(1.6f, 0.3f, 0.3f)));
+    m_shipShapes[0].Append(box, glm::translate(glm::vec3(0.8f, 0.45f, 0.45f)) * glm::scale(glm::vec3(1.4f, 0.12f, 0.12f)));
+    m_shipShapes[0].Append(box, glm::translate(glm::vec3(0.8f, 0.45f, -0.45f)) * glm::scale(glm::vec3(1.4f, 0.12f, 0.12f)));
+
+    // escort
+    m_shipShapes[1].Append(box, glm::scale(glm::vec3(1.2f, 0.25f, 0.5f)));
+    m_shipShapes[1].Append(box, glm::translate(glm::vec3(0.3f, 0.2f, 0.35f)) * glm::scale(glm::vec3(0.9f, 0.12f, 0.12f)));
+    m_shipShapes[1].Append(box, glm::translate(glm::vec3(0.3f, 0.2f, -0.35f)) * glm::scale(glm::vec3(0.9f, 0.12f, 0.12f)));
+}
+
+/***********************************************************
+ *  FindEntry()
+ *
+ *  This method returns the table entry of a chunk, or null
+ *  when the chunk lies outside the world.
+ ***********************************************************/
+const WorldStreamer::CHUNK_ENTRY* WorldStreamer::FindEntry(int chunkX, int chunkZ) const {
+    int x = chunkX - m_header.firstChunkX;
+    int z = chunkZ - m_header.firstChunkZ;
+    if ((x < 0) || (z < 0) || (x >= m_header.chunksX) || (z >= m_header.chunksZ)) {
+        return nullptr;
+    }
+
+    return &m_table[(size_t)z * m_header.chunksX + x];
+}
+
+/***********************************************************
+ *  ChunkKey()
+ *
+ *  This method returns a single key for chunk coordinates.
+ ***********************************************************/
+int64_t WorldStreamer::ChunkKey(int chunkX, int chunkZ) {
+    return ((int64_t)chunkX << 32) | (uint32_t)chunkZ;
+}
+
+/***********************************************************
+ *  ChunkOrigin()
+ *
+ *  This method returns the world position of the corner of
+ *  a resident chunk, which its vertices are relative to.
+ ***********************************************************/
+glm::dvec3 WorldStreamer::ChunkOrigin(int slot) const {
+    return glm::dvec3(
+        (double)m_chunks[slot].chunkX * m_header.chunkSize, 0.0,
+        (double)m_chunks[slot].chunkZ * m_header.chunkSize);
+}
+
+/***********************************************************
+ *  GetChunkBounds()
+ *
+ *  This method returns the bounds of the vertices of a
+ *  resident chunk, relative to the chunk corner.
+ ***********************************************************/
+void WorldStreamer::GetChunkBounds(int slot, glm::vec3& boundsMin, glm::vec3& boundsMax) const {
+    boundsMin = m_chunks[slot].boundsMin;
+    boundsMax = m_chunks[slot].boundsMax;
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used to bring the resident chunks in line
+ *  with the camera.  Chunks behind the unload radius are
+ *  released, queued requests that fell out of range are
+ *  dropped, the missing chunks in range are requested
+ *  nearest first, and a few finished chunks are uploaded.
+ ***********************************************************/
+void WorldStreamer::Update(const glm::dvec3& cameraPosition, MeshBuffer::VERTEX_LAYOUT layout) {
+    m_unloadedSlots.clear();
+    m_loadedSlots.clear();
+    if (!m_loader.joinable()) {
+        return;
+    }
+
+    int cameraX = (int)floor(cameraPosition.x / m_header.chunkSize);
+    int cameraZ = (int)floor(cameraPosition.z / m_header.chunkSize);
+    auto chunkDistance = [cameraX, cameraZ](int chunkX, int chunkZ) {
+        return std::max(std::abs(chunkX - cameraX), std::abs(chunkZ - cameraZ));
+    };
+
+    for (size_t slot = 0; slot < m_chunks.size(); slot++) {
+        if ((m_chunks[slot].pBuffer != nullptr) &&
+            (chunkDistance(m_chunks[slot].chunkX, m_chunks[slot].chunkZ) > UNLOAD_RADIUS)) {
+            UnloadSlot((int)slot);
+            m_unloadedSlots.push_back((int)slot);
+        }
+    }
+
+    // find the chunks in range that are neither resident nor on their way
+    std::vector<REQUEST> newRequests;
+    double now = glfwGetTime();
+    for (int z = cameraZ - LOAD_RADIUS; z <= cameraZ + LOAD_RADIUS; z++) {
+        for (int x = cameraX - LOAD_RADIUS; x <= cameraX + LOAD_RADIUS; x++) {
+            const CHUNK_ENTRY* pEntry = FindEntry(x, z);
+            int64_t key = ChunkKey(x, z);
+            if ((pEntry == nullptr) || (pEntry->shipCount == 0) ||
+                (m_residentKeys.count(key) != 0) || (m_requestedKeys.count(key) != 0)) {
+                continue;
+            }
+
+            REQUEST request;
+            request.chunkX = x;
+            request.chunkZ = z;
+            request.requestTime = now;
+            newRequests.push_back(request);
+            m_requestedKeys.insert(key);
+        }
+    }
+    std::sort(newRequests.begin(), newRequests.end(),
+        [&chunkDistance](const REQUEST& a, const REQUEST& b) {
+            return chunkDistance(a.chunkX, a.chunkZ) < chunkDistance(b.chunkX, b.chunkZ);
+        });
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // requests the loader has not started on are dropped once out of range
+        for (size_t i = 0; i < m_requests.size();) {
+            if (chunkDistance(m_requests[i].chunkX, m_requests[i].chunkZ) > LOAD_RADIUS) {
+                m_requestedKeys.erase(ChunkKey(m_requests[i].chunkX, m_requests[i].chunkZ));
+                m_requests.erase(m_requests.begin() + i);
+            }
+            else {
+                i++;
+            }
+        }
+        m_requests.insert(m_requests.end(), newRequests.begin(), newRequests.end());
+
+        while (!m_finished.empty()) {
+            m_pendingBytes += LoadedBytes(m_finished.front());
+            m_readyChunks.push_back(std::move(m_finished.front()));
+            m_finished.pop_front();
+        }
+    }
+    if (!newRequests.empty()) {
+        m_requestReady.notify_one();
+    }
+
+    int uploads = 0;
+    while (!m_readyChunks.empty() && (uploads < MAX_UPLOADS_PER_FRAME)) {
+        LOADED_CHUNK& loaded = m_readyChunks.front();
+        int64_t key = ChunkKey(loaded.chunkX, loaded.chunkZ);
+        m_pendingBytes -= LoadedBytes(loaded);
+
+        // a chunk that was cancelled or left behind is not uploaded
+        bool bWanted = (m_requestedKeys.erase(key) != 0) &&
+            (chunkDistance(loaded.chunkX, loaded.chunkZ) <= UNLOAD_RADIUS) && (loaded.ships > 0);
+        if (bWanted) {
+            UploadChunk(loaded, layout);
+            uploads++;
+        }
+        m_readyChunks.pop_front();
+    }
+
+    m_peakBytes = std::max(m_peakBytes, m_residentBytes + m_pendingBytes);
+
+    if (m_pFrameStats) {
+        m_pFrameStats->AddCount("chunks resident", (double)m_residentKeys.size());
+        m_pFrameStats->AddCount("chunk requests", (double)m_requestedKeys.size());
+        m_pFrameStats->AddCount("ships resident", m_residentShips);
+        m_pFrameStats->AddCount("chunk MB", (m_residentBytes + m_pendingBytes) / BYTES_PER_MB);
+        m_pFrameStats->AddCount("chunk peak MB", m_peakBytes / BYTES_PER_MB);
+    }
+}
+
+/***********************************************************
+ *  UnloadAll()
+ *
+ *  This method is used to release every resident chunk and
+ *  forget the requests; chunks the loader is still working
+ *  on are dropped when they come back.
+ ***********************************************************/
+void WorldStreamer::UnloadAll() {
+    m_unloadedSlots.clear();
+    m_loadedSlots.clear();
+    for (size_t slot = 0; slot < m_chunks.size(); slot++) {
+        if (m_chunks[slot].pBuffer != nullptr) {
+            UnloadSlot((int)slot);
+            m_unloadedSlots.push_back((int)slot);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_requests.clear();
+    }
+    m_requestedKeys.clear();
+    m_readyChunks.clear();
+    m_pendingBytes = 0;
+}
+
+/***********************************************************
+ *  LoaderLoop()
+ *
+ *  This method runs on the loader thread.  It takes the
+ *  requests in order, reads and builds each chunk and hands
+ *  it back; a chunk that fails to read comes back empty so
+ *  that its request is still cleared.
+ ***********************************************************/
+void WorldStreamer::LoaderLoop() {
+    while (true) {
+        REQUEST request;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_requestReady.wait(lock, [this]() { return m_bStopLoader || !m_requests.empty(); });
+            if (m_bStopLoader) {
+                return;
+            }
+            request = m_requests.front();
+            m_requests.pop_front();
+        }
+
+        LOADED_CHUNK chunk;
+        if (!LoadChunk(request, chunk)) {
+            chunk.ships = 0;
+            chunk.geometry.Clear();
+            chunk.instances.clear();
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_finished.push_back(std::move(chunk));
+    }
+}
+
+/***********************************************************
+ *  LoadChunk()
+ *
+ *  This method runs on the loader thread to read the ship
+ *  records of a chunk and merge the ship shapes into one
+ *  geometry, placed relative to the chunk corner.  Every
+ *  ship also gets an impostor for when the chunk is far.
+ ***********************************************************/
+bool WorldStreamer::LoadChunk(const REQUEST& request, LOADED_CHUNK& chunk) {
+    double startTime = glfwGetTime();
+
+    chunk.chunkX = request.chunkX;
+    chunk.chunkZ = request.chunkZ;
+    chunk.requestTime = request.requestTime;
+
+    const CHUNK_ENTRY* pEntry = FindEntry(request.chunkX, request.chunkZ);
+    if (pEntry == nullptr) {
+        return false;
+    }
+
+    std::vector<SHIP_RECORD> records(pEntry->shipCount);
+    if ((fseek(m_pFile, (long)pEntry->offset, SEEK_SET) != 0) ||
+        (fread(records.data(), sizeof(SHIP_RECORD), records.size(), m_pFile) != records.size())) {
+        std::cout << "Error: Could not read chunk " << request.chunkX << ", " << request.chunkZ << std::endl;
+        return false;
+    }
+
+    chunk.instances.resize(records.size());
+    for (size_t i = 0; i < records.size(); i++) {
+        const SHIP_RECORD& ship = records[i];
+        uint32_t shipClass = std::min<uint32_t>(ship.shipClass, (uint32_t)m_shipShapes.size() - 1);
+        glm::vec3 position(ship.position[0], ship.position[1], ship.position[2]);
+        glm::mat4 model = glm::translate(position) *
+            glm::rotate(glm::radians(ship.yawDegrees), glm::vec3(0.0f, 1.0f, 0.0f)) *
+            glm::scale(glm::vec3(ship.scale));
+        chunk.geometry.Append(m_shipShapes[shipClass], model);
+
+        chunk.instances[i].positionScale = glm::vec4(position, ship.scale);
+        chunk.instances[i].yawGroup = glm::vec2(glm::radians(ship.yawDegrees), (float)shipClass);
+    }
+    chunk.ships = (int)records.size();
+    chunk.readTime = glfwGetTime() - startTime;
+
+    return true;
+}
+
+/***********************************************************
+ *  UploadChunk()
+ *
+ *  This method is used to upload a finished chunk into a
+ *  mesh buffer and make it resident in a free slot.
+ ***********************************************************/
+void WorldStreamer::UploadChunk(LOADED_CHUNK& loaded, MeshBuffer::VERTEX_LAYOUT layout) {
+    MeshBuffer* pBuffer = new MeshBuffer();
+    if (!pBuffer->Upload(loaded.geometry, layout, "fleet chunk")) {
+        delete pBuffer;
+        return;
+    }
+
+    int slot = 0;
+    if (!m_freeSlots.empty()) {
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    }
+    else {
+        slot = (int)m_chunks.size();
+        m_chunks.push_back(CHUNK());
+    }
+
+    CHUNK& chunk = m_chunks[slot];
+    chunk.chunkX = loaded.chunkX;
+    chunk.chunkZ = loaded.chunkZ;
+    chunk.ships = loaded.ships;
+    chunk.pBuffer = pBuffer;
+    ImpostorAtlas::UploadInstances(loaded.instances, chunk.impostors);
+    loaded.geometry.GetBounds(chunk.boundsMin, chunk.boundsMax);
+
+    m_residentKeys[ChunkKey(chunk.chunkX, chunk.chunkZ)] = slot;
+    m_residentBytes += pBuffer->BufferBytes() + chunk.impostors.bufferBytes;
+    m_residentShips += chunk.ships;
+    m_loadedSlots.push_back(slot);
+
+    if (m_pFrameStats) {
+        m_pFrameStats->AddSample("chunk load ms", (glfwGetTime() - loaded.requestTime) * 1000.0);
+        m_pFrameStats->AddSample("chunk read ms", loaded.readTime * 1000.0);
+    }
+}
+
+/***********************************************************
+ *  UnloadSlot()
+ *
+ *  This method is used to release a resident chunk and free
+ *  its slot for the next chunk.
+ ***********************************************************/
+void WorldStreamer::UnloadSlot(int slot) {
+    CHUNK& chunk = m_chunks[slot];
+
+    m_residentKeys.erase(ChunkKey(chunk.chunkX, chunk.chunkZ));
+    m_residentBytes -= chunk.pBuffer->BufferBytes() + chunk.impostors.bufferBytes;
+    m_residentShips -= chunk.ships;
+
+    delete chunk.pBuffer;
+    chunk.pBuffer = nullptr;
+    ImpostorAtlas::DestroyInstances(chunk.impostors);
+    m_freeSlots.push_back(slot);
+}
+
+/***********************************************************
+ *  LoadedBytes()
+ *
+ *  This method returns the memory held by the vertices,
+ *  indices and impostors of the passed in loaded chunk.
+ ***********************************************************/
+size_t WorldStreamer::LoadedBytes(const LOADED_CHUNK& chunk) {
+    return chunk.geometry.Vertices().size() * sizeof(PrimitiveGeometry::VERTEX) +
+        chunk.geometry.Indices().size() * sizeof(unsigned int) +
+        chunk.instances.size() * sizeof(ImpostorAtlas::INSTANCE);
+}
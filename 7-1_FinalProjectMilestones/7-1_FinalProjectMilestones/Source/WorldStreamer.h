@@ -0,0 +1,170 @@
+///////////////////////////////////////////////////////////////////////////////
+// worldstreamer.h
+// ============
+// stream the chunks of a large fleet world in and out around the camera,
+// reading them from a binary world file on a background thread
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "FrameStats.h"
+#include "MeshBuffer.h"
+#include "PrimitiveGeometry.h"
+#include "ImpostorAtlas.h"
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+class WorldStreamer {
+public:
+    // constructor
+    WorldStreamer(FrameStats* pFrameStats = nullptr);
+    // destructor
+    ~WorldStreamer();
+
+    // open the world file, generating it first if it does not exist, and
+    // start the loader thread
+    bool Initialize(const char* filename);
+
+    // request the chunks around the camera, unload the ones left behind and
+    // upload the chunks the loader has finished; the camera is in world
+    // coordinates, which are kept in double precision
+    void Update(const glm::dvec3& cameraPosition, MeshBuffer::VERTEX_LAYOUT layout);
+    // unload every chunk and drop the requests
+    void UnloadAll();
+
+    // slots of the chunks that were unloaded and loaded by the last update,
+    // the unloaded slots may be given to chunks loaded in the same update
+    const std::vector<int>& UnloadedSlots() const { return m_unloadedSlots; }
+    const std::vector<int>& LoadedSlots() const { return m_loadedSlots; }
+
+    // get a resident chunk by slot
+    int SlotCount() const { return (int)m_chunks.size(); }
+    bool IsResident(int slot) const { return m_chunks[slot].pBuffer != nullptr; }
+    const MeshBuffer* ChunkBuffer(int slot) const { return m_chunks[slot].pBuffer; }
+    // world position of the corner the chunk vertices are relative to
+    glm::dvec3 ChunkOrigin(int slot) const;
+    // bounds of the chunk vertices before the compact position decode
+    void GetChunkBounds(int slot, glm::vec3& boundsMin, glm::vec3& boundsMax) const;
+    // one impostor per ship of the chunk, grouped by ship class
+    const ImpostorAtlas::INSTANCE_BUFFER& ChunkImpostors(int slot) const { return m_chunks[slot].impostors; }
+
+    // shapes of the ship classes, each around its own origin
+    int ShipClassCount() const { return (int)m_shipShapes.size(); }
+    const PrimitiveGeometry& ShipShape(int shipClass) const { return m_shipShapes[shipClass]; }
+
+    float ChunkSize() const { return m_header.chunkSize; }
+
+private:
+    // Struct to hold the header at the start of the world file
+    struct WORLD_HEADER {
+        char magic[4];
+        uint32_t version;
+        int32_t firstChunkX;       // Chunk coordinates of the first table entry
+        int32_t firstChunkZ;
+        int32_t chunksX;           // Chunks along each axis
+        int32_t chunksZ;
+        float chunkSize;           // Edge length of a chunk in world units
+        uint32_t shipCount;
+    };
+
+    // Struct to hold one entry of the chunk table that follows the header,
+    // ordered by Z then X
+    struct CHUNK_ENTRY {
+        uint64_t offset;           // File offset of the first ship record
+        uint32_t shipCount;
+        uint32_t reserved;
+    };
+
+    // Struct to hold one ship in the file, placed relative to the chunk corner
+    struct SHIP_RECORD {
+        float position[3];
+        float yawDegrees;
+        float scale;
+        uint32_t shipClass;
+    };
+
+    // Struct to hold a chunk request handed to the loader thread
+    struct REQUEST {
+        int chunkX = 0;
+        int chunkZ = 0;
+        double requestTime = 0.0;
+    };
+
+    // Struct to hold a chunk the loader thread has built
+    struct LOADED_CHUNK {
+        int chunkX = 0;
+        int chunkZ = 0;
+        double requestTime = 0.0;
+        double readTime = 0.0;     // Seconds spent reading and building
+        int ships = 0;
+        PrimitiveGeometry geometry;
+        std::vector<ImpostorAtlas::INSTANCE> instances;
+    };
+
+    // Struct to hold a resident chunk
+    struct CHUNK {
+        int chunkX = 0;
+        int chunkZ = 0;
+        int ships = 0;
+        MeshBuffer* pBuffer = nullptr;
+        ImpostorAtlas::INSTANCE_BUFFER impostors;
+        glm::vec3 boundsMin = glm::vec3(0.0f);
+        glm::vec3 boundsMax = glm::vec3(0.0f);
+    };
+
+    FrameStats* m_pFrameStats;        // Frame statistics, may be null
+
+    // world file, read only by the loader thread once it is running
+    FILE* m_pFile;
+    WORLD_HEADER m_header;
+    std::vector<CHUNK_ENTRY> m_table;
+    // ship shapes, built once and only read afterwards
+    std::vector<PrimitiveGeometry> m_shipShapes;
+
+    // resident chunks by slot, and the slot of each resident chunk key
+    std::vector<CHUNK> m_chunks;
+    std::vector<int> m_freeSlots;
+    std::unordered_map<int64_t, int> m_residentKeys;
+    // chunks requested and not yet resident
+    std::unordered_set<int64_t> m_requestedKeys;
+    // chunks built by the loader that wait for their upload
+    std::deque<LOADED_CHUNK> m_readyChunks;
+    std::vector<int> m_unloadedSlots;
+    std::vector<int> m_loadedSlots;
+
+    // loader thread and the queues shared with it
+    std::thread m_loader;
+    std::mutex m_mutex;
+    std::condition_variable m_requestReady;
+    std::deque<REQUEST> m_requests;
+    std::deque<LOADED_CHUNK> m_finished;
+    bool m_bStopLoader;
+
+    // memory held by the chunks, resident on the GPU and waiting on the CPU
+    size_t m_residentBytes;
+    size_t m_pendingBytes;
+    size_t m_peakBytes;
+    int m_residentShips;
+
+    bool GenerateWorld(const char* filename);
+    bool ReadWorld();
+    void BuildShipShapes();
+    const CHUNK_ENTRY* FindEntry(int chunkX, int chunkZ) const;
+    static int64_t ChunkKey(int chunkX, int chunkZ);
+    void LoaderLoop();
+    bool LoadChunk(const REQUEST& request, LOADED_CHUNK& chunk);
+    void UploadChunk(LOADED_CHUNK& loaded, MeshBuffer::VERTEX_LAYOUT layout);
+    void UnloadSlot(int slot);
+    static size_t LoadedBytes(const LOADED_CHUNK& chunk);
+};